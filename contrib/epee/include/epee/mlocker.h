@@ -43,16 +43,15 @@ namespace epee
     static size_t get_page_size();
     static size_t get_num_locked_pages();
     static size_t get_num_locked_objects();
+    /// Stack pages with no objects left that are still locked, to save syscalls if they're reused;
+    /// not included in get_num_locked_pages().  Never more than MAX_CACHED_PAGES over all threads.
+    static size_t get_num_cached_pages();
+    static constexpr size_t MAX_CACHED_PAGES = 4;
 
     static void lock(void *ptr, size_t len);
     static void unlock(void *ptr, size_t len);
 
   private:
-    static size_t page_size;
-    static size_t num_locked_objects;
-
-    static std::mutex &mutex();
-    static std::map<size_t, unsigned int> &map();
     static void lock_page(size_t page);
     static void unlock_page(size_t page);
 
@@ -64,6 +63,9 @@ namespace epee
   ///
   /// Primarily useful for making sure that private keys don't get swapped out
   //  to disk
+  ///
+  /// Objects on the constructing thread's own stack (i.e. temporaries) take a thread-local path
+  /// that needs no lock and, after the first time a given stack page is used, no syscall.
   template <class T>
   struct mlocked : public T {
     using type = T;
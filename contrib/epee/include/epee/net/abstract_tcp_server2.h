@@ -54,6 +54,8 @@
 #define OXEN_DEFAULT_LOG_CATEGORY "net"
 
 #define ABSTRACT_SERVER_SEND_QUE_MAX_COUNT 1000
+// most queued chunks handed to a single (scatter-gather) write
+#define ABSTRACT_SERVER_SEND_GATHER_MAX_COUNT 64
 
 namespace epee
 {
@@ -127,6 +129,7 @@ namespace net_utils
   private:
     //----------------- i_service_endpoint ---------------------
     virtual bool do_send(shared_sv message); ///< (see do_send from i_service_endpoint)
+    virtual bool do_send(shared_sv header, shared_sv body); ///< (see do_send from i_service_endpoint)
     virtual bool send_done();
     virtual bool close();
     virtual bool call_run_once_service_io();
@@ -135,7 +138,10 @@ namespace net_utils
     virtual bool add_ref();
     virtual bool release();
     //------------------------------------------------------
-    bool do_send_chunk(shared_sv chunk); ///< will send (or queue) a part of data. internal use only
+    bool do_send_chunk(shared_sv chunk, bool more = false); ///< will send (or queue) a part of data; with more, only queues it, as the next chunk follows right away. internal use only
+    bool do_send_chunks(shared_sv message); ///< do_send_chunk()s message, split up if it's big (m_chunking_lock must be held)
+    /// Starts writing the chunks at the front of m_send_que (m_send_que_lock must be held)
+    void start_write(std::shared_ptr<connection<t_protocol_handler>> self);
 
     std::shared_ptr<connection<t_protocol_handler> > safe_shared_from_this();
     bool shutdown();
@@ -171,6 +177,7 @@ namespace net_utils
     std::shared_ptr<connection<t_protocol_handler> > m_self_ref; // the reference to hold
     std::mutex m_self_refs_lock;
     std::mutex m_chunking_lock; // held while we add small chunks of the big do_send() to small do_send_chunk()
+    size_t m_send_que_writing = 0; // how many chunks at the front of m_send_que the write in progress is sending
     std::mutex m_shutdown_lock; // held while shutting down
     
     t_connection_type m_connection_type;
@@ -305,10 +305,7 @@ PRAGMA_WARNING_DISABLE_VS(4355)
         context.m_current_speed_down = current_speed_down;
         context.m_max_speed_down = std::max(context.m_max_speed_down, current_speed_down);
     
-    {
-			std::lock_guard lock{epee::net_utils::network_throttle_manager::network_throttle_manager::m_lock_get_global_throttle_in};
-			epee::net_utils::network_throttle_manager::network_throttle_manager::get_global_throttle_in().handle_trafic_exact(bytes_transferred);
-		}
+		epee::net_utils::network_throttle_manager::get_global_throttle_in().handle_trafic_exact(bytes_transferred);
 
 		double delay=0; // will be calculated - how much we should sleep to obey speed limit etc
 
@@ -316,10 +313,7 @@ PRAGMA_WARNING_DISABLE_VS(4355)
 		if (speed_limit_is_enabled()) {
 			do // keep sleeping if we should sleep
 			{
-				{
-					std::lock_guard lock{epee::net_utils::network_throttle_manager::m_lock_get_global_throttle_in};
-					delay = epee::net_utils::network_throttle_manager::get_global_throttle_in().get_sleep_time_after_tick( bytes_transferred );
-				}
+				delay = epee::net_utils::network_throttle_manager::get_global_throttle_in().get_sleep_time_after_tick( bytes_transferred );
 				
 				delay *= 0.5;
 				long int ms = (long int)(delay * 100);
@@ -410,14 +404,30 @@ PRAGMA_WARNING_DISABLE_VS(4355)
   //---------------------------------------------------------------------------------
     template<class t_protocol_handler>
   bool connection<t_protocol_handler>::do_send(shared_sv message) {
+    return do_send(shared_sv{}, std::move(message));
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  bool connection<t_protocol_handler>::do_send(shared_sv header, shared_sv body) {
     TRY_ENTRY();
 
     // Use safe_shared_from_this, because of this is public method and it can be called on the object being deleted
     auto self = safe_shared_from_this();
     if (!self) return false;
     if (m_was_shutdown) return false;
-		// TODO avoid copy
 
+    // The parts are queued as they are, sharing their buffers, and get written out together; held
+    // so that nothing else gets queued in between them
+    std::lock_guard send_guard{m_chunking_lock};
+    if (!header.view.empty() && !do_send_chunk(std::move(header), true))
+      return false;
+    return do_send_chunks(std::move(body));
+
+    CATCH_ENTRY_L0("connection<t_protocol_handler>::do_send", false);
+  } // do_send()
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
+  bool connection<t_protocol_handler>::do_send_chunks(shared_sv message) {
 		const double factor = 32; // TODO config
 		typedef long long signed int t_safe; // my t_size to avoid any overunderflow in arithmetic
 		const t_safe chunksize_good = (t_safe)( 1024 * std::max(1.0,factor) );
@@ -427,10 +437,9 @@ PRAGMA_WARNING_DISABLE_VS(4355)
         CHECK_AND_ASSERT_MES(! (chunksize_max<0), false, "Negative chunksize_max" ); // make sure it is unsigned before removin sign with cast:
         long long unsigned int chunksize_max_unsigned = static_cast<long long unsigned int>( chunksize_max ) ;
 
+        // Splitting a big message only makes views into it, so the speed limit can be applied
+        // between the pieces; without one they are written together anyway
         if (allow_split && (message.size() > chunksize_max_unsigned)) {
-            { // LOCK: chunking
-                std::lock_guard send_guard{m_chunking_lock};
-
                 while (!message.view.empty()) {
                     bool ok = do_send_chunk(message.extract_prefix(chunksize_good));
 
@@ -440,18 +449,15 @@ PRAGMA_WARNING_DISABLE_VS(4355)
                 }
 
 				return true; // done - e.g. queued - all the chunks of current do_send call
-			} // LOCK: chunking
 		} // a big block (to be chunked) - all chunks
 		else { // small block
 			return do_send_chunk(std::move(message)); // just send as 1 big chunk
 		}
-
-    CATCH_ENTRY_L0("connection<t_protocol_handler>::do_send", false);
-	} // do_send()
+	} // do_send_chunks()
 
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
-  bool connection<t_protocol_handler>::do_send_chunk(shared_sv chunk)
+  bool connection<t_protocol_handler>::do_send_chunk(shared_sv chunk, bool more)
   {
     TRY_ENTRY();
     // Use safe_shared_from_this, because of this is public method and it can be called on the object being deleted
@@ -510,32 +516,21 @@ PRAGMA_WARNING_DISABLE_VS(4355)
 
     m_send_que.push_back(std::move(chunk));
 
-    if(m_send_que.size() > 1)
+    if(m_send_que_writing > 0)
     { // active operation should be in progress, nothing to do, just wait last operation callback
-        auto size_now = m_send_que.back().size();
         //do_send_handler_delayed( ptr , size_now ); // (((H))) // empty function
       
+    }
+    else if(more)
+    { // the rest is queued right after this, and goes out in the same write
     }
     else
     { // no active operation
 
-        if(m_send_que.size()!=1)
-        {
-            return false;
-        }
-
-        auto size_now = m_send_que.front().size();
         if (speed_limit_is_enabled())
 			do_send_handler_write( m_send_que.back().data(), m_send_que.back().size() ); // (((H)))
 
-        CHECK_AND_ASSERT_MES( size_now == m_send_que.front().size(), false, "Unexpected queue size");
-        reset_timer(get_default_timeout(), false);
-        using namespace boost::placeholders;
-        boost::asio::async_write(socket(), boost::asio::buffer(m_send_que.front().data(), size_now ) ,
-                                 strand_.wrap(
-                                 boost::bind(&connection<t_protocol_handler>::handle_write, self, _1, _2)
-                                 )
-                                 );
+        start_write(std::move(self));
     }
     
     //do_send_handler_stop( ptr , cb ); // empty function
@@ -546,6 +541,27 @@ PRAGMA_WARNING_DISABLE_VS(4355)
   } // do_send_chunk
   //---------------------------------------------------------------------------------
   template<class t_protocol_handler>
+  void connection<t_protocol_handler>::start_write(std::shared_ptr<connection<t_protocol_handler>> self)
+  {
+    // One write straight from the queued chunks, as many as there are up to the gather limit. With
+    // a speed limit it's a chunk at a time, so handle_write can sleep between them.
+    const size_t max_count = speed_limit_is_enabled() ? 1 : ABSTRACT_SERVER_SEND_GATHER_MAX_COUNT;
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(std::min(max_count, m_send_que.size()));
+    for (auto it = m_send_que.begin(); it != m_send_que.end() && buffers.size() < max_count; ++it)
+      buffers.emplace_back(it->data(), it->size());
+    m_send_que_writing = buffers.size();
+
+    reset_timer(get_default_timeout(), false);
+    using namespace boost::placeholders;
+    boost::asio::async_write(socket(), buffers,
+                             strand_.wrap(
+                             boost::bind(&connection<t_protocol_handler>::handle_write, std::move(self), _1, _2)
+                             )
+                             );
+  }
+  //---------------------------------------------------------------------------------
+  template<class t_protocol_handler>
   std::chrono::milliseconds connection<t_protocol_handler>::get_default_timeout()
   {
     unsigned count;
@@ -696,7 +712,9 @@ PRAGMA_WARNING_DISABLE_VS(4355)
       return;
     }
 
-    m_send_que.pop_front();
+    CHECK_AND_ASSERT_MES( m_send_que_writing >= 1 && m_send_que_writing <= m_send_que.size(), void(), "Unexpected queue size");
+    m_send_que.erase(m_send_que.begin(), m_send_que.begin() + m_send_que_writing);
+    m_send_que_writing = 0;
     if(m_send_que.empty())
     {
       if(m_want_close_connection)
@@ -706,17 +724,9 @@ PRAGMA_WARNING_DISABLE_VS(4355)
     }else
     {
       //have more data to send
-		reset_timer(get_default_timeout(), false);
-		auto size_now = m_send_que.front().size();
 		if (speed_limit_is_enabled())
 			do_send_handler_write_from_queue(e, m_send_que.front().size() , m_send_que.size()); // (((H)))
-		CHECK_AND_ASSERT_MES( size_now == m_send_que.front().size(), void(), "Unexpected queue size");
-        using namespace boost::placeholders;
-        boost::asio::async_write(socket(), boost::asio::buffer(m_send_que.front().data(), size_now) , 
-           strand_.wrap(
-            boost::bind(&connection<t_protocol_handler>::handle_write, connection<t_protocol_handler>::shared_from_this(), _1, _2)
-			  )
-          );
+        start_write(connection<t_protocol_handler>::shared_from_this());
     }
     lock.unlock();
 
@@ -73,6 +73,7 @@ namespace levin
 
 
 #define LEVIN_DEFAULT_MAX_PACKET_SIZE 100000000      //100MB by default
+#define LEVIN_MAX_BODY_RESERVE 4000000              //4MB reserved up front for an incoming body, at most
 
 #define LEVIN_PACKET_REQUEST			0x00000001
 #define LEVIN_PACKET_RESPONSE		0x00000002
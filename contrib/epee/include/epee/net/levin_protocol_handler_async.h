@@ -30,6 +30,7 @@
 #include <mutex>
 #include <unordered_map>
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <thread>
@@ -94,6 +95,7 @@ public:
   int invoke_async(int command, const epee::span<const uint8_t> in_buff, boost::uuids::uuid connection_id, const callback_t &cb, std::chrono::nanoseconds timeout = 0s);
 
   int notify(int command, const epee::span<const uint8_t> in_buff, boost::uuids::uuid connection_id);
+  int notify(int command, epee::shared_sv body, boost::uuids::uuid connection_id);
   int send(epee::shared_sv message, const boost::uuids::uuid& connection_id);
   bool close(boost::uuids::uuid connection_id);
   bool update_connection_context(const t_connection_context& contxt);
@@ -123,17 +125,19 @@ class async_protocol_handler
 {
   std::string m_fragment_buffer;
 
-  bool send_message(uint32_t command, epee::span<const uint8_t> in_buff, uint32_t flags, bool expect_response)
+  // The header goes out as its own small buffer in front of the body, so the body is never copied
+  // to join them
+  bool send_message(uint32_t command, shared_sv body, uint32_t flags, bool expect_response, uint32_t return_code = 0)
   {
-    const bucket_head2 head = make_header(command, in_buff.size(), flags, expect_response);
-    std::string data;
-    data.reserve(sizeof(head) + in_buff.size());
-    data.append(reinterpret_cast<const char*>(&head), sizeof(head));
-    data.append(reinterpret_cast<const char*>(in_buff.data()), in_buff.size());
-    if(!m_pservice_endpoint->do_send(shared_sv{std::move(data)}))
-      return false;
+    bucket_head2 head = make_header(command, body.size(), flags, expect_response);
+    head.m_return_code = SWAP32LE(return_code);
+    return m_pservice_endpoint->do_send(
+      shared_sv{std::string(reinterpret_cast<const char*>(&head), sizeof(head))}, std::move(body));
+  }
 
-    return true;
+  bool send_message(uint32_t command, epee::span<const uint8_t> in_buff, uint32_t flags, bool expect_response)
+  {
+    return send_message(command, shared_sv{std::string(reinterpret_cast<const char*>(in_buff.data()), in_buff.size())}, flags, expect_response);
   }
 
 public:
@@ -496,11 +500,7 @@ public:
                 m_current_head.m_command, buff_to_invoke, return_buff, m_connection_context
               );
 
-              bucket_head2 head = make_header(m_current_head.m_command, return_buff.size(), LEVIN_PACKET_RESPONSE, false);
-              head.m_return_code = SWAP32LE(return_code);
-              return_buff.insert(0, reinterpret_cast<const char*>(&head), sizeof(head));
-
-              if(!m_pservice_endpoint->do_send(shared_sv{std::move(return_buff)}))
+              if(!send_message(m_current_head.m_command, shared_sv{std::move(return_buff)}, LEVIN_PACKET_RESPONSE, false, return_code))
                 return false;
             }
             else
@@ -550,6 +550,10 @@ public:
           {
             return false;
           }
+          // make room for the body now, so it arrives in place rather than being moved each time
+          // the buffer fills up.  The size comes from the (possibly not yet handshaked) peer, so
+          // only reserve up to a few MB; anything bigger grows incrementally as it arrives.
+          m_cache_in_buffer.reserve(std::min<uint64_t>(m_current_head.m_cb, LEVIN_MAX_BODY_RESERVE));
         }
         break;
       default:
@@ -675,6 +679,16 @@ public:
   }
 
   int notify(int command, const epee::span<const uint8_t> in_buff)
+  {
+    return notify(command, shared_sv{std::string(reinterpret_cast<const char*>(in_buff.data()), in_buff.size())});
+  }
+
+  /*! Sends `body` with a levin header in front of it. The body is queued
+      for sending as it is, shared rather than copied, so the same body can
+      go to any number of connections.
+
+      \return 1 on success */
+  int notify(int command, shared_sv body)
   {
     auto scope_exit_handler = misc_utils::create_scope_leave_handler(
       [this] { return finish_outer_call(); });
@@ -687,7 +701,7 @@ public:
     if(m_deletion_initiated)
       return LEVIN_ERROR_CONNECTION_DESTROYED;
 
-    if (!send_message(command, in_buff, LEVIN_PACKET_REQUEST, false))
+    if (!send_message(command, std::move(body), LEVIN_PACKET_REQUEST, false))
     {
       return -1;
     }
@@ -894,6 +908,14 @@ int async_protocol_handler_config<t_connection_context>::notify(int command, con
 }
 //------------------------------------------------------------------------------------------
 template<class t_connection_context>
+int async_protocol_handler_config<t_connection_context>::notify(int command, shared_sv body, boost::uuids::uuid connection_id)
+{
+  async_protocol_handler<t_connection_context>* aph;
+  int r = find_and_lock_connection(connection_id, aph);
+  return LEVIN_OK == r ? aph->notify(command, std::move(body)) : r;
+}
+//------------------------------------------------------------------------------------------
+template<class t_connection_context>
 int async_protocol_handler_config<t_connection_context>::send(shared_sv message, const boost::uuids::uuid& connection_id)
 {
   async_protocol_handler<t_connection_context>* aph;
@@ -423,6 +423,16 @@ namespace net_utils
 	struct i_service_endpoint
 	{
     virtual bool do_send(shared_sv message)=0;
+    // sends header then body, with nothing else in between; endpoints that can queue the two as
+    // they are should, rather than joining them
+    virtual bool do_send(shared_sv header, shared_sv body)
+    {
+      std::string message;
+      message.reserve(header.size() + body.size());
+      message.append(header.view);
+      message.append(body.view);
+      return do_send(shared_sv{std::move(message)});
+    }
     virtual bool close()=0;
     virtual bool send_done()=0;
     virtual bool call_run_once_service_io()=0;
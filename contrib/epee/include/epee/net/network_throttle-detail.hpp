@@ -36,7 +36,10 @@
 #ifndef INCLUDED_throttle_detail_hpp
 #define INCLUDED_throttle_detail_hpp
 
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <memory>
 #include <boost/circular_buffer.hpp>
 #include "network_throttle.hpp"
 
@@ -106,6 +109,77 @@ class network_throttle : public i_network_throttle {
         void logger_handle_net(const std::string &filename, double time, size_t size) override;
 };
 
+/***
+ * Throttle for traffic shared by all connections, i.e. the global in/inreq/out limits.
+ *
+ * Every I/O thread counts its packets into its own cache line of counters with relaxed atomic
+ * adds; whichever thread first notices that `aggregate_interval` has passed folds all the
+ * counters into the per-second history, so the per-packet path never takes a lock or writes to a
+ * cache line that other I/O threads are writing.  The sleep time is computed from the aggregated
+ * history the same way network_throttle does it; traffic that has not been aggregated yet is at
+ * most `aggregate_interval` old, and callers re-check after sleeping anyway.
+ *
+ * All methods are thread-safe and need no external locking, except set_name().
+*/
+class shared_network_throttle : public i_network_throttle {
+	public:
+		static constexpr size_t SHARDS = 16; ///< number of per-thread counters; threads beyond this share them
+		static constexpr int64_t aggregate_interval_ms = 50; ///< how stale the history is allowed to get
+
+	private:
+		struct alignas(64) shard {
+			std::atomic<uint64_t> bytes{0};
+			std::atomic<uint64_t> packets{0};
+		};
+
+		std::atomic<network_speed_bps> m_target_speed;
+		const size_t m_window_size; // the number of 1 second slots to average over
+
+		mutable std::array<shard, SHARDS> m_shards;
+
+		// Only written by the thread holding m_aggregating:
+		mutable std::unique_ptr<std::atomic<uint64_t>[]> m_history; // bytes per slot, indexed by slot % m_window_size
+		mutable std::atomic<int64_t> m_history_slot; // the slot (in seconds) of the newest history entry
+		mutable std::atomic<uint64_t> m_window_bytes; // sum of m_history
+		mutable std::atomic<int64_t> m_start_ms; // when we first got traffic or a tick, 0 if not yet
+		mutable std::atomic<uint64_t> m_total_packets;
+		mutable std::atomic<uint64_t> m_total_bytes;
+
+		mutable std::atomic<int64_t> m_next_aggregate_ms;
+		mutable std::atomic_flag m_aggregating = ATOMIC_FLAG_INIT;
+
+		std::string m_name; // my name for debug and logs
+		std::string m_nameshort; // my name for debug and logs (used in log file name)
+
+	public:
+		shared_network_throttle(const std::string &nameshort, const std::string &name, int window_size=-1);
+		void set_name(const std::string &name) override;
+		void set_target_speed( network_speed_kbps target ) override;
+		network_speed_kbps get_target_speed() override;
+
+		void handle_trafic_exact(size_t packet_size) override;
+		void handle_trafic_tcp(size_t packet_size) override;
+
+		void tick() override; ///< aggregates the per-thread counters if it is time to
+
+		double get_time_seconds() const override;
+
+		void calculate_times(size_t packet_size, calculate_times_struct &cts, bool dbg, double force_window) const override;
+
+		network_time_seconds get_sleep_time_after_tick(size_t packet_size) override;
+		network_time_seconds get_sleep_time(size_t packet_size) const override; ///< also aggregates if due, so never reads a stale window
+
+		size_t get_recommended_size_of_planned_transport() const override;
+		std::pair<uint64_t, uint64_t> get_stats() const override; ///< up to aggregate_interval_ms behind
+
+	private:
+		static int64_t get_time_ms();
+		shard& local_shard() const;
+		void maybe_aggregate(int64_t now_ms) const;
+		void aggregate(int64_t now_ms) const;
+		void logger_handle_net(const std::string &filename, double time, size_t size) override;
+};
+
 /***
  * The complete set of traffic throttle for one typical connection
 */
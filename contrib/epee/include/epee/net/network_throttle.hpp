@@ -38,7 +38,7 @@
 #define INCLUDED_network_throttle_hpp
 
 #include <string>
-#include <mutex>
+#include <cstdint>
 
 namespace epee
 {
@@ -74,20 +74,12 @@ class network_throttle_manager {
 	// [[note1]] see also http://www.nuonsoft.com/blog/2012/10/21/implementing-a-thread-safe-singleton-with-c11/
 	// [[note2]] _inreq is the requested in traffic - we anticipate we will get in-bound traffic soon as result of what we do (e.g. that we sent network downloads requests)
 	
-	//protected:
-	public: // XXX
-
-    static std::mutex m_lock_get_global_throttle_in;
-    static std::mutex m_lock_get_global_throttle_inreq;
-    static std::mutex m_lock_get_global_throttle_out;
-
-		friend class connection_basic; // FRIEND - to directly access global throttle-s. !! REMEMBER TO USE LOCKS!
-		friend class connection_basic_pimpl; // ditto
+	// [[note3]] the global throttles are shared_network_throttle-s, which are lock-free; callers need no locking
 
 	public:
-		static i_network_throttle & get_global_throttle_in(); ///< singleton ; for friend class ; caller MUST use proper locks! like m_lock_get_global_throttle_in
-		static i_network_throttle & get_global_throttle_inreq(); ///< ditto ; use lock ... use m_lock_get_global_throttle_inreq obviously
-		static i_network_throttle & get_global_throttle_out(); ///< ditto ; use lock ... use m_lock_get_global_throttle_out obviously
+		static i_network_throttle & get_global_throttle_in(); ///< singleton ; thread-safe
+		static i_network_throttle & get_global_throttle_inreq(); ///< ditto
+		static i_network_throttle & get_global_throttle_out(); ///< ditto
 };
 
 
@@ -97,5 +97,29 @@ void buffer::append(const void *data, size_t sz)
   NET_BUFFER_LOG("storage now " << offset << "/" << storage.size() << "/" << storage.capacity());
 }
 
+void buffer::reserve(size_t sz)
+{
+  if (sz <= size() || offset + sz <= storage.capacity())
+    return;
+
+  // at most one move or reallocation of what's here now, rather than one each time append runs out
+  const size_t bytes = size();
+  if (sz <= storage.capacity())
+  {
+    NET_BUFFER_LOG("reserving " << sz << " by moving " << bytes << " from offset " << offset);
+    memmove(storage.data(), storage.data() + offset, bytes);
+    storage.resize(bytes);
+  }
+  else
+  {
+    NET_BUFFER_LOG("reserving " << sz << " by reallocating");
+    std::vector<uint8_t> new_storage;
+    new_storage.reserve(sz);
+    new_storage.insert(new_storage.end(), storage.data() + offset, storage.data() + storage.size());
+    std::swap(storage, new_storage);
+  }
+  offset = 0;
+}
+
 }
 }
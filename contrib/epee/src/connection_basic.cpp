@@ -167,40 +167,20 @@ connection_basic::~connection_basic() noexcept(false) {
 }
 
 void connection_basic::set_rate_up_limit(uint64_t limit) {
-	{
-		std::lock_guard lock{network_throttle_manager::m_lock_get_global_throttle_out};
-		network_throttle_manager::get_global_throttle_out().set_target_speed(limit);
-	}
+	network_throttle_manager::get_global_throttle_out().set_target_speed(limit);
 }
 
 void connection_basic::set_rate_down_limit(uint64_t limit) {
-	{
-	  std::lock_guard lock{network_throttle_manager::m_lock_get_global_throttle_in};
-		network_throttle_manager::get_global_throttle_in().set_target_speed(limit);
-	}
-
-	{
-	  std::lock_guard lock{network_throttle_manager::m_lock_get_global_throttle_inreq};
-		network_throttle_manager::get_global_throttle_inreq().set_target_speed(limit);
-	}
+	network_throttle_manager::get_global_throttle_in().set_target_speed(limit);
+	network_throttle_manager::get_global_throttle_inreq().set_target_speed(limit);
 }
 
 uint64_t connection_basic::get_rate_up_limit() {
-    uint64_t limit;
-    {
-         std::lock_guard lock{network_throttle_manager::m_lock_get_global_throttle_out};
-         limit = network_throttle_manager::get_global_throttle_out().get_target_speed();
-	}
-    return limit;
+	return network_throttle_manager::get_global_throttle_out().get_target_speed();
 }
 
 uint64_t connection_basic::get_rate_down_limit() {
-    uint64_t limit;
-    {
-         std::lock_guard lock{network_throttle_manager::m_lock_get_global_throttle_in};
-         limit = network_throttle_manager::get_global_throttle_in().get_target_speed();
-	}
-    return limit;
+	return network_throttle_manager::get_global_throttle_in().get_target_speed();
 }
 
 void connection_basic::set_tos_flag(int tos) {
@@ -219,10 +199,7 @@ void connection_basic::sleep_before_packet(size_t packet_size, int phase,  int q
 			return;
 		}
 
-		{ 
-			std::lock_guard lock{network_throttle_manager::m_lock_get_global_throttle_out};
-			delay = network_throttle_manager::get_global_throttle_out().get_sleep_time_after_tick( packet_size );
-		}
+		delay = network_throttle_manager::get_global_throttle_out().get_sleep_time_after_tick( packet_size );
 
 		delay *= 0.50;
 		if (delay > 0) {
@@ -232,10 +209,7 @@ void connection_basic::sleep_before_packet(size_t packet_size, int phase,  int q
 	} while(delay > 0);
 
 // XXX LATER XXX
-	{
-	  std::lock_guard lock{network_throttle_manager::m_lock_get_global_throttle_out};
-		network_throttle_manager::get_global_throttle_out().handle_trafic_exact( packet_size ); // increase counter - global
-	}
+	network_throttle_manager::get_global_throttle_out().handle_trafic_exact( packet_size ); // increase counter - global
 
 }
 
@@ -254,9 +228,7 @@ void connection_basic::logger_handle_net_write(size_t size) {
 }
 
 double connection_basic::get_sleep_time(size_t cb) {
-	std::lock_guard lock{epee::net_utils::network_throttle_manager::network_throttle_manager::m_lock_get_global_throttle_out};
-    auto t = network_throttle_manager::get_global_throttle_out().get_sleep_time(cb);
-    return t;
+	return network_throttle_manager::get_global_throttle_out().get_sleep_time(cb);
 }
 
 
@@ -37,13 +37,21 @@
 #include "epee/misc_log_ex.h"
 #include "epee/mlocker.h"
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cerrno>
 #include <cstdint>
 #include <cstring>
-#include <map>
 #include <mutex>
+#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#if defined HAVE_MLOCK && defined __GLIBC__
+#include <pthread.h>
+#define HAVE_STACK_BOUNDS 1
+#endif
 
 // did an mlock operation previously fail? we only
 // want to log an error once and be done with it
@@ -82,28 +90,162 @@ static void do_unlock(void *ptr, size_t len)
 #endif
 }
 
-namespace epee
+namespace
 {
-  size_t mlocker::page_size = 0;
-  size_t mlocker::num_locked_objects = 0;
+  std::atomic<size_t> num_locked_pages{0};
+  std::atomic<size_t> num_locked_objects{0};
+
+  // Idle stack pages that the threads' stack caches are keeping locked, across all threads.
+  // These count against RLIMIT_MEMLOCK like any other locked page, so there are at most
+  // mlocker::MAX_CACHED_PAGES of them; past that, a stack page is unlocked as soon as its last
+  // object goes away.
+  std::atomic<size_t> num_cached_pages{0};
+
+  bool reserve_cached_page()
+  {
+    size_t n = num_cached_pages.load(std::memory_order_relaxed);
+    do
+    {
+      if (n >= epee::mlocker::MAX_CACHED_PAGES)
+        return false;
+    } while (!num_cached_pages.compare_exchange_weak(n, n + 1, std::memory_order_relaxed));
+    return true;
+  }
+
+  // Page reference counts for everything not handled by the thread's stack cache below.  Split
+  // into stripes so that threads locking unrelated pages don't contend.
+  struct page_stripe
+  {
+    std::mutex mutex;
+    std::unordered_map<size_t, unsigned int> pages;
+  };
+  constexpr size_t NUM_STRIPES = 64;
+
+  page_stripe &stripe(size_t page)
+  {
+    static auto *stripes = new std::array<page_stripe, NUM_STRIPES>();
+    return (*stripes)[page % NUM_STRIPES];
+  }
+
+  // Pages of the current thread's stack that this thread has locked.  Objects on a thread's own
+  // stack are always created and destroyed by that thread, so these need no synchronization.  A
+  // page stays mlock()ed when its last object goes away (if num_cached_pages has room), so a hot
+  // loop creating temporary keys doesn't make a pair of syscalls per key; idle pages are unlocked
+  // when the slot is needed for another page, or when the thread exits.  Each idle entry (count 0)
+  // holds one of the num_cached_pages reservations.
+  //
+  // The counts of locked pages and objects are kept here too, rather than in the global counters,
+  // so that the owning thread is the only one writing to them; they're atomic only so that
+  // get_num_locked_*() can read them.
+  //
+  // This is deliberately trivially destructible, so that it stays usable while other thread_local
+  // objects are destroyed at thread exit; stack_cache_cleanup does the unlocking.
+  struct stack_cache
+  {
+    struct entry { size_t page; unsigned int count; };
+    static constexpr size_t SIZE = 16;
+
+    bool initialized;
+    bool dead;
+    uintptr_t lo, hi; // this thread's stack, or both 0 if unknown
+    size_t used;
+    entry entries[SIZE];
+    std::atomic<size_t> locked_pages;
+    std::atomic<size_t> locked_objects;
+
+    static void add(std::atomic<size_t> &n, ptrdiff_t d) { n.store(n.load(std::memory_order_relaxed) + d, std::memory_order_relaxed); }
 
-  std::mutex &mlocker::mutex()
+    bool on_stack(size_t page, size_t page_size) const { return page * page_size >= lo && page * page_size < hi; }
+    entry *find(size_t page)
+    {
+      for (size_t i = 0; i < used; ++i)
+        if (entries[i].page == page)
+          return &entries[i];
+      return nullptr;
+    }
+  };
+  thread_local stack_cache tl_stack{};
+
+  // All live threads' stack caches, for get_num_locked_*()
+  std::mutex &stack_caches_mutex()
+  {
+    static auto *mutex = new std::mutex();
+    return *mutex;
+  }
+  std::vector<stack_cache*> &stack_caches()
   {
-    static std::mutex *vmutex = new std::mutex();
-    return *vmutex;
+    static auto *caches = new std::vector<stack_cache*>();
+    return *caches;
   }
-  std::map<size_t, unsigned int> &mlocker::map()
+
+  size_t sum_stack_caches(std::atomic<size_t> stack_cache::*n)
+  {
+    std::lock_guard lock{stack_caches_mutex()};
+    size_t sum = 0;
+    for (auto *c : stack_caches())
+      sum += (c->*n).load(std::memory_order_relaxed);
+    return sum;
+  }
+
+  struct stack_cache_cleanup
+  {
+    ~stack_cache_cleanup()
+    {
+      {
+        std::lock_guard lock{stack_caches_mutex()};
+        auto &caches = stack_caches();
+        caches.erase(std::remove(caches.begin(), caches.end(), &tl_stack), caches.end());
+      }
+      const size_t page_size = epee::mlocker::get_page_size();
+      for (size_t i = 0; i < tl_stack.used; ++i)
+      {
+        do_unlock((void*)(tl_stack.entries[i].page * page_size), page_size);
+        if (tl_stack.entries[i].count == 0)
+          --num_cached_pages;
+      }
+      tl_stack.used = 0;
+      tl_stack.dead = true;
+    }
+  };
+  thread_local stack_cache_cleanup tl_stack_cleanup;
+
+  // Returns the thread's stack cache if `page` is on its stack, otherwise nullptr
+  stack_cache *stack_cache_for(size_t page, size_t page_size)
   {
-    static std::map<size_t, unsigned int> *vmap = new std::map<size_t, unsigned int>();
-    return *vmap;
+#if defined(HAVE_STACK_BOUNDS)
+    stack_cache &c = tl_stack;
+    if (!c.initialized)
+    {
+      c.initialized = true;
+      pthread_attr_t attr;
+      if (pthread_getattr_np(pthread_self(), &attr) == 0)
+      {
+        void *addr;
+        size_t size;
+        if (pthread_attr_getstack(&attr, &addr, &size) == 0)
+        {
+          c.lo = (uintptr_t)addr;
+          c.hi = c.lo + size;
+        }
+        pthread_attr_destroy(&attr);
+      }
+      (void)&tl_stack_cleanup; // make sure its destructor runs at thread exit
+      std::lock_guard lock{stack_caches_mutex()};
+      stack_caches().push_back(&c);
+    }
+    if (!c.dead && c.on_stack(page, page_size))
+      return &c;
+#endif
+    return nullptr;
   }
+}
 
+namespace epee
+{
   size_t mlocker::get_page_size()
   {
 #if defined(HAVE_MLOCK)
-    std::lock_guard lock{mutex()};
-    if (page_size == 0)
-      page_size = query_page_size();
+    static const size_t page_size = query_page_size();
     return page_size;
 #else
     return 0;
@@ -134,12 +276,14 @@ namespace epee
     if (page_size == 0)
       return;
 
-    std::lock_guard lock{mutex()};
     const size_t first = ((uintptr_t)ptr) / page_size;
     const size_t last = (((uintptr_t)ptr) + len - 1) / page_size;
     for (size_t page = first; page <= last; ++page)
       lock_page(page);
-    ++num_locked_objects;
+    if (stack_cache *c = stack_cache_for(first, page_size))
+      stack_cache::add(c->locked_objects, 1);
+    else
+      ++num_locked_objects;
 
     CATCH_ENTRY_L1("mlocker::lock", void());
 #endif
@@ -153,12 +297,14 @@ namespace epee
     size_t page_size = get_page_size();
     if (page_size == 0)
       return;
-    std::lock_guard lock{mutex()};
     const size_t first = ((uintptr_t)ptr) / page_size;
     const size_t last = (((uintptr_t)ptr) + len - 1) / page_size;
     for (size_t page = first; page <= last; ++page)
       unlock_page(page);
-    --num_locked_objects;
+    if (stack_cache *c = stack_cache_for(first, page_size))
+      stack_cache::add(c->locked_objects, -1);
+    else
+      --num_locked_objects;
 
     CATCH_ENTRY_L1("mlocker::lock", void());
 #endif
@@ -166,35 +312,80 @@ namespace epee
 
   size_t mlocker::get_num_locked_pages()
   {
-#if defined(HAVE_MLOCK)
-    std::lock_guard lock{mutex()};
-    return map().size();
-#else
-    return 0;
-#endif
+    return num_locked_pages + sum_stack_caches(&stack_cache::locked_pages);
   }
 
   size_t mlocker::get_num_locked_objects()
   {
-#if defined(HAVE_MLOCK)
-    std::lock_guard lock{mutex()};
-    return num_locked_objects;
-#else
-    return 0;
-#endif
+    return num_locked_objects + sum_stack_caches(&stack_cache::locked_objects);
+  }
+
+  size_t mlocker::get_num_cached_pages()
+  {
+    return num_cached_pages;
   }
 
+  // A page's objects are all counted either in the stack cache or in its stripe: a page only goes
+  // into the stack cache when the stripe has no count for it, and after that locks find it in the
+  // cache.
   void mlocker::lock_page(size_t page)
   {
 #if defined(HAVE_MLOCK)
-    std::pair<std::map<size_t, unsigned int>::iterator, bool> p = map().insert(std::make_pair(page, 1));
-    if (p.second)
+    const size_t page_size = get_page_size();
+    page_stripe &s = stripe(page);
+    if (stack_cache *c = stack_cache_for(page, page_size))
+    {
+      if (auto *e = c->find(page))
+      {
+        if (e->count++ == 0)
+        {
+          stack_cache::add(c->locked_pages, 1);
+          --num_cached_pages;
+        }
+        return;
+      }
+      std::unique_lock lock{s.mutex};
+      if (!s.pages.count(page))
+      {
+        lock.unlock();
+        stack_cache::entry *e = nullptr;
+        if (c->used < stack_cache::SIZE)
+          e = &c->entries[c->used++];
+        else
+        {
+          for (auto &idle : c->entries)
+          {
+            if (idle.count == 0)
+            {
+              do_unlock((void*)(idle.page * page_size), page_size);
+              --num_cached_pages;
+              e = &idle;
+              break;
+            }
+          }
+        }
+        if (e)
+        {
+          do_lock((void*)(page * page_size), page_size);
+          *e = {page, 1};
+          stack_cache::add(c->locked_pages, 1);
+          return;
+        }
+        lock.lock();
+      }
+      // Otherwise fall through to the stripe; the cache is full of pages in use
+    }
+
+    std::lock_guard lock{s.mutex};
+    auto [it, inserted] = s.pages.emplace(page, 1);
+    if (inserted)
     {
       do_lock((void*)(page * page_size), page_size);
+      ++num_locked_pages;
     }
     else
     {
-      ++p.first->second;
+      ++it->second;
     }
 #endif
   }
@@ -202,13 +393,34 @@ namespace epee
   void mlocker::unlock_page(size_t page)
   {
 #if defined(HAVE_MLOCK)
-    std::map<size_t, unsigned int>::iterator i = map().find(page);
-    if (i != map().end())
+    const size_t page_size = get_page_size();
+    if (stack_cache *c = stack_cache_for(page, page_size))
+    {
+      if (auto *e = c->find(page); e && e->count > 0)
+      {
+        if (--e->count == 0)
+        {
+          stack_cache::add(c->locked_pages, -1);
+          if (!reserve_cached_page())
+          {
+            do_unlock((void*)(page * page_size), page_size);
+            *e = c->entries[--c->used];
+          }
+        }
+        return;
+      }
+    }
+
+    page_stripe &s = stripe(page);
+    std::lock_guard lock{s.mutex};
+    auto i = s.pages.find(page);
+    if (i != s.pages.end())
     {
       if (!--i->second)
       {
-        map().erase(i);
+        s.pages.erase(i);
         do_unlock((void*)(page * page_size), page_size);
+        --num_locked_pages;
       }
     }
 #endif
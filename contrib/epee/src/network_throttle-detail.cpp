@@ -33,8 +33,8 @@
 /* rfree: implementation for throttle details */
 
 #include <string>
-#include <sstream>
 #include <fstream>
+#include <mutex>
 #include <iomanip>
 #include <algorithm>
 
@@ -175,14 +175,9 @@ void network_throttle::_handle_trafic_exact(size_t packet_size, size_t orginal_s
 {
 	tick();
 
-	calculate_times_struct cts ;  calculate_times(packet_size, cts , false, -1);
-	calculate_times_struct cts2;  calculate_times(packet_size, cts2, false, 5);
 	m_history.front().m_size += packet_size;
 	m_total_packets++;
 	m_total_bytes += packet_size;
-
-	std::ostringstream oss; oss << "["; 	for (auto sample: m_history) oss << sample.m_size << " ";	 oss << "]" << std::ends;
-	std::string history_str = oss.str();
 }
 
 void network_throttle::handle_trafic_tcp(size_t packet_size)
@@ -197,7 +192,7 @@ network_time_seconds network_throttle::get_sleep_time_after_tick(size_t packet_s
 	return get_sleep_time(packet_size);
 }
 
-void network_throttle::logger_handle_net(const std::string &filename, double time, size_t size) {
+static void append_net_log(const std::string &filename, double time, size_t size) {
     static std::mutex mutex;
 
     std::lock_guard lock{mutex};
@@ -210,6 +205,10 @@ void network_throttle::logger_handle_net(const std::string &filename, double tim
     }
 }
 
+void network_throttle::logger_handle_net(const std::string &filename, double time, size_t size) {
+    append_net_log(filename, time, size);
+}
+
 // fine tune this to decide about sending speed:
 network_time_seconds network_throttle::get_sleep_time(size_t packet_size) const 
 {
@@ -261,11 +260,6 @@ void network_throttle::calculate_times(size_t packet_size, calculate_times_struc
     {	// how much data we recommend now to download
         cts.recomendetDataSize = M*cts.window - E;
     }
-
-	if (dbg) {
-		std::ostringstream oss; oss << "["; 	for (auto sample: m_history) oss << sample.m_size << " ";	 oss << "]" << std::ends;
-		std::string history_str = oss.str();
-	}
 }
 
 double network_throttle::get_time_seconds() const {
@@ -320,6 +314,183 @@ std::pair<uint64_t, uint64_t> network_throttle::get_stats() const {
     return {m_total_packets, m_total_bytes};
 }
 
+// ================================================================================================
+// shared_network_throttle
+// ================================================================================================
+
+shared_network_throttle::shared_network_throttle(const std::string &nameshort, const std::string &name, int window_size)
+	: m_target_speed(16 * 1024),
+	  m_window_size( (window_size==-1) ? 10 : window_size ),
+	  m_history(new std::atomic<uint64_t>[m_window_size]),
+	  m_history_slot(0), m_window_bytes(0), m_start_ms(0), m_total_packets(0), m_total_bytes(0),
+	  m_next_aggregate_ms(0),
+	  m_nameshort(nameshort)
+{
+	set_name(name);
+	for (size_t i = 0; i < m_window_size; i++)
+		m_history[i].store(0, std::memory_order_relaxed);
+}
+
+void shared_network_throttle::set_name(const std::string &name)
+{
+	m_name = name;
+}
+
+void shared_network_throttle::set_target_speed( network_speed_kbps target )
+{
+	m_target_speed.store(target * 1024, std::memory_order_relaxed);
+}
+
+network_speed_kbps shared_network_throttle::get_target_speed()
+{
+	return m_target_speed.load(std::memory_order_relaxed) / 1024;
+}
+
+int64_t shared_network_throttle::get_time_ms() {
+	#if defined(__APPLE__)
+	auto point = std::chrono::system_clock::now();
+	#else
+	auto point = std::chrono::steady_clock::now();
+	#endif
+	return std::chrono::duration_cast< std::chrono::milliseconds >( point.time_since_epoch() ).count();
+}
+
+double shared_network_throttle::get_time_seconds() const {
+	return get_time_ms() / 1000.;
+}
+
+shared_network_throttle::shard& shared_network_throttle::local_shard() const {
+	// Threads get consecutive shards as they first touch any shared throttle, so the (fixed size)
+	// I/O thread pool normally ends up with one shard per thread.
+	static std::atomic<size_t> next_thread{0};
+	thread_local const size_t index = next_thread.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+	return m_shards[index];
+}
+
+void shared_network_throttle::handle_trafic_exact(size_t packet_size)
+{
+	auto& s = local_shard();
+	s.bytes.fetch_add(packet_size, std::memory_order_relaxed);
+	s.packets.fetch_add(1, std::memory_order_relaxed);
+	maybe_aggregate(get_time_ms());
+}
+
+// The header cost and minimal segment size here and below are network_throttle's defaults
+void shared_network_throttle::handle_trafic_tcp(size_t packet_size)
+{
+	handle_trafic_exact(std::max<size_t>(256, packet_size + 128));
+}
+
+void shared_network_throttle::tick()
+{
+	maybe_aggregate(get_time_ms());
+}
+
+void shared_network_throttle::maybe_aggregate(int64_t now_ms) const
+{
+	if (now_ms < m_next_aggregate_ms.load(std::memory_order_relaxed))
+		return;
+	// Whoever gets the flag does the work; everyone else carries on rather than waiting for it.
+	if (m_aggregating.test_and_set(std::memory_order_acquire))
+		return;
+	if (now_ms >= m_next_aggregate_ms.load(std::memory_order_relaxed))
+	{
+		m_next_aggregate_ms.store(now_ms + aggregate_interval_ms, std::memory_order_relaxed);
+		aggregate(now_ms);
+	}
+	m_aggregating.clear(std::memory_order_release);
+}
+
+void shared_network_throttle::aggregate(int64_t now_ms) const
+{
+	if (m_start_ms.load(std::memory_order_relaxed) == 0)
+		m_start_ms.store(now_ms, std::memory_order_relaxed);
+
+	const int64_t W = m_window_size;
+	const int64_t slot = now_ms / 1000;
+	const int64_t last = m_history_slot.load(std::memory_order_relaxed);
+	if (slot > last)
+	{
+		// Clear the slots we moved past; they still hold the traffic from one window ago.
+		for (int64_t s = std::max(last + 1, slot - W + 1); s <= slot; s++)
+			m_window_bytes.fetch_sub(m_history[s % W].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+		m_history_slot.store(slot, std::memory_order_relaxed);
+	}
+
+	uint64_t bytes = 0, packets = 0;
+	for (auto& s : m_shards)
+	{
+		bytes += s.bytes.exchange(0, std::memory_order_relaxed);
+		packets += s.packets.exchange(0, std::memory_order_relaxed);
+	}
+	if (!packets)
+		return;
+	m_history[slot % W].fetch_add(bytes, std::memory_order_relaxed);
+	m_window_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	m_total_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	m_total_packets.fetch_add(packets, std::memory_order_relaxed);
+}
+
+// Same logic as network_throttle::calculate_times, over the aggregated history
+void shared_network_throttle::calculate_times(size_t packet_size, calculate_times_struct &cts, bool dbg, double force_window) const
+{
+	const int64_t now_ms = get_time_ms();
+	maybe_aggregate(now_ms);
+
+	const int64_t start_ms = m_start_ms.load(std::memory_order_relaxed);
+	if (!start_ms) {
+		cts.window=0; cts.average=0; cts.delay=0;
+		cts.recomendetDataSize = 256;
+		return;
+	}
+
+	const double the_window_size = std::max( (double)m_window_size ,
+		((force_window>0) ? force_window : m_window_size)
+	);
+	network_time_seconds window_len = (the_window_size-1) + (now_ms % 1000) / 1000.;
+	cts.window = std::max( std::min( window_len , (now_ms - start_ms) / 1000. ) , 1.0 );
+
+	const double E = m_window_bytes.load(std::memory_order_relaxed);
+	const double M = m_target_speed.load(std::memory_order_relaxed);
+	const double D1 = (E - M*cts.window) / M;
+	const double D2 = (E + packet_size - M*cts.window) / M;
+
+	cts.delay = (D1*0.80 + D2*0.20);
+	cts.average = E/cts.window;
+	if (E <= 0 && cts.delay >= 0)
+		cts.delay = 0;
+	cts.recomendetDataSize = M*cts.window - E;
+}
+
+network_time_seconds shared_network_throttle::get_sleep_time_after_tick(size_t packet_size) {
+	return get_sleep_time(packet_size);
+}
+
+network_time_seconds shared_network_throttle::get_sleep_time(size_t packet_size) const
+{
+	calculate_times_struct cts = { 0, 0, 0, 0};
+	calculate_times(packet_size, cts, true, m_window_size);
+	return cts.delay;
+}
+
+size_t shared_network_throttle::get_recommended_size_of_planned_transport() const {
+	calculate_times_struct cts = { 0, 0, 0, 0};
+	calculate_times(0, cts, false, -1);
+	cts.recomendetDataSize += 128;
+	if (cts.recomendetDataSize<0) cts.recomendetDataSize=0;
+	if (cts.recomendetDataSize>1024*1024) cts.recomendetDataSize=1024*1024;
+	return (size_t)cts.recomendetDataSize;
+}
+
+std::pair<uint64_t, uint64_t> shared_network_throttle::get_stats() const {
+	maybe_aggregate(get_time_ms());
+	return {m_total_packets.load(std::memory_order_relaxed), m_total_bytes.load(std::memory_order_relaxed)};
+}
+
+void shared_network_throttle::logger_handle_net(const std::string &filename, double time, size_t size) {
+	append_net_log(filename, time, size);
+}
+
 
 } // namespace
 } // namespace
@@ -65,29 +65,23 @@ namespace net_utils
 // network_throttle_manager
 // ================================================================================================
 
-// ================================================================================================
-// static:
-std::mutex network_throttle_manager::m_lock_get_global_throttle_in;
-std::mutex network_throttle_manager::m_lock_get_global_throttle_inreq;
-std::mutex network_throttle_manager::m_lock_get_global_throttle_out;
-
 // ================================================================================================
 // methods:
 i_network_throttle & network_throttle_manager::get_global_throttle_in() { 
-	static network_throttle obj_get_global_throttle_in("in/all","<<< global-IN",10);
+	static shared_network_throttle obj_get_global_throttle_in("in/all","<<< global-IN",10);
 	return obj_get_global_throttle_in;
 }
 
 
 
 i_network_throttle & network_throttle_manager::get_global_throttle_inreq() { 
-	static network_throttle obj_get_global_throttle_inreq("inreq/all", "<== global-IN-REQ",10);
+	static shared_network_throttle obj_get_global_throttle_inreq("inreq/all", "<== global-IN-REQ",10);
 	return obj_get_global_throttle_inreq;
 }
 
 
 i_network_throttle & network_throttle_manager::get_global_throttle_out() { 
-	static network_throttle obj_get_global_throttle_out("out/all", ">>> global-OUT",10);
+	static shared_network_throttle obj_get_global_throttle_out("out/all", ">>> global-OUT",10);
 	return obj_get_global_throttle_out;
 }
 
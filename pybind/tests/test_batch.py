@@ -0,0 +1,111 @@
+# Tests and benchmarks of the batch keyring calls.  These don't need a daemon; run them from the
+# build directory after installing the module with:
+#
+#     python3 -m pytest pybind/tests
+#
+# (add --benchmark-only for just the benchmarks)
+#
+# (needs pytest, pytest-benchmark and numpy)
+
+import threading
+
+import numpy as np
+import pytest
+
+import pywallet3
+
+# Two fixed testnet keyrings, the same as the wallet3 tests use
+KEYS = [
+    (
+        "d6a2eac72d1432fb816793aa7e8e86947116ac1423cbad5804ca49893e03b00c",
+        "2fc259850413006e39450de23e3c63e69ccbdd3a14329707db55e3501bcda5fb",
+        "e93c833da9342958aff37c030cadcd04df8976c06aa2e0b83563205781cb8a02",
+        "5c1e8d44b4d7cb1269e69180dbf7aaf9c1fed4089b2bd4117dd1a70e90f19600",
+    ),
+    (
+        "e6c9165356c619a64a0d26fafd99891acccccf8717a8067859d972ecd8bcfc0a",
+        "b76f2d7c8a036ff65c564dcb27081c04fe3f2157942e23b0496ca797ba728e4f",
+        "961d67bb5b3ed1af8678bbfcf621f9c15c2b7bff080892890020bdfd47fe4f0a",
+        "8a0ebacd613e0b03b8f27bc64bd961ea2ebf4c671c6e7f3268651acf0823fed5",
+    ),
+]
+
+
+def make_keyring(i):
+    return pywallet3.Keyring(*KEYS[i], "testnet")
+
+
+@pytest.fixture(scope="module")
+def keyring():
+    keys = make_keyring(0)
+    keys.expand_subaddresses(2, 50)
+    return keys
+
+
+def others_outputs(count, outputs_per_tx=2):
+    """Outputs that aren't ours, using the other keyring's subaddress keys as valid points."""
+    points = make_keyring(1).get_subaddress_spend_public_keys(0, 0, count - 1)
+    tx_pubkeys = np.repeat(points[::outputs_per_tx], outputs_per_tx, axis=0)[:count]
+    indices = np.tile(np.arange(outputs_per_tx, dtype=np.uint64), count)[:count]
+    return tx_pubkeys, points[::-1].copy(), indices
+
+
+def test_subaddress_spend_public_keys(keyring):
+    keys = keyring.get_subaddress_spend_public_keys(0, 0, 9)
+    assert keys.shape == (10, 32)
+    assert keys.dtype == np.uint8
+    assert bytes(keys[0]).hex() == KEYS[0][1]
+    assert len({bytes(k) for k in keys}) == 10
+    # A range is the same keys as the whole
+    assert (keyring.get_subaddress_spend_public_keys(0, 4, 6) == keys[4:7]).all()
+
+
+def test_scan_outputs(keyring):
+    tx_pubkeys, output_keys, indices = others_outputs(100)
+    found = keyring.scan_outputs(tx_pubkeys, output_keys, indices)
+    assert found.shape == (100, 2)
+    assert (found == -1).all()
+
+    with pytest.raises(ValueError):
+        keyring.scan_outputs(tx_pubkeys, output_keys[:10], indices)
+    with pytest.raises(ValueError):
+        keyring.scan_outputs(tx_pubkeys.reshape(-1), output_keys, indices)
+
+
+def test_scan_outputs_while_expanding():
+    # Both calls release the GIL, so a keyring shared between threads gets its subaddresses
+    # expanded (and its lookup table rehashed) while outputs are being looked up in it
+    keys = make_keyring(0)
+    keys.expand_subaddresses(1, 10)
+    tx_pubkeys, output_keys, indices = others_outputs(2000)
+    scans = []
+
+    def scan():
+        for _ in range(20):
+            scans.append(keys.scan_outputs(tx_pubkeys, output_keys, indices))
+
+    def expand():
+        for minor in range(20, 420, 20):
+            keys.expand_subaddresses(2, minor)
+
+    threads = [threading.Thread(target=scan), threading.Thread(target=expand)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    assert len(scans) == 20
+    assert all((found == -1).all() for found in scans)
+
+
+@pytest.mark.parametrize("count", [1000, 10000])
+def test_bench_scan_outputs(benchmark, keyring, count):
+    tx_pubkeys, output_keys, indices = others_outputs(count)
+    found = benchmark(keyring.scan_outputs, tx_pubkeys, output_keys, indices)
+    assert found.shape == (count, 2)
+
+
+@pytest.mark.parametrize("count", [100, 1000])
+def test_bench_subaddress_spend_public_keys(benchmark, keyring, count):
+    keys = benchmark(keyring.get_subaddress_spend_public_keys, 1, 0, count - 1)
+    assert keys.shape == (count, 32)
@@ -1,12 +1,101 @@
 #include "wallet3/keyring.hpp"
 
 #include <common/hex.h>
+#include <common/threadpool.h>
 #include <crypto/crypto.h>
 #include <cryptonote_basic/cryptonote_basic.h>
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "../common.hpp"
 
 namespace wallet {
+
+namespace {
+    using key_array = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>;
+    using index_array = py::array_t<uint64_t, py::array::c_style | py::array::forcecast>;
+
+    // The keys in an array of shape (n, 32)
+    const crypto::public_key* keys_in(const key_array& keys, const char* name, size_t& count) {
+        if (keys.ndim() != 2 || keys.shape(1) != sizeof(crypto::public_key))
+            throw std::invalid_argument{std::string{name} + " must be an array of shape (n, 32)"};
+        count = keys.shape(0);
+        return reinterpret_cast<const crypto::public_key*>(keys.data());
+    }
+
+    // For each output: the subaddress (major, minor) it was sent to, or (-1, -1) if it isn't
+    // ours, out of the subaddresses the keyring has been expanded to.  Outputs of the same
+    // transaction are expected to be next to each other, so that the derivation is only worked out
+    // once per transaction.
+    py::array_t<int64_t> scan_outputs(
+            Keyring& keys,
+            const key_array& tx_pubkeys,
+            const key_array& output_keys,
+            const index_array& output_indices) {
+        size_t count, pubkey_count;
+        const auto* tx_keys = keys_in(tx_pubkeys, "tx_pubkeys", pubkey_count);
+        const auto* out_keys = keys_in(output_keys, "output_keys", count);
+        if (pubkey_count != count || output_indices.ndim() != 1 ||
+            static_cast<size_t>(output_indices.shape(0)) != count)
+            throw std::invalid_argument{
+                    "tx_pubkeys, output_keys and output_indices must have the same length"};
+        const uint64_t* indices = output_indices.data();
+
+        py::array_t<int64_t> result({count, size_t{2}});
+        int64_t* out = result.mutable_data();
+        {
+            py::gil_scoped_release release;
+            auto scan = [&](size_t begin, size_t end) {
+                crypto::key_derivation derivation;
+                for (size_t i = begin; i < end; ++i) {
+                    if (i == begin || tx_keys[i] != tx_keys[i - 1])
+                        derivation = keys.generate_key_derivation(tx_keys[i]);
+                    auto index = keys.output_and_derivation_ours(
+                            derivation, out_keys[i], indices[i]);
+                    out[2 * i] = index ? int64_t{index->major} : -1;
+                    out[2 * i + 1] = index ? int64_t{index->minor} : -1;
+                }
+            };
+
+            auto& tpool = tools::threadpool::getInstance();
+            const size_t chunk = std::max<size_t>(
+                    64, (count + tpool.get_max_concurrency() - 1) / tpool.get_max_concurrency());
+            if (count <= chunk) {
+                scan(0, count);
+            } else {
+                tools::threadpool::waiter waiter;
+                for (size_t begin = 0; begin < count; begin += chunk)
+                    tpool.submit(
+                            &waiter,
+                            [&scan, begin, end = std::min(count, begin + chunk)] {
+                                scan(begin, end);
+                            },
+                            true);
+                waiter.wait(&tpool);
+            }
+        }
+        return result;
+    }
+
+    // The spend public keys of subaddresses {account, begin} to {account, end}, as an array of
+    // shape (end - begin + 1, 32)
+    py::array_t<uint8_t> subaddress_spend_public_keys(
+            Keyring& keys, uint32_t account, uint32_t begin, uint32_t end) {
+        std::vector<crypto::public_key> pkeys;
+        {
+            py::gil_scoped_release release;
+            pkeys = keys.get_subaddress_spend_public_keys(account, begin, end);
+        }
+        py::array_t<uint8_t> result({pkeys.size(), sizeof(crypto::public_key)});
+        std::copy_n(
+                reinterpret_cast<const uint8_t*>(pkeys.data()),
+                pkeys.size() * sizeof(crypto::public_key),
+                result.mutable_data());
+        return result;
+    }
+}  // namespace
+
 void Keyring_Init(py::module& mod) {
     py::class_<Keyring, std::shared_ptr<Keyring>>(mod, "Keyring")
             .def(py::init([](std::string ssk,
@@ -27,10 +116,30 @@ void Keyring_Init(py::module& mod) {
                 tools::hex_to_type<crypto::public_key>(spk, spend_pub);
                 tools::hex_to_type<crypto::secret_key>(vsk, view_priv);
                 tools::hex_to_type<crypto::public_key>(vpk, view_pub);
-                return Keyring(spend_priv, spend_pub, view_priv, view_pub, std::move(type));
+                return std::make_shared<Keyring>(
+                        spend_priv, spend_pub, view_priv, view_pub, std::move(type));
             }))
 
-            .def("get_main_address", &Keyring::get_main_address);
+            .def("get_main_address",
+                 &Keyring::get_main_address,
+                 py::call_guard<py::gil_scoped_release>())
+            .def("expand_subaddresses",
+                 [](Keyring& keys, uint32_t major, uint32_t minor) {
+                     keys.expand_subaddresses({major, minor});
+                 },
+                 py::arg("major"),
+                 py::arg("minor"),
+                 py::call_guard<py::gil_scoped_release>())
+            .def("get_subaddress_spend_public_keys",
+                 &subaddress_spend_public_keys,
+                 py::arg("account"),
+                 py::arg("begin"),
+                 py::arg("end"))
+            .def("scan_outputs",
+                 &scan_outputs,
+                 py::arg("tx_pubkeys"),
+                 py::arg("output_keys"),
+                 py::arg("output_indices"));
 }
 
 }  // namespace wallet
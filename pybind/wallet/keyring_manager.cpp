@@ -18,7 +18,8 @@ void KeyringManager_Init(py::module& mod) {
             }))
 
             .def("generate_keyring_from_electrum_seed",
-                 &KeyringManager::generate_keyring_from_electrum_seed);
+                 &KeyringManager::generate_keyring_from_electrum_seed,
+                 py::call_guard<py::gil_scoped_release>());
 }
 
 }  // namespace wallet
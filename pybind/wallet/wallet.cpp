@@ -30,6 +30,9 @@ void Wallet_Init(py::module& mod) {
             .def(py::init([](const std::string& wallet_name,
                              std::shared_ptr<Keyring> keyring,
                              Config config) {
+                // Only the wallet setup runs without the GIL; pybind needs it back to set up the
+                // holder and register the new instance once we return.
+                py::gil_scoped_release release;
                 auto& comms_config = config.daemon;
                 auto& omq_rpc_config = config.omq_rpc;
                 auto oxenmq = std::make_shared<oxenmq::OxenMQ>(omq_logger, oxenmq::LogLevel::info);
@@ -43,8 +46,25 @@ void Wallet_Init(py::module& mod) {
                         "",
                         std::move(config));
             }))
-            .def("get_balance", &Wallet::get_balance)
-            .def("deregister", &Wallet::deregister);
+            .def("get_balance", &Wallet::get_balance, py::call_guard<py::gil_scoped_release>())
+            .def("get_unlocked_balance",
+                 &Wallet::get_unlocked_balance,
+                 py::call_guard<py::gil_scoped_release>())
+            .def("deregister", &Wallet::deregister, py::call_guard<py::gil_scoped_release>());
+
+    // The (balance, unlocked balance) of each of the wallets, as an array of shape (n, 2)
+    mod.def("get_balances", [](const std::vector<std::shared_ptr<Wallet>>& wallets) {
+        py::array_t<uint64_t> result({wallets.size(), size_t{2}});
+        uint64_t* out = result.mutable_data();
+        {
+            py::gil_scoped_release release;
+            for (size_t i = 0; i < wallets.size(); ++i) {
+                out[2 * i] = wallets[i]->get_balance();
+                out[2 * i + 1] = wallets[i]->get_unlocked_balance();
+            }
+        }
+        return result;
+    });
 }
 
 }  // namespace wallet
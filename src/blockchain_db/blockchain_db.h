@@ -145,6 +145,20 @@ struct alt_block_data_t {
     uint8_t checkpointed;
 };
 
+/**
+ * @brief the per-block metadata stored alongside each block
+ */
+struct block_info_t {
+    uint64_t height;
+    uint64_t timestamp;
+    uint64_t already_generated_coins;
+    uint64_t weight;
+    uint64_t long_term_weight;
+    difficulty_type cumulative_difficulty;
+    difficulty_type difficulty;  //!< cumulative difficulty less that of the previous block
+    crypto::hash hash;
+};
+
 /**
  * @brief a struct containing txpool per transaction metadata
  */
@@ -1060,6 +1074,24 @@ class BlockchainDB {
     virtual std::vector<uint64_t> get_long_term_block_weights(
             uint64_t start_height, size_t count) const = 0;
 
+    /**
+     * @brief fetch the metadata of a range of blocks
+     *
+     * The subclass should return the hash, timestamp, weights, generated coins and (cumulative)
+     * difficulty of each block with heights starting at h1 and ending at h2, inclusively.  This is
+     * the same data returned by get_block_weight(), get_block_cumulative_difficulty(), etc., but
+     * gathered in a single pass rather than with separate lookups for every field of every block.
+     *
+     * If the height range requested goes past the end of the blockchain,
+     * the subclass should throw BLOCK_DNE.
+     *
+     * @param h1 the start height
+     * @param h2 the end height
+     *
+     * @return the block metadata, in height order
+     */
+    virtual std::vector<block_info_t> get_block_info_range(uint64_t h1, uint64_t h2) const = 0;
+
     /**
      * @brief fetch a block's hash
      *
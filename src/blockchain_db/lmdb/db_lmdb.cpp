@@ -2936,10 +2936,10 @@ size_t BlockchainLMDB::get_block_weight(const uint64_t& height) const {
     return ret;
 }
 
-std::vector<uint64_t> BlockchainLMDB::get_block_info_64bit_fields(
+void BlockchainLMDB::for_block_info_range(
         uint64_t start_height,
         size_t count,
-        uint64_t (*extract)(const mdb_block_info* bi_data)) const {
+        const std::function<void(const mdb_block_info&)>& f) const {
     log::trace(logcat, "BlockchainLMDB::{}", __func__);
     check_open();
 
@@ -2950,9 +2950,6 @@ std::vector<uint64_t> BlockchainLMDB::get_block_info_64bit_fields(
     if (start_height >= h)
         throw0(DB_ERROR(("Height " + std::to_string(start_height) + " not in blockchain").c_str()));
 
-    std::vector<uint64_t> ret;
-    ret.reserve(count);
-
     MDB_val v;
     uint64_t range_begin = 0, range_end = 0;
     for (uint64_t height = start_height; height < h && count--; ++height) {
@@ -2983,10 +2980,18 @@ std::vector<uint64_t> BlockchainLMDB::get_block_info_64bit_fields(
                         lmdb_error("Error attempting to retrieve block_info from the db: ", result)
                                 .c_str()));
         }
-        ret.push_back(
-                extract(static_cast<const mdb_block_info*>(v.mv_data) + (height - range_begin)));
+        f(static_cast<const mdb_block_info*>(v.mv_data)[height - range_begin]);
     }
+}
 
+std::vector<uint64_t> BlockchainLMDB::get_block_info_64bit_fields(
+        uint64_t start_height,
+        size_t count,
+        uint64_t (*extract)(const mdb_block_info* bi_data)) const {
+    std::vector<uint64_t> ret;
+    ret.reserve(count);
+    for_block_info_range(
+            start_height, count, [&](const mdb_block_info& bi) { ret.push_back(extract(&bi)); });
     return ret;
 }
 
@@ -3049,6 +3054,40 @@ std::vector<uint64_t> BlockchainLMDB::get_long_term_block_weights(
     });
 }
 
+std::vector<block_info_t> BlockchainLMDB::get_block_info_range(uint64_t h1, uint64_t h2) const {
+    log::trace(logcat, "BlockchainLMDB::{}  heights: {}-{}", __func__, h1, h2);
+    check_open();
+
+    if (h2 < h1)
+        return {};
+    if (h2 >= height())
+        throw0(BLOCK_DNE(("Attempt to get block info up to height " + std::to_string(h2) +
+                          " failed -- block not in db")
+                                 .c_str()));
+
+    std::vector<block_info_t> ret;
+    ret.reserve(h2 - h1 + 1);
+    // Start one block early (if there is one) so that we have the previous cumulative difficulty
+    // for the first block's difficulty.
+    const uint64_t start = h1 ? h1 - 1 : 0;
+    difficulty_type prev_cumulative_difficulty = 0;
+    for_block_info_range(start, h2 - start + 1, [&](const mdb_block_info& bi) {
+        if (bi.bi_height >= h1) {
+            auto& info = ret.emplace_back();
+            info.height = bi.bi_height;
+            info.timestamp = bi.bi_timestamp;
+            info.already_generated_coins = bi.bi_coins;
+            info.weight = bi.bi_weight;
+            info.long_term_weight = bi.bi_long_term_block_weight;
+            info.cumulative_difficulty = bi.bi_diff;
+            info.difficulty = bi.bi_diff - prev_cumulative_difficulty;
+            info.hash = bi.bi_hash;
+        }
+        prev_cumulative_difficulty = bi.bi_diff;
+    });
+    return ret;
+}
+
 difficulty_type BlockchainLMDB::get_block_cumulative_difficulty(const uint64_t& height) const {
     log::trace(logcat, "BlockchainLMDB::{}  height: {}", __func__, height);
     check_open();
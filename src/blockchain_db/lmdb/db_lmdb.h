@@ -221,6 +221,8 @@ class BlockchainLMDB : public BlockchainDB {
     std::vector<uint64_t> get_long_term_block_weights(
             uint64_t start_height, size_t count) const override;
 
+    std::vector<block_info_t> get_block_info_range(uint64_t h1, uint64_t h2) const override;
+
     crypto::hash get_block_hash_from_height(const uint64_t& height) const override;
 
     std::vector<block> get_blocks_range(const uint64_t& h1, const uint64_t& h2) const override;
@@ -460,6 +462,11 @@ class BlockchainLMDB : public BlockchainDB {
 
     uint64_t get_database_size() const override;
 
+    void for_block_info_range(
+            uint64_t start_height,
+            size_t count,
+            const std::function<void(const mdb_block_info&)>& f) const;
+
     std::vector<uint64_t> get_block_info_64bit_fields(
             uint64_t start_height, size_t count, uint64_t (*extract)(const mdb_block_info*)) const;
 
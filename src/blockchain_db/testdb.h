@@ -129,6 +129,10 @@ class BaseTestDB : public cryptonote::BlockchainDB {
             uint64_t start_height, size_t count) const override {
         return {};
     }
+    virtual std::vector<cryptonote::block_info_t> get_block_info_range(
+            uint64_t h1, uint64_t h2) const override {
+        return {};
+    }
     virtual crypto::hash get_block_hash_from_height(const uint64_t& height) const override {
         return crypto::hash();
     }
@@ -26,11 +26,19 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <exception>
+#include <limits>
+#include <map>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "blockchain_db/blockchain_db.h"
 #include "blockchain_objects.h"
 #include "common/command_line.h"
 #include "common/fs-format.h"
 #include "common/median.h"
+#include "common/threadpool.h"
 #include "common/varint.h"
 #include "cryptonote_core/cryptonote_core.h"
 #include "cryptonote_core/uptime_proof.h"
@@ -41,6 +49,113 @@ using namespace cryptonote;
 
 static auto logcat = log::Cat("bcutil");
 
+// Finds min depths: how many ring hops back from a transaction the nearest coinbase transaction
+// is.  The transaction that created each ring member comes from the db's output index, rather than
+// from reading and parsing the block it is in, and every depth found is remembered, so that walks
+// from later transactions stop as soon as they reach one.  Safe to use from several threads.
+class depth_finder {
+  public:
+    explicit depth_finder(BlockchainDB& db) : db{db} {}
+
+    // Throws if a transaction is missing or can't be parsed
+    uint64_t depth(const crypto::hash& txid);
+
+  private:
+    struct tx_node {
+        bool coinbase = false;
+        // The transactions that created the ring members of the inputs, without duplicates
+        std::vector<crypto::hash> sources;
+    };
+
+    tx_node load(const crypto::hash& txid) const;
+    std::optional<uint64_t> known(const crypto::hash& txid) const;
+    void remember(const crypto::hash& txid, uint64_t depth);
+
+    BlockchainDB& db;
+    mutable std::shared_mutex mutex;
+    std::unordered_map<crypto::hash, uint64_t> depths;
+};
+
+std::optional<uint64_t> depth_finder::known(const crypto::hash& txid) const {
+    std::shared_lock lock{mutex};
+    if (auto it = depths.find(txid); it != depths.end())
+        return it->second;
+    return std::nullopt;
+}
+
+void depth_finder::remember(const crypto::hash& txid, uint64_t depth) {
+    std::unique_lock lock{mutex};
+    depths.emplace(txid, depth);
+}
+
+depth_finder::tx_node depth_finder::load(const crypto::hash& txid) const {
+    std::string bd;
+    if (!db.get_pruned_tx_blob(txid, bd))
+        throw std::runtime_error{"Failed to get txid {} from db"_format(txid)};
+    cryptonote::transaction tx;
+    if (!cryptonote::parse_and_validate_tx_base_from_blob(bd, tx))
+        throw std::runtime_error{"Bad tx: {}"_format(txid)};
+
+    tx_node node;
+    std::vector<tx_out_index> creators;
+    for (const auto& in : tx.vin) {
+        if (std::holds_alternative<cryptonote::txin_gen>(in)) {
+            node.coinbase = true;
+            return node;
+        }
+        auto* txin = std::get_if<cryptonote::txin_to_key>(&in);
+        if (!txin)
+            throw std::runtime_error{"Bad vin type in txid {}"_format(txid)};
+        db.get_output_tx_and_index(
+                txin->amount,
+                cryptonote::relative_output_offsets_to_absolute(txin->key_offsets),
+                creators);
+        for (const auto& [creator, index] : creators)
+            node.sources.push_back(creator);
+    }
+    std::sort(node.sources.begin(), node.sources.end());
+    node.sources.erase(std::unique(node.sources.begin(), node.sources.end()), node.sources.end());
+    return node;
+}
+
+// Walks back breadth-first, one ring hop at a time, looking at each transaction once.  A
+// transaction whose depth is already known isn't walked past: it bounds the depth by its own plus
+// the hops to it, and the walk stops once no transaction further back could do better.
+uint64_t depth_finder::depth(const crypto::hash& start) {
+    if (auto d = known(start))
+        return *d;
+
+    uint64_t best = std::numeric_limits<uint64_t>::max();
+    std::vector<crypto::hash> txids{start};
+    std::unordered_set<crypto::hash> seen{start};
+    for (uint64_t depth = 0; !txids.empty() && depth < best; ++depth) {
+        log::debug(logcat, "Considering {} transaction(s) at depth {}", txids.size(), depth);
+        std::vector<crypto::hash> new_txids;
+        for (const crypto::hash& txid : txids) {
+            if (auto d = known(txid)) {
+                best = std::min(best, depth + *d);
+                continue;
+            }
+            auto node = load(txid);
+            if (node.coinbase) {
+                log::debug(logcat, "{} is a coinbase transaction", txid);
+                remember(txid, 0);
+                best = std::min(best, depth);
+                break;
+            }
+            for (const auto& source : node.sources)
+                if (seen.insert(source).second)
+                    new_txids.push_back(source);
+        }
+        std::swap(txids, new_txids);
+    }
+    if (best == std::numeric_limits<uint64_t>::max())
+        throw std::runtime_error{"No coinbase transaction found behind txid {}"_format(start)};
+
+    remember(start, best);
+    return best;
+}
+
 int main(int argc, char* argv[]) {
     TRY_ENTRY();
 
@@ -58,6 +173,10 @@ int main(int argc, char* argv[]) {
             "txid", "Get min depth for this txid", ""};
     const command_line::arg_descriptor<uint64_t> arg_height = {
             "height", "Get min depth for all txes at this height", 0};
+    const command_line::arg_descriptor<uint64_t> arg_to_height = {
+            "to-height",
+            "With --height, get min depths for all txes from --height up to this height",
+            0};
     const command_line::arg_descriptor<bool> arg_include_coinbase = {
             "include-coinbase", "Include coinbase in the average", false};
 
@@ -67,6 +186,7 @@ int main(int argc, char* argv[]) {
     command_line::add_arg(desc_cmd_sett, arg_log_level);
     command_line::add_arg(desc_cmd_sett, arg_txid);
     command_line::add_arg(desc_cmd_sett, arg_height);
+    command_line::add_arg(desc_cmd_sett, arg_to_height);
     command_line::add_arg(desc_cmd_sett, arg_include_coinbase);
     command_line::add_arg(desc_cmd_only, command_line::arg_help);
 
@@ -109,12 +229,19 @@ int main(int argc, char* argv[]) {
                                         : network_type::MAINNET;
     std::string opt_txid_string = command_line::get_arg(vm, arg_txid);
     uint64_t opt_height = command_line::get_arg(vm, arg_height);
+    uint64_t opt_to_height = command_line::get_arg(vm, arg_to_height);
     bool opt_include_coinbase = command_line::get_arg(vm, arg_include_coinbase);
 
-    if (!opt_txid_string.empty() && opt_height) {
+    if (!opt_txid_string.empty() && (opt_height || opt_to_height)) {
         std::cerr << "txid and height cannot be given at the same time" << std::endl;
         return 1;
     }
+    if (opt_to_height && opt_to_height < opt_height) {
+        std::cerr << "to-height cannot be below height" << std::endl;
+        return 1;
+    }
+    if (!opt_to_height)
+        opt_to_height = opt_height;
     crypto::hash opt_txid{};
     if (!opt_txid_string.empty()) {
         if (!tools::hex_to_type(opt_txid_string, opt_txid)) {
@@ -148,153 +275,102 @@ int main(int argc, char* argv[]) {
     CHECK_AND_ASSERT_MES(r, 1, "Failed to initialize source blockchain storage");
     log::warning(logcat, "Source blockchain storage initialized OK");
 
-    std::vector<crypto::hash> start_txids;
+    if (opt_txid_string.empty() && opt_to_height >= db->height()) {
+        std::cerr << "Height " << opt_to_height << " is not in the blockchain" << std::endl;
+        return 1;
+    }
+
+    // The transactions to check, by block.  A transaction only spends outputs from earlier
+    // blocks, so going through the blocks in order, the depths of the transactions in each are
+    // found in parallel, and most of their ring members lead straight to depths already known.
+    std::vector<std::vector<crypto::hash>> start_txids;
+    size_t start_count = 0;
     if (!opt_txid_string.empty()) {
-        start_txids.push_back(opt_txid);
+        start_txids.push_back({opt_txid});
     } else {
-        const std::string bd = db->get_block_blob_from_height(opt_height);
-        cryptonote::block b;
-        if (!cryptonote::parse_and_validate_block_from_blob(bd, b)) {
-            log::warning(logcat, "Bad block from db");
-            return 1;
+        for (uint64_t height = opt_height; height <= opt_to_height; ++height) {
+            const std::string bd = db->get_block_blob_from_height(height);
+            cryptonote::block b;
+            if (!cryptonote::parse_and_validate_block_from_blob(bd, b)) {
+                log::warning(logcat, "Bad block from db");
+                return 1;
+            }
+            auto& txids = start_txids.emplace_back(b.tx_hashes);
+            if (opt_include_coinbase)
+                txids.push_back(cryptonote::get_transaction_hash(b.miner_tx));
         }
-        for (const crypto::hash& txid : b.tx_hashes)
-            start_txids.push_back(txid);
-        if (opt_include_coinbase)
-            start_txids.push_back(cryptonote::get_transaction_hash(b.miner_tx));
     }
+    for (const auto& txids : start_txids)
+        start_count += txids.size();
 
-    if (start_txids.empty()) {
+    if (start_count == 0) {
         log::warning(logcat, "No transaction(s) to check");
         return 1;
     }
 
+    depth_finder finder{*db};
+    auto& tpool = tools::threadpool::getInstance();
     std::vector<uint64_t> depths;
-    for (const crypto::hash& start_txid : start_txids) {
-        uint64_t depth = 0;
-        bool coinbase = false;
+    depths.reserve(start_count);
+    for (size_t block = 0; block < start_txids.size(); ++block) {
+        const auto& txids = start_txids[block];
+        std::vector<uint64_t> block_depths(txids.size());
+        std::vector<std::exception_ptr> errors(txids.size());
+        tools::threadpool::waiter waiter;
+        for (size_t i = 0; i < txids.size(); ++i)
+            tpool.submit(
+                    &waiter,
+                    [&, i] {
+                        try {
+                            block_depths[i] = finder.depth(txids[i]);
+                        } catch (...) {
+                            errors[i] = std::current_exception();
+                        }
+                    },
+                    true);
+        waiter.wait(&tpool);
 
-        log::warning(logcat, "Checking depth for txid {}", start_txid);
-        std::vector<crypto::hash> txids(1, start_txid);
-        while (!coinbase) {
-            log::warning(logcat, "Considering {} transaction(s) at depth {}", txids.size(), depth);
-            std::vector<crypto::hash> new_txids;
-            for (const crypto::hash& txid : txids) {
-                std::string bd;
-                if (!db->get_pruned_tx_blob(txid, bd)) {
-                    log::warning(logcat, "Failed to get txid {} from db", txid);
-                    return 1;
-                }
-                cryptonote::transaction tx;
-                if (!cryptonote::parse_and_validate_tx_base_from_blob(bd, tx)) {
-                    log::warning(logcat, "Bad tx: {}", txid);
+        for (size_t i = 0; i < txids.size(); ++i) {
+            if (errors[i]) {
+                try {
+                    std::rethrow_exception(errors[i]);
+                } catch (const std::exception& e) {
+                    log::warning(logcat, "{}", e.what());
                     return 1;
                 }
-                for (size_t ring = 0; ring < tx.vin.size(); ++ring) {
-                    if (std::holds_alternative<cryptonote::txin_gen>(tx.vin[ring])) {
-                        log::debug(logcat, "{} is a coinbase transaction", txid);
-                        coinbase = true;
-                        goto done;
-                    }
-                    if (auto* txin = std::get_if<cryptonote::txin_to_key>(&tx.vin[ring])) {
-                        const uint64_t amount = txin->amount;
-                        auto absolute_offsets =
-                                cryptonote::relative_output_offsets_to_absolute(txin->key_offsets);
-                        for (uint64_t offset : absolute_offsets) {
-                            const output_data_t od = db->get_output_key(amount, offset);
-                            const crypto::hash block_hash =
-                                    db->get_block_hash_from_height(od.height);
-                            bd = db->get_block_blob(block_hash);
-                            cryptonote::block b;
-                            if (!cryptonote::parse_and_validate_block_from_blob(bd, b)) {
-                                log::warning(logcat, "Bad block from db");
-                                return 1;
-                            }
-                            // find the tx which created this output
-                            bool found = false;
-                            for (size_t out = 0; out < b.miner_tx.vout.size(); ++out) {
-                                if (auto* txout = std::get_if<cryptonote::txout_to_key>(
-                                            &b.miner_tx.vout[out].target)) {
-                                    if (txout->key == od.pubkey) {
-                                        found = true;
-                                        new_txids.push_back(
-                                                cryptonote::get_transaction_hash(b.miner_tx));
-                                        log::debug(
-                                                logcat,
-                                                "adding txid: {}",
-                                                cryptonote::get_transaction_hash(b.miner_tx));
-                                        break;
-                                    }
-                                } else {
-                                    log::warning(
-                                            logcat,
-                                            "Bad vout type in txid {}",
-                                            cryptonote::get_transaction_hash(b.miner_tx));
-                                    return 1;
-                                }
-                            }
-                            for (const crypto::hash& block_txid : b.tx_hashes) {
-                                if (found)
-                                    break;
-                                if (!db->get_pruned_tx_blob(block_txid, bd)) {
-                                    log::warning(
-                                            logcat, "Failed to get txid {} from db", block_txid);
-                                    return 1;
-                                }
-                                cryptonote::transaction tx2;
-                                if (!cryptonote::parse_and_validate_tx_base_from_blob(bd, tx2)) {
-                                    log::warning(logcat, "Bad tx: {}", block_txid);
-                                    return 1;
-                                }
-                                for (size_t out = 0; out < tx2.vout.size(); ++out) {
-                                    if (auto* txout = std::get_if<cryptonote::txout_to_key>(
-                                                &tx2.vout[out].target)) {
-                                        if (txout->key == od.pubkey) {
-                                            found = true;
-                                            new_txids.push_back(block_txid);
-                                            log::debug(logcat, "adding txid: {}", block_txid);
-                                            break;
-                                        }
-                                    } else {
-                                        log::warning(
-                                                logcat, "Bad vout type in txid {}", block_txid);
-                                        return 1;
-                                    }
-                                }
-                            }
-                            if (!found) {
-                                log::warning(logcat, "Output originating transaction not found");
-                                return 1;
-                            }
-                        }
-                    } else {
-                        log::warning(logcat, "Bad vin type in txid {}", txid);
-                        return 1;
-                    }
-                }
-            }
-            if (!coinbase) {
-                std::swap(txids, new_txids);
-                ++depth;
             }
+            if (start_txids.size() == 1)
+                log::warning(logcat, "Min depth for txid {}: {}", txids[i], block_depths[i]);
+            else
+                log::info(logcat, "Min depth for txid {}: {}", txids[i], block_depths[i]);
+            depths.push_back(block_depths[i]);
         }
-    done:
-        log::warning(logcat, "Min depth for txid {}: {}", start_txid, depth);
-        depths.push_back(depth);
+        if (start_txids.size() > 1 && (block + 1) % 1000 == 0)
+            log::warning(
+                    logcat,
+                    "Done up to height {}, {} transaction(s)",
+                    opt_height + block,
+                    depths.size());
     }
 
+    std::map<uint64_t, size_t> distribution;
     uint64_t cumulative_depth = 0;
-    for (uint64_t depth : depths)
+    for (uint64_t depth : depths) {
         cumulative_depth += depth;
+        ++distribution[depth];
+    }
+    if (depths.size() > 1)
+        for (const auto& [depth, count] : distribution)
+            log::warning(logcat, "Min depth {}: {} transaction(s)", depth, count);
     log::warning(
             logcat,
             "Average min depth for {} transaction(s): {}",
-            start_txids.size(),
+            depths.size(),
             cumulative_depth / (float)depths.size());
     log::warning(
             logcat,
             "Median min depth for {} transaction(s): {}",
-            start_txids.size(),
+            depths.size(),
             tools::median(std::move(depths)));
 
     core_storage->deinit();
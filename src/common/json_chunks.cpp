@@ -0,0 +1,110 @@
+#include "json_chunks.h"
+
+#include <charconv>
+#include <iterator>
+
+namespace tools {
+
+using namespace std::literals;
+
+void json_chunks::append(std::string_view json_text) {
+    m_size += json_text.size();
+    while (!json_text.empty()) {
+        // The first chunk just grows with what gets appended (most responses are small); once the
+        // body has spilled past it, later chunks are allocated at full size up front.
+        if (m_chunks.empty() && m_sent == 0)
+            m_chunks.emplace_back().reserve(std::min(json_text.size(), CHUNK_SIZE));
+        else if (m_chunks.empty() || m_chunks.back().size() >= CHUNK_SIZE)
+            m_chunks.emplace_back().reserve(CHUNK_SIZE);
+        auto& chunk = m_chunks.back();
+        auto n = std::min(json_text.size(), CHUNK_SIZE - chunk.size());
+        chunk.append(json_text.substr(0, n));
+        json_text.remove_prefix(n);
+        if (m_sink && chunk.size() >= CHUNK_SIZE)
+            flush();
+    }
+}
+
+void json_chunks::flush() {
+    if (!m_sink || m_chunks.empty())
+        return;
+    auto chunk = std::move(m_chunks.back());
+    m_chunks.pop_back();
+    m_sent++;
+    m_sink(std::move(chunk));
+}
+
+void json_chunks::append(char c) {
+    append(std::string_view{&c, 1});
+}
+
+namespace {
+    // True if `s` can be written as a json string by just quoting it, i.e. it is all printable ascii
+    // with nothing that needs escaping.  This is the common case (keys, hex values) and lets us skip
+    // building a temporary copy of the string through dump().
+    bool plain_json_string(std::string_view s) {
+        for (char c : s)
+            if (c < 0x20 || c > 0x7e || c == '"' || c == '\\')
+                return false;
+        return true;
+    }
+}  // namespace
+
+void json_chunks::append_string(std::string_view s) {
+    if (plain_json_string(s)) {
+        append('"');
+        append(s);
+        append('"');
+    } else {
+        append(std::string_view{nlohmann::json(s).dump()});
+    }
+}
+
+void json_chunks::append(const nlohmann::json& j) {
+    // Walk the containers ourselves and only dump() the leaves, so that we never need the whole
+    // serialization of a large object or array in one string.  The punctuation matches what the
+    // compact dump() produces, so the output is identical.
+    if (j.is_object()) {
+        append('{');
+        for (auto it = j.begin(); it != j.end(); ++it) {
+            if (it != j.begin())
+                append(',');
+            append_string(it.key());
+            append(':');
+            append(it.value());
+        }
+        append('}');
+    } else if (j.is_array()) {
+        append('[');
+        for (auto it = j.begin(); it != j.end(); ++it) {
+            if (it != j.begin())
+                append(',');
+            append(*it);
+        }
+        append(']');
+    } else if (j.is_string()) {
+        append_string(j.get_ref<const std::string&>());
+    } else if (j.is_number_unsigned() || j.is_number_integer()) {
+        char buf[24];
+        auto [end, ec] = j.is_number_unsigned()
+                               ? std::to_chars(std::begin(buf), std::end(buf), j.get<uint64_t>())
+                               : std::to_chars(std::begin(buf), std::end(buf), j.get<int64_t>());
+        append(std::string_view{buf, static_cast<size_t>(end - buf)});
+    } else if (j.is_boolean()) {
+        append(j.get<bool>() ? "true"sv : "false"sv);
+    } else if (j.is_null()) {
+        append("null"sv);
+    } else {
+        append(std::string_view{j.dump()});
+    }
+}
+
+std::string json_chunks::str() const {
+    std::string result;
+    result.reserve(m_size);
+    for (const auto& chunk : m_chunks)
+        result += chunk;
+    return result;
+}
+
+}  // namespace tools
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+
+namespace tools {
+
+// Serialized json text split across fixed-size chunks.  Unlike `json.dump()`, which builds one
+// contiguous string (copying everything written so far each time it has to grow), appending here
+// never moves what has already been written, and a network writer can send and release the chunks
+// one at a time rather than needing the whole body in memory at once.
+class json_chunks {
+  public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    json_chunks() = default;
+
+    /// Constructs a json_chunks that hands each chunk off to `sink` as soon as it fills up instead
+    /// of keeping it, so that only the chunk currently being written is held here.  Call flush()
+    /// at the end to hand off the final, partial chunk.  If `sink` throws, the exception propagates
+    /// out of the append() call that filled the chunk.
+    explicit json_chunks(std::function<void(std::string chunk)> sink) : m_sink{std::move(sink)} {}
+
+    /// Appends already-encoded json text (e.g. punctuation or a pre-serialized value).
+    void append(std::string_view json_text);
+    void append(char c);
+
+    /// Appends the compact serialization of `j`; the output is identical to `j.dump()`.
+    void append(const nlohmann::json& j);
+
+    /// Appends `s` as a json string value (i.e. quoted and escaped).
+    void append_string(std::string_view s);
+
+    /// Hands the current, partially filled chunk (if any) to the sink.  Does nothing if this
+    /// json_chunks has no sink.
+    void flush();
+
+    /// Number of chunks that have been handed off to the sink so far.
+    size_t sent() const { return m_sent; }
+
+    /// Total number of bytes appended.
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /// The chunks themselves (not including any already handed to the sink); every chunk but the
+    /// last is exactly CHUNK_SIZE bytes.  Senders may pop chunks off the front as they go (which
+    /// does not update size()).
+    std::deque<std::string>& chunks() { return m_chunks; }
+    const std::deque<std::string>& chunks() const { return m_chunks; }
+
+    /// Concatenates all the chunks into a single string.
+    std::string str() const;
+
+  private:
+    std::deque<std::string> m_chunks;
+    size_t m_size = 0;
+    std::function<void(std::string chunk)> m_sink;
+    size_t m_sent = 0;
+};
+
+}  // namespace tools
@@ -34,6 +34,8 @@
 
 static thread_local int depth = 0;
 static thread_local bool is_leaf = false;
+// The pool whose task this thread is running, if any
+static thread_local const tools::threadpool* current_pool = nullptr;
 
 namespace tools {
 
@@ -82,15 +84,18 @@ void threadpool::create(unsigned int max_threads) {
 void threadpool::submit(waiter* obj, std::function<void()> f, bool leaf) {
     CHECK_AND_ASSERT_THROW_MES(!is_leaf, "A leaf routine is using a thread pool");
     std::unique_lock lock{mutex};
-    if (!leaf && ((active == max && !queue.empty()) || depth > 0)) {
+    if (!leaf && ((active == max && !queue.empty()) || (depth > 0 && current_pool == this))) {
         // if all available threads are already running
         // and there's work waiting, just run in current thread
         lock.unlock();
+        const auto* outer_pool = current_pool;
+        current_pool = this;
         ++depth;
         is_leaf = leaf;
         f();
         --depth;
         is_leaf = false;
+        current_pool = outer_pool;
     } else {
         if (obj)
             obj->inc();
@@ -157,11 +162,14 @@ void threadpool::run(bool flush) {
         e = std::move(queue.front());
         queue.pop_front();
         lock.unlock();
+        const auto* outer_pool = current_pool;
+        current_pool = this;
         ++depth;
         is_leaf = e.leaf;
         e.f();
         --depth;
         is_leaf = false;
+        current_pool = outer_pool;
 
         if (e.wo)
             e.wo->dec();
@@ -31,6 +31,7 @@
 #include <cstddef>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <thread>
@@ -48,6 +49,11 @@ class threadpool {
     static threadpool* getNewForUnitTests(unsigned max_threads = 0) {
         return new threadpool(max_threads);
     }
+    // A pool separate from the global one, for work that shouldn't queue up behind (or hold up)
+    // everything else.  Its tasks can still submit to, and wait on, the global pool.
+    static std::unique_ptr<threadpool> getNewDedicated(unsigned max_threads) {
+        return std::unique_ptr<threadpool>{new threadpool(max_threads)};
+    }
 
     // The waiter lets the caller know when all of its
     // tasks are completed.
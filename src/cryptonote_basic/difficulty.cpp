@@ -139,26 +139,24 @@ difficulty_calc_mode difficulty_mode(cryptonote::network_type nettype, uint64_t
     return result;
 }
 
-difficulty_type next_difficulty_v2(
-        std::vector<std::uint64_t> timestamps,
-        std::vector<difficulty_type> cumulative_difficulties,
+static difficulty_type lwma_next_difficulty(
+        const std::uint64_t* timestamps,
+        const difficulty_type* cumulative_difficulties,
+        size_t count,
         size_t target_seconds,
         difficulty_calc_mode mode) {
     const int64_t T = static_cast<int64_t>(target_seconds);
     size_t N = old::DIFFICULTY_WINDOW;
 
     // Return a difficulty of 1 for first 4 blocks if it's the start of the chain.
-    if (timestamps.size() < 4) {
+    if (count < 4) {
         return 1;
     }
     // Otherwise, use a smaller N if the start of the chain is less than N+1.
-    else if (timestamps.size() - 1 < N) {
-        N = timestamps.size() - 1;
-    } else {
-        // Otherwise make sure timestamps and cumulative_difficulties are correct size.
-        timestamps.resize(N + 1);
-        cumulative_difficulties.resize(N + 1);
+    else if (count - 1 < N) {
+        N = count - 1;
     }
+    // Otherwise only the first N+1 timestamps and cumulative_difficulties are used.
 
     // To get an average solvetime to within +/- ~0.1%, use an adjustment factor.
     // adjust=0.999 for 80 < N < 120(?)
@@ -208,4 +206,52 @@ difficulty_type next_difficulty_v2(
 
     return next_difficulty;
 }
+
+difficulty_type next_difficulty_v2(
+        std::vector<std::uint64_t> timestamps,
+        std::vector<difficulty_type> cumulative_difficulties,
+        size_t target_seconds,
+        difficulty_calc_mode mode) {
+    return lwma_next_difficulty(
+            timestamps.data(),
+            cumulative_difficulties.data(),
+            timestamps.size(),
+            target_seconds,
+            mode);
+}
+
+void difficulty_window::push(
+        uint64_t height, uint64_t timestamp, difficulty_type cumulative_difficulty) {
+    if (height != m_next_height)
+        clear();
+    m_next_height = height + 1;
+    if (height == 0)
+        return;  // The genesis block never counts towards difficulty
+
+    if (m_timestamps.size() == 2 * CAPACITY) {
+        m_timestamps.erase(m_timestamps.begin(), m_timestamps.begin() + CAPACITY);
+        m_cumulative_difficulties.erase(
+                m_cumulative_difficulties.begin(), m_cumulative_difficulties.begin() + CAPACITY);
+    }
+    m_timestamps.push_back(timestamp);
+    m_cumulative_difficulties.push_back(cumulative_difficulty);
+}
+
+difficulty_type difficulty_window::next_difficulty(
+        size_t block_count, size_t target_seconds, difficulty_calc_mode mode) const {
+    const size_t count = std::min(block_count, size());
+    const size_t offset = m_timestamps.size() - count;
+    return lwma_next_difficulty(
+            m_timestamps.data() + offset,
+            m_cumulative_difficulties.data() + offset,
+            count,
+            target_seconds,
+            mode);
+}
+
+void difficulty_window::clear() {
+    m_timestamps.clear();
+    m_cumulative_difficulties.clear();
+    m_next_height = 0;
+}
 }  // namespace cryptonote
@@ -30,6 +30,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -83,4 +84,37 @@ difficulty_type next_difficulty_v2(
         std::vector<difficulty_type> cumulative_difficulties,
         size_t target_second,
         difficulty_calc_mode mode);
+
+// Sliding window over the timestamps and cumulative difficulties of the most recent blocks of a
+// chain (never including the genesis block), large enough for any difficulty window size in use.
+// Advancing it by a block is amortized O(1) and it is cheap to copy, so a chain that forks off a
+// block can start from that block's window instead of rebuilding it from the database.
+class difficulty_window {
+  public:
+    static constexpr size_t CAPACITY =
+            std::max(old::DIFFICULTY_BLOCKS_COUNT(true), old::DIFFICULTY_BLOCKS_COUNT(false));
+
+    // Appends the block at `height`.  If `height` does not directly follow the last block pushed
+    // the window is restarted from this block.
+    void push(uint64_t height, uint64_t timestamp, difficulty_type cumulative_difficulty);
+
+    // Calculates the difficulty of the block following the last one pushed from (up to) the last
+    // `block_count` blocks in the window; the result is identical to calling next_difficulty_v2
+    // with those blocks.
+    difficulty_type next_difficulty(
+            size_t block_count, size_t target_seconds, difficulty_calc_mode mode) const;
+
+    // Height of the block whose difficulty next_difficulty() calculates.
+    uint64_t next_height() const { return m_next_height; }
+
+    size_t size() const { return std::min<size_t>(m_timestamps.size(), CAPACITY); }
+    void clear();
+
+  private:
+    // Holds up to 2*CAPACITY entries and drops the oldest CAPACITY at once when full, so the live
+    // entries stay contiguous for next_difficulty.
+    std::vector<uint64_t> m_timestamps;
+    std::vector<difficulty_type> m_cumulative_difficulties;
+    uint64_t m_next_height = 0;
+};
 }  // namespace cryptonote
@@ -163,6 +163,11 @@ namespace p2p {
     inline constexpr int64_t DEFAULT_LIMIT_RATE_UP = 2048;    // kB/s
     inline constexpr int64_t DEFAULT_LIMIT_RATE_DOWN = 8192;  // kB/s
     inline constexpr auto FAILED_ADDR_FORGET = 1h;
+    // How long an address that just failed is skipped; doubles with each consecutive failure, up
+    // to FAILED_ADDR_FORGET.
+    inline constexpr auto FAILED_ADDR_BACKOFF = 2min;
+    // Maximum number of outgoing connects + handshakes to have running at once
+    inline constexpr size_t MAX_CONCURRENT_OUT_CONNECTS = 8;
     inline constexpr auto IP_BLOCK_TIME = 24h;
     inline constexpr size_t IP_FAILS_BEFORE_BLOCK = 10;
     inline constexpr auto IDLE_CONNECTION_KILL_INTERVAL = 5min;
@@ -1261,70 +1261,82 @@ difficulty_type Blockchain::get_difficulty_for_alternative_chain(
         block_count = old::DIFFICULTY_BLOCKS_COUNT(before_hf16);
     }
 
-    std::vector<uint64_t> timestamps;
-    std::vector<difficulty_type> cumulative_difficulties;
-    // if the alt chain isn't long enough to calculate the difficulty target
-    // based on its blocks alone, need to get more blocks from the main chain
-    if (alt_chain.size() < block_count) {
-        std::unique_lock lock{*this};
-
-        // Figure out start and stop offsets for main chain blocks
-        size_t main_chain_stop_offset =
-                alt_chain.size() ? alt_chain.front().height : alt_block_height;
-        size_t main_chain_count =
-                block_count - std::min(static_cast<size_t>(block_count), alt_chain.size());
-        main_chain_count = std::min(main_chain_count, main_chain_stop_offset);
-        size_t main_chain_start_offset = main_chain_stop_offset - main_chain_count;
+    // The window ends at the alt block's parent: the tip of the alt chain, or the main chain block
+    // it forks from.
+    const crypto::hash parent_hash = alt_chain.size()
+                                           ? cryptonote::get_block_hash(alt_chain.back().bl)
+                                           : get_block_id_by_height(alt_block_height - 1);
+
+    difficulty_window window;
+    bool have_window = false;
+    {
+        std::lock_guard lock{m_cache.m_alt_difficulty_windows_lock};
+        auto& windows = m_cache.m_alt_difficulty_windows;
+        if (auto it = windows.find(parent_hash); it != windows.end()) {
+            window = it->second;
+            have_window = true;
+        } else if (alt_chain.size()) {
+            // Otherwise extend the window of the parent's parent, if we have it
+            const auto& parent = alt_chain.back();
+            if (auto it = windows.find(parent.bl.prev_id);
+                it != windows.end() && it->second.next_height() == parent.height) {
+                window = it->second;
+                window.push(parent.height, parent.bl.timestamp, parent.cumulative_difficulty);
+                have_window = true;
+            }
+        }
+    }
 
-        if (!main_chain_start_offset)
-            ++main_chain_start_offset;  // skip genesis block
+    if (!have_window) {
+        // if the alt chain isn't long enough to fill the window, get more blocks from the main
+        // chain
+        const size_t capacity = difficulty_window::CAPACITY;
+        if (alt_chain.size() < capacity) {
+            std::unique_lock lock{*this};
 
-        // get difficulties and timestamps from relevant main chain blocks
-        for (; main_chain_start_offset < main_chain_stop_offset; ++main_chain_start_offset) {
-            timestamps.push_back(m_db->get_block_timestamp(main_chain_start_offset));
-            cumulative_difficulties.push_back(
-                    m_db->get_block_cumulative_difficulty(main_chain_start_offset));
-        }
+            // Figure out start and stop offsets for main chain blocks
+            size_t main_chain_stop_offset =
+                    alt_chain.size() ? alt_chain.front().height : alt_block_height;
+            size_t main_chain_count = capacity - alt_chain.size();
+            main_chain_count = std::min(main_chain_count, main_chain_stop_offset);
+            size_t main_chain_start_offset = main_chain_stop_offset - main_chain_count;
 
-        // make sure we haven't accidentally grabbed too many blocks...maybe don't need this check?
-        CHECK_AND_ASSERT_MES(
-                (alt_chain.size() + timestamps.size()) <= block_count,
-                false,
-                "Internal error, alt_chain.size()["
-                        << alt_chain.size() << "] + vtimestampsec.size()[" << timestamps.size()
-                        << "] NOT <= DIFFICULTY_WINDOW[]" << block_count);
+            if (!main_chain_start_offset)
+                ++main_chain_start_offset;  // skip genesis block
 
-        for (const auto& bei : alt_chain) {
-            timestamps.push_back(bei.bl.timestamp);
-            cumulative_difficulties.push_back(bei.cumulative_difficulty);
+            // get difficulties and timestamps from relevant main chain blocks
+            for (; main_chain_start_offset < main_chain_stop_offset; ++main_chain_start_offset)
+                window.push(
+                        main_chain_start_offset,
+                        m_db->get_block_timestamp(main_chain_start_offset),
+                        m_db->get_block_cumulative_difficulty(main_chain_start_offset));
         }
+
+        // then the most recent blocks of the alt chain itself
+        auto it = alt_chain.begin();
+        if (alt_chain.size() > capacity)
+            std::advance(it, alt_chain.size() - capacity);
+        for (; it != alt_chain.end(); ++it)
+            window.push(it->height, it->bl.timestamp, it->cumulative_difficulty);
     }
-    // if the alt chain is long enough for the difficulty calc, grab difficulties
-    // and timestamps from it alone
-    else {
-        timestamps.resize(static_cast<size_t>(block_count));
-        cumulative_difficulties.resize(static_cast<size_t>(block_count));
-        size_t count = 0;
-        size_t max_i = timestamps.size() - 1;
-        // get difficulties and timestamps from most recent blocks in alt chain
-        for (auto it = alt_chain.rbegin(); it != alt_chain.rend(); ++it) {
-            const auto& bei = *it;
-            timestamps[max_i - count] = bei.bl.timestamp;
-            cumulative_difficulties[max_i - count] = bei.cumulative_difficulty;
-            count++;
-            if (count >= block_count)
-                break;
-        }
+
+    if (parent_hash) {
+        constexpr size_t MAX_CACHED_WINDOWS = 256;
+        std::lock_guard lock{m_cache.m_alt_difficulty_windows_lock};
+        auto& windows = m_cache.m_alt_difficulty_windows;
+        if (windows.size() >= MAX_CACHED_WINDOWS && !windows.count(parent_hash))
+            windows.erase(std::min_element(
+                    windows.begin(), windows.end(), [](const auto& a, const auto& b) {
+                        return a.second.next_height() < b.second.next_height();
+                    }));
+        windows.insert_or_assign(parent_hash, window);
     }
 
     // calculate the difficulty target for the block and return it
     uint64_t height =
             (alt_chain.size() ? alt_chain.front().height : alt_block_height) + alt_chain.size() + 1;
-    return next_difficulty_v2(
-            timestamps,
-            cumulative_difficulties,
-            tools::to_seconds(TARGET_BLOCK_TIME),
-            difficulty_mode(m_nettype, height));
+    return window.next_difficulty(
+            block_count, tools::to_seconds(TARGET_BLOCK_TIME), difficulty_mode(m_nettype, height));
 }
 //------------------------------------------------------------------
 // This function does a sanity check on basic things that all miner
@@ -2576,98 +2588,155 @@ bool Blockchain::get_blocks(
     return true;
 }
 //------------------------------------------------------------------
-// TODO: This function *looks* like it won't need to be rewritten
-//      to use BlockchainDB, as it calls other functions that were,
-//      but it warrants some looking into later.
-//
-// FIXME: This function appears to want to return false if any transactions
-//       that belong with blocks are missing, but not if blocks themselves
-//       are missing.
-bool Blockchain::handle_get_blocks(
-        NOTIFY_REQUEST_GET_BLOCKS::request& arg, NOTIFY_RESPONSE_GET_BLOCKS::request& rsp) {
-    log::trace(logcat, "Blockchain::{}", __func__);
-    std::unique_lock blockchain_lock{m_blockchain_lock, std::defer_lock};
-    auto blink_lock = m_tx_pool.blink_shared_lock(std::defer_lock);
-    std::lock(blockchain_lock, blink_lock);
-
-    db_rtxn_guard rtxn_guard(m_db);
-    rsp.current_blockchain_height = get_current_blockchain_height();
-    std::vector<std::pair<std::string, block>> blocks;
-    {
-        std::unordered_set<crypto::hash> missed_ids;
-        get_blocks(arg.blocks, blocks, &missed_ids);
-        rsp.missed_ids.insert(rsp.missed_ids.end(), missed_ids.begin(), missed_ids.end());
+Blockchain::get_blocks_status Blockchain::get_block_entry(
+        const crypto::hash& id,
+        block_complete_entry& entry,
+        std::unordered_set<crypto::hash>& missed_txs) const {
+    block blk;
+    uint64_t block_height = 0, chain_height = 0;
+    try {
+        if (!m_db->block_exists(id, &block_height))
+            return get_blocks_status::missed_block;
+        entry.block = m_db->get_block_blob_from_height(block_height);
+        chain_height = m_db->height();
+    } catch (const std::exception& e) {
+        log::error(logcat, "Failed to read block {}: {}", id, e.what());
+        return get_blocks_status::failed;
+    }
+    if (!parse_and_validate_block_from_blob(entry.block, blk)) {
+        log::error(logcat, "Invalid block: {}", id);
+        entry.block.clear();
+        return get_blocks_status::missed_block;
     }
 
-    uint64_t const top_height = (m_db->height() - 1);
+    uint64_t const top_height = chain_height - 1;
     uint64_t const earliest_height_to_sync_checkpoints_granularly =
             (top_height < service_nodes::CHECKPOINT_STORE_PERSISTENTLY_INTERVAL)
                     ? 0
                     : top_height - service_nodes::CHECKPOINT_STORE_PERSISTENTLY_INTERVAL;
+    uint64_t checkpoint_interval = service_nodes::CHECKPOINT_STORE_PERSISTENTLY_INTERVAL;
+    if (block_height >= earliest_height_to_sync_checkpoints_granularly)
+        checkpoint_interval = service_nodes::CHECKPOINT_INTERVAL;
 
-    for (auto& bl : blocks) {
-        auto& block_blob = bl.first;
-        auto& block = bl.second;
+    if ((block_height % checkpoint_interval) == 0) {
+        try {
+            checkpoint_t checkpoint;
+            if (m_checkpoints.get_checkpoint(block_height, checkpoint))
+                entry.checkpoint = t_serializable_object_to_blob(checkpoint);
+        } catch (const std::exception& e) {
+            log::error(
+                    logcat,
+                    "Get block checkpoint from DB failed non-trivially at height: {}, what = {}",
+                    block_height,
+                    e.what());
+            return get_blocks_status::failed;
+        }
+    }
 
-        rsp.blocks.push_back(block_complete_entry());
-        block_complete_entry& block_entry = rsp.blocks.back();
+    entry.txs.reserve(blk.tx_hashes.size());
+    try {
+        for (const auto& h : blk.tx_hashes) {
+            std::string tx;
+            if (m_db->get_tx_blob(h, tx))
+                entry.txs.push_back(std::move(tx));
+            else
+                missed_txs.insert(h);
+        }
+    } catch (const std::exception& e) {
+        log::error(logcat, "Failed to read transactions of block {}: {}", id, e.what());
+        return get_blocks_status::failed;
+    }
 
-        uint64_t const block_height = get_block_height(block);
-        uint64_t checkpoint_interval = service_nodes::CHECKPOINT_STORE_PERSISTENTLY_INTERVAL;
-        if (block_height >= earliest_height_to_sync_checkpoints_granularly)
-            checkpoint_interval = service_nodes::CHECKPOINT_INTERVAL;
+    if (!missed_txs.empty()) {
+        // do not display an error if the peer asked for an unpruned block which we are not
+        // meant to have
+        if (tools::has_unpruned_block(
+                    block_height, chain_height, m_db->get_blockchain_pruning_seed())) {
+            log::error(
+                    logcat,
+                    "Error retrieving blocks, missed {} transactions for block with hash: {}",
+                    missed_txs.size(),
+                    id);
+        }
+        return get_blocks_status::missed_txs;
+    }
 
-        if ((block_height % checkpoint_interval) == 0) {
-            try {
-                checkpoint_t checkpoint;
-                if (get_checkpoint(block_height, checkpoint))
-                    block_entry.checkpoint = t_serializable_object_to_blob(checkpoint);
-            } catch (const std::exception& e) {
-                log::error(
-                        logcat,
-                        "Get block checkpoint from DB failed non-trivially at height: {}, what = "
-                        "{}",
-                        block_height,
-                        e.what());
-                return false;
-            }
+    for (const auto& h : blk.tx_hashes) {
+        if (auto blink = m_tx_pool.get_blink(h)) {
+            auto l = blink->shared_lock();
+            entry.blinks.emplace_back();
+            blink->fill_serialization_data(entry.blinks.back());
         }
+    }
+    return get_blocks_status::found;
+}
+//------------------------------------------------------------------
+bool Blockchain::handle_get_blocks(
+        NOTIFY_REQUEST_GET_BLOCKS::request& arg, NOTIFY_RESPONSE_GET_BLOCKS::request& rsp) {
+    log::trace(logcat, "Blockchain::{}", __func__);
+    auto blink_lock = m_tx_pool.blink_shared_lock();
 
-        // FIXME: s/rsp.missed_ids/missed_tx_id/ ?  Seems like rsp.missed_ids
-        //        is for missed blocks, not missed transactions as well.
-        std::unordered_set<crypto::hash> missed_tx_ids;
-        get_transactions_blobs(block.tx_hashes, block_entry.txs, &missed_tx_ids);
+    rsp.current_blockchain_height = get_current_blockchain_height();
 
-        for (auto& h : block.tx_hashes) {
-            if (auto blink = m_tx_pool.get_blink(h)) {
-                auto l = blink->shared_lock();
-                block_entry.blinks.emplace_back();
-                blink->fill_serialization_data(block_entry.blinks.back());
+    // Filled in place, then the missed blocks are squeezed out, so that the blocks stay in the
+    // order they were asked for
+    const size_t count = arg.blocks.size();
+    rsp.blocks.resize(count);
+    std::vector<get_blocks_status> status(count, get_blocks_status::failed);
+
+    // Ranges of at least a few blocks, so that a small request doesn't pay for a pile of read txns
+    constexpr size_t MIN_BLOCKS_PER_RANGE = 4;
+    auto& tpool = tools::threadpool::getInstance();
+    const size_t ranges = std::max<size_t>(
+            1,
+            std::min<size_t>(
+                    tpool.get_max_concurrency(),
+                    (count + MIN_BLOCKS_PER_RANGE - 1) / MIN_BLOCKS_PER_RANGE));
+    // Each range stops at its first block with missing txs; those are what the peer is told it
+    // missed
+    std::vector<std::unordered_set<crypto::hash>> missed_txs(ranges);
+
+    auto read_range = [&](size_t r) {
+        const size_t begin = count * r / ranges, end = count * (r + 1) / ranges;
+        try {
+            db_rtxn_guard rtxn_guard{m_db};
+            for (size_t i = begin; i < end; i++) {
+                status[i] = get_block_entry(arg.blocks[i], rsp.blocks[i], missed_txs[r]);
+                if (status[i] == get_blocks_status::missed_txs ||
+                    status[i] == get_blocks_status::failed)
+                    break;
             }
+        } catch (const std::exception& e) {
+            log::error(logcat, "Failed to read requested blocks: {}", e.what());
         }
+    };
 
-        if (missed_tx_ids.size() != 0) {
-            // do not display an error if the peer asked for an unpruned block which we are not
-            // meant to have
-            if (tools::has_unpruned_block(
-                        get_block_height(block),
-                        get_current_blockchain_height(),
-                        get_blockchain_pruning_seed())) {
-                log::error(
-                        logcat,
-                        "Error retrieving blocks, missed {} transactions for block with hash: {}",
-                        missed_tx_ids.size(),
-                        get_block_hash(block));
-            }
+    if (ranges == 1)
+        read_range(0);
+    else {
+        tools::threadpool::waiter waiter;
+        for (size_t r = 0; r < ranges; r++)
+            tpool.submit(&waiter, [&read_range, r] { read_range(r); }, true);
+        waiter.wait(&tpool);
+    }
 
-            rsp.missed_ids.insert(rsp.missed_ids.end(), missed_tx_ids.begin(), missed_tx_ids.end());
-            return false;
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        switch (status[i]) {
+            case get_blocks_status::found:
+                if (found != i)
+                    rsp.blocks[found] = std::move(rsp.blocks[i]);
+                found++;
+                break;
+            case get_blocks_status::missed_block: rsp.missed_ids.push_back(arg.blocks[i]); break;
+            case get_blocks_status::missed_txs:
+                for (const auto& r : missed_txs)
+                    rsp.missed_ids.insert(rsp.missed_ids.end(), r.begin(), r.end());
+                return false;
+            case get_blocks_status::failed: return false;
         }
-
-        // pack block
-        block_entry.block = std::move(block_blob);
     }
-
+    rsp.blocks.resize(found);
     return true;
 }
 //------------------------------------------------------------------
@@ -3616,6 +3685,201 @@ bool Blockchain::expand_transaction_2(
     return true;
 }
 //------------------------------------------------------------------
+bool Blockchain::check_tx_rct_signatures(
+        transaction& tx,
+        const crypto::hash& tx_prefix_hash,
+        const std::vector<std::vector<rct::ctkey>>& pubkeys,
+        bool* rct_deferred) {
+    if (!expand_transaction_2(tx, tx_prefix_hash, pubkeys)) {
+        log::error(log::Cat("verify"), "Failed to expand rct signatures!");
+        return false;
+    }
+
+    // from version 2, check ringct signatures
+    // obviously, the original and simple rct APIs use a mixRing that's indexes
+    // in opposite orders, because it'd be too simple otherwise...
+    const rct::rctSig& rv = tx.rct_signatures;
+    switch (rv.type) {
+        case rct::RCTType::Null: {
+            // we only accept no signatures for coinbase txes
+            if (!std::holds_alternative<txin_gen>(tx.vin[0])) {
+                log::error(log::Cat("verify"), "Null rct signature on non-coinbase tx");
+                return false;
+            }
+            break;
+        }
+        case rct::RCTType::Simple:
+        case rct::RCTType::Bulletproof:
+        case rct::RCTType::Bulletproof2:
+        case rct::RCTType::CLSAG: {
+            // check all this, either reconstructed (so should really pass), or not
+            {
+                if (pubkeys.size() != rv.mixRing.size()) {
+                    log::error(
+                            log::Cat("verify"),
+                            "Failed to check ringct signatures: mismatched pubkeys/mixRing "
+                            "size");
+                    return false;
+                }
+                for (size_t i = 0; i < pubkeys.size(); ++i) {
+                    if (pubkeys[i].size() != rv.mixRing[i].size()) {
+                        log::error(
+                                log::Cat("verify"),
+                                "Failed to check ringct signatures: mismatched pubkeys/mixRing "
+                                "size");
+                        return false;
+                    }
+                }
+
+                for (size_t n = 0; n < pubkeys.size(); ++n) {
+                    for (size_t m = 0; m < pubkeys[n].size(); ++m) {
+                        if (pubkeys[n][m].dest != rct::rct2pk(rv.mixRing[n][m].dest)) {
+                            log::error(
+                                    log::Cat("verify"),
+                                    "Failed to check ringct signatures: mismatched pubkey at "
+                                    "vin {}, index {}",
+                                    n,
+                                    m);
+                            return false;
+                        }
+                        if (pubkeys[n][m].mask != rct::rct2pk(rv.mixRing[n][m].mask)) {
+                            log::error(
+                                    log::Cat("verify"),
+                                    "Failed to check ringct signatures: mismatched commitment "
+                                    "at vin {}, index {}",
+                                    n,
+                                    m);
+                            return false;
+                        }
+                    }
+                }
+            }
+
+            const size_t n_sigs =
+                    rv.type == rct::RCTType::CLSAG ? rv.p.CLSAGs.size() : rv.p.MGs.size();
+            if (n_sigs != tx.vin.size()) {
+                log::error(
+                        log::Cat("verify"),
+                        "Failed to check ringct signatures: mismatched MGs/vin sizes");
+                return false;
+            }
+            for (size_t n = 0; n < tx.vin.size(); ++n) {
+                bool error;
+                if (rv.type == rct::RCTType::CLSAG)
+                    error = memcmp(
+                            &var::get<txin_to_key>(tx.vin[n]).k_image, &rv.p.CLSAGs[n].I, 32);
+                else
+                    error = rv.p.MGs[n].II.empty() ||
+                            memcmp(&var::get<txin_to_key>(tx.vin[n]).k_image,
+                                   &rv.p.MGs[n].II[0],
+                                   32);
+                if (error) {
+                    log::error(
+                            log::Cat("verify"),
+                            "Failed to check ringct signatures: mismatched key image");
+                    return false;
+                }
+            }
+
+            if (rct_deferred)
+                *rct_deferred = true;
+            else if (!rct::verRctNonSemanticsSimple(rv)) {
+                log::error(log::Cat("verify"), "Failed to check ringct signatures!");
+                return false;
+            }
+            break;
+        }
+        case rct::RCTType::Full: {
+            // check all this, either reconstructed (so should really pass), or not
+            {
+                bool size_matches = true;
+                for (size_t i = 0; i < pubkeys.size(); ++i)
+                    size_matches &= pubkeys[i].size() == rv.mixRing.size();
+                for (size_t i = 0; i < rv.mixRing.size(); ++i)
+                    size_matches &= pubkeys.size() == rv.mixRing[i].size();
+                if (!size_matches) {
+                    log::error(
+                            log::Cat("verify"),
+                            "Failed to check ringct signatures: mismatched pubkeys/mixRing "
+                            "size");
+                    return false;
+                }
+
+                for (size_t n = 0; n < pubkeys.size(); ++n) {
+                    for (size_t m = 0; m < pubkeys[n].size(); ++m) {
+                        if (pubkeys[n][m].dest != rct::rct2pk(rv.mixRing[m][n].dest)) {
+                            log::error(
+                                    log::Cat("verify"),
+                                    "Failed to check ringct signatures: mismatched pubkey at "
+                                    "vin {}, index {}",
+                                    n,
+                                    m);
+                            return false;
+                        }
+                        if (pubkeys[n][m].mask != rct::rct2pk(rv.mixRing[m][n].mask)) {
+                            log::error(
+                                    log::Cat("verify"),
+                                    "Failed to check ringct signatures: mismatched commitment "
+                                    "at vin {}, index {}",
+                                    n,
+                                    m);
+                            return false;
+                        }
+                    }
+                }
+            }
+
+            if (rv.p.MGs.size() != 1) {
+                log::error(
+                        log::Cat("verify"), "Failed to check ringct signatures: Bad MGs size");
+                return false;
+            }
+            if (rv.p.MGs.empty() || rv.p.MGs[0].II.size() != tx.vin.size()) {
+                log::error(
+                        log::Cat("verify"),
+                        "Failed to check ringct signatures: mismatched II/vin sizes");
+                return false;
+            }
+            for (size_t n = 0; n < tx.vin.size(); ++n) {
+                if (memcmp(&var::get<txin_to_key>(tx.vin[n]).k_image, &rv.p.MGs[0].II[n], 32)) {
+                    log::error(
+                            log::Cat("verify"),
+                            "Failed to check ringct signatures: mismatched II/vin sizes");
+                    return false;
+                }
+            }
+
+            if (!rct::verRct(rv, false)) {
+                log::error(log::Cat("verify"), "Failed to check ringct signatures!");
+                return false;
+            }
+            break;
+        }
+        default:
+            log::error(
+                    log::Cat("verify"), "{}: Unsupported rct type: {}", __func__, (int)rv.type);
+            return false;
+    }
+
+    return true;
+}
+//------------------------------------------------------------------
+std::optional<uint64_t> Blockchain::get_cached_txin_verification(
+        const crypto::hash& txid, hf hf_version) {
+    txin_verification v;
+    {
+        std::lock_guard lock{m_txin_verification_cache_mutex};
+        auto it = m_txin_verification_cache.find(txid);
+        if (it == m_txin_verification_cache.end())
+            return std::nullopt;
+        v = it->second;
+    }
+    if (v.hf_version != hf_version || v.tip_height >= m_db->height() ||
+        m_db->get_block_hash_from_height(v.tip_height) != v.tip)
+        return std::nullopt;
+    return v.max_used_block_height;
+}
+//------------------------------------------------------------------
 // This function validates transaction inputs and their keys.
 // FIXME: consider moving functionality specific to one input into
 //        check_tx_input() rather than here, and use this function simply
@@ -3625,7 +3889,8 @@ bool Blockchain::check_tx_inputs(
         transaction& tx,
         tx_verification_context& tvc,
         uint64_t* pmax_used_block_height,
-        std::unordered_set<crypto::key_image>* key_image_conflicts) {
+        std::unordered_set<crypto::key_image>* key_image_conflicts,
+        bool* rct_deferred) {
     log::trace(logcat, "Blockchain::{}", __func__);
     uint64_t max_used_block_height = 0;
     if (!pmax_used_block_height)
@@ -3674,6 +3939,8 @@ bool Blockchain::check_tx_inputs(
         }
 
         crypto::hash tx_prefix_hash = get_transaction_prefix_hash(tx);
+        const crypto::hash txid = get_transaction_hash(tx);
+        const auto cached_max_used_height = get_cached_txin_verification(txid, hf_version);
 
         std::vector<std::vector<rct::ctkey>> pubkeys(tx.vin.size());
         size_t sig_index = 0;
@@ -3736,8 +4003,9 @@ bool Blockchain::check_tx_inputs(
                 }
 
                 // make sure that output being spent matches up correctly with the
-                // signature spending it.
-                if (!check_tx_input(
+                // signature spending it.  (Skipped if we've already done this for this tx).
+                if (!cached_max_used_height &&
+                    !check_tx_input(
                             in_to_key,
                             tx_prefix_hash,
                             pubkeys[sig_index],
@@ -3793,6 +4061,9 @@ bool Blockchain::check_tx_inputs(
             }
         }
 
+        if (cached_max_used_height)
+            *pmax_used_block_height = *cached_max_used_height;
+
         if (hf_version >= feature::ENFORCE_MIN_AGE) {
             CHECK_AND_ASSERT_MES(
                     *pmax_used_block_height + DEFAULT_TX_SPENDABLE_AGE <= m_db->height(),
@@ -3800,176 +4071,33 @@ bool Blockchain::check_tx_inputs(
                     "Transaction spends at least one output which is too young");
         }
 
-        if (!expand_transaction_2(tx, tx_prefix_hash, pubkeys)) {
-            log::error(log::Cat("verify"), "Failed to expand rct signatures!");
-            return false;
-        }
-
-        // from version 2, check ringct signatures
-        // obviously, the original and simple rct APIs use a mixRing that's indexes
-        // in opposite orders, because it'd be too simple otherwise...
-        const rct::rctSig& rv = tx.rct_signatures;
-        switch (rv.type) {
-            case rct::RCTType::Null: {
-                // we only accept no signatures for coinbase txes
-                if (!std::holds_alternative<txin_gen>(tx.vin[0])) {
-                    log::error(log::Cat("verify"), "Null rct signature on non-coinbase tx");
-                    return false;
-                }
-                break;
-            }
-            case rct::RCTType::Simple:
-            case rct::RCTType::Bulletproof:
-            case rct::RCTType::Bulletproof2:
-            case rct::RCTType::CLSAG: {
-                // check all this, either reconstructed (so should really pass), or not
-                {
-                    if (pubkeys.size() != rv.mixRing.size()) {
-                        log::error(
-                                log::Cat("verify"),
-                                "Failed to check ringct signatures: mismatched pubkeys/mixRing "
-                                "size");
-                        return false;
-                    }
-                    for (size_t i = 0; i < pubkeys.size(); ++i) {
-                        if (pubkeys[i].size() != rv.mixRing[i].size()) {
-                            log::error(
-                                    log::Cat("verify"),
-                                    "Failed to check ringct signatures: mismatched pubkeys/mixRing "
-                                    "size");
-                            return false;
-                        }
-                    }
-
-                    for (size_t n = 0; n < pubkeys.size(); ++n) {
-                        for (size_t m = 0; m < pubkeys[n].size(); ++m) {
-                            if (pubkeys[n][m].dest != rct::rct2pk(rv.mixRing[n][m].dest)) {
-                                log::error(
-                                        log::Cat("verify"),
-                                        "Failed to check ringct signatures: mismatched pubkey at "
-                                        "vin {}, index {}",
-                                        n,
-                                        m);
-                                return false;
-                            }
-                            if (pubkeys[n][m].mask != rct::rct2pk(rv.mixRing[n][m].mask)) {
-                                log::error(
-                                        log::Cat("verify"),
-                                        "Failed to check ringct signatures: mismatched commitment "
-                                        "at vin {}, index {}",
-                                        n,
-                                        m);
-                                return false;
-                            }
-                        }
-                    }
-                }
-
-                const size_t n_sigs =
-                        rv.type == rct::RCTType::CLSAG ? rv.p.CLSAGs.size() : rv.p.MGs.size();
-                if (n_sigs != tx.vin.size()) {
-                    log::error(
-                            log::Cat("verify"),
-                            "Failed to check ringct signatures: mismatched MGs/vin sizes");
-                    return false;
-                }
-                for (size_t n = 0; n < tx.vin.size(); ++n) {
-                    bool error;
-                    if (rv.type == rct::RCTType::CLSAG)
-                        error = memcmp(
-                                &var::get<txin_to_key>(tx.vin[n]).k_image, &rv.p.CLSAGs[n].I, 32);
-                    else
-                        error = rv.p.MGs[n].II.empty() ||
-                                memcmp(&var::get<txin_to_key>(tx.vin[n]).k_image,
-                                       &rv.p.MGs[n].II[0],
-                                       32);
-                    if (error) {
-                        log::error(
-                                log::Cat("verify"),
-                                "Failed to check ringct signatures: mismatched key image");
-                        return false;
-                    }
-                }
-
-                if (!rct::verRctNonSemanticsSimple(rv)) {
-                    log::error(log::Cat("verify"), "Failed to check ringct signatures!");
-                    return false;
-                }
-                break;
-            }
-            case rct::RCTType::Full: {
-                // check all this, either reconstructed (so should really pass), or not
-                {
-                    bool size_matches = true;
-                    for (size_t i = 0; i < pubkeys.size(); ++i)
-                        size_matches &= pubkeys[i].size() == rv.mixRing.size();
-                    for (size_t i = 0; i < rv.mixRing.size(); ++i)
-                        size_matches &= pubkeys.size() == rv.mixRing[i].size();
-                    if (!size_matches) {
-                        log::error(
-                                log::Cat("verify"),
-                                "Failed to check ringct signatures: mismatched pubkeys/mixRing "
-                                "size");
-                        return false;
-                    }
-
-                    for (size_t n = 0; n < pubkeys.size(); ++n) {
-                        for (size_t m = 0; m < pubkeys[n].size(); ++m) {
-                            if (pubkeys[n][m].dest != rct::rct2pk(rv.mixRing[m][n].dest)) {
-                                log::error(
-                                        log::Cat("verify"),
-                                        "Failed to check ringct signatures: mismatched pubkey at "
-                                        "vin {}, index {}",
-                                        n,
-                                        m);
-                                return false;
-                            }
-                            if (pubkeys[n][m].mask != rct::rct2pk(rv.mixRing[m][n].mask)) {
-                                log::error(
-                                        log::Cat("verify"),
-                                        "Failed to check ringct signatures: mismatched commitment "
-                                        "at vin {}, index {}",
-                                        n,
-                                        m);
-                                return false;
-                            }
-                        }
-                    }
-                }
-
-                if (rv.p.MGs.size() != 1) {
-                    log::error(
-                            log::Cat("verify"), "Failed to check ringct signatures: Bad MGs size");
-                    return false;
-                }
-                if (rv.p.MGs.empty() || rv.p.MGs[0].II.size() != tx.vin.size()) {
-                    log::error(
-                            log::Cat("verify"),
-                            "Failed to check ringct signatures: mismatched II/vin sizes");
-                    return false;
-                }
-                for (size_t n = 0; n < tx.vin.size(); ++n) {
-                    if (memcmp(&var::get<txin_to_key>(tx.vin[n]).k_image, &rv.p.MGs[0].II[n], 32)) {
-                        log::error(
-                                log::Cat("verify"),
-                                "Failed to check ringct signatures: mismatched II/vin sizes");
-                        return false;
-                    }
-                }
+        if (cached_max_used_height) {
+            log::trace(
+                    logcat,
+                    "Skipping ring and signature checks of previously verified tx {}",
+                    txid);
+        } else {
+            if (!check_tx_rct_signatures(tx, tx_prefix_hash, pubkeys, rct_deferred))
+                return false;
 
-                if (!rct::verRct(rv, false)) {
-                    log::error(log::Cat("verify"), "Failed to check ringct signatures!");
-                    return false;
-                }
-                break;
+            // Don't cache a deferred result (the signatures haven't actually been checked yet) or a
+            // result that only passed because we were told to collect key image conflicts.
+            if ((!rct_deferred || !*rct_deferred) &&
+                (!key_image_conflicts || key_image_conflicts->empty())) {
+                std::lock_guard lock{m_txin_verification_cache_mutex};
+                if (m_txin_verification_cache.size() >= TXIN_VERIFICATION_CACHE_MAX)
+                    m_txin_verification_cache.clear();
+                const uint64_t tip_height = m_db->height() - 1;
+                m_txin_verification_cache[txid] = {
+                        m_db->get_block_hash_from_height(tip_height),
+                        tip_height,
+                        *pmax_used_block_height,
+                        hf_version};
             }
-            default:
-                log::error(
-                        log::Cat("verify"), "{}: Unsupported rct type: {}", __func__, (int)rv.type);
-                return false;
         }
 
         // for bulletproofs, check they're only multi-output after v8
+        const rct::rctSig& rv = tx.rct_signatures;
         if (rct::is_rct_bulletproof(rv.type) && hf_version < hf::hf10_bulletproofs) {
             for (const rct::Bulletproof& proof : rv.p.bulletproofs) {
                 if (proof.V.size() > 1 && !hack::test_suite_permissive_txes) {
@@ -4830,6 +4958,9 @@ bool Blockchain::handle_block_to_main_chain(
     // XXX old code adds miner tx here
 
     size_t tx_index = 0;
+    // Indices (into txs) of txs whose RingCT signature verification has been deferred so that we
+    // can do them all at once, in parallel, after the serial (db-dependent) checks.
+    std::vector<size_t> rct_deferred_txs;
     // Iterate over the block's transaction hashes, grabbing each
     // from the tx_pool and validating them.  Each is then added
     // to txs.  Keys spent in each are added to <keys> by the double spend check.
@@ -4911,7 +5042,8 @@ bool Blockchain::handle_block_to_main_chain(
         {
             // validate that transaction inputs and the keys spending them are correct.
             tx_verification_context tvc{};
-            if (!check_tx_inputs(tx, tvc)) {
+            bool rct_deferred = false;
+            if (!check_tx_inputs(tx, tvc, nullptr, nullptr, &rct_deferred)) {
                 log::info(
                         logcat,
                         fg(fmt::terminal_color::red),
@@ -4938,6 +5070,8 @@ bool Blockchain::handle_block_to_main_chain(
                 return_tx_to_pool(txs);
                 return false;
             }
+            if (rct_deferred)
+                rct_deferred_txs.push_back(txs.size() - 1);
         }
 #if defined(PER_BLOCK_CHECKPOINT)
         else {
@@ -4969,6 +5103,42 @@ bool Blockchain::handle_block_to_main_chain(
 
     m_blocks_txs_check.clear();
 
+    if (!rct_deferred_txs.empty()) {
+        // Txs that we've already verified (typically when they were added to the mempool) come out
+        // of check_tx_inputs without deferring anything, so this is just the leftover txs that we
+        // are seeing for the first time; verify their signatures in parallel.
+        auto rct_start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> rct_valid(rct_deferred_txs.size(), 0);
+        tools::threadpool& tpool = tools::threadpool::getInstance();
+        tools::threadpool::waiter waiter;
+        for (size_t i = 0; i < rct_deferred_txs.size(); i++)
+            tpool.submit(
+                    &waiter,
+                    [&, i] {
+                        rct_valid[i] = rct::verRctNonSemanticsSimple(
+                                txs[rct_deferred_txs[i]].first.rct_signatures);
+                    },
+                    true);
+        waiter.wait(&tpool);
+
+        for (size_t i = 0; i < rct_deferred_txs.size(); i++) {
+            if (rct_valid[i])
+                continue;
+            log::info(
+                    logcat,
+                    fg(fmt::terminal_color::red),
+                    "Block with id: {} has at least one transaction (id: {}) with invalid ringct "
+                    "signatures",
+                    id,
+                    get_transaction_hash(txs[rct_deferred_txs[i]].first));
+            add_block_as_invalid(bl);
+            bvc.m_verifivation_failed = true;
+            return_tx_to_pool(txs);
+            return false;
+        }
+        t_checktx += std::chrono::steady_clock::now() - rct_start;
+    }
+
     auto vmt = std::chrono::steady_clock::now();
     uint64_t base_reward = 0;
     uint64_t already_generated_coins =
@@ -5191,6 +5361,13 @@ bool Blockchain::handle_block_to_main_chain(
     bvc.m_added_to_main_chain = true;
     ++m_sync_counter;
 
+    {
+        // Mined txs won't be checked again, so drop their cached verification results
+        std::lock_guard lock{m_txin_verification_cache_mutex};
+        for (const auto& txid : bl.tx_hashes)
+            m_txin_verification_cache.erase(txid);
+    }
+
     m_tx_pool.on_blockchain_inc(bl);
     invalidate_block_template_cache();
 
@@ -46,6 +46,8 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/serialization/list.hpp>
 #include <functional>
+#include <mutex>
+#include <optional>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -550,6 +552,11 @@ class Blockchain {
      * the request object encapsulates a list of block hashes.  for each block hash, the block is
      * fetched along with all of that block's transactions.
      *
+     * The blocks are read in contiguous ranges, in parallel on the thread pool, each range in its
+     * own db read txn; the blockchain lock is not taken, so serving blocks to syncing peers
+     * doesn't hold up (or wait on) adding blocks.  Each block and its transactions come from the
+     * same db snapshot; a block popped off the chain since being requested counts as missed.
+     *
      * @param arg the request
      * @param rsp return-by-reference the response to fill in
      *
@@ -1162,6 +1169,25 @@ class Blockchain {
   private:
 #endif
 
+    // How looking up one block of a NOTIFY_REQUEST_GET_BLOCKS went
+    enum class get_blocks_status : uint8_t { found, missed_block, missed_txs, failed };
+
+    /**
+     * @brief reads one requested block, its transactions, checkpoint and blinks for
+     * handle_get_blocks
+     *
+     * Reads in the calling thread's db read txn, without the blockchain lock; the caller must hold
+     * a blink_shared_lock().
+     *
+     * @param id the hash of the block
+     * @param entry return-by-reference the block entry to fill in
+     * @param missed_txs return-by-reference the hashes of any of the block's transactions not found
+     */
+    get_blocks_status get_block_entry(
+            const crypto::hash& id,
+            block_complete_entry& entry,
+            std::unordered_set<crypto::hash>& missed_txs) const;
+
     struct block_pow_verified {
         bool valid;
         bool precomputed;
@@ -1228,6 +1254,21 @@ class Blockchain {
     std::vector<crypto::hash> m_blocks_hash_check;
     std::vector<crypto::hash> m_blocks_txs_check;
 
+    // Results of successful ring membership + RingCT signature checks, keyed by txid.  A result
+    // stays good for as long as the block that was the chain tip when we verified the tx remains in
+    // the main chain (new blocks can only make ring members more unlocked; popping that block could
+    // remove ring members and so invalidates the entry).  This mainly lets block validation skip
+    // redoing work that already happened when the tx was added to the mempool.
+    struct txin_verification {
+        crypto::hash tip;
+        uint64_t tip_height;
+        uint64_t max_used_block_height;
+        hf hf_version;
+    };
+    std::unordered_map<crypto::hash, txin_verification> m_txin_verification_cache;
+    std::mutex m_txin_verification_cache_mutex;
+    static constexpr size_t TXIN_VERIFICATION_CACHE_MAX = 50000;
+
     blockchain_db_sync_mode m_db_sync_mode;
     bool m_fast_sync;
     bool m_show_time_stats;
@@ -1262,6 +1303,12 @@ class Blockchain {
         uint64_t m_timestamps_and_difficulties_height{0};
         crypto::hash m_difficulty_for_next_block_top_hash{};
         difficulty_type m_difficulty_for_next_miner_block{1};
+
+        // NOTE: Difficulty windows ending at recently seen alt chain parents, keyed by that
+        // block's hash, so that extending an alt chain advances its parent's window rather than
+        // re-reading the whole window from the db.
+        mutable std::mutex m_alt_difficulty_windows_lock;
+        mutable std::unordered_map<crypto::hash, difficulty_window> m_alt_difficulty_windows;
     } m_cache;
 
     boost::asio::io_service m_async_service;
@@ -1379,6 +1426,15 @@ class Blockchain {
      * input set
      * @param key_image_conflicts if specified then don't fail on duplicate key images but instead
      * add them here for the caller to decide on
+     * @param rct_deferred if non-null then the (expensive) RingCT signature verification of a
+     * simple rct tx is skipped and *rct_deferred is set to true; the caller is then responsible for
+     * calling rct::verRctNonSemanticsSimple on the (expanded) tx signatures itself.  This lets
+     * block validation verify the signatures of all of a block's txs in parallel.
+     *
+     * Ring membership and RingCT signature results of txs that pass are cached (see
+     * m_txin_verification_cache) so that when the tx shows up again in a block the expensive checks
+     * can be skipped.  The cheap, chain-state dependent checks (spent key images, service node
+     * locks/blacklist, minimum age, etc.) are always re-run.
      *
      * @return false if any validation step fails, otherwise true
      */
@@ -1386,7 +1442,35 @@ class Blockchain {
             transaction& tx,
             tx_verification_context& tvc,
             uint64_t* pmax_used_block_height = nullptr,
-            std::unordered_set<crypto::key_image>* key_image_conflicts = nullptr);
+            std::unordered_set<crypto::key_image>* key_image_conflicts = nullptr,
+            bool* rct_deferred = nullptr);
+
+    /**
+     * @brief expands and verifies the RingCT signatures of a transfer tx
+     *
+     * Called from check_tx_inputs() once the tx's ring members have been loaded into `pubkeys`.
+     *
+     * @param tx the transaction to check; its rct signatures get expanded
+     * @param tx_prefix_hash the tx prefix hash
+     * @param pubkeys the ring member keys/commitments of each input
+     * @param rct_deferred see check_tx_inputs()
+     *
+     * @return false if the signatures are invalid, otherwise true
+     */
+    bool check_tx_rct_signatures(
+            transaction& tx,
+            const crypto::hash& tx_prefix_hash,
+            const std::vector<std::vector<rct::ctkey>>& pubkeys,
+            bool* rct_deferred);
+
+    /**
+     * @brief looks up a previous successful input verification of the given tx
+     *
+     * @return the tx's max used block height if the tx had its inputs verified against a chain
+     * that is still part of the main chain at the current hard fork version; std::nullopt
+     * otherwise.
+     */
+    std::optional<uint64_t> get_cached_txin_verification(const crypto::hash& txid, hf hf_version);
 
     /**
      * @brief performs a blockchain reorganization according to the longest chain rule
@@ -36,6 +36,7 @@
 #include "blockchain.h"
 #include "common/apply_permutation.h"
 #include "common/hex.h"
+#include "common/threadpool.h"
 #include "crypto/crypto.h"
 #include "crypto/hash.h"
 #include "cryptonote_basic/cryptonote_format_utils.h"
@@ -808,13 +809,11 @@ bool construct_tx_with_tx_key(
     struct input_generation_context_data {
         keypair in_ephemeral;
     };
-    std::vector<input_generation_context_data> in_contexts;
+    std::vector<input_generation_context_data> in_contexts(sources.size());
+    std::vector<crypto::key_image> in_images(sources.size());
 
     uint64_t summary_inputs_money = 0;
-    // fill inputs
-    int idx = -1;
     for (const tx_source_entry& src_entr : sources) {
-        ++idx;
         if (src_entr.real_output >= src_entr.outputs.size()) {
             log::error(
                     globallogcat,
@@ -824,26 +823,54 @@ bool construct_tx_with_tx_key(
             return false;
         }
         summary_inputs_money += src_entr.amount;
+    }
 
-        // key_derivation recv_derivation;
-        in_contexts.push_back(input_generation_context_data());
-        keypair& in_ephemeral = in_contexts.back().in_ephemeral;
-        crypto::key_image img;
+    // Each input's ephemeral key and key image is independent of the others, so with the software
+    // device (which keeps no per-call state) we derive them across the threadpool; results land in
+    // per-input slots so the tx is assembled in the same order either way.
+    std::vector<char> key_image_ok(sources.size(), 0);
+    auto generate_input_key_image = [&](size_t i) {
+        const auto& src_entr = sources[i];
         const auto& out_key = reinterpret_cast<const crypto::public_key&>(
                 src_entr.outputs[src_entr.real_output].second.dest);
-        if (!generate_key_image_helper(
-                    sender_account_keys,
-                    subaddresses,
-                    out_key,
-                    src_entr.real_out_tx_key,
-                    src_entr.real_out_additional_tx_keys,
-                    src_entr.real_output_in_tx_index,
-                    in_ephemeral,
-                    img,
-                    hwdev)) {
+        key_image_ok[i] = generate_key_image_helper(
+                sender_account_keys,
+                subaddresses,
+                out_key,
+                src_entr.real_out_tx_key,
+                src_entr.real_out_additional_tx_keys,
+                src_entr.real_output_in_tx_index,
+                in_contexts[i].in_ephemeral,
+                in_images[i],
+                hwdev);
+    };
+    if (sources.size() > 1 && hwdev.get_type() == hw::device::type::SOFTWARE) {
+        tools::threadpool& tpool = tools::threadpool::getInstance();
+        tools::threadpool::waiter waiter;
+        for (size_t i = 0; i < sources.size(); ++i)
+            tpool.submit(&waiter, [&, i] {
+                try {
+                    generate_input_key_image(i);
+                } catch (...) {
+                    key_image_ok[i] = 0;
+                }
+            });
+        waiter.wait(&tpool);
+    } else {
+        for (size_t i = 0; i < sources.size(); ++i)
+            generate_input_key_image(i);
+    }
+
+    // fill inputs
+    int idx = -1;
+    for (const tx_source_entry& src_entr : sources) {
+        ++idx;
+        if (!key_image_ok[idx]) {
             log::error(globallogcat, "Key image generation failed!");
             return false;
         }
+        const keypair& in_ephemeral = in_contexts[idx].in_ephemeral;
+        const crypto::key_image& img = in_images[idx];
 
         // check that derivated key is equal with real output key (if non multisig)
         if (!msout && !(in_ephemeral.pub == src_entr.outputs[src_entr.real_output].second.dest)) {
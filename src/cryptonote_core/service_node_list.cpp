@@ -2580,15 +2580,15 @@ void service_node_list::state_t::update_from_block(
         for (const auto& key_info : active_snode_list)
             existing_swarms[key_info.second->swarm_id].push_back(key_info.first);
 
-        calc_swarm_changes(existing_swarms, seed);
-
         /// Apply changes
-        for (const auto& [swarm_id, snodes] : existing_swarms) {
-            for (const auto& snode : snodes) {
-                auto& sn_info_ptr = service_nodes_infos.at(snode);
-                if (sn_info_ptr->swarm_id == swarm_id)
-                    continue;  /// nothing changed for this snode
-                duplicate_info(sn_info_ptr).swarm_id = swarm_id;
+        if (calc_swarm_changes(existing_swarms, seed)) {
+            for (const auto& [swarm_id, snodes] : existing_swarms) {
+                for (const auto& snode : snodes) {
+                    auto& sn_info_ptr = service_nodes_infos.at(snode);
+                    if (sn_info_ptr->swarm_id == swarm_id)
+                        continue;  /// nothing changed for this snode
+                    duplicate_info(sn_info_ptr).swarm_id = swarm_id;
+                }
             }
         }
     }
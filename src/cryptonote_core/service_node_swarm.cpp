@@ -79,6 +79,9 @@ prod_static size_t calc_threshold(const swarm_snode_map_t& swarm_to_snodes) {
     return threshold;
 };
 
+#ifdef UNIT_TEST
+// The excess pool as a list, as the swarm code used to build it before every pick; see
+// get_excess_pool_size and pick_from_excess_swarms for what it does now.
 prod_static const excess_pool_snode& pick_from_excess_pool(
         const std::vector<excess_pool_snode>& excess_pool, std::mt19937_64& mt) {
     /// Select random snode
@@ -86,14 +89,6 @@ prod_static const excess_pool_snode& pick_from_excess_pool(
     return excess_pool.at(idx);
 }
 
-prod_static void remove_excess_snode_from_swarm(
-        const excess_pool_snode& excess_snode, swarm_snode_map_t& swarm_to_snodes) {
-    auto& swarm_sn_vec = swarm_to_snodes.at(excess_snode.swarm_id);
-    swarm_sn_vec.erase(
-            std::remove(swarm_sn_vec.begin(), swarm_sn_vec.end(), excess_snode.public_key),
-            swarm_sn_vec.end());
-}
-
 prod_static void get_excess_pool(
         size_t threshold,
         const swarm_snode_map_t& swarm_to_snodes,
@@ -118,19 +113,65 @@ prod_static void get_excess_pool(
         }
     }
 }
+#endif
 
-prod_static void create_new_swarm_from_excess(
-        swarm_snode_map_t& swarm_to_snodes, std::mt19937_64& mt) {
-    const bool has_starving_swarms = std::any_of(
+prod_static void remove_excess_snode_from_swarm(
+        const excess_pool_snode& excess_snode, swarm_snode_map_t& swarm_to_snodes) {
+    auto& swarm_sn_vec = swarm_to_snodes.at(excess_snode.swarm_id);
+    swarm_sn_vec.erase(
+            std::remove(swarm_sn_vec.begin(), swarm_sn_vec.end(), excess_snode.public_key),
+            swarm_sn_vec.end());
+}
+
+/// Counts the snodes get_excess_pool would put in the pool, and the excess it would give, without
+/// building the pool.
+prod_static size_t get_excess_pool_size(
+        size_t threshold, const swarm_snode_map_t& swarm_to_snodes, size_t& excess) {
+    if (threshold < MIN_SWARM_SIZE)
+        return 0;
+
+    size_t pool_size = 0;
+    excess = 0;
+    for (const auto& entry : swarm_to_snodes) {
+        if (entry.second.size() > threshold) {
+            excess += entry.second.size() - MIN_SWARM_SIZE;
+            pool_size += entry.second.size();
+        }
+    }
+    return pool_size;
+}
+
+/// Same pick as pick_from_excess_pool on the pool get_excess_pool would build (of `pool_size`
+/// snodes), found by walking the swarms rather than copying every snode in them.
+prod_static excess_pool_snode pick_from_excess_swarms(
+        size_t threshold,
+        const swarm_snode_map_t& swarm_to_snodes,
+        size_t pool_size,
+        std::mt19937_64& mt) {
+    auto idx = tools::uniform_distribution_portable(mt, pool_size);
+    for (const auto& entry : swarm_to_snodes) {
+        if (entry.second.size() <= threshold)
+            continue;
+        if (idx < entry.second.size())
+            return {entry.second[idx], entry.first};
+        idx -= entry.second.size();
+    }
+    throw std::out_of_range{"excess pool index out of range"};
+}
+
+prod_static bool has_starving_swarms(const swarm_snode_map_t& swarm_to_snodes) {
+    return std::any_of(
             swarm_to_snodes.begin(),
             swarm_to_snodes.end(),
             [](const swarm_snode_map_t::value_type& pair) {
                 return pair.second.size() < MIN_SWARM_SIZE;
             });
-    if (has_starving_swarms)
-        return;
+}
 
-    std::vector<excess_pool_snode> pool_snodes;
+prod_static void create_new_swarm_from_excess(
+        swarm_snode_map_t& swarm_to_snodes, std::mt19937_64& mt) {
+    if (has_starving_swarms(swarm_to_snodes))
+        return;
 
     while (calc_excess(swarm_to_snodes) >= calc_threshold(swarm_to_snodes)) {
         log::debug(logcat, "New swarm creation");
@@ -138,12 +179,13 @@ prod_static void create_new_swarm_from_excess(
         new_swarm_snodes.reserve(NEW_SWARM_SIZE);
         while (new_swarm_snodes.size() < NEW_SWARM_SIZE) {
             size_t excess;
-            get_excess_pool(EXCESS_BASE, swarm_to_snodes, pool_snodes, excess);
-            if (pool_snodes.size() == 0) {
+            const size_t pool_size = get_excess_pool_size(EXCESS_BASE, swarm_to_snodes, excess);
+            if (pool_size == 0) {
                 log::error(logcat, "Error while getting excess pool for new swarm creation");
                 return;
             }
-            const auto& random_excess_snode = pick_from_excess_pool(pool_snodes, mt);
+            const auto random_excess_snode =
+                    pick_from_excess_swarms(EXCESS_BASE, swarm_to_snodes, pool_size, mt);
             new_swarm_snodes.push_back(random_excess_snode.public_key);
             remove_excess_snode_from_swarm(random_excess_snode, swarm_to_snodes);
         }
@@ -206,11 +248,23 @@ prod_static void assign_snodes(
     }
 }
 
-void calc_swarm_changes(swarm_snode_map_t& swarm_to_snodes, uint64_t seed) {
+bool calc_swarm_changes(swarm_snode_map_t& swarm_to_snodes, uint64_t seed) {
 
     if (swarm_to_snodes.size() == 0) {
         // nothing to do
-        return;
+        return false;
+    }
+
+    /// With no one to assign, no swarm short of MIN_SWARM_SIZE and not enough excess for a new
+    /// swarm, none of the steps below would do anything: this is the case whenever the only change
+    /// since the last time is snodes leaving swarms that can spare them.
+    if (!swarm_to_snodes.count(UNASSIGNED_SWARM_ID) && !has_starving_swarms(swarm_to_snodes) &&
+        calc_excess(swarm_to_snodes) < calc_threshold(swarm_to_snodes)) {
+        log::trace(
+                logcat,
+                "calc_swarm_changes. swarms: {}, nothing to change",
+                swarm_to_snodes.size());
+        return false;
     }
 
     std::mt19937_64 mersenne_twister(seed);
@@ -261,14 +315,15 @@ void calc_swarm_changes(swarm_snode_map_t& swarm_to_snodes, uint64_t seed) {
                 size_t percentile_value = sorted_swarm_sizes.at(percentile_index).size - 1;
                 percentile_value = std::max(MIN_SWARM_SIZE, percentile_value);
                 size_t excess;
-                std::vector<excess_pool_snode> excess_pool;
-                get_excess_pool(percentile_value, swarm_to_snodes, excess_pool, excess);
+                const size_t pool_size =
+                        get_excess_pool_size(percentile_value, swarm_to_snodes, excess);
                 /// If we can't save the swarm, don't bother continuing
                 const size_t deficit = MIN_SWARM_SIZE - poor_swarm_snodes.size();
                 insufficient_excess = (excess < deficit);
                 if (insufficient_excess)
                     break;
-                const auto& excess_snode = pick_from_excess_pool(excess_pool, mersenne_twister);
+                const auto excess_snode = pick_from_excess_swarms(
+                        percentile_value, swarm_to_snodes, pool_size, mersenne_twister);
                 remove_excess_snode_from_swarm(excess_snode, swarm_to_snodes);
                 /// Add public key to poor swarm
                 poor_swarm_snodes.push_back(excess_snode.public_key);
@@ -321,5 +376,6 @@ void calc_swarm_changes(swarm_snode_map_t& swarm_to_snodes, uint64_t seed) {
     for (const auto& entry : swarm_to_snodes) {
         log::debug(logcat, "{}: {}", entry.first, entry.second.size());
     }
+    return true;
 }
 }  // namespace service_nodes
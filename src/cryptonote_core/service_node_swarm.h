@@ -21,7 +21,9 @@ struct excess_pool_snode {
 
 uint64_t get_new_swarm_id(const swarm_snode_map_t& swarm_to_snodes);
 
-void calc_swarm_changes(swarm_snode_map_t& swarm_to_snodes, uint64_t seed);
+/// Assigns the snodes under UNASSIGNED_SWARM_ID to swarms and rebalances the swarms, as needed.
+/// Returns false if nothing needed doing (so swarm_to_snodes is untouched).
+bool calc_swarm_changes(swarm_snode_map_t& swarm_to_snodes, uint64_t seed);
 
 #ifdef UNIT_TEST
 size_t calc_excess(const swarm_snode_map_t& swarm_to_snodes);
@@ -44,5 +46,13 @@ const excess_pool_snode& pick_from_excess_pool(
         const std::vector<excess_pool_snode>& excess_pool, std::mt19937_64& mt);
 void remove_excess_snode_from_swarm(
         const excess_pool_snode& excess_snode, swarm_snode_map_t& swarm_to_snodes);
+size_t get_excess_pool_size(
+        size_t threshold, const swarm_snode_map_t& swarm_to_snodes, size_t& excess);
+excess_pool_snode pick_from_excess_swarms(
+        size_t threshold,
+        const swarm_snode_map_t& swarm_to_snodes,
+        size_t pool_size,
+        std::mt19937_64& mt);
+bool has_starving_swarms(const swarm_snode_map_t& swarm_to_snodes);
 #endif
 }  // namespace service_nodes
@@ -605,69 +605,97 @@ bool verify_vote_signature(
     return result;
 }
 
-template <typename T>
-static std::vector<pool_vote_entry>* find_vote_in_pool(
-        std::vector<T>& pool, const quorum_vote_t& vote, bool create) {
-    T typed_vote{vote};
-    auto it = std::find(pool.begin(), pool.end(), typed_vote);
-    if (it != pool.end())
-        return &it->votes;
-    if (!create)
-        return nullptr;
-    pool.push_back(std::move(typed_vote));
-    return &pool.back().votes;
+std::vector<pool_vote_entry> voting_pool::vote_group::list() const {
+    std::vector<pool_vote_entry> result;
+    result.reserve(votes.size());
+    for (const auto& [index, entry] : votes)
+        result.push_back(entry);
+    return result;
+}
+
+template <typename Key>
+typename std::map<Key, voting_pool::vote_group>::iterator voting_pool::indexed_pool<Key>::erase(
+        typename std::map<Key, vote_group>::iterator it) {
+    for (auto& [index, entry] : it->second.votes)
+        relay.erase({entry.time_last_sent_p2p, &entry});
+    return groups.erase(it);
+}
+
+template <typename Key>
+void voting_pool::indexed_pool<Key>::cull(uint64_t min_height, uint64_t max_height) {
+    while (!groups.empty() && std::get<0>(groups.begin()->first) < min_height)
+        erase(groups.begin());
+    while (!groups.empty() && std::get<0>(std::prev(groups.end())->first) > max_height)
+        erase(std::prev(groups.end()));
+}
+
+template <typename Map>
+static typename Map::mapped_type* find_group(
+        Map& groups, typename Map::key_type key, bool create) {
+    if (create)
+        return &groups[std::move(key)];
+    auto it = groups.find(key);
+    return it != groups.end() ? &it->second : nullptr;
 }
 
-std::vector<pool_vote_entry>* voting_pool::find_vote_pool(
+std::pair<voting_pool::vote_group*, voting_pool::relay_queue*> voting_pool::find_vote_group(
         const quorum_vote_t& find_vote, bool create_if_not_found) {
     switch (find_vote.type) {
         default:
             log::info(logcat, "Unhandled find_vote type with value: {}", (int)find_vote.type);
             assert("Unhandled find_vote type" == 0);
-            return nullptr;
+            return {nullptr, nullptr};
 
         case quorum_type::obligations:
-            return find_vote_in_pool(m_obligations_pool, find_vote, create_if_not_found);
+            return {find_group(
+                            m_obligations_pool.groups,
+                            obligations_key{
+                                    find_vote.block_height,
+                                    find_vote.state_change.worker_index,
+                                    find_vote.state_change.state},
+                            create_if_not_found),
+                    &m_obligations_pool.relay};
 
         case quorum_type::checkpointing:
-            return find_vote_in_pool(m_checkpoint_pool, find_vote, create_if_not_found);
+            return {find_group(
+                            m_checkpoint_pool.groups,
+                            checkpoint_key{find_vote.block_height, find_vote.checkpoint.block_hash},
+                            create_if_not_found),
+                    &m_checkpoint_pool.relay};
     }
 }
 
 void voting_pool::set_relayed(const std::vector<quorum_vote_t>& votes) {
     std::unique_lock lock{m_lock};
-    const time_t now = time(NULL);
+    const uint64_t now = time(NULL);
 
     for (const quorum_vote_t& find_vote : votes) {
-        std::vector<pool_vote_entry>* vote_pool = find_vote_pool(find_vote);
+        auto [group, relay] = find_vote_group(find_vote);
+        if (!group)
+            continue;
 
-        if (vote_pool)  // We found the group that this vote belongs to
-        {
-            auto vote = std::find_if(
-                    vote_pool->begin(),
-                    vote_pool->end(),
-                    [&find_vote](pool_vote_entry const& entry) {
-                        return (find_vote.index_in_group == entry.vote.index_in_group);
-                    });
-
-            if (vote != vote_pool->end()) {
-                vote->time_last_sent_p2p = now;
-            }
-        }
+        auto it = group->votes.find(find_vote.index_in_group);
+        if (it == group->votes.end())
+            continue;
+
+        pool_vote_entry& entry = it->second;
+        relay->erase({entry.time_last_sent_p2p, &entry});
+        entry.time_last_sent_p2p = now;
+        relay->emplace(entry.time_last_sent_p2p, &entry);
     }
 }
 
-template <typename T>
 static void append_relayable_votes(
         std::vector<quorum_vote_t>& result,
-        const T& pool,
+        const std::set<std::pair<uint64_t, pool_vote_entry*>>& relay,
         const uint64_t max_last_sent,
         uint64_t min_height) {
-    for (const auto& pool_entry : pool)
-        for (const auto& vote_entry : pool_entry.votes)
-            if (vote_entry.vote.block_height >= min_height &&
-                vote_entry.time_last_sent_p2p <= max_last_sent)
-                result.push_back(vote_entry.vote);
+    for (const auto& [last_sent, entry] : relay) {
+        if (last_sent > max_last_sent)
+            break;
+        if (entry->vote.block_height >= min_height)
+            result.push_back(entry->vote);
+    }
 }
 
 std::vector<quorum_vote_t> voting_pool::get_relayable_votes(
@@ -687,49 +715,37 @@ std::vector<quorum_vote_t> voting_pool::get_relayable_votes(
         return result;  // no quorum relaying before HF14
 
     if (hf_version < hf::hf14_blink || quorum_relay)
-        append_relayable_votes(result, m_obligations_pool, max_last_sent, min_height);
+        append_relayable_votes(result, m_obligations_pool.relay, max_last_sent, min_height);
 
     if (hf_version < hf::hf14_blink || !quorum_relay)
-        append_relayable_votes(result, m_checkpoint_pool, max_last_sent, min_height);
+        append_relayable_votes(result, m_checkpoint_pool.relay, max_last_sent, min_height);
 
     return result;
 }
 
-// return: True if the vote was unique
-static bool add_vote_to_pool_if_unique(
-        std::vector<pool_vote_entry>& votes, quorum_vote_t const& vote) {
-    auto vote_it = std::lower_bound(
-            votes.begin(),
-            votes.end(),
-            vote,
-            [](pool_vote_entry const& pool_entry, quorum_vote_t const& vote) {
-                assert(pool_entry.vote.group == vote.group);
-                return pool_entry.vote.index_in_group < vote.index_in_group;
-            });
-
-    if (vote_it == votes.end() || vote_it->vote.index_in_group != vote.index_in_group) {
-        votes.insert(vote_it, {vote});
-        return true;
-    }
-
-    return false;
-}
-
 std::vector<pool_vote_entry> voting_pool::add_pool_vote_if_unique(
         const quorum_vote_t& vote, cryptonote::vote_verification_context& vvc) {
     std::unique_lock lock{m_lock};
-    auto* votes = find_vote_pool(vote, /*create_if_not_found=*/true);
-    if (!votes)
+    auto [group, relay] = find_vote_group(vote, /*create_if_not_found=*/true);
+    if (!group)
         return {};
 
-    vvc.m_added_to_pool = add_vote_to_pool_if_unique(*votes, vote);
-    return *votes;
+    vvc.m_added_to_pool = false;
+    if (vote.index_in_group < MAX_VOTERS && !group->voted[vote.index_in_group]) {
+        group->voted.set(vote.index_in_group);
+        auto& entry = group->votes.emplace(vote.index_in_group, pool_vote_entry{vote, 0})
+                              .first->second;
+        relay->emplace(entry.time_last_sent_p2p, &entry);
+        vvc.m_added_to_pool = true;
+    }
+
+    return group->list();
 }
 
 void voting_pool::remove_used_votes(std::vector<cryptonote::transaction> const& txs, hf version) {
     // TODO(doyle): Cull checkpoint votes
     std::unique_lock lock{m_lock};
-    if (m_obligations_pool.empty())
+    if (m_obligations_pool.groups.empty())
         return;
 
     for (const auto& tx : txs) {
@@ -742,46 +758,27 @@ void voting_pool::remove_used_votes(std::vector<cryptonote::transaction> const&
             continue;
         }
 
-        auto it = std::find(m_obligations_pool.begin(), m_obligations_pool.end(), state_change);
-
-        if (it != m_obligations_pool.end())
+        auto it = m_obligations_pool.groups.find(obligations_key{
+                state_change.block_height, state_change.service_node_index, state_change.state});
+        if (it != m_obligations_pool.groups.end())
             m_obligations_pool.erase(it);
     }
 }
 
-template <typename T>
-static void cull_votes(std::vector<T>& vote_pool, uint64_t min_height, uint64_t max_height) {
-    for (auto it = vote_pool.begin(); it != vote_pool.end();) {
-        const T& pool_entry = *it;
-        if (pool_entry.height < min_height || pool_entry.height > max_height)
-            it = vote_pool.erase(it);
-        else
-            ++it;
-    }
-}
-
 void voting_pool::remove_expired_votes(uint64_t height) {
     std::unique_lock lock{m_lock};
     uint64_t min_height = (height < VOTE_LIFETIME) ? 0 : height - VOTE_LIFETIME;
-    cull_votes(m_obligations_pool, min_height, height);
-    cull_votes(m_checkpoint_pool, min_height, height);
+    m_obligations_pool.cull(min_height, height);
+    m_checkpoint_pool.cull(min_height, height);
 }
 
 bool voting_pool::received_checkpoint_vote(uint64_t height, size_t index_in_quorum) const {
-    auto pool_it = std::find_if(
-            m_checkpoint_pool.begin(),
-            m_checkpoint_pool.end(),
-            [height](checkpoint_pool_entry const& entry) { return entry.height == height; });
-
-    if (pool_it == m_checkpoint_pool.end())
+    std::unique_lock lock{m_lock};
+    auto it = m_checkpoint_pool.groups.lower_bound(checkpoint_key{height, crypto::hash{}});
+    if (it == m_checkpoint_pool.groups.end() || it->first.first != height)
         return false;
 
-    for (auto it = pool_it->votes.begin(); it != pool_it->votes.end(); it++) {
-        if (it->vote.index_in_group == index_in_quorum)
-            return true;
-    }
-
-    return false;
+    return index_in_quorum < MAX_VOTERS && it->second.voted[index_in_quorum];
 }
 
 KV_SERIALIZE_MAP_CODE_BEGIN(quorum_vote_t)
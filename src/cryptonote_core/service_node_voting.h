@@ -28,9 +28,13 @@
 
 #pragma once
 
+#include <bitset>
 #include <boost/serialization/base_object.hpp>
 #include <cassert>
+#include <map>
 #include <mutex>
+#include <set>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -168,42 +172,42 @@ struct voting_pool {
     bool received_checkpoint_vote(uint64_t height, size_t index_in_quorum) const;
 
   private:
-    std::vector<pool_vote_entry>* find_vote_pool(
-            const quorum_vote_t& vote, bool create_if_not_found = false);
+    // Upper bound on quorum sizes we index voters by; votes from higher indices are never pooled.
+    static constexpr size_t MAX_VOTERS = 64;
+
+    // All votes for one (height, subject) in a pool, keyed by the voter's index in the quorum.  The
+    // map nodes never move, which lets the relay queue refer to them directly.
+    struct vote_group {
+        std::map<uint16_t, pool_vote_entry> votes;
+        std::bitset<MAX_VOTERS> voted;
 
-    struct obligations_pool_entry {
-        explicit obligations_pool_entry(const quorum_vote_t& vote) :
-                height{vote.block_height},
-                worker_index{vote.state_change.worker_index},
-                state{vote.state_change.state} {}
-        obligations_pool_entry(const cryptonote::tx_extra_service_node_state_change& sc) :
-                height{sc.block_height}, worker_index{sc.service_node_index}, state{sc.state} {}
-
-        uint64_t height;
-        uint32_t worker_index;
-        new_state state;
-        std::vector<pool_vote_entry> votes;
-
-        bool operator==(const obligations_pool_entry& e) const {
-            return height == e.height && worker_index == e.worker_index && state == e.state;
-        }
+        std::vector<pool_vote_entry> list() const;
     };
-    std::vector<obligations_pool_entry> m_obligations_pool;
-
-    struct checkpoint_pool_entry {
-        explicit checkpoint_pool_entry(const quorum_vote_t& vote) :
-                height{vote.block_height}, hash{vote.checkpoint.block_hash} {}
-        checkpoint_pool_entry(uint64_t height, crypto::hash const& hash) :
-                height(height), hash(hash) {}
-        uint64_t height;
-        crypto::hash hash;
-        std::vector<pool_vote_entry> votes;
-
-        bool operator==(const checkpoint_pool_entry& e) const {
-            return height == e.height && hash == e.hash;
-        }
+
+    // Relay candidates ordered by the time we last sent them over p2p (0 if never), so relay
+    // selection can stop at the first vote sent too recently.
+    using relay_queue = std::set<std::pair<uint64_t, pool_vote_entry*>>;
+
+    template <typename Key>
+    struct indexed_pool {
+        std::map<Key, vote_group> groups;  // Key starts with the height
+        relay_queue relay;
+
+        typename std::map<Key, vote_group>::iterator erase(
+                typename std::map<Key, vote_group>::iterator it);
+        void cull(uint64_t min_height, uint64_t max_height);
     };
-    std::vector<checkpoint_pool_entry> m_checkpoint_pool;
+
+    // (height, worker index, new state)
+    using obligations_key = std::tuple<uint64_t, uint32_t, new_state>;
+    // (height, checkpointed block hash)
+    using checkpoint_key = std::pair<uint64_t, crypto::hash>;
+
+    std::pair<vote_group*, relay_queue*> find_vote_group(
+            const quorum_vote_t& vote, bool create_if_not_found = false);
+
+    indexed_pool<obligations_key> m_obligations_pool;
+    indexed_pool<checkpoint_key> m_checkpoint_pool;
 
     mutable std::recursive_mutex m_lock;
 };
@@ -35,14 +35,19 @@
 #pragma once
 
 #include <boost/circular_buffer.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
 #include "block_queue.h"
 #include "common/meta.h"
 #include "common/periodic_task.h"
+#include "common/threadpool.h"
 #include "cryptonote_basic/connection_context.h"
 #include "cryptonote_protocol_defs.h"
 #include "cryptonote_protocol_handler_common.h"
@@ -129,6 +134,10 @@ class t_cryptonote_protocol_handler : public i_cryptonote_protocol {
             int command,
             NOTIFY_RESPONSE_GET_BLOCKS::request& arg,
             cryptonote_connection_context& context);
+    bool serve_get_blocks(
+            NOTIFY_REQUEST_GET_BLOCKS::request& arg,
+            const epee::net_utils::connection_context_base& context);
+    void serve_queued_get_blocks(const boost::uuids::uuid& connection_id);
     int handle_request_get_txs(
             int command,
             NOTIFY_REQUEST_GET_TXS::request& arg,
@@ -193,7 +202,7 @@ class t_cryptonote_protocol_handler : public i_cryptonote_protocol {
             std::string arg_buff;
             epee::serialization::store_t_to_binary(arg, arg_buff);
             return m_p2p->relay_notify_to_list(
-                    T::ID, epee::strspan<uint8_t>(arg_buff), std::move(connections));
+                    T::ID, epee::shared_sv{std::move(arg_buff)}, std::move(connections));
         }
 
         return true;
@@ -264,8 +273,25 @@ class t_cryptonote_protocol_handler : public i_cryptonote_protocol {
     std::mutex m_buffer_mutex;
     boost::circular_buffer<size_t> m_avg_buffer = boost::circular_buffer<size_t>(10);
 
+    // NOTIFY_REQUEST_GET_BLOCKS waiting to be served, per connection, in the order they came in.
+    // A connection's requests are served one at a time, by a single task on m_get_blocks_pool.
+    struct queued_get_blocks {
+        epee::net_utils::connection_context_base context;
+        NOTIFY_REQUEST_GET_BLOCKS::request request;
+    };
+    std::mutex m_get_blocks_mutex;
+    std::unordered_map<
+            boost::uuids::uuid,
+            std::deque<queued_get_blocks>,
+            boost::hash<boost::uuids::uuid>>
+            m_get_blocks_queue;
+    // Declared last, so that its threads are stopped before anything they use goes away
+    std::unique_ptr<tools::threadpool> m_get_blocks_pool;
+
     template <class t_parameter>
-    bool post_notify(typename t_parameter::request& arg, cryptonote_connection_context& context) {
+    bool post_notify(
+            typename t_parameter::request& arg,
+            const epee::net_utils::connection_context_base& context) {
         log::debug(
                 globallogcat,
                 "[{}] post {} -->",
@@ -273,7 +299,8 @@ class t_cryptonote_protocol_handler : public i_cryptonote_protocol {
                 tools::type_name<t_parameter>());
         std::string blob;
         epee::serialization::store_t_to_binary(arg, blob);
-        return m_p2p->invoke_notify_to_peer(t_parameter::ID, epee::strspan<uint8_t>(blob), context);
+        return m_p2p->invoke_notify_to_peer(
+                t_parameter::ID, epee::shared_sv{std::move(blob)}, context);
     }
 };
 
@@ -71,6 +71,8 @@ namespace cryptonote
   constexpr auto PASSIVE_PEER_KICK_TIME = 1min;
   constexpr auto DROP_ON_SYNC_WEDGE_THRESHOLD = 30s;
   constexpr auto LAST_ACTIVITY_STALL_THRESHOLD = 2s;
+  constexpr unsigned GET_BLOCKS_SERVE_THREADS = 4; // peers served at once; their block reads fan out onto the global thread pool
+  constexpr size_t GET_BLOCKS_MAX_QUEUED = 4; // per connection; a syncing peer only asks for one span at a time
 
   using seconds_f = std::chrono::duration<double>;
 
@@ -99,12 +101,16 @@ namespace cryptonote
 
     m_block_download_max_size = command_line::get_arg(vm, cryptonote::arg_block_download_max_size);
 
+    m_get_blocks_pool = tools::threadpool::getNewDedicated(GET_BLOCKS_SERVE_THREADS);
+
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core>
   bool t_cryptonote_protocol_handler<t_core>::deinit()
   {
+    // Waits for the requests being served; the ones still queued are dropped
+    m_get_blocks_pool.reset();
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
@@ -1102,16 +1108,87 @@ namespace cryptonote
       return 1;
     }
 
+    if (!m_get_blocks_pool)
+    {
+      if (!serve_get_blocks(arg, context))
+        drop_connection(context, false, false);
+      return 1;
+    }
+
+    // Reading and packing up the blocks is left to m_get_blocks_pool, so that the p2p threads get
+    // on with other peers in the meantime
+    bool start = false, too_many = false;
+    {
+      std::lock_guard lock{m_get_blocks_mutex};
+      auto& queue = m_get_blocks_queue[context.m_connection_id];
+      if (queue.size() >= GET_BLOCKS_MAX_QUEUED)
+        too_many = true;
+      else
+      {
+        queue.push_back({context, std::move(arg)});
+        start = queue.size() == 1;
+      }
+    }
+    if (too_many)
+    {
+      log::warning(logcat, "{}Too many NOTIFY_REQUEST_GET_BLOCKS waiting to be served, dropping connection", context);
+      drop_connection(context, false, false);
+      return 1;
+    }
+    if (start)
+      m_get_blocks_pool->submit(nullptr, [this, id = context.m_connection_id] { serve_queued_get_blocks(id); });
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  bool t_cryptonote_protocol_handler<t_core>::serve_get_blocks(NOTIFY_REQUEST_GET_BLOCKS::request& arg, const epee::net_utils::connection_context_base& context)
+  {
     NOTIFY_RESPONSE_GET_BLOCKS::request rsp;
     if(!m_core.get_blockchain_storage().handle_get_blocks(arg, rsp))
     {
       log::error(logcat, "failed to handle request NOTIFY_REQUEST_GET_BLOCKS, dropping connection");
-      drop_connection(context, false, false);
-      return 1;
+      return false;
     }
     log::info(log::Cat("net.p2p.msg"), "-->>NOTIFY_RESPONSE_GET_BLOCKS: blocks.size()={}, rsp.m_current_blockchain_height={}, missed_ids.size()={}", rsp.blocks.size(), rsp.current_blockchain_height, rsp.missed_ids.size());
     post_notify<NOTIFY_RESPONSE_GET_BLOCKS>(rsp, context);
-    return 1;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  void t_cryptonote_protocol_handler<t_core>::serve_queued_get_blocks(const boost::uuids::uuid& connection_id)
+  {
+    // Only this task takes requests off the connection's queue, or removes it, so the queue and
+    // its front stay put while the lock isn't held
+    std::unique_lock lock{m_get_blocks_mutex};
+    auto& queue = m_get_blocks_queue[connection_id];
+    while (!queue.empty())
+    {
+      auto& next = queue.front();
+      lock.unlock();
+      bool ok = true;
+      if (!m_stopping)
+      {
+        try
+        {
+          ok = serve_get_blocks(next.request, next.context);
+        }
+        catch (const std::exception& e)
+        {
+          log::error(logcat, "[{}] Failed to serve NOTIFY_REQUEST_GET_BLOCKS: {}", epee::net_utils::print_connection_context_short(next.context), e.what());
+          ok = false;
+        }
+      }
+      if (!ok)
+      {
+        m_p2p->for_connection(connection_id, [&](cryptonote_connection_context& ctx, nodetool::peerid_type peer_id) {
+          drop_connection(ctx, false, false);
+          return true;
+        });
+      }
+      lock.lock();
+      queue.pop_front();
+    }
+    m_get_blocks_queue.erase(connection_id);
   }
   //------------------------------------------------------------------------------------------------------------------------
 
@@ -2442,7 +2519,7 @@ Use the "help" command to see the list of available commands.
       epee::serialization::store_t_to_binary(arg_without_tx_blobs, fluffyBlob);
     }
 
-    m_p2p->relay_notify_to_list(NOTIFY_NEW_FLUFFY_BLOCK::ID, epee::strspan<uint8_t>(fluffyBlob), std::move(fluffyConnections));
+    m_p2p->relay_notify_to_list(NOTIFY_NEW_FLUFFY_BLOCK::ID, epee::shared_sv{std::move(fluffyBlob)}, std::move(fluffyConnections));
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------
@@ -2618,6 +2695,12 @@ Use the "help" command to see the list of available commands.
     }
 
     m_block_queue.flush_spans(context.m_connection_id, false);
+    {
+      // Nobody to send them to; the one being served (at the front) is finished off regardless
+      std::lock_guard lock{m_get_blocks_mutex};
+      if (auto it = m_get_blocks_queue.find(context.m_connection_id); it != m_get_blocks_queue.end() && !it->second.empty())
+        it->second.erase(std::next(it->second.begin()), it->second.end());
+    }
     log::debug(logcat, "{}[{}] state: {} in state {}", context, epee::string_tools::to_string_hex(context.m_pruning_seed), "closed", cryptonote::get_protocol_state_string(context.m_state));
   }
 
@@ -619,6 +619,8 @@ bool rpc_command_executor::show_status() {
                 info["outgoing_connections_count"].get<int>(),
                 info["incoming_connections_count"].get<int>(),
                 tools::friendly_duration(uptime));
+        if (auto dropped = info.value("dropped_log_messages", uint64_t{0}))
+            msg.append(", {} log messages dropped", dropped);
     }
 
     if (!my_sn_key.empty()) {
@@ -0,0 +1,208 @@
+#include "async_sink.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+namespace oxen::logging {
+
+using namespace std::literals;
+
+static std::atomic<uint64_t> next_sink_id{0};
+
+static size_t round_up_pow2(size_t n) {
+    size_t p = 2;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+async_sink::async_sink(spdlog::sink_ptr downstream, overflow_policy policy, size_t ring_size) :
+        downstream_{std::move(downstream)},
+        policy_{policy},
+        ring_size_{round_up_pow2(ring_size)},
+        id_{++next_sink_id} {
+    thread_ = std::thread{[this] { run(); }};
+}
+
+async_sink::~async_sink() {
+    {
+        std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    wake_cv_.notify_one();
+    thread_.join();
+}
+
+async_sink::ring& async_sink::local_ring() {
+    // A thread's rings, by sink.  The sink holds the other reference to each ring, so a ring whose
+    // sink is gone is only referenced from here and can be dropped.
+    thread_local std::vector<std::pair<uint64_t, std::shared_ptr<ring>>> rings;
+    for (auto& [id, r] : rings)
+        if (id == id_)
+            return *r;
+
+    rings.erase(
+            std::remove_if(
+                    rings.begin(), rings.end(), [](auto& r) { return r.second.use_count() == 1; }),
+            rings.end());
+    auto r = std::make_shared<ring>(ring_size_);
+    {
+        std::lock_guard lock{mutex_};
+        rings_.push_back(r);
+    }
+    return *rings.emplace_back(id_, std::move(r)).second;
+}
+
+void async_sink::wake() {
+    if (!wake_pending_.exchange(true, std::memory_order_relaxed))
+        wake_cv_.notify_one();
+}
+
+void async_sink::log(const spdlog::details::log_msg& msg) {
+    auto& r = local_ring();
+    const size_t mask = r.slots.size() - 1;
+    const bool may_drop = policy_ == overflow_policy::drop && msg.level < spdlog::level::warn;
+
+    const size_t head = r.head.load(std::memory_order_relaxed);
+    while (head - r.tail.load(std::memory_order_acquire) > mask) {
+        if (may_drop) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        wake();
+        std::this_thread::yield();
+    }
+
+    auto& rec = r.slots[head & mask];
+    rec.time = msg.time;
+    rec.source = msg.source;
+    rec.level = msg.level;
+    rec.thread_id = msg.thread_id;
+    rec.logger_name.assign(msg.logger_name.data(), msg.logger_name.size());
+    rec.payload.assign(msg.payload.data(), msg.payload.size());
+    r.head.store(head + 1, std::memory_order_release);
+
+    // Otherwise the writer thread picks it up on its next poll
+    if (msg.level >= spdlog::level::err ||
+        head + 1 - r.tail.load(std::memory_order_relaxed) > r.slots.size() / 2)
+        wake();
+}
+
+void async_sink::flush() {
+    std::unique_lock lock{mutex_};
+    const auto req = ++flush_requested_;
+    wake_cv_.notify_one();
+    flushed_cv_.wait(lock, [&] { return flush_done_ >= req; });
+}
+
+void async_sink::set_pattern(const std::string& pattern) {
+    downstream_->set_pattern(pattern);
+}
+
+void async_sink::set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) {
+    downstream_->set_formatter(std::move(sink_formatter));
+}
+
+size_t async_sink::drain(const std::vector<std::shared_ptr<ring>>& rings) {
+    // Collect everything currently in the rings without releasing it, so that the records can be
+    // written in place, then hand the slots back all at once.
+    claimed_.clear();
+    batch_.clear();
+    for (auto& r : rings) {
+        const size_t tail = r->tail.load(std::memory_order_relaxed);
+        const size_t head = r->head.load(std::memory_order_acquire);
+        if (head == tail)
+            continue;
+        const size_t mask = r->slots.size() - 1;
+        for (size_t i = tail; i != head; i++)
+            batch_.push_back(&r->slots[i & mask]);
+        claimed_.emplace_back(r.get(), head);
+    }
+    if (batch_.empty())
+        return 0;
+
+    // Each ring is already in order; this interleaves the threads
+    std::stable_sort(batch_.begin(), batch_.end(), [](record* a, record* b) {
+        return a->time < b->time;
+    });
+
+    for (auto* rec : batch_) {
+        spdlog::details::log_msg msg{
+                rec->time, rec->source, rec->logger_name, rec->level, rec->payload};
+        msg.thread_id = rec->thread_id;
+        try {
+            downstream_->log(msg);
+        } catch (...) {
+            // Nowhere to report it; keep going so the producers don't fill up and stall.
+        }
+        // Don't let one huge message pin its memory in the slot forever
+        if (rec->payload.capacity() > 4096)
+            std::string{}.swap(rec->payload);
+    }
+
+    for (auto& [r, head] : claimed_)
+        r->tail.store(head, std::memory_order_release);
+    return batch_.size();
+}
+
+void async_sink::run() {
+    std::vector<std::shared_ptr<ring>> rings;
+    uint64_t reported_dropped = 0;
+
+    std::unique_lock lock{mutex_};
+    while (true) {
+        const auto flush_req = flush_requested_;
+        const bool stopping = stop_;
+        rings = rings_;
+        wake_pending_.store(false, std::memory_order_relaxed);
+        lock.unlock();
+
+        const size_t written = drain(rings);
+
+        if (auto dropped = dropped_.load(std::memory_order_relaxed); dropped > reported_dropped) {
+            auto notice = fmt::format(
+                    "{} log messages dropped because the log buffer was full",
+                    dropped - reported_dropped);
+            spdlog::details::log_msg msg{"logging", spdlog::level::warn, notice};
+            try {
+                downstream_->log(msg);
+            } catch (...) {
+            }
+            reported_dropped = dropped;
+        }
+
+        if (flush_req > flush_done_ || stopping) {
+            try {
+                downstream_->flush();
+            } catch (...) {
+            }
+        }
+        rings.clear();
+
+        lock.lock();
+        if (flush_req > flush_done_) {
+            flush_done_ = flush_req;
+            flushed_cv_.notify_all();
+        }
+        // Rings of threads that have exited are only referenced from here; once they're
+        // drained, nothing more can show up in them.
+        rings_.erase(
+                std::remove_if(
+                        rings_.begin(),
+                        rings_.end(),
+                        [](auto& r) {
+                            return r.use_count() == 1 &&
+                                   r->head.load(std::memory_order_acquire) ==
+                                           r->tail.load(std::memory_order_relaxed);
+                        }),
+                rings_.end());
+
+        if (stopping)
+            break;
+        if (!written && flush_requested_ == flush_req && !stop_)
+            wake_cv_.wait_for(lock, 10ms);
+    }
+}
+
+}  // namespace oxen::logging
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <spdlog/sinks/sink.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace oxen::logging {
+
+/// What async_sink does with a message when the logging thread's buffer is full.
+enum class overflow_policy {
+    drop,   ///< count it in dropped() and carry on; warnings and errors still block
+    block,  ///< wait for the writer thread to make room
+};
+
+/// A sink that hands messages to a background thread which writes them to another sink, so that
+/// logging from hot paths costs a copy of the message rather than a mutex, the pattern formatting
+/// and a write syscall.
+///
+/// Each logging thread gets its own single-producer ring buffer of `ring_size` messages, so
+/// threads never contend with each other; the writer thread drains all of them, orders what it
+/// got by timestamp and passes it on to the wrapped sink, which does the formatting.  When a ring
+/// is full the message is dropped or the thread blocks, according to `policy`; dropped messages
+/// are counted, and reported in the log itself once there is room again.
+///
+/// flush() waits until everything logged before it has been written and then flushes the wrapped
+/// sink.
+class async_sink : public spdlog::sinks::sink {
+  public:
+    static constexpr size_t DEFAULT_RING_SIZE = 4096;
+
+    explicit async_sink(
+            spdlog::sink_ptr downstream,
+            overflow_policy policy = overflow_policy::drop,
+            size_t ring_size = DEFAULT_RING_SIZE);
+    ~async_sink() override;
+
+    void log(const spdlog::details::log_msg& msg) override;
+    void flush() override;
+    void set_pattern(const std::string& pattern) override;
+    void set_formatter(std::unique_ptr<spdlog::formatter> sink_formatter) override;
+
+    /// The number of messages dropped so far because a ring buffer was full.
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  private:
+    struct record {
+        spdlog::log_clock::time_point time;
+        spdlog::source_loc source;
+        spdlog::level::level_enum level;
+        size_t thread_id;
+        std::string logger_name;
+        std::string payload;
+    };
+
+    struct ring {
+        explicit ring(size_t size) : slots(size) {}
+        std::vector<record> slots;
+        alignas(64) std::atomic<size_t> head{0};  // next slot to write; only the producer writes it
+        alignas(64) std::atomic<size_t> tail{0};  // next slot to read; only the writer thread writes it
+    };
+
+    ring& local_ring();
+    void wake();
+    void run();
+    size_t drain(const std::vector<std::shared_ptr<ring>>& rings);
+
+    const spdlog::sink_ptr downstream_;
+    const overflow_policy policy_;
+    const size_t ring_size_;
+    const uint64_t id_;
+
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> wake_pending_{false};
+
+    std::mutex mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    std::vector<std::shared_ptr<ring>> rings_;
+    uint64_t flush_requested_ = 0;
+    uint64_t flush_done_ = 0;
+    bool stop_ = false;
+
+    // Only used by the writer thread:
+    std::vector<std::pair<ring*, size_t>> claimed_;
+    std::vector<record*> batch_;
+
+    std::thread thread_;
+};
+
+}  // namespace oxen::logging
@@ -2,12 +2,17 @@
 
 #include <spdlog/sinks/rotating_file_sink.h>
 
+#include "async_sink.h"
+
 #include <filesystem>
 #include <oxen/log.hpp>
 
 namespace oxen::logging {
 static auto logcat = log::Cat("logging");
 
+// The file sink installed by set_file_sink, if any
+static std::weak_ptr<async_sink> file_sink_;
+
 void set_additional_log_categories(log::Level& log_level) {
     switch (log_level) {
         case log::Level::critical: break;
@@ -83,7 +88,11 @@ void set_file_sink(const std::string& log_location) {
         auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
                 log_location, LOG_FILE_SIZE_LIMIT, EXTRA_FILES, rotate_on_open);
 
-        log::add_sink(std::move(file_sink));
+        // Formatting and writing happen on the sink's own thread, so turning up the log level
+        // doesn't slow down whatever is doing the logging.
+        auto sink = std::make_shared<async_sink>(std::move(file_sink));
+        file_sink_ = sink;
+        log::add_sink(std::move(sink));
     } catch (const spdlog::spdlog_ex& ex) {
         log::error(
                 logcat,
@@ -96,6 +105,11 @@ void set_file_sink(const std::string& log_location) {
     log::info(logcat, "Writing logs to {}", log_location);
 }
 
+uint64_t dropped_log_messages() {
+    auto sink = file_sink_.lock();
+    return sink ? sink->dropped() : 0;
+}
+
 using namespace std::literals;
 
 using strlvl = std::pair<std::string_view, log::Level>;
@@ -35,6 +35,9 @@ void set_file_sink(const std::string& log_location);
 void set_additional_log_categories(const log::Level& log_level);
 void process_categories_string(const std::string& categories);
 
+// Number of messages the file sink has dropped because it couldn't keep up
+uint64_t dropped_log_messages();
+
 std::optional<log::Level> parse_level(std::string input);
 std::optional<log::Level> parse_level(uint8_t input);
 std::optional<log::Level> parse_level(oxenmq::LogLevel input);
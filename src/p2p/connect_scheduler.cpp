@@ -0,0 +1,81 @@
+#include "connect_scheduler.h"
+
+#include <algorithm>
+
+namespace nodetool {
+
+connect_scheduler::connect_scheduler(
+        size_t max_in_flight, clock::duration base_backoff, clock::duration max_backoff) :
+        max_in_flight_{std::max<size_t>(max_in_flight, 1)},
+        base_backoff_{base_backoff},
+        max_backoff_{std::max(base_backoff, max_backoff)} {}
+
+connect_scheduler::clock::duration connect_scheduler::backoff(unsigned count) const {
+    auto b = base_backoff_;
+    for (unsigned i = 1; i < count && b < max_backoff_; i++)
+        b *= 2;
+    return std::min(b, max_backoff_);
+}
+
+bool connect_scheduler::backing_off_locked(const std::string& host, clock::time_point now) const {
+    auto it = failures_.find(host);
+    return it != failures_.end() && now - it->second.last < backoff(it->second.count);
+}
+
+void connect_scheduler::record_failure_locked(const std::string& host, clock::time_point now) {
+    auto [it, inserted] = failures_.try_emplace(host, failures{now, 0});
+    auto& f = it->second;
+    if (!inserted && now - f.last > max_backoff_)
+        f.count = 0;
+    f.last = now;
+    f.count++;
+
+    // Drop entries that can no longer affect anything so the map doesn't grow without bound
+    // across a long-running node's lifetime.
+    if (inserted && failures_.size() % 256 == 0) {
+        for (auto i = failures_.begin(); i != failures_.end();) {
+            if (now - i->second.last > max_backoff_)
+                i = failures_.erase(i);
+            else
+                ++i;
+        }
+    }
+}
+
+bool connect_scheduler::try_begin(const std::string& host, clock::time_point now) {
+    std::lock_guard lock{mutex_};
+    if (in_flight_.size() >= max_in_flight_ || backing_off_locked(host, now))
+        return false;
+    return in_flight_.insert(host).second;
+}
+
+void connect_scheduler::finish(const std::string& host, bool success, clock::time_point now) {
+    std::lock_guard lock{mutex_};
+    in_flight_.erase(host);
+    if (success)
+        failures_.erase(host);
+    else
+        record_failure_locked(host, now);
+}
+
+void connect_scheduler::record_failure(const std::string& host, clock::time_point now) {
+    std::lock_guard lock{mutex_};
+    record_failure_locked(host, now);
+}
+
+bool connect_scheduler::backing_off(const std::string& host, clock::time_point now) const {
+    std::lock_guard lock{mutex_};
+    return backing_off_locked(host, now);
+}
+
+size_t connect_scheduler::in_flight() const {
+    std::lock_guard lock{mutex_};
+    return in_flight_.size();
+}
+
+size_t connect_scheduler::free_slots() const {
+    std::lock_guard lock{mutex_};
+    return max_in_flight_ - std::min(max_in_flight_, in_flight_.size());
+}
+
+}  // namespace nodetool
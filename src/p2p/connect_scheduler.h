@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace nodetool {
+
+/// Bookkeeping for the outbound connection attempts made by node_server's connections_maker.
+/// It caps how many connect+handshake attempts are in flight at once, makes sure a host is only
+/// being tried once at a time, and backs off hosts that keep failing: after the n-th consecutive
+/// failure a host is skipped for `base_backoff * 2^(n-1)`, capped at `max_backoff`.  A failure
+/// more than `max_backoff` after the previous one starts the count over.
+///
+/// Hosts are identified by their host string (i.e. without the port), the same way the address
+/// failure cache did.  All methods are thread-safe.
+class connect_scheduler {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    connect_scheduler(
+            size_t max_in_flight, clock::duration base_backoff, clock::duration max_backoff);
+
+    /// Reserves an in-flight slot for an attempt on `host`.  Returns false, reserving nothing,
+    /// if all slots are taken, `host` is already being tried, or `host` is still backing off.
+    /// Every successful call must be paired with a call to finish().
+    bool try_begin(const std::string& host, clock::time_point now = clock::now());
+
+    /// Releases the slot taken by try_begin() and records the outcome of the attempt.
+    void finish(const std::string& host, bool success, clock::time_point now = clock::now());
+
+    /// Records a failed attempt on `host` that was not made through try_begin() (e.g. a
+    /// synchronous connect through a proxy).
+    void record_failure(const std::string& host, clock::time_point now = clock::now());
+
+    /// Returns true if `host` failed recently enough that it should not be tried yet.
+    bool backing_off(const std::string& host, clock::time_point now = clock::now()) const;
+
+    size_t in_flight() const;
+    size_t free_slots() const;
+
+  private:
+    struct failures {
+        clock::time_point last;
+        unsigned count;
+    };
+
+    clock::duration backoff(unsigned count) const;
+    bool backing_off_locked(const std::string& host, clock::time_point now) const;
+    void record_failure_locked(const std::string& host, clock::time_point now);
+
+    const size_t max_in_flight_;
+    const clock::duration base_backoff_;
+    const clock::duration max_backoff_;
+
+    mutable std::mutex mutex_;
+    std::unordered_set<std::string> in_flight_;
+    std::unordered_map<std::string, failures> failures_;
+};
+
+}  // namespace nodetool
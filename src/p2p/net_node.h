@@ -55,6 +55,7 @@
 #include "epee/net/levin_protocol_handler.h"
 #include "epee/net/levin_protocol_handler_async.h"
 #include "epee/storages/levin_abstract_invoke2.h"
+#include "connect_scheduler.h"
 #include "epee/warnings.h"
 #include "net/fwd.h"
 #include "net_node_common.h"
@@ -327,7 +328,7 @@ class node_server
     //----------------- i_p2p_endpoint -------------------------------------------------------------
     virtual bool relay_notify_to_list(
             int command,
-            const epee::span<const uint8_t> data_buff,
+            epee::shared_sv data_buff,
             std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> connections);
     virtual epee::net_utils::zone send_txs(
             std::vector<std::string> txs,
@@ -341,7 +342,7 @@ class node_server
             const epee::net_utils::connection_context_base& context);
     virtual bool invoke_notify_to_peer(
             int command,
-            const epee::span<const uint8_t> req_buff,
+            epee::shared_sv req_buff,
             const epee::net_utils::connection_context_base& context);
     virtual bool drop_connection(const epee::net_utils::connection_context_base& context);
     virtual void request_callback(const epee::net_utils::connection_context_base& context);
@@ -375,6 +376,11 @@ class node_server
     bool peer_sync_idle_maker();
     bool do_handshake_with_peer(
             peerid_type& pi, p2p_connection_context& context, bool just_take_peerlist = false);
+    // Starts a handshake on an established connection without waiting for it; `done(ok,
+    // peer_id, context)` is called exactly once, with the live connection context on success.
+    template <class t_callback>
+    void async_handshake_with_peer(
+            const p2p_connection_context& context, bool just_take_peerlist, t_callback done);
     bool do_peer_timed_sync(
             const epee::net_utils::connection_context_base& context, peerid_type peer_id);
 
@@ -387,6 +393,26 @@ class node_server
             uint64_t last_seen_stamp = 0,
             PeerType peer_type = white,
             uint64_t first_seen_stamp = 0);
+    // Connects to a peer picked from the anchor/white/gray list: asynchronously (returning as
+    // soon as the attempt is started) in zones using direct connections, otherwise through
+    // try_to_connect_and_handshake_with_new_peer.
+    bool connect_to_new_peer(
+            const epee::net_utils::network_address& na,
+            uint64_t last_seen_stamp,
+            PeerType peer_type,
+            uint64_t first_seen_stamp = 0);
+    bool start_connect_and_handshake(
+            network_zone& zone,
+            const epee::net_utils::network_address& na,
+            uint64_t last_seen_stamp,
+            PeerType peer_type,
+            uint64_t first_seen_stamp);
+    void on_new_out_peer(
+            network_zone& zone,
+            const epee::net_utils::network_address& na,
+            peerid_type pi,
+            const p2p_connection_context& con,
+            uint64_t first_seen_stamp);
     size_t get_random_index_with_fixed_probability(size_t max_index);
     bool is_peer_used(const peerlist_entry& peer);
     bool is_peer_used(const anchor_peerlist_entry& peer);
@@ -425,6 +451,8 @@ class node_server
     size_t get_incoming_connections_count(network_zone&);
     size_t get_outgoing_connections_count();
     size_t get_outgoing_connections_count(network_zone&);
+    // Outgoing connections plus connection attempts still in progress
+    size_t get_outgoing_and_pending_count(network_zone&);
 
     bool check_connection_and_handshake_with_peer(
             const epee::net_utils::network_address& na, uint64_t last_seen_stamp);
@@ -493,8 +521,10 @@ class node_server
     added. `std::map::operator[]` WILL insert! */
     std::map<epee::net_utils::zone, network_zone> m_network_zones;
 
-    std::map<std::string, time_t> m_conn_fails_cache;
-    std::shared_mutex m_conn_fails_cache_lock;
+    connect_scheduler m_connect_scheduler{
+            cryptonote::p2p::MAX_CONCURRENT_OUT_CONNECTS,
+            cryptonote::p2p::FAILED_ADDR_BACKOFF,
+            cryptonote::p2p::FAILED_ADDR_FORGET};
 
     std::shared_mutex m_blocked_hosts_lock;  // for both hosts and subnets
     std::map<std::string, time_t> m_blocked_hosts;
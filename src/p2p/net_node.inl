@@ -863,6 +863,25 @@ namespace nodetool
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::do_handshake_with_peer(peerid_type& pi, p2p_connection_context& context_, bool just_take_peerlist)
+  {
+    std::promise<void> ev;
+    bool hsh_result = false;
+    async_handshake_with_peer(context_, just_take_peerlist,
+      [&](bool ok, peerid_type peer_id, p2p_connection_context& context)
+    {
+      hsh_result = ok;
+      pi = peer_id;
+      if (ok)
+        context_ = context;
+      ev.set_value();
+    });
+    ev.get_future().wait();
+    return hsh_result;
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  template<class t_callback>
+  void node_server<t_payload_net_handler>::async_handshake_with_peer(const p2p_connection_context& context_, bool just_take_peerlist, t_callback done)
   {
     network_zone& zone = m_network_zones.at(context_.m_remote_address.get_zone());
 
@@ -870,82 +889,82 @@ namespace nodetool
     using response_t = typename COMMAND_HANDSHAKE::response;
 
     request_t arg{};
-    response_t rsp{};
     get_local_node_data(arg.node_data, zone);
     m_payload_handler.get_payload_sync_data(arg.payload_data);
 
-    std::promise<void> ev;
-    std::atomic<bool> hsh_result(false);
-    bool timeout = false;
+    auto handshake_failed = [&zone](const p2p_connection_context& context, bool timeout)
+    {
+      log::warning(logcat, "{}COMMAND_HANDSHAKE Failed", context);
+      if (!timeout)
+        zone.m_net_server.get_config_object().close(context.m_connection_id);
+    };
 
     bool r = epee::net_utils::async_invoke_remote_command2<response_t>(context_.m_connection_id, COMMAND_HANDSHAKE::ID, arg, zone.m_net_server.get_config_object(),
-      [this, &pi, &ev, &hsh_result, &just_take_peerlist, &context_, &timeout](int code, response_t&& rsp, p2p_connection_context& context)
+      [this, just_take_peerlist, done, handshake_failed](int code, response_t&& rsp, p2p_connection_context& context)
     {
-      OXEN_DEFER { ev.set_value(); };
-
-      if(code < 0)
+      bool timeout = false;
+      peerid_type pi{};
+      auto handshake = [&]() -> bool
       {
-        log::warning(logcat, "{}COMMAND_HANDSHAKE invoke failed. ({},{})", context, code, epee::levin::get_err_descr(code));
-        if (code == LEVIN_ERROR_CONNECTION_TIMEDOUT || code == LEVIN_ERROR_CONNECTION_DESTROYED)
-          timeout = true;
-        return;
-      }
+        if(code < 0)
+        {
+          log::warning(logcat, "{}COMMAND_HANDSHAKE invoke failed. ({},{})", context, code, epee::levin::get_err_descr(code));
+          if (code == LEVIN_ERROR_CONNECTION_TIMEDOUT || code == LEVIN_ERROR_CONNECTION_DESTROYED)
+            timeout = true;
+          return false;
+        }
 
-      if(rsp.node_data.network_id != m_network_id)
-      {
-        log::warning(logcat, "{}COMMAND_HANDSHAKE Failed, wrong network! ({}), closing connection.", context, boost::lexical_cast<std::string>(rsp.node_data.network_id));
-        return;
-      }
+        if(rsp.node_data.network_id != m_network_id)
+        {
+          log::warning(logcat, "{}COMMAND_HANDSHAKE Failed, wrong network! ({}), closing connection.", context, boost::lexical_cast<std::string>(rsp.node_data.network_id));
+          return false;
+        }
 
-      if(!handle_remote_peerlist(rsp.local_peerlist_new, context))
-      {
-        log::warning(logcat, "{}COMMAND_HANDSHAKE: failed to handle_remote_peerlist(...), closing connection.", context);
-        add_host_fail(context.m_remote_address);
-        return;
-      }
-      hsh_result = true;
-      if(!just_take_peerlist)
-      {
-        if(!m_payload_handler.process_payload_sync_data(std::move(rsp.payload_data), context, true))
+        if(!handle_remote_peerlist(rsp.local_peerlist_new, context))
         {
-          log::warning(logcat, "{}COMMAND_HANDSHAKE invoked, but process_payload_sync_data returned false, dropping connection.", context);
-          hsh_result = false;
-          return;
+          log::warning(logcat, "{}COMMAND_HANDSHAKE: failed to handle_remote_peerlist(...), closing connection.", context);
+          add_host_fail(context.m_remote_address);
+          return false;
         }
+        if(!just_take_peerlist)
+        {
+          if(!m_payload_handler.process_payload_sync_data(std::move(rsp.payload_data), context, true))
+          {
+            log::warning(logcat, "{}COMMAND_HANDSHAKE invoked, but process_payload_sync_data returned false, dropping connection.", context);
+            return false;
+          }
 
-        pi = context.peer_id = rsp.node_data.peer_id;
-        network_zone& zone = m_network_zones.at(context.m_remote_address.get_zone());
-        zone.m_peerlist.set_peer_just_seen(rsp.node_data.peer_id, context.m_remote_address, context.m_pruning_seed);
+          pi = context.peer_id = rsp.node_data.peer_id;
+          network_zone& zone = m_network_zones.at(context.m_remote_address.get_zone());
+          zone.m_peerlist.set_peer_just_seen(rsp.node_data.peer_id, context.m_remote_address, context.m_pruning_seed);
 
-        // move
-        if(rsp.node_data.peer_id == zone.m_config.m_peer_id)
+          // move
+          if(rsp.node_data.peer_id == zone.m_config.m_peer_id)
+          {
+            log::debug(logcat, "{}Connection to self detected, dropping connection", context);
+            return false;
+          }
+          log::info(logcat, "{}New connection handshaked, pruning seed {}", context, epee::string_tools::to_string_hex(context.m_pruning_seed));
+          log::debug(logcat, "{} COMMAND_HANDSHAKE INVOKED OK", context);
+        }else
         {
-          log::debug(logcat, "{}Connection to self detected, dropping connection", context);
-          hsh_result = false;
-          return;
+          log::debug(logcat, "{} COMMAND_HANDSHAKE(AND CLOSE) INVOKED OK", context);
         }
-        log::info(logcat, "{}New connection handshaked, pruning seed {}", context, epee::string_tools::to_string_hex(context.m_pruning_seed));
-        log::debug(logcat, "{} COMMAND_HANDSHAKE INVOKED OK", context);
-      }else
-      {
-        log::debug(logcat, "{} COMMAND_HANDSHAKE(AND CLOSE) INVOKED OK", context);
-      }
-      context_ = context;
-    }, std::chrono::milliseconds{cryptonote::p2p::DEFAULT_HANDSHAKE_INVOKE_TIMEOUT});
+        return true;
+      };
 
-    if(r)
-    {
-      ev.get_future().wait();
-    }
+      const bool hsh_result = handshake();
+      if (!hsh_result)
+        handshake_failed(context, timeout);
+      done(hsh_result, pi, context);
+    }, std::chrono::milliseconds{cryptonote::p2p::DEFAULT_HANDSHAKE_INVOKE_TIMEOUT});
 
-    if(!hsh_result)
+    if(!r)
     {
-      log::warning(logcat, "{}COMMAND_HANDSHAKE Failed", context_);
-      if (!timeout)
-        zone.m_net_server.get_config_object().close(context_.m_connection_id);
+      p2p_connection_context context = context_;
+      handshake_failed(context, false);
+      done(false, peerid_type{}, context);
     }
-
-    return hsh_result;
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
@@ -1078,6 +1097,28 @@ namespace nodetool
     return "never"s;
   }
 
+  static bool get_ip_and_port(const epee::net_utils::network_address& na, std::string& ip, std::string& port)
+  {
+    bool is_ipv4 = na.get_type_id() == epee::net_utils::ipv4_network_address::get_type_id();
+    bool is_ipv6 = na.get_type_id() == epee::net_utils::ipv6_network_address::get_type_id();
+    CHECK_AND_ASSERT_MES(is_ipv4 || is_ipv6, false,
+      "Only IPv4 or IPv6 addresses are supported here");
+
+    if (is_ipv4)
+    {
+      const epee::net_utils::ipv4_network_address &ipv4 = na.as<const epee::net_utils::ipv4_network_address>();
+      ip = epee::string_tools::get_ip_string_from_int32(ipv4.ip());
+      port = std::to_string(ipv4.port());
+    }
+    else
+    {
+      const epee::net_utils::ipv6_network_address &ipv6 = na.as<const epee::net_utils::ipv6_network_address>();
+      ip = ipv6.ip().to_string();
+      port = std::to_string(ipv6.port());
+    }
+    return true;
+  }
+
   template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::try_to_connect_and_handshake_with_new_peer(const epee::net_utils::network_address& na, bool just_take_peerlist, uint64_t last_seen_stamp, PeerType peer_type, uint64_t first_seen_stamp)
   {
@@ -1133,13 +1174,20 @@ namespace nodetool
       return true;
     }
 
+    on_new_out_peer(zone, na, pi, *con, first_seen_stamp);
+    return true;
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  void node_server<t_payload_net_handler>::on_new_out_peer(network_zone& zone, const epee::net_utils::network_address& na, peerid_type pi, const p2p_connection_context& con, uint64_t first_seen_stamp)
+  {
     peerlist_entry pe_local{};
     pe_local.adr = na;
     pe_local.id = pi;
     time_t last_seen;
     time(&last_seen);
     pe_local.last_seen = static_cast<int64_t>(last_seen);
-    pe_local.pruning_seed = con->m_pruning_seed;
+    pe_local.pruning_seed = con.m_pruning_seed;
     zone.m_peerlist.append_with_peer_white(pe_local);
     //update last seen and push it to peerlist manager
 
@@ -1151,7 +1199,70 @@ namespace nodetool
     zone.m_peerlist.append_with_peer_anchor(ape);
     zone.m_notifier.new_out_connection();
 
-    log::debug(logcat, "{}CONNECTION HANDSHAKED OK.", *con );
+    log::debug(logcat, "{}CONNECTION HANDSHAKED OK.", con);
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  bool node_server<t_payload_net_handler>::connect_to_new_peer(const epee::net_utils::network_address& na, uint64_t last_seen_stamp, PeerType peer_type, uint64_t first_seen_stamp)
+  {
+    network_zone& zone = m_network_zones.at(na.get_zone());
+    if (zone.m_connect == &public_connect)
+      return start_connect_and_handshake(zone, na, last_seen_stamp, peer_type, first_seen_stamp);
+    return try_to_connect_and_handshake_with_new_peer(na, false, last_seen_stamp, peer_type, first_seen_stamp);
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
+  bool node_server<t_payload_net_handler>::start_connect_and_handshake(network_zone& zone, const epee::net_utils::network_address& na, uint64_t last_seen_stamp, PeerType peer_type, uint64_t first_seen_stamp)
+  {
+    if (zone.m_current_number_of_out_peers >= zone.m_config.m_net_config.max_out_connection_count) // out peers limit
+      return false;
+
+    std::string ip, port;
+    if (!get_ip_and_port(na, ip, port))
+      return false;
+
+    const std::string host = na.host_str();
+    if (!m_connect_scheduler.try_begin(host))
+    {
+      log::debug(logcat, "Not connecting to {}: already connecting, backing off, or no free connect slots", na.str());
+      return false;
+    }
+
+    log::debug(logcat, "Connecting to {}(peer_type={}, last_seen: {})...",
+            na.str(), peer_type, format_stamp_ago(last_seen_stamp));
+
+    auto handshake_done = [this, &zone, na, host, peer_type, first_seen_stamp](bool ok, peerid_type pi, p2p_connection_context& context)
+    {
+      if (!ok)
+      {
+        log::info(logcat, "{}{} Failed to HANDSHAKE with peer {}", context, is_priority_node(na) ? "[priority]" : "", na.str());
+        m_connect_scheduler.finish(host, false);
+        return;
+      }
+      context.m_anchor = peer_type == anchor;
+      on_new_out_peer(zone, na, pi, context, first_seen_stamp);
+      m_connect_scheduler.finish(host, true);
+    };
+
+    bool r = zone.m_net_server.connect_async(ip, port, zone.m_config.m_net_config.connection_timeout.count(),
+      [this, na, host, handshake_done](const p2p_connection_context& context, const boost::system::error_code& ec) -> bool
+    {
+      if (ec)
+      {
+        log::info(logcat, "{} Connect failed to {}: {}", is_priority_node(na) ? "[priority]" : "", na.str(), ec.message());
+        m_connect_scheduler.finish(host, false);
+        return false;
+      }
+      async_handshake_with_peer(context, false, handshake_done);
+      return true;
+    }, zone.m_bind_ip);
+
+    if (!r)
+    {
+      log::warning(logcat, "Failed to call connect_async to {}, network error.", na.str());
+      m_connect_scheduler.finish(host, false);
+      return false;
+    }
     return true;
   }
 
@@ -1198,20 +1309,13 @@ namespace nodetool
   template<class t_payload_net_handler>
   void node_server<t_payload_net_handler>::record_addr_failed(const epee::net_utils::network_address& addr)
   {
-    std::unique_lock lock{m_conn_fails_cache_lock};
-    m_conn_fails_cache[addr.host_str()] = time(NULL);
+    m_connect_scheduler.record_failure(addr.host_str());
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
   bool node_server<t_payload_net_handler>::is_addr_recently_failed(const epee::net_utils::network_address& addr)
   {
-    std::shared_lock lock{m_conn_fails_cache_lock};
-    auto it = m_conn_fails_cache.find(addr.host_str());
-    if (it == m_conn_fails_cache.end())
-      return false;
-
-    auto ago = std::chrono::system_clock::now() - std::chrono::system_clock::from_time_t(it->second);
-    return ago <= cryptonote::p2p::FAILED_ADDR_FORGET;
+    return m_connect_scheduler.backing_off(addr.host_str());
   }
 
   static std::string peerid_to_string(peerid_type peer_id)
@@ -1242,7 +1346,7 @@ namespace nodetool
       log::debug(logcat, "Selected peer: {} {} first_seen: {}",
               peerid_to_string(pe.id), pe.adr.str(), format_stamp_ago(pe.first_seen));
 
-      if(!try_to_connect_and_handshake_with_new_peer(pe.adr, false, 0, anchor, pe.first_seen)) {
+      if(!connect_to_new_peer(pe.adr, 0, anchor, pe.first_seen)) {
         log::debug(logcat, "Handshake failed");
         continue;
       }
@@ -1379,7 +1483,7 @@ namespace nodetool
               (use_white_list ? white : gray),
               format_stamp_ago(pe.last_seen));
 
-      if(!try_to_connect_and_handshake_with_new_peer(pe.adr, false, pe.last_seen, use_white_list ? white : gray)) {
+      if(!connect_to_new_peer(pe.adr, pe.last_seen, use_white_list ? white : gray)) {
         log::debug(logcat, "Handshake failed");
         continue;
       }
@@ -1477,7 +1581,7 @@ namespace nodetool
 
     // Only have seeds in the public zone right now.
 
-    size_t start_conn_count = get_public_outgoing_connections_count();
+    size_t start_conn_count = get_public_outgoing_connections_count() + m_connect_scheduler.in_flight();
     if(!get_public_white_peers_count() && !connect_to_seed())
     {
       return false;
@@ -1489,35 +1593,38 @@ namespace nodetool
     {
       size_t base_expected_white_connections = (zone.second.m_config.m_net_config.max_out_connection_count*cryptonote::p2p::DEFAULT_WHITELIST_CONNECTIONS_PERCENT)/100;
 
-      size_t conn_count = get_outgoing_connections_count(zone.second);
+      size_t conn_count = get_outgoing_and_pending_count(zone.second);
       while(conn_count < zone.second.m_config.m_net_config.max_out_connection_count)
       {
         const size_t expected_white_connections = m_payload_handler.get_next_needed_pruning_stripe().second ? zone.second.m_config.m_net_config.max_out_connection_count : base_expected_white_connections;
         if(conn_count < expected_white_connections)
         {
           //start from anchor list
-          while (get_outgoing_connections_count(zone.second) < cryptonote::p2p::DEFAULT_ANCHOR_CONNECTIONS_COUNT
+          while (get_outgoing_and_pending_count(zone.second) < cryptonote::p2p::DEFAULT_ANCHOR_CONNECTIONS_COUNT
             && make_expected_connections_count(zone.second, anchor, cryptonote::p2p::DEFAULT_ANCHOR_CONNECTIONS_COUNT));
           //then do white list
-          while (get_outgoing_connections_count(zone.second) < expected_white_connections
+          while (get_outgoing_and_pending_count(zone.second) < expected_white_connections
             && make_expected_connections_count(zone.second, white, expected_white_connections));
           //then do grey list
-          while (get_outgoing_connections_count(zone.second) < zone.second.m_config.m_net_config.max_out_connection_count
+          while (get_outgoing_and_pending_count(zone.second) < zone.second.m_config.m_net_config.max_out_connection_count
             && make_expected_connections_count(zone.second, gray, zone.second.m_config.m_net_config.max_out_connection_count));
         }else
         {
           //start from grey list
-          while (get_outgoing_connections_count(zone.second) < zone.second.m_config.m_net_config.max_out_connection_count
+          while (get_outgoing_and_pending_count(zone.second) < zone.second.m_config.m_net_config.max_out_connection_count
             && make_expected_connections_count(zone.second, gray, zone.second.m_config.m_net_config.max_out_connection_count));
           //and then do white list
-          while (get_outgoing_connections_count(zone.second) < zone.second.m_config.m_net_config.max_out_connection_count
+          while (get_outgoing_and_pending_count(zone.second) < zone.second.m_config.m_net_config.max_out_connection_count
             && make_expected_connections_count(zone.second, white, zone.second.m_config.m_net_config.max_out_connection_count));
         }
         if(zone.second.m_net_server.is_stop_signal_sent())
           return false;
-        size_t new_conn_count = get_outgoing_connections_count(zone.second);
+        size_t new_conn_count = get_outgoing_and_pending_count(zone.second);
         if (new_conn_count <= conn_count)
         {
+          // all connect slots are busy: nothing to do until some of those attempts finish
+          if (!m_connect_scheduler.free_slots())
+            break;
           // we did not make any connection, sleep a bit to avoid a busy loop in case we don't have
           // any peers to try, then break so we will try seeds to get more peers
           std::this_thread::sleep_for(1s);
@@ -1527,7 +1634,8 @@ namespace nodetool
       }
     }
 
-    if (start_conn_count == get_public_outgoing_connections_count() && start_conn_count < m_network_zones.at(zone_type::public_).m_config.m_net_config.max_out_connection_count)
+    // (while attempts are still in flight we don't know yet whether they will work out)
+    if (!m_connect_scheduler.in_flight() && start_conn_count == get_public_outgoing_connections_count() && start_conn_count < m_network_zones.at(zone_type::public_).m_config.m_net_config.max_out_connection_count)
     {
       log::info(logcat, "Failed to connect to any, trying seeds");
       if (!connect_to_seed())
@@ -1549,7 +1657,10 @@ namespace nodetool
       zone.m_peerlist.get_and_empty_anchor_peerlist(apl);
     }
 
-    size_t conn_count = get_outgoing_connections_count(zone);
+    if (zone.m_connect == &public_connect && !m_connect_scheduler.free_slots())
+      return false;
+
+    size_t conn_count = get_outgoing_and_pending_count(zone);
     //add new connections from white peers
     if(conn_count < expected_connections)
     {
@@ -1609,6 +1720,17 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
+  size_t node_server<t_payload_net_handler>::get_outgoing_and_pending_count(network_zone& zone)
+  {
+    // In-flight attempts that already got as far as the handshake are counted twice here; that
+    // only makes us a little conservative until they finish.
+    size_t count = get_outgoing_connections_count(zone);
+    if (zone.m_connect == &public_connect)
+      count += m_connect_scheduler.in_flight();
+    return count;
+  }
+  //-----------------------------------------------------------------------------------
+  template<class t_payload_net_handler>
   size_t node_server<t_payload_net_handler>::get_outgoing_connections_count()
   {
     size_t count = 0;
@@ -1814,7 +1936,7 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
-  bool node_server<t_payload_net_handler>::relay_notify_to_list(int command, const epee::span<const uint8_t> data_buff, std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> connections)
+  bool node_server<t_payload_net_handler>::relay_notify_to_list(int command, epee::shared_sv data_buff, std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> connections)
   {
     std::sort(connections.begin(), connections.end());
     auto zone = m_network_zones.begin();
@@ -1833,7 +1955,7 @@ namespace nodetool
         ++zone;
       }
       if (zone->first == c_id.first)
-        zone->second.m_net_server.get_config_object().notify(command, data_buff, c_id.second);
+        zone->second.m_net_server.get_config_object().notify(command, data_buff, c_id.second); // shares data_buff's buffer
     }
     return true;
   }
@@ -1900,13 +2022,13 @@ namespace nodetool
   }
   //-----------------------------------------------------------------------------------
   template<class t_payload_net_handler>
-  bool node_server<t_payload_net_handler>::invoke_notify_to_peer(int command, const epee::span<const uint8_t> req_buff, const epee::net_utils::connection_context_base& context)
+  bool node_server<t_payload_net_handler>::invoke_notify_to_peer(int command, epee::shared_sv req_buff, const epee::net_utils::connection_context_base& context)
   {
     if(is_filtered_command(context.m_remote_address, command))
       return false;
 
     network_zone& zone = m_network_zones.at(context.m_remote_address.get_zone());
-    int res = zone.m_net_server.get_config_object().notify(command, req_buff, context.m_connection_id);
+    int res = zone.m_net_server.get_config_object().notify(command, std::move(req_buff), context.m_connection_id);
     return res > 0;
   }
   //-----------------------------------------------------------------------------------
@@ -2531,26 +2653,10 @@ namespace nodetool
   std::optional<p2p_connection_context_t<typename t_payload_net_handler::connection_context>>
   node_server<t_payload_net_handler>::public_connect(network_zone& zone, epee::net_utils::network_address const& na)
   {
-    bool is_ipv4 = na.get_type_id() == epee::net_utils::ipv4_network_address::get_type_id();
-    bool is_ipv6 = na.get_type_id() == epee::net_utils::ipv6_network_address::get_type_id();
-    CHECK_AND_ASSERT_MES(is_ipv4 || is_ipv6, std::nullopt,
-      "Only IPv4 or IPv6 addresses are supported here");
-
     std::string address;
     std::string port;
-
-    if (is_ipv4)
-    {
-      const epee::net_utils::ipv4_network_address &ipv4 = na.as<const epee::net_utils::ipv4_network_address>();
-      address = epee::string_tools::get_ip_string_from_int32(ipv4.ip());
-      port = std::to_string(ipv4.port());
-    }
-    else
-    {
-      const epee::net_utils::ipv6_network_address &ipv6 = na.as<const epee::net_utils::ipv6_network_address>();
-      address = ipv6.ip().to_string();
-      port = std::to_string(ipv6.port());
-    }
+    if (!get_ip_and_port(na, address, port))
+      return std::nullopt;
 
     typename net_server::t_connection_context con{};
     const bool res = zone.m_net_server.connect(address, port,
@@ -47,7 +47,7 @@ template <class t_connection_context>
 struct i_p2p_endpoint {
     virtual bool relay_notify_to_list(
             int command,
-            const epee::span<const uint8_t> data_buff,
+            epee::shared_sv data_buff,
             std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> connections) = 0;
     virtual epee::net_utils::zone send_txs(
             std::vector<std::string> txs,
@@ -61,7 +61,7 @@ struct i_p2p_endpoint {
             const epee::net_utils::connection_context_base& context) = 0;
     virtual bool invoke_notify_to_peer(
             int command,
-            const epee::span<const uint8_t> req_buff,
+            epee::shared_sv req_buff,
             const epee::net_utils::connection_context_base& context) = 0;
     virtual bool drop_connection(const epee::net_utils::connection_context_base& context) = 0;
     virtual void request_callback(const epee::net_utils::connection_context_base& context) = 0;
@@ -85,7 +85,7 @@ template <class t_connection_context>
 struct p2p_endpoint_stub : public i_p2p_endpoint<t_connection_context> {
     virtual bool relay_notify_to_list(
             int command,
-            const epee::span<const uint8_t> data_buff,
+            epee::shared_sv data_buff,
             std::vector<std::pair<epee::net_utils::zone, boost::uuids::uuid>> connections) {
         return false;
     }
@@ -105,7 +105,7 @@ struct p2p_endpoint_stub : public i_p2p_endpoint<t_connection_context> {
     }
     virtual bool invoke_notify_to_peer(
             int command,
-            const epee::span<const uint8_t> req_buff,
+            epee::shared_sv req_buff,
             const epee::net_utils::connection_context_base& context) {
         return true;
     }
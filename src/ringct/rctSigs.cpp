@@ -30,6 +30,13 @@
 
 #include "rctSigs.h"
 
+#include <array>
+#include <atomic>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include "bulletproofs.h"
 #include "common/threadpool.h"
 #include "common/util.h"
@@ -40,6 +47,174 @@
 namespace rct {
 static auto logcat = log::Cat("ringct");
 
+namespace {
+
+    // The points CLSAG signing/verification derives from a ring member's one-time public key:
+    // the decompressed key itself, and its hash-to-point, both in double scalarmult precomp form.
+    // Popular decoys show up in many rings so we keep these in a (sharded) LRU cache rather than
+    // redoing the decompression and hash-to-point for every signature they appear in.
+    struct ring_member_points {
+        geDsmp P;
+        geDsmp H;
+    };
+
+    class ring_member_cache {
+        static constexpr size_t SHARDS = 16;
+
+        struct shard {
+            std::mutex mutex;
+            std::list<std::pair<key, ring_member_points>> lru;  // most recently used first
+            std::unordered_map<key, decltype(lru)::iterator> index;
+        };
+        std::array<shard, SHARDS> shards_;
+        std::atomic<size_t> max_per_shard_{4096 / SHARDS};
+        std::atomic<uint64_t> hits_{0}, misses_{0};
+
+        static void compute(const key& P, ring_member_points& out) {
+            precomp(out.P.k, P);  // Throws if P isn't a valid point
+            ge_p3 H_p3;
+            hash_to_p3(H_p3, P);
+            ge_dsm_precomp(out.H.k, &H_p3);
+        }
+
+      public:
+        // Loads the precomputed points for ring member `P` into `out`, computing (and caching) them
+        // if not already cached.  Throws if P is not a valid point.
+        void get(const key& P, ring_member_points& out) {
+            const size_t max = max_per_shard_.load(std::memory_order_relaxed);
+            if (max == 0) {
+                compute(P, out);
+                return;
+            }
+
+            auto& sh = shards_[P.bytes[0] % SHARDS];
+            {
+                std::lock_guard lock{sh.mutex};
+                if (auto it = sh.index.find(P); it != sh.index.end()) {
+                    sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+                    out = it->second->second;
+                    hits_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            // Compute without holding the lock; if another thread races us to it we just end up
+            // computing it twice.
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            compute(P, out);
+
+            std::lock_guard lock{sh.mutex};
+            if (sh.index.count(P))
+                return;
+            while (sh.lru.size() >= max) {
+                sh.index.erase(sh.lru.back().first);
+                sh.lru.pop_back();
+            }
+            sh.lru.emplace_front(P, out);
+            sh.index.emplace(P, sh.lru.begin());
+        }
+
+        void resize(size_t entries) {
+            const size_t per_shard = (entries + SHARDS - 1) / SHARDS;
+            max_per_shard_ = per_shard;
+            for (auto& sh : shards_) {
+                std::lock_guard lock{sh.mutex};
+                while (sh.lru.size() > per_shard) {
+                    sh.index.erase(sh.lru.back().first);
+                    sh.lru.pop_back();
+                }
+            }
+        }
+
+        clsag_ring_cache_stats stats() {
+            clsag_ring_cache_stats st{};
+            st.hits = hits_;
+            st.misses = misses_;
+            for (auto& sh : shards_) {
+                std::lock_guard lock{sh.mutex};
+                st.size += sh.lru.size();
+            }
+            return st;
+        }
+    };
+
+    ring_member_cache& ring_cache() {
+        static ring_member_cache cache;
+        return cache;
+    }
+
+    clsag_scratch& thread_clsag_scratch() {
+        static thread_local clsag_scratch scratch;
+        return scratch;
+    }
+
+    // Fills `mu_to_hash` with the CLSAG aggregation hash input (with the CLSAG_AGG_0 domain) and
+    // computes the mu_P and mu_C aggregation coefficients.  The two hashes differ only in their
+    // domain separator so we reuse the buffer for both.
+    template <typename GetP, typename GetC>
+    void clsag_aggregation_hashes(
+            keyV& mu_to_hash,
+            size_t n,
+            GetP get_P,
+            GetC get_C,
+            const key& I,
+            const key& D,
+            const key& C_offset,
+            key& mu_P,
+            key& mu_C) {
+        mu_to_hash.resize(2 * n + 4);  // domain, P, C, I, D, C_offset
+        for (size_t i = 0; i < n; ++i) {
+            mu_to_hash[i + 1] = get_P(i);
+            mu_to_hash[i + n + 1] = get_C(i);
+        }
+        mu_to_hash[2 * n + 1] = I;
+        mu_to_hash[2 * n + 2] = D;
+        mu_to_hash[2 * n + 3] = C_offset;
+
+        sc_0(mu_to_hash[0].bytes);
+        memcpy(mu_to_hash[0].bytes,
+               cryptonote::hashkey::CLSAG_AGG_0.data(),
+               cryptonote::hashkey::CLSAG_AGG_0.size());
+        mu_P = hash_to_scalar(mu_to_hash);
+        sc_0(mu_to_hash[0].bytes);
+        memcpy(mu_to_hash[0].bytes,
+               cryptonote::hashkey::CLSAG_AGG_1.data(),
+               cryptonote::hashkey::CLSAG_AGG_1.size());
+        mu_C = hash_to_scalar(mu_to_hash);
+    }
+
+    // Sets up the round hash buffer: domain, P, C, C_offset, message, (L, R left for the caller)
+    template <typename GetP, typename GetC>
+    void clsag_round_hash_prefix(
+            keyV& c_to_hash,
+            size_t n,
+            GetP get_P,
+            GetC get_C,
+            const key& C_offset,
+            const key& message) {
+        c_to_hash.resize(2 * n + 5);
+        sc_0(c_to_hash[0].bytes);
+        memcpy(c_to_hash[0].bytes,
+               cryptonote::hashkey::CLSAG_ROUND.data(),
+               cryptonote::hashkey::CLSAG_ROUND.size());
+        for (size_t i = 0; i < n; ++i) {
+            c_to_hash[i + 1] = get_P(i);
+            c_to_hash[i + n + 1] = get_C(i);
+        }
+        c_to_hash[2 * n + 1] = C_offset;
+        c_to_hash[2 * n + 2] = message;
+    }
+
+}  // namespace
+
+void set_clsag_ring_cache_size(size_t entries) {
+    ring_cache().resize(entries);
+}
+
+clsag_ring_cache_stats get_clsag_ring_cache_stats() {
+    return ring_cache().stats();
+}
+
 static rct::Bulletproof make_dummy_bulletproof(
         const std::vector<uint64_t>& outamounts, rct::keyV& C, rct::keyV& masks) {
     const size_t n_outs = outamounts.size();
@@ -158,7 +333,8 @@ clsag CLSAG_Gen(
         const multisig_kLRki* kLRki,
         key* mscout,
         key* mspout,
-        hw::device& hwdev) {
+        hw::device& hwdev,
+        clsag_scratch& scratch) {
     clsag sig;
     size_t n = P.size();  // ring size
     CHECK_AND_ASSERT_THROW_MES(
@@ -201,47 +377,28 @@ clsag CLSAG_Gen(
     scalarmultKey(sig.D, D, INV_EIGHT);
 
     // Aggregation hashes
-    keyV mu_P_to_hash(2 * n + 4);  // domain, I, D, P, C, C_offset
-    keyV mu_C_to_hash(2 * n + 4);  // domain, I, D, P, C, C_offset
-    sc_0(mu_P_to_hash[0].bytes);
-    memcpy(mu_P_to_hash[0].bytes,
-           cryptonote::hashkey::CLSAG_AGG_0.data(),
-           cryptonote::hashkey::CLSAG_AGG_0.size());
-    sc_0(mu_C_to_hash[0].bytes);
-    memcpy(mu_C_to_hash[0].bytes,
-           cryptonote::hashkey::CLSAG_AGG_1.data(),
-           cryptonote::hashkey::CLSAG_AGG_1.size());
-    for (size_t i = 1; i < n + 1; ++i) {
-        mu_P_to_hash[i] = P[i - 1];
-        mu_C_to_hash[i] = P[i - 1];
-    }
-    for (size_t i = n + 1; i < 2 * n + 1; ++i) {
-        mu_P_to_hash[i] = C_nonzero[i - n - 1];
-        mu_C_to_hash[i] = C_nonzero[i - n - 1];
-    }
-    mu_P_to_hash[2 * n + 1] = sig.I;
-    mu_P_to_hash[2 * n + 2] = sig.D;
-    mu_P_to_hash[2 * n + 3] = C_offset;
-    mu_C_to_hash[2 * n + 1] = sig.I;
-    mu_C_to_hash[2 * n + 2] = sig.D;
-    mu_C_to_hash[2 * n + 3] = C_offset;
     key mu_P, mu_C;
-    mu_P = hash_to_scalar(mu_P_to_hash);
-    mu_C = hash_to_scalar(mu_C_to_hash);
+    clsag_aggregation_hashes(
+            scratch.mu_to_hash,
+            n,
+            [&](size_t i) -> const key& { return P[i]; },
+            [&](size_t i) -> const key& { return C_nonzero[i]; },
+            sig.I,
+            sig.D,
+            C_offset,
+            mu_P,
+            mu_C);
 
     // Initial commitment
-    keyV c_to_hash(2 * n + 5);  // domain, P, C, C_offset, message, aG, aH
+    auto& c_to_hash = scratch.c_to_hash;
     key c;
-    sc_0(c_to_hash[0].bytes);
-    memcpy(c_to_hash[0].bytes,
-           cryptonote::hashkey::CLSAG_ROUND.data(),
-           cryptonote::hashkey::CLSAG_ROUND.size());
-    for (size_t i = 1; i < n + 1; ++i) {
-        c_to_hash[i] = P[i - 1];
-        c_to_hash[i + n] = C_nonzero[i - 1];
-    }
-    c_to_hash[2 * n + 1] = C_offset;
-    c_to_hash[2 * n + 2] = message;
+    clsag_round_hash_prefix(
+            c_to_hash,
+            n,
+            [&](size_t i) -> const key& { return P[i]; },
+            [&](size_t i) -> const key& { return C_nonzero[i]; },
+            C_offset,
+            message);
 
     // Multisig data is present
     if (kLRki) {
@@ -266,10 +423,8 @@ clsag CLSAG_Gen(
     key R;
     key c_p;  // = c[i]*mu_P
     key c_c;  // = c[i]*mu_C
-    geDsmp P_precomp;
+    ring_member_points ring_pts;
     geDsmp C_precomp;
-    geDsmp H_precomp;
-    ge_p3 Hi_p3;
 
     while (i != l) {
         sig.s[i] = skGen();
@@ -278,16 +433,14 @@ clsag CLSAG_Gen(
         sc_mul(c_c.bytes, mu_C.bytes, c.bytes);
 
         // Precompute points
-        precomp(P_precomp.k, P[i]);
+        ring_cache().get(P[i], ring_pts);
         precomp(C_precomp.k, C[i]);
 
         // Compute L
-        addKeys_aGbBcC(L, sig.s[i], c_p, P_precomp.k, c_c, C_precomp.k);
+        addKeys_aGbBcC(L, sig.s[i], c_p, ring_pts.P.k, c_c, C_precomp.k);
 
         // Compute R
-        hash_to_p3(Hi_p3, P[i]);
-        ge_dsm_precomp(H_precomp.k, &Hi_p3);
-        addKeys_aAbBcC(R, sig.s[i], H_precomp.k, c_p, I_precomp.k, c_c, D_precomp.k);
+        addKeys_aAbBcC(R, sig.s[i], ring_pts.H.k, c_p, I_precomp.k, c_c, D_precomp.k);
 
         c_to_hash[2 * n + 3] = L;
         c_to_hash[2 * n + 4] = R;
@@ -311,6 +464,35 @@ clsag CLSAG_Gen(
     return sig;
 }
 
+clsag CLSAG_Gen(
+        const key& message,
+        const keyV& P,
+        const key& p,
+        const keyV& C,
+        const key& z,
+        const keyV& C_nonzero,
+        const key& C_offset,
+        const unsigned int l,
+        const multisig_kLRki* kLRki,
+        key* mscout,
+        key* mspout,
+        hw::device& hwdev) {
+    return CLSAG_Gen(
+            message,
+            P,
+            p,
+            C,
+            z,
+            C_nonzero,
+            C_offset,
+            l,
+            kLRki,
+            mscout,
+            mspout,
+            hwdev,
+            thread_clsag_scratch());
+}
+
 clsag CLSAG_Gen(
         const key& message,
         const keyV& P,
@@ -519,38 +701,72 @@ clsag proveRctCLSAGSimple(
         key* mscout,
         key* mspout,
         unsigned int index,
-        hw::device& hwdev) {
+        hw::device& hwdev,
+        clsag_scratch& scratch) {
     // setup vars
-    size_t rows = 1;
     size_t cols = pubs.size();
     CHECK_AND_ASSERT_THROW_MES(cols >= 1, "Empty pubs");
     CHECK_AND_ASSERT_THROW_MES(
             (kLRki && mscout) || (!kLRki && !mscout), "Only one of kLRki/mscout is present");
-    keyV tmp(rows + 1);
-    keyV sk(rows + 1);
-    size_t i;
-    keyM M(cols, tmp);
 
-    keyV P, C, C_nonzero;
-    P.reserve(pubs.size());
-    C.reserve(pubs.size());
-    C_nonzero.reserve(pubs.size());
-    for (const ctkey& k : pubs) {
-        P.push_back(k.dest);
-        C_nonzero.push_back(k.mask);
-        rct::key tmp;
-        subKeys(tmp, k.mask, Cout);
-        C.push_back(tmp);
+    auto& P = scratch.P;
+    auto& C = scratch.C;
+    auto& C_nonzero = scratch.C_nonzero;
+    P.resize(cols);
+    C.resize(cols);
+    C_nonzero.resize(cols);
+    for (size_t i = 0; i < cols; i++) {
+        P[i] = pubs[i].dest;
+        C_nonzero[i] = pubs[i].mask;
+        subKeys(C[i], pubs[i].mask, Cout);
     }
 
+    key sk[2];
     sk[0] = copy(inSk.dest);
     sc_sub(sk[1].bytes, inSk.mask.bytes, a.bytes);
     clsag result = CLSAG_Gen(
-            message, P, sk[0], C, sk[1], C_nonzero, Cout, index, kLRki, mscout, mspout, hwdev);
-    memwipe(sk.data(), sk.size() * sizeof(key));
+            message,
+            P,
+            sk[0],
+            C,
+            sk[1],
+            C_nonzero,
+            Cout,
+            index,
+            kLRki,
+            mscout,
+            mspout,
+            hwdev,
+            scratch);
+    memwipe(sk, sizeof(sk));
     return result;
 }
 
+clsag proveRctCLSAGSimple(
+        const key& message,
+        const ctkeyV& pubs,
+        const ctkey& inSk,
+        const key& a,
+        const key& Cout,
+        const multisig_kLRki* kLRki,
+        key* mscout,
+        key* mspout,
+        unsigned int index,
+        hw::device& hwdev) {
+    return proveRctCLSAGSimple(
+            message,
+            pubs,
+            inSk,
+            a,
+            Cout,
+            kLRki,
+            mscout,
+            mspout,
+            index,
+            hwdev,
+            thread_clsag_scratch());
+}
+
 // Ring-ct MG sigs
 // Prove:
 //    c.f. https://eprint.iacr.org/2015/1098 section 4. definition 10.
@@ -639,7 +855,11 @@ bool verRctMGSimple(const key& message, const mgSig& mg, const ctkeyV& pubs, con
 }
 
 bool verRctCLSAGSimple(
-        const key& message, const clsag& sig, const ctkeyV& pubs, const key& C_offset) {
+        const key& message,
+        const clsag& sig,
+        const ctkeyV& pubs,
+        const key& C_offset,
+        clsag_scratch& scratch) {
     try {
         const size_t n = pubs.size();
 
@@ -671,57 +891,35 @@ bool verRctCLSAGSimple(
         precomp(D_precomp.k, D_8);
 
         // Aggregation hashes
-        keyV mu_P_to_hash(2 * n + 4);  // domain, I, D, P, C, C_offset
-        keyV mu_C_to_hash(2 * n + 4);  // domain, I, D, P, C, C_offset
-        sc_0(mu_P_to_hash[0].bytes);
-        memcpy(mu_P_to_hash[0].bytes,
-               cryptonote::hashkey::CLSAG_AGG_0.data(),
-               cryptonote::hashkey::CLSAG_AGG_0.size());
-        sc_0(mu_C_to_hash[0].bytes);
-        memcpy(mu_C_to_hash[0].bytes,
-               cryptonote::hashkey::CLSAG_AGG_1.data(),
-               cryptonote::hashkey::CLSAG_AGG_1.size());
-        for (size_t i = 1; i < n + 1; ++i) {
-            mu_P_to_hash[i] = pubs[i - 1].dest;
-            mu_C_to_hash[i] = pubs[i - 1].dest;
-        }
-        for (size_t i = n + 1; i < 2 * n + 1; ++i) {
-            mu_P_to_hash[i] = pubs[i - n - 1].mask;
-            mu_C_to_hash[i] = pubs[i - n - 1].mask;
-        }
-        mu_P_to_hash[2 * n + 1] = sig.I;
-        mu_P_to_hash[2 * n + 2] = sig.D;
-        mu_P_to_hash[2 * n + 3] = C_offset;
-        mu_C_to_hash[2 * n + 1] = sig.I;
-        mu_C_to_hash[2 * n + 2] = sig.D;
-        mu_C_to_hash[2 * n + 3] = C_offset;
         key mu_P, mu_C;
-        mu_P = hash_to_scalar(mu_P_to_hash);
-        mu_C = hash_to_scalar(mu_C_to_hash);
+        clsag_aggregation_hashes(
+                scratch.mu_to_hash,
+                n,
+                [&](size_t i) -> const key& { return pubs[i].dest; },
+                [&](size_t i) -> const key& { return pubs[i].mask; },
+                sig.I,
+                sig.D,
+                C_offset,
+                mu_P,
+                mu_C);
 
         // Set up round hash
-        keyV c_to_hash(2 * n + 5);  // domain, P, C, C_offset, message, L, R
-        sc_0(c_to_hash[0].bytes);
-        memcpy(c_to_hash[0].bytes,
-               cryptonote::hashkey::CLSAG_ROUND.data(),
-               cryptonote::hashkey::CLSAG_ROUND.size());
-        for (size_t i = 1; i < n + 1; ++i) {
-            c_to_hash[i] = pubs[i - 1].dest;
-            c_to_hash[i + n] = pubs[i - 1].mask;
-        }
-        c_to_hash[2 * n + 1] = C_offset;
-        c_to_hash[2 * n + 2] = message;
+        auto& c_to_hash = scratch.c_to_hash;
+        clsag_round_hash_prefix(
+                c_to_hash,
+                n,
+                [&](size_t i) -> const key& { return pubs[i].dest; },
+                [&](size_t i) -> const key& { return pubs[i].mask; },
+                C_offset,
+                message);
         key c_p;  // = c[i]*mu_P
         key c_c;  // = c[i]*mu_C
         key c_new;
         key L;
         key R;
-        geDsmp P_precomp;
+        ring_member_points ring_pts;
         geDsmp C_precomp;
-        geDsmp H_precomp;
         size_t i = 0;
-        ge_p3 hash8_p3;
-        geDsmp hash_precomp;
         ge_p3 temp_p3;
         ge_p1p1 temp_p1;
 
@@ -731,7 +929,7 @@ bool verRctCLSAGSimple(
             sc_mul(c_c.bytes, mu_C.bytes, c.bytes);
 
             // Precompute points for L/R
-            precomp(P_precomp.k, pubs[i].dest);
+            ring_cache().get(pubs[i].dest, ring_pts);
 
             CHECK_AND_ASSERT_MES(
                     ge_frombytes_vartime(&temp_p3, pubs[i].mask.bytes) == 0,
@@ -742,12 +940,10 @@ bool verRctCLSAGSimple(
             ge_dsm_precomp(C_precomp.k, &temp_p3);
 
             // Compute L
-            addKeys_aGbBcC(L, sig.s[i], c_p, P_precomp.k, c_c, C_precomp.k);
+            addKeys_aGbBcC(L, sig.s[i], c_p, ring_pts.P.k, c_c, C_precomp.k);
 
             // Compute R
-            hash_to_p3(hash8_p3, pubs[i].dest);
-            ge_dsm_precomp(hash_precomp.k, &hash8_p3);
-            addKeys_aAbBcC(R, sig.s[i], hash_precomp.k, c_p, I_precomp.k, c_c, D_precomp.k);
+            addKeys_aAbBcC(R, sig.s[i], ring_pts.H.k, c_p, I_precomp.k, c_c, D_precomp.k);
 
             c_to_hash[2 * n + 3] = L;
             c_to_hash[2 * n + 4] = R;
@@ -764,6 +960,11 @@ bool verRctCLSAGSimple(
     }
 }
 
+bool verRctCLSAGSimple(
+        const key& message, const clsag& sig, const ctkeyV& pubs, const key& C_offset) {
+    return verRctCLSAGSimple(message, sig, pubs, C_offset, thread_clsag_scratch());
+}
+
 // These functions get keys from blockchain
 // replace these when connecting blockchain
 // populateFromBlockchain creates a keymatrix with "mixin" + 1 columns and one of the columns is
@@ -939,7 +1140,7 @@ rctSig genRctSimple(
         msout->c.resize(inamounts.size());
         msout->mu_p.resize(inamounts.size());
     }
-    for (i = 0; i < inamounts.size(); i++) {
+    auto sign_input = [&](size_t i) {
         rv.p.CLSAGs[i] = proveRctCLSAGSimple(
                 full_message,
                 rv.mixRing[i],
@@ -951,6 +1152,30 @@ rctSig genRctSimple(
                 msout ? &msout->mu_p[i] : NULL,
                 index[i],
                 hwdev);
+    };
+    // Every input's CLSAG signs the same message over its own ring, so with the software device
+    // they can be produced concurrently, each into its own slot.  Hardware devices and multisig
+    // signing carry state across the per-input calls and stay sequential.
+    if (inamounts.size() > 1 && !kLRki && !msout &&
+        hwdev.get_type() == hw::device::type::SOFTWARE) {
+        tools::threadpool& tpool = tools::threadpool::getInstance();
+        tools::threadpool::waiter waiter;
+        std::vector<std::exception_ptr> errors(inamounts.size());
+        for (i = 0; i < inamounts.size(); i++)
+            tpool.submit(&waiter, [&, i] {
+                try {
+                    sign_input(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        waiter.wait(&tpool);
+        for (auto& e : errors)
+            if (e)
+                std::rethrow_exception(e);
+    } else {
+        for (i = 0; i < inamounts.size(); i++)
+            sign_input(i);
     }
     return rv;
 }
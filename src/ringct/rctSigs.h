@@ -67,6 +67,42 @@ bool verifyBorromean(const boroSig& bb, const key64 P1, const key64 P2);
 //  Ver verifies that the MG sig was created correctly
 bool MLSAG_Ver(const key& message, const keyM& pk, const mgSig& sig, size_t dsRows);
 
+// Reusable scratch buffers for CLSAG signing and verification.  The hash buffers depend on the
+// ring size, so reusing a scratch object across calls avoids reallocating them for every
+// signature.  The overloads that don't take one use a thread-local instance.
+struct clsag_scratch {
+    keyV mu_to_hash;       // domain, P, C, I, D, C_offset
+    keyV c_to_hash;        // domain, P, C, C_offset, message, L, R
+    keyV P, C, C_nonzero;  // ring keys split out of the ctkeyV (signing only)
+};
+
+// CLSAG signing and verification cache the decompressed (and hashed-to-point) one-time keys of
+// ring members, keyed by the compressed key, since the same popular decoys show up in many
+// different rings.  This sets the maximum number of cached ring members (default 4096, about
+// 10MB); 0 disables the cache.
+void set_clsag_ring_cache_size(size_t entries);
+
+struct clsag_ring_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    size_t size;
+};
+clsag_ring_cache_stats get_clsag_ring_cache_stats();
+
+clsag CLSAG_Gen(
+        const key& message,
+        const keyV& P,
+        const key& p,
+        const keyV& C,
+        const key& z,
+        const keyV& C_nonzero,
+        const key& C_offset,
+        const unsigned int l,
+        const multisig_kLRki* kLRki,
+        key* mscout,
+        key* mspout,
+        hw::device& hwdev,
+        clsag_scratch& scratch);
 clsag CLSAG_Gen(
         const key& message,
         const keyV& P,
@@ -100,7 +136,20 @@ clsag proveRctCLSAGSimple(
         key*,
         unsigned int,
         hw::device&);
+clsag proveRctCLSAGSimple(
+        const key&,
+        const ctkeyV&,
+        const ctkey&,
+        const key&,
+        const key&,
+        const multisig_kLRki*,
+        key*,
+        key*,
+        unsigned int,
+        hw::device&,
+        clsag_scratch&);
 bool verRctCLSAGSimple(const key&, const clsag&, const ctkeyV&, const key&);
+bool verRctCLSAGSimple(const key&, const clsag&, const ctkeyV&, const key&, clsag_scratch&);
 
 // proveRange and verRange
 // proveRange gives C, and mask such that \sumCi = C
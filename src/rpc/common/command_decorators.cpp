@@ -8,4 +8,61 @@ void RPC_COMMAND::set_bt() {
     response_hex.format = tools::json_binary_proxy::fmt::bt;
 }
 
+void RPC_COMMAND::stream_array(
+        std::string key,
+        size_t size,
+        std::function<void(size_t i, tools::json_binary_proxy elem)> fill) {
+    streamed.push_back({std::move(key), size, std::move(fill)});
+}
+
+void RPC_COMMAND::write_response(tools::json_chunks& out) {
+    if (streamed.empty()) {
+        out.append(response);
+        return;
+    }
+
+    // Write the response object ourselves so that the streamed arrays can go in after the regular
+    // keys, with each element dropped as soon as it has been written.
+    out.append('{');
+    bool first = true;
+    auto write_key = [&](const std::string& key) {
+        if (!first)
+            out.append(',');
+        first = false;
+        out.append_string(key);
+        out.append(':');
+    };
+    for (auto it = response.begin(); it != response.end(); ++it) {
+        write_key(it.key());
+        out.append(it.value());
+    }
+    for (auto& s : streamed) {
+        write_key(s.key);
+        out.append('[');
+        nlohmann::json elem;
+        for (size_t i = 0; i < s.size; i++) {
+            if (i > 0)
+                out.append(',');
+            elem = nlohmann::json::object();
+            s.fill(i, tools::json_binary_proxy{elem, response_hex.format});
+            out.append(elem);
+        }
+        out.append(']');
+    }
+    out.append('}');
+    streamed.clear();
+}
+
+void RPC_COMMAND::fill_streamed() {
+    for (auto& s : streamed) {
+        auto& arr = (response[s.key] = nlohmann::json::array());
+        for (size_t i = 0; i < s.size; i++)
+            s.fill(
+                    i,
+                    tools::json_binary_proxy{
+                            arr.emplace_back(nlohmann::json::object()), response_hex.format});
+    }
+    streamed.clear();
+}
+
 }  // namespace cryptonote::rpc
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <functional>
 #include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
 
 #include "common/json_binary_proxy.h"
+#include "common/json_chunks.h"
 
 namespace cryptonote::rpc {
 
@@ -68,6 +72,40 @@ struct RPC_COMMAND {
     ///   std::string data = "abc";
     ///   rpc.response_b64["foo"]["bar"] = data; // json: "YWJj", bt: "abc"
     tools::json_binary_proxy response_b64{response, tools::json_binary_proxy::fmt::base64};
+
+    /// Adds an array to the response whose elements are produced one at a time, after the command
+    /// returns, rather than being built up in `response`.  `fill(i, elem)` is called for each `i`
+    /// in [0, size) with an empty json object to fill in (the proxy encodes binary values the same
+    /// way as `response_hex`).  When the response is being written out as json each element is
+    /// serialized and released before the next one is produced, so a large list never exists as a
+    /// complete DOM.  The array is placed after all of the keys set in `response`, which must not
+    /// also contain `key`.  `fill` is called after the command has returned, so it must own (or
+    /// otherwise keep alive) whatever it needs.
+    ///
+    /// Usage:
+    ///   rpc.stream_array("items", items.size(), [items = std::move(items)](size_t i, auto elem) {
+    ///       (*elem)["height"] = items[i].height;
+    ///       elem["hash"] = items[i].hash;  // hex for json, binary for bt
+    ///   });
+    void stream_array(
+            std::string key,
+            size_t size,
+            std::function<void(size_t i, tools::json_binary_proxy elem)> fill);
+
+    /// Writes the json response, including any streamed arrays, into `out`.
+    void write_response(tools::json_chunks& out);
+
+    /// Builds any streamed arrays into `response` for callers that need the complete response
+    /// value (e.g. to bt-encode it).
+    void fill_streamed();
+
+  private:
+    struct streamed_array {
+        std::string key;
+        size_t size;
+        std::function<void(size_t i, tools::json_binary_proxy elem)> fill;
+    };
+    std::vector<streamed_array> streamed;
 };
 
 /// Tag types that are used (via inheritance) to set rpc endpoint properties
@@ -4,6 +4,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include "common/json_chunks.h"
 #include "json_bt.h"
 
 namespace cryptonote::rpc {
@@ -93,6 +94,11 @@ struct rpc_request {
 
     // Values to pass through to the invoke() call
     rpc_context context;
+
+    // If set, a json (i.e. non-bt) response is written into this as it is serialized, rather than
+    // being returned, and the invoke() call returns a null json value instead.  The caller can
+    // give the json_chunks a sink to start sending the response before it is complete.
+    tools::json_chunks* json_out = nullptr;
 };
 
 // Note: to use, parse_request(RPC, rpc_input) must be defined for each typename RPC
@@ -124,6 +130,12 @@ auto make_invoke() {
         if (rpc.response.is_null())
             rpc.response = json::object();
 
+        if (!rpc.is_bt() && request.json_out) {
+            rpc.write_response(*request.json_out);
+            return json{};
+        }
+
+        rpc.fill_streamed();
         if (rpc.is_bt())
             return json_to_bt(std::move(rpc.response));
         else
@@ -68,6 +68,7 @@
 #include "cryptonote_core/uptime_proof.h"
 #include "epee/net/network_throttle.hpp"
 #include "epee/string_tools.h"
+#include "logging/oxen_logger.h"
 #include "net/parse.h"
 #include "oxen/log.hpp"
 #include "oxen_economy.h"
@@ -292,6 +293,7 @@ void core_rpc_server::invoke(GET_INFO& info, rpc_context context) {
             info.response["last_lokinet_ping"] = m_core.m_last_lokinet_ping.load();
         }
         info.response["free_space"] = m_core.get_free_space();
+        info.response["dropped_log_messages"] = oxen::logging::dropped_log_messages();
     }
 
     if (m_core.offline())
@@ -309,20 +311,16 @@ void core_rpc_server::invoke(GET_INFO& info, rpc_context context) {
 void core_rpc_server::invoke(GET_NET_STATS& get_net_stats, rpc_context context) {
     get_net_stats.response["start_time"] = m_core.get_start_time();
     {
-        std::lock_guard lock{
-                epee::net_utils::network_throttle_manager::m_lock_get_global_throttle_in};
         auto [packets, bytes] =
                 epee::net_utils::network_throttle_manager::get_global_throttle_in().get_stats();
         get_net_stats.response["total_packets_in"] = packets;
         get_net_stats.response["total_bytes_in"] = bytes;
     }
     {
-        std::lock_guard lock{
-                epee::net_utils::network_throttle_manager::m_lock_get_global_throttle_out};
         auto [packets, bytes] =
                 epee::net_utils::network_throttle_manager::get_global_throttle_out().get_stats();
-        get_net_stats.response["total_packets_in"] = packets;
-        get_net_stats.response["total_bytes_in"] = bytes;
+        get_net_stats.response["total_packets_out"] = packets;
+        get_net_stats.response["total_bytes_out"] = bytes;
     }
     get_net_stats.response["status"] = STATUS_OK;
 }
@@ -1437,6 +1435,24 @@ void core_rpc_server::fill_block_header_response(
         block_header_response& response,
         bool fill_pow_hash,
         bool get_tx_hashes) {
+    auto infos = m_core.get_blockchain_storage().get_db().get_block_info_range(height, height);
+    if (infos.empty())
+        throw rpc_error{
+                ERROR_INTERNAL,
+                "Internal error: can't get block info by height. Height = {}."_format(height)};
+    fill_block_header_response(
+            blk, orphan_status, infos.front(), hash, response, fill_pow_hash, get_tx_hashes);
+}
+//------------------------------------------------------------------------------------------------------------------------------
+void core_rpc_server::fill_block_header_response(
+        const block& blk,
+        bool orphan_status,
+        const block_info_t& info,
+        const crypto::hash& hash,
+        block_header_response& response,
+        bool fill_pow_hash,
+        bool get_tx_hashes) {
+    const uint64_t height = info.height;
     response.major_version = static_cast<uint8_t>(blk.major_version);
     response.minor_version = blk.minor_version;
     response.timestamp = blk.timestamp;
@@ -1446,19 +1462,15 @@ void core_rpc_server::fill_block_header_response(
     response.height = height;
     response.depth = m_core.get_current_blockchain_height() - height - 1;
     response.hash = tools::type_to_hex(hash);
-    response.difficulty = m_core.get_blockchain_storage().block_difficulty(height);
-    response.cumulative_difficulty =
-            m_core.get_blockchain_storage().get_db().get_block_cumulative_difficulty(height);
-    response.block_weight = m_core.get_blockchain_storage().get_db().get_block_weight(height);
+    response.difficulty = info.difficulty;
+    response.cumulative_difficulty = info.cumulative_difficulty;
     response.reward = (blk.reward > 0) ? blk.reward : get_block_reward(blk);
-    response.block_size = response.block_weight =
-            m_core.get_blockchain_storage().get_db().get_block_weight(height);
+    response.block_size = response.block_weight = info.weight;
     response.num_txes = blk.tx_hashes.size();
     if (fill_pow_hash)
         response.pow_hash = tools::type_to_hex(get_block_longhash_w_blockchain(
                 m_core.get_nettype(), &m_core.get_blockchain_storage(), blk, height, 0));
-    response.long_term_weight =
-            m_core.get_blockchain_storage().get_db().get_block_long_term_weight(height);
+    response.long_term_weight = info.long_term_weight;
     response.service_node_winner =
             tools::type_to_hex(blk.service_node_winner_key) == ""
                     ? tools::type_to_hex(
@@ -1474,6 +1486,96 @@ void core_rpc_server::fill_block_header_response(
     }
 }
 //------------------------------------------------------------------------------------------------------------------------------
+void core_rpc_server::get_block_headers(
+        uint64_t start_height,
+        uint64_t end_height,
+        bool fill_pow_hash,
+        bool get_tx_hashes,
+        std::vector<block_header_response>& headers) {
+    auto& db = m_core.get_blockchain_storage().get_db();
+    std::vector<block_info_t> infos;
+    try {
+        infos = db.get_block_info_range(start_height, end_height);
+    } catch (const BLOCK_DNE&) {
+        throw rpc_error{
+                ERROR_INTERNAL,
+                "Internal error: can't get block info for heights {}-{}."_format(
+                        start_height, end_height)};
+    }
+    if (infos.size() != end_height - start_height + 1)
+        throw rpc_error{ERROR_INTERNAL, "Internal error: unexpected number of block infos."};
+
+    const uint64_t curr_height = m_core.get_current_blockchain_height();
+    const uint64_t cache_from =
+            curr_height > HEADER_CACHE_BLOCKS ? curr_height - HEADER_CACHE_BLOCKS : 0;
+    const size_t first = headers.size();
+    headers.resize(first + infos.size());
+
+    // Pull whatever we can out of the cache; the pow hash needs the block so it always misses.
+    std::vector<size_t> missing;
+    {
+        std::lock_guard lock{m_header_cache_mutex};
+        for (size_t i = 0; i < infos.size(); ++i) {
+            auto it = fill_pow_hash ? m_header_cache.end() : m_header_cache.find(infos[i].height);
+            if (it == m_header_cache.end() || it->second.first != infos[i].hash) {
+                missing.push_back(i);
+                continue;
+            }
+            auto& hdr = headers[first + i];
+            hdr = it->second.second;
+            hdr.depth = curr_height - hdr.height - 1;
+            if (!get_tx_hashes)
+                hdr.tx_hashes.clear();
+        }
+    }
+    if (missing.empty())
+        return;
+
+    std::vector<std::pair<uint64_t, std::pair<crypto::hash, block_header_response>>> to_cache;
+    size_t next = 0;
+    db.for_blocks_range(
+            infos[missing.front()].height,
+            infos[missing.back()].height,
+            [&](uint64_t height, const crypto::hash& hash, const block& blk) {
+                const size_t i = missing[next];
+                if (height != infos[i].height)
+                    return true;  // Already filled from the cache
+                if (blk.miner_tx.vin.size() != 1 ||
+                    !std::holds_alternative<txin_gen>(blk.miner_tx.vin.front()))
+                    throw rpc_error{
+                            ERROR_INTERNAL,
+                            "Internal error: coinbase transaction in the block has the wrong type"};
+                if (var::get<txin_gen>(blk.miner_tx.vin.front()).height != height)
+                    throw rpc_error{
+                            ERROR_INTERNAL,
+                            "Internal error: coinbase transaction in the block has the wrong "
+                            "height"};
+                auto& hdr = headers[first + i];
+                fill_block_header_response(
+                        blk, false, infos[i], hash, hdr, fill_pow_hash, true /*tx hashes*/);
+                if (height >= cache_from && hash == infos[i].hash) {
+                    auto& cached =
+                            to_cache.emplace_back(height, std::make_pair(hash, hdr)).second.second;
+                    cached.pow_hash.reset();
+                }
+                if (!get_tx_hashes)
+                    hdr.tx_hashes.clear();
+                return ++next < missing.size();
+            });
+    if (next != missing.size())
+        throw rpc_error{
+                ERROR_INTERNAL,
+                "Internal error: can't get block by height. Height = {}."_format(
+                        infos[missing[next]].height)};
+
+    if (to_cache.empty())
+        return;
+    std::lock_guard lock{m_header_cache_mutex};
+    for (auto& [height, entry] : to_cache)
+        m_header_cache.insert_or_assign(height, std::move(entry));
+    m_header_cache.erase(m_header_cache.begin(), m_header_cache.lower_bound(cache_from));
+}
+//------------------------------------------------------------------------------------------------------------------------------
 void core_rpc_server::invoke(GET_LAST_BLOCK_HEADER& get_last_block_header, rpc_context context) {
     if (!check_core_ready()) {
         get_last_block_header.response["status"] = STATUS_BUSY;
@@ -1557,33 +1659,13 @@ void core_rpc_server::invoke(
     if (start_height >= bc_height || end_height >= bc_height || start_height > end_height)
         throw rpc_error{ERROR_TOO_BIG_HEIGHT, "Invalid start/end heights."};
     std::vector<block_header_response> headers;
-    for (uint64_t h = start_height; h <= end_height; ++h) {
-        block blk;
-        bool have_block = m_core.get_block_by_height(h, blk);
-        if (!have_block)
-            throw rpc_error{
-                    ERROR_INTERNAL,
-                    "Internal error: can't get block by height. Height = {}."_format(h)};
-        if (blk.miner_tx.vin.size() != 1 ||
-            !std::holds_alternative<txin_gen>(blk.miner_tx.vin.front()))
-            throw rpc_error{
-                    ERROR_INTERNAL,
-                    "Internal error: coinbase transaction in the block has the wrong type"};
-        uint64_t block_height = var::get<txin_gen>(blk.miner_tx.vin.front()).height;
-        if (block_height != h)
-            throw rpc_error{
-                    ERROR_INTERNAL,
-                    "Internal error: coinbase transaction in the block has the wrong height"};
-        auto& hdr = headers.emplace_back();
-        fill_block_header_response(
-                blk,
-                false,
-                block_height,
-                get_block_hash(blk),
-                hdr,
-                get_block_headers_range.request.fill_pow_hash && context.admin,
-                get_block_headers_range.request.get_tx_hashes);
-    }
+    headers.reserve(end_height - start_height + 1);
+    get_block_headers(
+            start_height,
+            end_height,
+            get_block_headers_range.request.fill_pow_hash && context.admin,
+            get_block_headers_range.request.get_tx_hashes,
+            headers);
     get_block_headers_range.response["headers"] = headers;
     get_block_headers_range.response["status"] = STATUS_OK;
     return;
@@ -1595,33 +1677,26 @@ void core_rpc_server::invoke(
                 curr_height = m_core.get_current_blockchain_height(),
                 pow = get_block_header_by_height.request.fill_pow_hash && context.admin,
                 tx_hashes = get_block_header_by_height.request.get_tx_hashes](
-                       uint64_t height, block_header_response& bhr) {
+                       uint64_t height, std::vector<block_header_response>& headers) {
         if (height >= curr_height)
             throw rpc_error{
                     ERROR_TOO_BIG_HEIGHT,
                     "Requested block height: " + std::to_string(height) +
                             " greater than current top block height: " +
                             std::to_string(curr_height - 1)};
-        block blk;
-        bool have_block = m_core.get_block_by_height(height, blk);
-        if (!have_block)
-            throw rpc_error{
-                    ERROR_INTERNAL,
-                    "Internal error: can't get block by height. Height = " +
-                            std::to_string(height) + '.'};
-        fill_block_header_response(blk, false, height, get_block_hash(blk), bhr, pow, tx_hashes);
+        get_block_headers(height, height, pow, tx_hashes, headers);
     };
 
-    block_header_response header;
     if (get_block_header_by_height.request.height) {
+        std::vector<block_header_response> header;
         get(*get_block_header_by_height.request.height, header);
-        get_block_header_by_height.response["block_header"] = header;
+        get_block_header_by_height.response["block_header"] = header.front();
     }
     std::vector<block_header_response> headers;
     if (!get_block_header_by_height.request.heights.empty())
         headers.reserve(get_block_header_by_height.request.heights.size());
     for (auto height : get_block_header_by_height.request.heights)
-        get(height, headers.emplace_back());
+        get(height, headers);
 
     get_block_header_by_height.response["status"] = STATUS_OK;
     get_block_header_by_height.response["block_headers"] = headers;
@@ -2857,14 +2932,18 @@ void core_rpc_server::invoke(GET_SERVICE_NODES& sns, rpc_context context) {
         sn_infos.resize(req.limit);
     }
 
-    auto& sn_states = (sns.response["service_node_states"] = json::array());
-    for (auto& pubkey_info : sn_infos)
-        fill_sn_response_entry(
-                sn_states.emplace_back(json::object()),
-                sns.is_bt(),
-                req.fields,
-                pubkey_info,
-                top_height);
+    // This can be a large list, so let the entries get built (and, for json, serialized) one at a
+    // time instead of putting them all into the response at once.
+    sns.stream_array(
+            "service_node_states",
+            sn_infos.size(),
+            [this,
+             is_bt = sns.is_bt(),
+             fields = std::move(req.fields),
+             sn_infos = std::move(sn_infos),
+             top_height = top_height](size_t i, json_binary_proxy entry) {
+                fill_sn_response_entry(*entry, is_bt, fields, sn_infos[i], top_height);
+            });
 }
 
 namespace {
@@ -33,7 +33,9 @@
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <variant>
 
 #include "core_rpc_server_binary_commands.h"
@@ -240,9 +242,32 @@ class core_rpc_server {
             block_header_response& response,
             bool fill_pow_hash,
             bool get_tx_hashes);
+    void fill_block_header_response(
+            const block& blk,
+            bool orphan_status,
+            const block_info_t& info,
+            const crypto::hash& hash,
+            block_header_response& response,
+            bool fill_pow_hash,
+            bool get_tx_hashes);
+    // Appends the headers of the main chain blocks [start_height, end_height] to `headers`,
+    // reading the block metadata in a single pass and reusing recently built headers.
+    void get_block_headers(
+            uint64_t start_height,
+            uint64_t end_height,
+            bool fill_pow_hash,
+            bool get_tx_hashes,
+            std::vector<block_header_response>& headers);
 
     core& m_core;
     nodetool::node_server<cryptonote::t_cryptonote_protocol_handler<cryptonote::core>>& m_p2p;
+
+    // Headers of recent main chain blocks, keyed by height along with the hash they were built
+    // for, so that a reorg simply makes the entry miss.  Entries always include the tx hashes and
+    // never the pow hash.
+    static constexpr uint64_t HEADER_CACHE_BLOCKS = 1024;
+    std::mutex m_header_cache_mutex;
+    std::map<uint64_t, std::pair<crypto::hash, block_header_response>> m_header_cache;
 };
 
 }  // namespace cryptonote::rpc
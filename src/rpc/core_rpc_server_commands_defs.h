@@ -559,6 +559,8 @@ struct MINING_STATUS : LEGACY, NO_ARGS {
 ///   as a service node)
 /// - `last_lokinet_ping` -- Last ping time of lokinet (0 if never or not running as a service node)
 /// - `free_space` -- Available disk space on the node.
+/// - `dropped_log_messages` -- Number of log messages dropped because the log file writer couldn't
+///   keep up.
 ///
 /// Example-JSON-Fetch
 struct GET_INFO : PUBLIC, LEGACY, NO_ARGS {
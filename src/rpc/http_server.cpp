@@ -3,11 +3,17 @@
 
 #include <oxenc/variant.h>
 
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <variant>
 
 #include "common/command_line.h"
+#include "common/json_chunks.h"
 #include "common/string_util.h"
 #include "cryptonote_config.h"
 #include "cryptonote_core/cryptonote_core.h"
@@ -225,12 +231,24 @@ namespace {
         std::string uri;
         const rpc_command* call{nullptr};
         rpc_request request{};
-        bool aborted{false};
+        std::atomic<bool> aborted{false};
         bool replied{false};
         bool jsonrpc{false};
         nlohmann::json jsonrpc_id{nullptr};
         std::vector<std::pair<std::string, std::string>> extra_headers;  // Extra headers to send
 
+        // State for a json response that gets sent while it is still being serialized: the OMQ
+        // worker producing the body hands each chunk over to the uWS loop thread, which buffers
+        // them in `pending` and writes them out as the client takes them (see stream_chunk() and
+        // send_pending()).  Everything but `pending_bytes` belongs to the uWS thread.
+        std::atomic<size_t> pending_bytes{0};  // Handed over but not yet written
+        std::deque<std::string> pending;
+        bool stream_done{false};    // No more chunks are coming
+        bool stream_failed{false};  // The response failed after part of it had been sent
+        bool headers_sent{false};
+        bool writable{true};  // false while waiting for onWritable
+        bool finished{false};  // The streamed response has been ended
+
         // If we have to drop the request because we are overloaded we want to reply with an error
         // (so that we close the connection instead of leaking it and leaving it hanging).  We don't
         // do this, of course, if the request got aborted and replied to.
@@ -273,8 +291,9 @@ namespace {
         }
     };
 
-    // Queues a response for the HTTP thread to handle
-    void queue_response(std::shared_ptr<call_data> data, std::string body) {
+    // Queues a response for the HTTP thread to handle.  The body is shared so that a single encoded
+    // response (e.g. a long poll update) can be queued for many requests without copying it.
+    void queue_response(std::shared_ptr<call_data> data, std::shared_ptr<const std::string> body) {
         auto& http = data->http;
         data->replied = true;
         http.loop_defer([data = std::move(data), body = std::move(body)] {
@@ -291,12 +310,99 @@ namespace {
                     res.writeHeader("Connection", "close");
                 for (const auto& [name, value] : data->extra_headers)
                     res.writeHeader(name, value);
-                res.end(body);
+                res.end(*body);
                 if (data->http.closing())
                     res.close();
             });
         });
     }
+    void queue_response(std::shared_ptr<call_data> data, std::string body) {
+        queue_response(std::move(data), std::make_shared<const std::string>(std::move(body)));
+    }
+
+    // How much of a streamed response may be waiting for the client to read it.  The worker
+    // producing the response never waits on the client (a few slow clients could otherwise tie up
+    // every RPC worker); a response that gets this far ahead of its client is abandoned instead.
+    constexpr size_t STREAM_MAX_PENDING_BYTES = 32 * 1024 * 1024;
+
+    // Thrown out of the response serialization to stop producing a streamed response when the
+    // client has gone away.
+    struct response_aborted {};
+
+    // Writes out whatever chunks of a streamed json response are buffered, stopping if the socket
+    // stops taking them (uWS then buffers the last one, and onWritable picks things back up).  Once
+    // the producer is done this ends the response or, if it failed part way through, closes the
+    // connection because there is no way to turn a partially sent body into an error.  Must be
+    // called from the uWS loop thread.
+    void send_pending(const std::shared_ptr<call_data>& data) {
+        if (data->aborted || data->finished || !data->writable)
+            return;
+        auto& res = data->res;
+        res.cork([&] {
+            if (!data->headers_sent) {
+                data->headers_sent = true;
+                res.onWritable([data](uint64_t) {
+                    data->writable = true;
+                    send_pending(data);
+                    return data->writable;
+                });
+                res.writeHeader("Server", data->http.server_header());
+                res.writeHeader("Content-Type", "application/json"sv);
+                if (data->http.closing())
+                    res.writeHeader("Connection", "close");
+                for (const auto& [name, value] : data->extra_headers)
+                    res.writeHeader(name, value);
+            }
+            if (data->stream_done && data->stream_failed) {
+                // The body gets cut off regardless, so don't bother sending the rest of it
+                data->finished = true;
+                data->pending.clear();
+                res.close();
+                return;
+            }
+            while (!data->pending.empty()) {
+                std::string chunk = std::move(data->pending.front());
+                data->pending.pop_front();
+                data->pending_bytes -= chunk.size();
+                if (!res.write(chunk)) {
+                    data->writable = false;
+                    return;
+                }
+            }
+            if (data->stream_done) {
+                data->finished = true;
+                res.end();
+                if (data->http.closing())
+                    res.close();
+            }
+        });
+    }
+
+    // Hands a chunk of a json response over to the uWS thread to be sent.  This is the sink of the
+    // json_chunks that the response gets serialized into, and so is called on the worker thread
+    // while the rest of the response is still being produced.
+    void stream_chunk(const std::shared_ptr<call_data>& data, std::string chunk) {
+        if (data->aborted)
+            throw response_aborted{};
+        if (data->pending_bytes + chunk.size() > STREAM_MAX_PENDING_BYTES)
+            throw std::runtime_error{"client is not reading the response fast enough"};
+        data->pending_bytes += chunk.size();
+        data->replied = true;
+        data->http.loop_defer([data, chunk = std::move(chunk)]() mutable {
+            data->pending.push_back(std::move(chunk));
+            send_pending(data);
+        });
+    }
+
+    // Signals the end of a streamed response; `failed` indicates that the response could not be
+    // completed and the connection should be closed.
+    void finish_stream(const std::shared_ptr<call_data>& data, bool failed) {
+        data->http.loop_defer([data, failed] {
+            data->stream_done = true;
+            data->stream_failed = failed;
+            send_pending(data);
+        });
+    }
 
     void invoke_txpool_hashes_bin(std::shared_ptr<call_data> data);
 
@@ -322,22 +428,41 @@ namespace {
         std::string json_message = "Internal error";
         std::string http_message;
 
+        // Json responses are serialized by the command straight into chunks, as it produces them
+        // (see RPC_COMMAND::stream_array), and each chunk is handed off to the uWS thread as soon
+        // as it fills so that large responses start going out before they are complete.  A
+        // response that fits in a single chunk is just sent in one piece at the end.  Binary
+        // responses come back already encoded.
+        tools::json_chunks json_result{
+                [&dataptr](std::string chunk) { stream_chunk(dataptr, std::move(chunk)); }};
         std::string result;
         try {
+            if (!data.call->is_binary) {
+                data.request.json_out = &json_result;
+                if (data.jsonrpc) {
+                    // Same output as dumping {"id":..., "jsonrpc":"2.0", "result":...}, but
+                    // without having to build the wrapper object.
+                    json_result.append(R"({"id":)"sv);
+                    json_result.append(data.jsonrpc_id);
+                    json_result.append(R"(,"jsonrpc":"2.0","result":)"sv);
+                }
+            }
             auto r = data.call->invoke(std::move(data.request), data.core_rpc);
-            if (data.jsonrpc)
-                result =
-                        nlohmann::json{
-                                {"jsonrpc", "2.0"},
-                                {"id", data.jsonrpc_id},
-                                {"result", var::get<nlohmann::json>(std::move(r))}}
-                                .dump();
-            else if (auto* json = std::get_if<nlohmann::json>(&r))
-                result = json->dump();
-            else
+            if (data.call->is_binary)
                 result = var::get<std::string>(std::move(r));
-            // And throw if we get back a bt_value because we don't accept that at all
+            else if (!std::holds_alternative<nlohmann::json>(r))
+                // A bt_value, which we don't accept at all
+                throw std::runtime_error{"RPC command returned a bt-encoded response"};
+            else {
+                if (data.jsonrpc)
+                    json_result.append('}');
+                if (json_result.sent() > 0)
+                    json_result.flush();
+            }
             json_error = 0;
+        } catch (const response_aborted&) {
+            // The client went away in the middle of a streamed response
+            return;
         } catch (const parse_error& e) {
             // This isn't really WARNable as it's the client fault; log at info level instead.
             log::info(
@@ -361,6 +486,9 @@ namespace {
         }
 
         if (json_error != 0) {
+            // Once part of the response has gone out all we can do is cut it off
+            if (json_result.sent() > 0)
+                return finish_stream(dataptr, true);
             data.http.loop_defer([data = std::move(dataptr),
                                   json_error,
                                   msg = std::move(data.jsonrpc ? json_message : http_message)] {
@@ -385,10 +513,18 @@ namespace {
                     "HTTP RPC {} [{}] OK ({} bytes){}",
                     data.uri,
                     data.request.context.remote,
-                    result.size(),
+                    data.call->is_binary ? result.size() : json_result.size(),
                     call_duration);
 
-        queue_response(std::move(dataptr), std::move(result));
+        if (json_result.sent() > 0)
+            finish_stream(dataptr, false);
+        else if (data.call->is_binary)
+            queue_response(std::move(dataptr), std::move(result));
+        else
+            queue_response(
+                    std::move(dataptr),
+                    json_result.empty() ? std::string{}
+                                        : std::move(json_result.chunks().front()));
     }
 
     std::string pool_hashes_response(std::vector<crypto::hash>&& pool_hashes) {
@@ -401,8 +537,55 @@ namespace {
         return response;
     }
 
-    std::list<std::pair<std::shared_ptr<call_data>, std::chrono::steady_clock::time_point>>
-            long_pollers;
+    // The encoded pool hashes response for a given pool state.  Computing this requires a walk of
+    // the whole pool (under the pool and blockchain locks), so we compute it once per pool version
+    // and share the encoded body between every request that asks for it until the pool changes.
+    struct pool_hashes_snapshot {
+        uint64_t cookie;
+        crypto::hash checksum;
+        std::shared_ptr<const std::string> body;
+    };
+
+    // Indexed by [admin][blinked_only]
+    std::optional<pool_hashes_snapshot> pool_snapshots[2][2];
+    std::mutex pool_snapshot_mutex;
+
+    pool_hashes_snapshot get_pool_hashes(tx_memory_pool& pool, bool admin, bool blinked_only) {
+        std::lock_guard lock{pool_snapshot_mutex};
+        auto& snap = pool_snapshots[admin][blinked_only];
+        // Read the cookie *before* fetching so that a change that races with us leaves a stale
+        // cookie (and thus a recompute next time) rather than a stale body.
+        const uint64_t cookie = pool.cookie();
+        if (snap && snap->cookie == cookie)
+            return *snap;
+
+        std::vector<crypto::hash> pool_hashes;
+        pool.get_transaction_hashes(pool_hashes, admin, blinked_only);
+        crypto::hash checksum{};
+        for (const auto& h : pool_hashes)
+            checksum ^= h;
+        snap = pool_hashes_snapshot{
+                cookie,
+                checksum,
+                std::make_shared<const std::string>(pool_hashes_response(std::move(pool_hashes)))};
+        return *snap;
+    }
+
+    // Blink approvals change the blinked-only responses without changing the pool cookie, so the
+    // long poll trigger has to explicitly throw away anything we have cached.
+    void invalidate_pool_snapshots() {
+        std::lock_guard lock{pool_snapshot_mutex};
+        for (auto& by_admin : pool_snapshots)
+            for (auto& snap : by_admin)
+                snap.reset();
+    }
+
+    struct long_poller {
+        std::shared_ptr<call_data> data;
+        std::chrono::steady_clock::time_point expiry;
+        bool blinked_only;
+    };
+    std::list<long_poller> long_pollers;
     std::mutex long_poll_mutex;
 
     // HTTP-only long-polling support for the transaction pool hashes command
@@ -417,17 +600,13 @@ namespace {
         if (!epee::serialization::load_t_from_binary(req, body))
             throw parse_error{"Failed to parse binary data parameters"};
 
-        std::vector<crypto::hash> pool_hashes;
-        data->core_rpc.get_core().get_pool().get_transaction_hashes(
-                pool_hashes,
+        auto snapshot = get_pool_hashes(
+                data->core_rpc.get_core().get_pool(),
                 data->request.context.admin,
-                req.blinked_txs_only /*include_only_blinked*/);
+                req.blinked_txs_only);
 
         if (req.long_poll) {
-            crypto::hash checksum{};
-            for (const auto& h : pool_hashes)
-                checksum ^= h;
-
+            const auto& checksum = snapshot.checksum;
             if (req.tx_pool_checksum == checksum) {
                 // Hashes match, which means we need to defer this request until later.
                 std::lock_guard lock{long_poll_mutex};
@@ -437,10 +616,11 @@ namespace {
                         "checksum matches current pool ({})",
                         data->request.context.remote,
                         checksum);
-                long_pollers.emplace_back(
+                long_pollers.push_back(long_poller{
                         std::move(data),
                         std::chrono::steady_clock::now() +
-                                GET_TRANSACTION_POOL_HASHES_BIN::long_poll_timeout);
+                                GET_TRANSACTION_POOL_HASHES_BIN::long_poll_timeout,
+                        req.blinked_txs_only});
                 return;
             }
 
@@ -454,12 +634,14 @@ namespace {
         }
 
         // Either not a long poll request or checksum didn't match
-        queue_response(std::move(data), pool_hashes_response(std::move(pool_hashes)));
+        queue_response(std::move(data), std::move(snapshot.body));
     }
 
     // This get invoked (from cryptonote_core.cpp) whenever the mempool is added to.  We queue
     // responses for everyone currently waiting.
     void long_poll_trigger(tx_memory_pool& pool) {
+        invalidate_pool_snapshots();
+
         std::lock_guard lock{long_poll_mutex};
         if (long_pollers.empty())
             return;
@@ -469,27 +651,25 @@ namespace {
                 "TX pool changed; sending tx pool to {} pending long poll connections",
                 long_pollers.size());
 
-        std::optional<std::string> body_public, body_admin;
+        // Each distinct response gets computed and encoded at most once, then shared by every
+        // waiting connection that wants it.
+        std::shared_ptr<const std::string> bodies[2][2];
 
-        for (auto& [dataptr, expiry] : long_pollers) {
+        for (auto& [dataptr, expiry, blinked_only] : long_pollers) {
             auto& data = *dataptr;
-            auto& body = data.request.context.admin ? body_admin : body_public;
-            if (!body) {
-                std::vector<crypto::hash> pool_hashes;
-                pool.get_transaction_hashes(
-                        pool_hashes, data.request.context.admin, true /*include_only_blinked*/);
-                body = pool_hashes_response(std::move(pool_hashes));
-            }
+            auto& body = bodies[data.request.context.admin][blinked_only];
+            if (!body)
+                body = get_pool_hashes(pool, data.request.context.admin, blinked_only).body;
             log::trace(
                     logcat,
                     "Sending deferred long poll pool update to {}",
                     data.request.context.remote);
-            queue_response(std::move(dataptr), *body);
+            queue_response(std::move(dataptr), body);
         }
         long_pollers.clear();
     }
 
-    std::string long_poll_timeout_body;
+    std::shared_ptr<const std::string> long_poll_timeout_body;
 
     // Called periodically to clear expired Starts up a periodic timer for checking for expired long
     // poll requests.  We run this only once a second because we don't really care if we time out at
@@ -500,21 +680,23 @@ namespace {
         if (long_pollers.empty())
             return;
 
-        if (long_poll_timeout_body.empty()) {
+        if (!long_poll_timeout_body) {
             GET_TRANSACTION_POOL_HASHES_BIN::response res{};
             res.status = STATUS_TX_LONG_POLL_TIMED_OUT;
-            epee::serialization::store_t_to_binary(res, long_poll_timeout_body);
+            std::string body;
+            epee::serialization::store_t_to_binary(res, body);
+            long_poll_timeout_body = std::make_shared<const std::string>(std::move(body));
         }
 
         int count = 0;
         auto now = std::chrono::steady_clock::now();
         for (auto it = long_pollers.begin(); it != long_pollers.end();) {
-            if (it->second < now) {
+            if (it->expiry < now) {
                 log::trace(
                         logcat,
                         "Sending long poll timeout to {}",
-                        it->first->request.context.remote);
-                queue_response(std::move(it->first), long_poll_timeout_body);
+                        it->data->request.context.remote);
+                queue_response(std::move(it->data), long_poll_timeout_body);
                 it = long_pollers.erase(it);
                 count++;
             } else
@@ -710,10 +892,12 @@ void http_server::shutdown(bool join) {
                     log::trace(logcat, "closing pending long poll requests");
                     std::lock_guard lock{long_poll_mutex};
                     for (auto it = long_pollers.begin(); it != long_pollers.end();) {
-                        if (&it->first->http != this)
+                        if (&it->data->http != this) {
+                            ++it;
                             continue;  // Belongs to some other http_server instance
-                        it->first->aborted = true;
-                        it->first->res.close();
+                        }
+                        it->data->aborted = true;
+                        it->data->res.close();
                         it = long_pollers.erase(it);
                     }
                 }
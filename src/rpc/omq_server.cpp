@@ -332,10 +332,14 @@ namespace cryptonote { namespace rpc {
                                            const tx_pool_options& opts) {
             send_mempool_notifications(id, tx, blob, opts);
         });
+        omq.add_timer([this] { flush_mempool_notifications(); }, mempool_notify_interval);
     }
 
-    template <typename Mutex, typename Subs, typename Call>
-    static void send_notifies(Mutex& mutex, Subs& subs, const char* desc, Call call) {
+    // Calls `collect(conn, sub)` for each unexpired subscription in `subs`, and removes the expired
+    // ones.  The subscription lock is only held while collecting, so `collect` should just copy out
+    // what it needs; the actual sending happens afterwards, without the lock.
+    template <typename Mutex, typename Subs, typename Collect>
+    static void collect_subscribers(Mutex& mutex, Subs& subs, const char* desc, Collect collect) {
         std::vector<oxenmq::ConnectionID> remove;
         {
             std::shared_lock lock{mutex};
@@ -345,15 +349,11 @@ namespace cryptonote { namespace rpc {
 
             auto now = std::chrono::steady_clock::now();
 
-            for (const auto& sub_pair : subs) {
-                auto& conn = sub_pair.first;
-                auto& sub = sub_pair.second;
-                if (sub.expiry < now) {
+            for (const auto& [conn, sub] : subs) {
+                if (sub.expiry < now)
                     remove.push_back(conn);
-                    continue;
-                } else {
-                    call(conn, sub);
-                }
+                else
+                    collect(conn, sub);
             }
         }
 
@@ -377,11 +377,18 @@ namespace cryptonote { namespace rpc {
     }
 
     void omq_rpc::send_block_notifications(const block& block) {
-        auto& omq = core_.get_omq();
-        std::string height = "{}"_format(get_block_height(block));
-        send_notifies(subs_mutex_, block_subs_, "block", [&](auto& conn, auto& sub) {
-            omq.send(conn, "notify.block", height, tools::view_guts(block.hash));
+        std::vector<oxenmq::ConnectionID> subs;
+        collect_subscribers(subs_mutex_, block_subs_, "block", [&](auto& conn, auto&) {
+            subs.push_back(conn);
         });
+        if (subs.empty())
+            return;
+
+        auto& omq = core_.get_omq();
+        const std::string height = "{}"_format(get_block_height(block));
+        const auto hash = tools::view_guts(block.hash);
+        for (auto& conn : subs)
+            omq.send(conn, "notify.block", height, hash);
     }
 
     void omq_rpc::send_mempool_notifications(
@@ -389,11 +396,60 @@ namespace cryptonote { namespace rpc {
             const transaction& tx,
             const std::string& blob,
             const tx_pool_options& opts) {
-        auto& omq = core_.get_omq();
-        send_notifies(subs_mutex_, mempool_subs_, "mempool", [&](auto& conn, auto& sub) {
-            if (sub.type == mempool_sub_type::all || opts.approved_blink)
-                omq.send(conn, "notify.mempool", tools::view_guts(id), blob);
+        {
+            // Don't bother queuing anything if no one is listening
+            std::shared_lock lock{subs_mutex_};
+            if (mempool_subs_.empty())
+                return;
+        }
+
+        std::lock_guard lock{pending_mempool_mutex_};
+        if (!pending_mempool_ids_.insert(id).second) {
+            // Already queued (e.g. a blink tx that got its approval after first being added): we
+            // just need to upgrade the existing entry so that blink subscribers get it, too.
+            if (opts.approved_blink)
+                for (auto& p : pending_mempool_)
+                    if (p.txid == tools::view_guts(id))
+                        p.approved_blink = true;
+            return;
+        }
+        pending_mempool_.push_back({std::string{tools::view_guts(id)}, blob, opts.approved_blink});
+    }
+
+    void omq_rpc::flush_mempool_notifications() {
+        std::vector<pending_mempool_notify> pending;
+        {
+            std::lock_guard lock{pending_mempool_mutex_};
+            if (pending_mempool_.empty())
+                return;
+            pending.swap(pending_mempool_);
+            pending_mempool_ids_.clear();
+        }
+
+        // Split the subscribers once per batch rather than re-checking each subscription type for
+        // every tx.
+        std::vector<oxenmq::ConnectionID> all_subs, blink_subs;
+        collect_subscribers(subs_mutex_, mempool_subs_, "mempool", [&](auto& conn, auto& sub) {
+            (sub.type == mempool_sub_type::all ? all_subs : blink_subs).push_back(conn);
         });
+        if (all_subs.empty() && blink_subs.empty())
+            return;
+
+        log::trace(
+                logcat,
+                "Sending {} mempool notifications to {} (all) + {} (blink) subscribers",
+                pending.size(),
+                all_subs.size(),
+                blink_subs.size());
+
+        auto& omq = core_.get_omq();
+        for (const auto& p : pending) {
+            for (auto& conn : all_subs)
+                omq.send(conn, "notify.mempool", p.txid, p.blob);
+            if (p.approved_blink)
+                for (auto& conn : blink_subs)
+                    omq.send(conn, "notify.mempool", p.txid, p.blob);
+        }
     }
 
     /// Get a set of blocks, their transactions, and their created outputs' global indices
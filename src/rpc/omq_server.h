@@ -33,6 +33,10 @@
 #include "cryptonote_core/blockchain.h"
 #include "oxenmq/connections.h"
 
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
 namespace oxenmq {
 class OxenMQ;
 }
@@ -58,13 +62,31 @@ class omq_rpc final {
         std::chrono::steady_clock::time_point expiry;
     };
 
+    // A mempool notification waiting to be flushed to subscribers.  The message parts are encoded
+    // once when queued and then shared by every subscriber it gets sent to.
+    struct pending_mempool_notify {
+        std::string txid;
+        std::string blob;
+        bool approved_blink;
+    };
+
     cryptonote::core& core_;
     core_rpc_server& rpc_;
     std::shared_timed_mutex subs_mutex_;
     std::unordered_map<oxenmq::ConnectionID, mempool_sub> mempool_subs_;
     std::unordered_map<oxenmq::ConnectionID, block_sub> block_subs_;
 
+    // Mempool additions are queued here (deduplicated by txid) and then flushed to subscribers in
+    // one pass every `mempool_notify_interval` so that a burst of txs costs us one walk of the
+    // subscriber list instead of one per tx.
+    std::mutex pending_mempool_mutex_;
+    std::vector<pending_mempool_notify> pending_mempool_;
+    std::unordered_set<crypto::hash> pending_mempool_ids_;
+
   public:
+    /// How often queued mempool notifications are flushed to mempool subscribers.
+    static constexpr std::chrono::milliseconds mempool_notify_interval{250};
+
     omq_rpc(cryptonote::core& core,
             core_rpc_server& rpc,
             const boost::program_options::variables_map& vm);
@@ -78,6 +100,10 @@ class omq_rpc final {
             const tx_pool_options& opts);
 
   private:
+    // Sends all queued mempool notifications to current subscribers.  Called periodically from an
+    // OxenMQ timer.
+    void flush_mempool_notifications();
+
     void on_get_blocks(oxenmq::Message& m);
 
     void on_mempool_sub_request(oxenmq::Message& m);
@@ -1641,6 +1641,7 @@ bool simple_wallet::set_ring(const std::vector<std::string>& args) {
         }
 
         char str[4096];
+        std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>> rings[2];  // abs, rel
         std::unique_ptr<FILE, tools::close_file> f(fopen(args[0].c_str(), "r"));
         if (f) {
             while (!feof(f.get())) {
@@ -1721,12 +1722,15 @@ bool simple_wallet::set_ring(const std::vector<std::string>& args) {
                 }
                 if (!valid)
                     continue;
-                if (!m_wallet->set_ring(key_image, ring, relative))
-                    fail_msg_writer() << tr("Failed to set ring for key image: ") << key_image
-                                      << ". " << tr("Continuing.");
+                rings[relative].emplace_back(key_image, std::move(ring));
             }
             f.reset();
         }
+        for (bool relative : {false, true})
+            if (!rings[relative].empty() && !m_wallet->set_rings(rings[relative], relative))
+                fail_msg_writer() << tr("Failed to set ") << rings[relative].size() << " "
+                                  << (relative ? tr("relative") : tr("absolute")) << " "
+                                  << tr("rings");
         return true;
     }
 
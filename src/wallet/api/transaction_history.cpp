@@ -30,6 +30,7 @@
 
 #include "transaction_history.h"
 
+#include <algorithm>
 #include <list>
 #include <string>
 
@@ -46,18 +47,18 @@ EXPORT
 TransactionHistory::~TransactionHistory() {}
 
 EXPORT
-TransactionHistoryImpl::TransactionHistoryImpl(WalletImpl* wallet) : m_wallet(wallet) {}
+TransactionHistoryImpl::TransactionHistoryImpl(WalletImpl* wallet) :
+        m_chain_height(std::make_shared<std::atomic<uint64_t>>(0)),
+        m_snapshot(std::make_shared<snapshot>()),
+        m_wallet(wallet) {}
 
 EXPORT
-TransactionHistoryImpl::~TransactionHistoryImpl() {
-    for (auto t : m_history)
-        delete t;
-}
+TransactionHistoryImpl::~TransactionHistoryImpl() = default;
 
 EXPORT
 int TransactionHistoryImpl::count() const {
     std::shared_lock lock{m_historyMutex};
-    int result = m_history.size();
+    int result = m_snapshot->list.size();
     return result;
 }
 
@@ -68,22 +69,24 @@ TransactionInfo* TransactionHistoryImpl::transaction(int index) const {
     if (index < 0)
         return nullptr;
     unsigned index_ = static_cast<unsigned>(index);
-    return index_ < m_history.size() ? m_history[index_] : nullptr;
+    const auto& history = m_snapshot->list;
+    return index_ < history.size() ? history[index_] : nullptr;
 }
 
 EXPORT
 TransactionInfo* TransactionHistoryImpl::transaction(std::string_view id) const {
     std::shared_lock lock{m_historyMutex};
-    auto itr = std::find_if(m_history.begin(), m_history.end(), [&](const TransactionInfo* ti) {
+    const auto& history = m_snapshot->list;
+    auto itr = std::find_if(history.begin(), history.end(), [&](const TransactionInfo* ti) {
         return ti->hash() == id;
     });
-    return itr != m_history.end() ? *itr : nullptr;
+    return itr != history.end() ? *itr : nullptr;
 }
 
 EXPORT
 std::vector<TransactionInfo*> TransactionHistoryImpl::getAll() const {
     std::shared_lock lock{m_historyMutex};
-    return m_history;
+    return m_snapshot->list;
 }
 
 static reward_type from_pay_type(wallet::pay_type ptype) {
@@ -94,87 +97,80 @@ static reward_type from_pay_type(wallet::pay_type ptype) {
     }
 }
 
+static std::string short_payment_id(const crypto::hash& id) {
+    std::string payment_id = tools::type_to_hex(id);
+    if (payment_id.substr(16).find_first_not_of('0') == std::string::npos)
+        payment_id = payment_id.substr(0, 16);
+    return payment_id;
+}
+
+EXPORT
+void TransactionHistoryImpl::invalidate(uint64_t height) {
+    // Lock-free: this gets called from wallet2 callbacks while the wallet is locked, and refresh()
+    // takes the wallet lock while holding m_historyMutex.
+    uint64_t current = m_invalid_from.load();
+    while (height < current && !m_invalid_from.compare_exchange_weak(current, height)) {}
+}
+
+void TransactionHistoryImpl::publish() {
+    auto snap = std::make_shared<snapshot>();
+    snap->entries.reserve(m_confirmed.size() + m_pending.size());
+    for (const auto& [height, ti] : m_confirmed)
+        snap->entries.push_back(ti);
+    snap->entries.insert(snap->entries.end(), m_pending.begin(), m_pending.end());
+    snap->list.reserve(snap->entries.size());
+    for (const auto& ti : snap->entries)
+        snap->list.push_back(ti.get());
+    m_snapshot = std::move(snap);
+}
+
 EXPORT
 void TransactionHistoryImpl::refresh() {
     // multithreaded access:
     // for "write" access, locking exclusively
     std::unique_lock lock{m_historyMutex};
 
-    // TODO: configurable values;
-    uint64_t min_height = 0;
-    uint64_t max_height = (uint64_t)-1;
+    auto w = m_wallet->wallet();
     uint64_t wallet_height = m_wallet->blockChainHeight();
 
-    // delete old transactions;
-    for (auto t : m_history)
-        delete t;
-    m_history.clear();
-
-    // transactions are stored in wallet2:
-    // - confirmed_transfer_details   - out transfers
-    // - unconfirmed_transfer_details - pending out transfers
-    // - payment_details              - input transfers
-
     // payments are "input transactions";
     // one input transaction contains only one transfer. e.g. <transaction_id> - <100XMR>
-
-    std::list<std::pair<crypto::hash, tools::wallet2::payment_details>> in_payments;
-    auto w = m_wallet->wallet();
-    w->get_payments(in_payments, min_height, max_height);
-    for (std::list<std::pair<crypto::hash, tools::wallet2::payment_details>>::const_iterator i =
-                 in_payments.begin();
-         i != in_payments.end();
-         ++i) {
-        const tools::wallet2::payment_details& pd = i->second;
-        std::string payment_id = tools::type_to_hex(i->first);
-        if (payment_id.substr(16).find_first_not_of('0') == std::string::npos)
-            payment_id = payment_id.substr(0, 16);
-        TransactionInfoImpl* ti = new TransactionInfoImpl();
-        ti->m_paymentid = payment_id;
+    auto make_in_entry = [&w](
+            const crypto::hash& payment_id,
+            const tools::wallet2::payment_details& pd,
+            bool pending) {
+        auto ti = std::make_shared<TransactionInfoImpl>();
+        ti->m_paymentid = short_payment_id(payment_id);
         ti->m_amount = pd.m_amount;
         ti->m_direction = TransactionInfo::Direction_In;
         ti->m_hash = tools::type_to_hex(pd.m_tx_hash);
         ti->m_blockheight = pd.m_block_height;
+        ti->m_pending = pending;
         ti->m_subaddrIndex = {pd.m_subaddr_index.minor};
         ti->m_subaddrAccount = pd.m_subaddr_index.major;
         ti->m_label = w->get_subaddress_label(pd.m_subaddr_index);
         ti->m_timestamp = pd.m_timestamp;
-        ti->m_confirmations =
-                (wallet_height > pd.m_block_height) ? wallet_height - pd.m_block_height : 0;
-        ti->m_unlock_time = pd.m_unlock_time;
+        if (!pending)
+            ti->m_unlock_time = pd.m_unlock_time;
         ti->m_reward_type = from_pay_type(pd.m_type);
         ti->m_is_stake = pd.m_type == wallet::pay_type::stake;
-        m_history.push_back(ti);
-    }
+        return ti;
+    };
 
-    // confirmed output transactions
     // one output transaction may contain more than one money transfer, e.g.
     // <transaction_id>:
     //    transfer1: 100XMR to <address_1>
     //    transfer2: 50XMR  to <address_2>
     //    fee: fee charged per transaction
     //
-
-    std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>> out_payments;
-    w->get_payments_out(out_payments, min_height, max_height);
-
-    for (std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>>::
-                 const_iterator i = out_payments.begin();
-         i != out_payments.end();
-         ++i) {
-
-        const crypto::hash& hash = i->first;
-        const tools::wallet2::confirmed_transfer_details& pd = i->second;
-
+    auto make_out_entry = [&w](
+            const crypto::hash& hash,
+            const tools::wallet2::confirmed_transfer_details& pd) {
         uint64_t change = pd.m_change == (uint64_t)-1 ? 0 : pd.m_change;  // change may not be known
         uint64_t fee = pd.m_amount_in - pd.m_amount_out;
 
-        std::string payment_id = tools::type_to_hex(i->second.m_payment_id);
-        if (payment_id.substr(16).find_first_not_of('0') == std::string::npos)
-            payment_id = payment_id.substr(0, 16);
-
-        TransactionInfoImpl* ti = new TransactionInfoImpl();
-        ti->m_paymentid = payment_id;
+        auto ti = std::make_shared<TransactionInfoImpl>();
+        ti->m_paymentid = short_payment_id(pd.m_payment_id);
         ti->m_amount = pd.m_amount_in - change - fee;
         ti->m_fee = fee;
         ti->m_direction = TransactionInfo::Direction_Out;
@@ -187,39 +183,27 @@ void TransactionHistoryImpl::refresh() {
                                       {pd.m_subaddr_account, *pd.m_subaddr_indices.begin()})
                             : "";
         ti->m_timestamp = pd.m_timestamp;
-        ti->m_confirmations =
-                (wallet_height > pd.m_block_height) ? wallet_height - pd.m_block_height : 0;
         ti->m_is_stake = pd.m_pay_type == wallet::pay_type::stake;
 
         // single output transaction might contain multiple transfers
         for (const auto& d : pd.m_dests) {
             ti->m_transfers.push_back({d.amount, d.address(w->nettype(), pd.m_payment_id)});
         }
-        m_history.push_back(ti);
-    }
+        return ti;
+    };
 
-    // unconfirmed output transactions
-    std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>> upayments_out;
-    w->get_unconfirmed_payments_out(upayments_out);
-    for (std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>>::
-                 const_iterator i = upayments_out.begin();
-         i != upayments_out.end();
-         ++i) {
-        const tools::wallet2::unconfirmed_transfer_details& pd = i->second;
-        const crypto::hash& hash = i->first;
+    auto make_pending_out_entry = [&w](
+            const crypto::hash& hash,
+            const tools::wallet2::unconfirmed_transfer_details& pd) {
         uint64_t amount = pd.m_amount_in;
         uint64_t fee = amount - pd.m_amount_out;
-        std::string payment_id = tools::type_to_hex(i->second.m_payment_id);
-        if (payment_id.substr(16).find_first_not_of('0') == std::string::npos)
-            payment_id = payment_id.substr(0, 16);
-        bool is_failed = pd.m_state == tools::wallet2::unconfirmed_transfer_details::failed;
 
-        TransactionInfoImpl* ti = new TransactionInfoImpl();
-        ti->m_paymentid = payment_id;
+        auto ti = std::make_shared<TransactionInfoImpl>();
+        ti->m_paymentid = short_payment_id(pd.m_payment_id);
         ti->m_amount = amount - pd.m_change - fee;
         ti->m_fee = fee;
         ti->m_direction = TransactionInfo::Direction_Out;
-        ti->m_failed = is_failed;
+        ti->m_failed = pd.m_state == tools::wallet2::unconfirmed_transfer_details::failed;
         ti->m_pending = true;
         ti->m_hash = tools::type_to_hex(hash);
         ti->m_subaddrIndex = pd.m_subaddr_indices;
@@ -229,40 +213,68 @@ void TransactionHistoryImpl::refresh() {
                                       {pd.m_subaddr_account, *pd.m_subaddr_indices.begin()})
                             : "";
         ti->m_timestamp = pd.m_timestamp;
-        ti->m_confirmations = 0;
         ti->m_is_stake = pd.m_pay_type == wallet::pay_type::stake;
-        m_history.push_back(ti);
+        return ti;
+    };
+
+
+    // transactions are stored in wallet2:
+    // - confirmed_transfer_details   - out transfers
+    // - unconfirmed_transfer_details - pending out transfers
+    // - payment_details              - input transfers
+    //
+    // Confirmed transfers below the height we last loaded up to can't have changed (reorgs,
+    // rescans and relabelling invalidate() what they touch), so we only reload from there up.
+    // This reloads by height range rather than applying per-txid changes from the wallet2
+    // callbacks: those fire per output or per spent input and don't carry an entry's fee or
+    // destinations, and new transfers are almost always at the top of the chain anyway.
+    const uint64_t min_height = std::min(
+            {m_loaded_height, m_invalid_from.exchange((uint64_t)-1), wallet_height});
+    const uint64_t max_height = (uint64_t)-1;
+    auto first_stale = m_confirmed.lower_bound(min_height);
+    bool changed = first_stale != m_confirmed.end();
+    m_confirmed.erase(first_stale, m_confirmed.end());
+
+    std::list<std::pair<crypto::hash, tools::wallet2::payment_details>> in_payments;
+    w->get_payments(in_payments, min_height, max_height);
+    for (const auto& [payment_id, pd] : in_payments) {
+        auto ti = make_in_entry(payment_id, pd, false);
+        ti->m_chain_height = m_chain_height;
+        m_confirmed.emplace(pd.m_block_height, std::move(ti));
+    }
+
+    std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>> out_payments;
+    w->get_payments_out(out_payments, min_height, max_height);
+    for (const auto& [hash, pd] : out_payments) {
+        auto ti = make_out_entry(hash, pd);
+        ti->m_chain_height = m_chain_height;
+        m_confirmed.emplace(pd.m_block_height, std::move(ti));
     }
 
+    changed |= !in_payments.empty() || !out_payments.empty() || !m_pending.empty();
+    m_loaded_height = wallet_height;
+    m_chain_height->store(wallet_height, std::memory_order_relaxed);
+
+    m_pending.clear();
+
+    // unconfirmed output transactions
+    std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>> upayments_out;
+    w->get_unconfirmed_payments_out(upayments_out);
+    for (const auto& [hash, pd] : upayments_out)
+        m_pending.push_back(make_pending_out_entry(hash, pd));
+
     // unconfirmed payments (tx pool)
     std::list<std::pair<crypto::hash, tools::wallet2::pool_payment_details>> upayments;
     w->get_unconfirmed_payments(upayments);
-    for (std::list<std::pair<crypto::hash, tools::wallet2::pool_payment_details>>::const_iterator
-                 i = upayments.begin();
-         i != upayments.end();
-         ++i) {
-        const tools::wallet2::payment_details& pd = i->second.m_pd;
-        std::string payment_id = tools::type_to_hex(i->first);
-        if (payment_id.substr(16).find_first_not_of('0') == std::string::npos)
-            payment_id = payment_id.substr(0, 16);
-        TransactionInfoImpl* ti = new TransactionInfoImpl();
-        ti->m_paymentid = payment_id;
-        ti->m_amount = pd.m_amount;
-        ti->m_direction = TransactionInfo::Direction_In;
-        ti->m_hash = tools::type_to_hex(pd.m_tx_hash);
-        ti->m_blockheight = pd.m_block_height;
-        ti->m_pending = true;
-        ti->m_subaddrIndex = {pd.m_subaddr_index.minor};
-        ti->m_subaddrAccount = pd.m_subaddr_index.major;
-        ti->m_label = w->get_subaddress_label(pd.m_subaddr_index);
-        ti->m_timestamp = pd.m_timestamp;
-        ti->m_confirmations = 0;
-        ti->m_reward_type = from_pay_type(pd.m_type);
-        ti->m_is_stake = pd.m_type == wallet::pay_type::stake;
-        m_history.push_back(ti);
-
+    for (const auto& [payment_id, ppd] : upayments) {
+        const tools::wallet2::payment_details& pd = ppd.m_pd;
+        m_pending.push_back(make_in_entry(payment_id, pd, true));
         log::info(logcat, "{}: Unconfirmed payment found {}", __FUNCTION__, pd.m_amount);
     }
+
+    changed |= !m_pending.empty();
+    if (changed)
+        publish();
 }
 
 }  // namespace Wallet
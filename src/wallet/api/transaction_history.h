@@ -28,6 +28,9 @@
 //
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <shared_mutex>
 
 #include "wallet/api/wallet2_api.h"
@@ -35,6 +38,7 @@
 namespace Wallet {
 
 class WalletImpl;
+class TransactionInfoImpl;
 
 class TransactionHistoryImpl : public TransactionHistory {
   public:
@@ -46,9 +50,35 @@ class TransactionHistoryImpl : public TransactionHistory {
     std::vector<TransactionInfo*> getAll() const override;
     void refresh() override;
 
+    // Marks confirmed history from `height` up as stale so that the next refresh() reloads it; used
+    // when the wallet detaches blocks, rescans, or relabels subaddresses.
+    void invalidate(uint64_t height);
+
   private:
-    // TransactionHistory is responsible of memory management
-    std::vector<TransactionInfo*> m_history;
+    using entry_ptr = std::shared_ptr<TransactionInfoImpl>;
+
+    // An immutable view of the history handed out by getAll() & co.  Entries that are unchanged
+    // by a refresh are shared between consecutive snapshots, so pointers into it stay valid.
+    struct snapshot {
+        std::vector<entry_ptr> entries;
+        std::vector<TransactionInfo*> list;
+    };
+    void publish();
+
+    // Confirmed in/out transfers ordered by block height; refresh() only reloads those at or
+    // above m_loaded_height.
+    std::multimap<uint64_t, entry_ptr> m_confirmed;
+    // Pool and pending outgoing transfers: few, and they change state without a new block, so
+    // these are reloaded on every refresh.
+    std::vector<entry_ptr> m_pending;
+    uint64_t m_loaded_height = 0;
+    // Lowest height invalidate()d since the last refresh
+    std::atomic<uint64_t> m_invalid_from{(uint64_t)-1};
+    // Shared with confirmed entries so their confirmation counts follow the chain without
+    // recreating them
+    std::shared_ptr<std::atomic<uint64_t>> m_chain_height;
+    std::shared_ptr<const snapshot> m_snapshot;
+
     WalletImpl* m_wallet;
     mutable std::shared_mutex m_historyMutex;
 };
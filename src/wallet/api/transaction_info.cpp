@@ -141,6 +141,10 @@ const std::vector<TransactionInfo::Transfer>& TransactionInfoImpl::transfers() c
 
 EXPORT
 uint64_t TransactionInfoImpl::confirmations() const {
+    if (m_chain_height) {
+        uint64_t height = m_chain_height->load(std::memory_order_relaxed);
+        return height > m_blockheight ? height - m_blockheight : 0;
+    }
     return m_confirmations;
 }
 
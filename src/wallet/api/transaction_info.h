@@ -28,7 +28,9 @@
 //
 // Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
 
+#include <atomic>
 #include <ctime>
+#include <memory>
 #include <string>
 
 #include "wallet/api/wallet2_api.h"
@@ -83,6 +85,9 @@ class TransactionInfoImpl : public TransactionInfo {
     std::vector<Transfer> m_transfers;
     uint64_t m_confirmations;
     uint64_t m_unlock_time;
+    // Set for confirmed txes held by a TransactionHistoryImpl; confirmations() is then derived
+    // from it rather than from m_confirmations.
+    std::shared_ptr<const std::atomic<uint64_t>> m_chain_height;
 
     friend class TransactionHistoryImpl;
 };
@@ -215,6 +215,11 @@ struct Wallet2CallbackImpl : public tools::i_wallet2_callback {
         // TODO;
     }
 
+    EXPORT
+    void on_reorg(uint64_t height, uint64_t blocks_detached, size_t transfers_detached) override {
+        m_wallet->m_history->invalidate(height);
+    }
+
     // Light wallet callbacks
     EXPORT
     void on_lw_new_block(uint64_t height) override {
@@ -1358,7 +1363,8 @@ EXPORT
 void WalletImpl::setSubaddressLabel(
         uint32_t accountIndex, uint32_t addressIndex, const std::string& label) {
     try {
-        return wallet()->set_subaddress_label({accountIndex, addressIndex}, label);
+        wallet()->set_subaddress_label({accountIndex, addressIndex}, label);
+        m_history->invalidate(0);  // history entries carry subaddress labels
     } catch (const std::exception& e) {
         log::error(logcat, "Error setting subaddress label: {}", e.what());
         setStatusError(std::string("Failed to set subaddress label: ") + e.what());
@@ -2281,8 +2287,10 @@ void WalletImpl::doRefresh() {
                     w->light_wallet() ||
 #endif
                     daemonSynced()) {
-                if (rescan)
+                if (rescan) {
                     w->rescan_blockchain(false);
+                    m_history->invalidate(0);
+                }
                 w->refresh(trustedDaemon());
                 if (!m_synchronized) {
                     m_synchronized = true;
@@ -31,8 +31,13 @@
 
 #include <lmdb.h>
 
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
 #include "common/file.h"
 #include "common/fs-format.h"
+#include "common/threadpool.h"
 #include "cryptonote_config.h"
 #include "epee/misc_log_ex.h"
 #include "wallet_errors.h"
@@ -164,20 +169,27 @@ namespace {
         return plaintext;
     }
 
-    void store_relative_ring(
-            MDB_txn* txn,
-            MDB_dbi& dbi,
+    struct encrypted_ring {
+        std::string key;
+        std::string data;
+    };
+
+    encrypted_ring encrypt_relative_ring(
             const crypto::key_image& key_image,
             const std::vector<uint64_t>& relative_ring,
             const crypto::chacha_key& chacha_key) {
+        encrypted_ring r;
+        r.key = encrypt(key_image, chacha_key, 0);
+        r.data = encrypt(compress_ring(relative_ring, V1TAG), key_image, chacha_key, 1);
+        return r;
+    }
+
+    void store_ring(MDB_txn* txn, MDB_dbi& dbi, const encrypted_ring& ring) {
         MDB_val key, data;
-        std::string key_ciphertext = encrypt(key_image, chacha_key, 0);
-        key.mv_data = (void*)key_ciphertext.data();
-        key.mv_size = key_ciphertext.size();
-        std::string compressed_ring = compress_ring(relative_ring, V1TAG);
-        std::string data_ciphertext = encrypt(compressed_ring, key_image, chacha_key, 1);
-        data.mv_size = data_ciphertext.size();
-        data.mv_data = (void*)data_ciphertext.c_str();
+        key.mv_data = (void*)ring.key.data();
+        key.mv_size = ring.key.size();
+        data.mv_data = (void*)ring.data.data();
+        data.mv_size = ring.data.size();
         int dbr = mdb_put(txn, dbi, &key, &data, 0);
         THROW_WALLET_EXCEPTION_IF(
                 dbr,
@@ -186,6 +198,57 @@ namespace {
                         std::string(mdb_strerror(dbr)));
     }
 
+    // Decrypts a stored ring (trying the current format first, then the pre-v1 one) and returns
+    // it as absolute offsets.
+    std::vector<uint64_t> decrypt_ring(
+            const std::string& ciphertext,
+            const crypto::key_image& key_image,
+            const crypto::chacha_key& chacha_key) {
+        std::vector<uint64_t> outs;
+        bool try_v0 = false;
+        try {
+            outs = decompress_ring(decrypt(ciphertext, key_image, chacha_key, 1), V1TAG);
+            if (outs.empty())
+                try_v0 = true;
+        } catch (...) {
+            try_v0 = true;
+        }
+        if (try_v0)
+            outs = decompress_ring(decrypt(ciphertext, key_image, chacha_key, 0), 0);
+        return cryptonote::relative_output_offsets_to_absolute(outs);
+    }
+
+    // Below this many key images the threadpool overhead outweighs the hashing/chacha work.
+    constexpr size_t PARALLEL_CRYPT_THRESHOLD = 32;
+
+    // Runs f(0), ..., f(n-1), spread over the threadpool when n is large; rethrows the first
+    // exception thrown by any of the calls.
+    template <typename F>
+    void for_each_ring(size_t n, F&& f) {
+        if (n < PARALLEL_CRYPT_THRESHOLD) {
+            for (size_t i = 0; i < n; ++i)
+                f(i);
+            return;
+        }
+        auto& tpool = tools::threadpool::getInstance();
+        const size_t jobs = std::min(n, (size_t)tpool.get_max_concurrency());
+        std::vector<std::exception_ptr> errors(jobs);
+        tools::threadpool::waiter waiter;
+        for (size_t j = 0; j < jobs; ++j)
+            tpool.submit(&waiter, [&, j] {
+                try {
+                    for (size_t i = j; i < n; i += jobs)
+                        f(i);
+                } catch (...) {
+                    errors[j] = std::current_exception();
+                }
+            });
+        waiter.wait(&tpool);
+        for (auto& e : errors)
+            if (e)
+                std::rethrow_exception(e);
+    }
+
     int resize_env(MDB_env* env, const fs::path& db_path, size_t needed) {
         MDB_envinfo mei;
         MDB_stat mst;
@@ -299,6 +362,11 @@ ringdb::~ringdb() {
 }
 
 void ringdb::close() {
+    {
+        std::lock_guard lock{cache_mutex_};
+        cache_.clear();
+        cache_key_.reset();
+    }
     if (env) {
         mdb_dbi_close(env, dbi_rings);
         mdb_dbi_close(env, dbi_blackballs);
@@ -307,26 +375,17 @@ void ringdb::close() {
     }
 }
 
+void ringdb::use_cache_key(const crypto::chacha_key& chacha_key) {
+    if (cache_key_ && !memcmp(cache_key_->data(), chacha_key.data(), chacha_key.size()))
+        return;
+    cache_.clear();
+    cache_key_ = chacha_key;
+}
+
 bool ringdb::add_rings(
         const crypto::chacha_key& chacha_key, const cryptonote::transaction_prefix& tx) {
-    MDB_txn* txn;
-    int dbr;
-    bool tx_active = false;
-
-    dbr = resize_env(env, filename_, get_ring_data_size(tx.vin.size()));
-    THROW_WALLET_EXCEPTION_IF(
-            dbr, tools::error::wallet_internal_error, "Failed to set env map size");
-    dbr = mdb_txn_begin(env, NULL, 0, &txn);
-    THROW_WALLET_EXCEPTION_IF(
-            dbr,
-            tools::error::wallet_internal_error,
-            "Failed to create LMDB transaction: " + std::string(mdb_strerror(dbr)));
-    OXEN_DEFER {
-        if (tx_active)
-            mdb_txn_abort(txn);
-    };
-    tx_active = true;
-
+    std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>> rings;
+    rings.reserve(tx.vin.size());
     for (const auto& in : tx.vin) {
         if (!std::holds_alternative<cryptonote::txin_to_key>(in))
             continue;
@@ -335,20 +394,18 @@ bool ringdb::add_rings(
         if (ring_size == 1)
             continue;
 
-        store_relative_ring(txn, dbi_rings, txin.k_image, txin.key_offsets, chacha_key);
+        rings.emplace_back(txin.k_image, txin.key_offsets);
     }
-
-    dbr = mdb_txn_commit(txn);
-    THROW_WALLET_EXCEPTION_IF(
-            dbr,
-            tools::error::wallet_internal_error,
-            "Failed to commit txn adding ring to database: " + std::string(mdb_strerror(dbr)));
-    tx_active = false;
-    return true;
+    return set_rings(chacha_key, rings, true);
 }
 
 bool ringdb::remove_rings(
         const crypto::chacha_key& chacha_key, const std::vector<crypto::key_image>& key_images) {
+    std::vector<std::string> keys(key_images.size());
+    for_each_ring(key_images.size(), [&](size_t i) {
+        keys[i] = encrypt(key_images[i], chacha_key, 0);
+    });
+
     MDB_txn* txn;
     int dbr;
     bool tx_active = false;
@@ -367,11 +424,10 @@ bool ringdb::remove_rings(
     };
     tx_active = true;
 
-    for (const crypto::key_image& key_image : key_images) {
+    for (size_t i = 0; i < key_images.size(); ++i) {
         MDB_val key, data;
-        std::string key_ciphertext = encrypt(key_image, chacha_key, 0);
-        key.mv_data = (void*)key_ciphertext.data();
-        key.mv_size = key_ciphertext.size();
+        key.mv_data = (void*)keys[i].data();
+        key.mv_size = keys[i].size();
 
         dbr = mdb_get(txn, dbi_rings, &key, &data);
         THROW_WALLET_EXCEPTION_IF(
@@ -383,7 +439,7 @@ bool ringdb::remove_rings(
         THROW_WALLET_EXCEPTION_IF(
                 data.mv_size <= 0, tools::error::wallet_internal_error, "Invalid ring data size");
 
-        log::debug(logcat, "Removing ring data for key image {}", key_image);
+        log::debug(logcat, "Removing ring data for key image {}", key_images[i]);
         dbr = mdb_del(txn, dbi_rings, &key, NULL);
         THROW_WALLET_EXCEPTION_IF(
                 dbr,
@@ -397,6 +453,11 @@ bool ringdb::remove_rings(
             tools::error::wallet_internal_error,
             "Failed to commit txn removing ring to database: " + std::string(mdb_strerror(dbr)));
     tx_active = false;
+
+    std::lock_guard lock{cache_mutex_};
+    use_cache_key(chacha_key);
+    for (const auto& key_image : key_images)
+        cache_[key_image] = std::nullopt;
     return true;
 }
 
@@ -420,67 +481,108 @@ bool ringdb::get_ring(
         const crypto::chacha_key& chacha_key,
         const crypto::key_image& key_image,
         std::vector<uint64_t>& outs) {
-    MDB_txn* txn;
-    int dbr;
-    bool tx_active = false;
-
-    dbr = resize_env(env, filename_, 0);
-    THROW_WALLET_EXCEPTION_IF(
-            dbr,
-            tools::error::wallet_internal_error,
-            "Failed to set env map size: " + std::string(mdb_strerror(dbr)));
-    dbr = mdb_txn_begin(env, NULL, 0, &txn);
-    THROW_WALLET_EXCEPTION_IF(
-            dbr,
-            tools::error::wallet_internal_error,
-            "Failed to create LMDB transaction: " + std::string(mdb_strerror(dbr)));
-    OXEN_DEFER {
-        if (tx_active)
-            mdb_txn_abort(txn);
-    };
-    tx_active = true;
-
-    MDB_val key, data;
-    std::string key_ciphertext = encrypt(key_image, chacha_key, 0);
-    key.mv_data = (void*)key_ciphertext.data();
-    key.mv_size = key_ciphertext.size();
-    dbr = mdb_get(txn, dbi_rings, &key, &data);
-    THROW_WALLET_EXCEPTION_IF(
-            dbr && dbr != MDB_NOTFOUND,
-            tools::error::wallet_internal_error,
-            "Failed to look for key image in LMDB table: " + std::string(mdb_strerror(dbr)));
-    if (dbr == MDB_NOTFOUND)
+    auto rings = get_rings(chacha_key, {key_image});
+    auto it = rings.find(key_image);
+    if (it == rings.end())
         return false;
-    THROW_WALLET_EXCEPTION_IF(
-            data.mv_size <= 0, tools::error::wallet_internal_error, "Invalid ring data size");
-
-    bool try_v0 = false;
-    std::string data_plaintext =
-            decrypt(std::string((const char*)data.mv_data, data.mv_size), key_image, chacha_key, 1);
-    try {
-        outs = decompress_ring(data_plaintext, V1TAG);
-        if (outs.empty())
-            try_v0 = true;
-    } catch (...) {
-        try_v0 = true;
+    outs = std::move(it->second);
+    return true;
+}
+
+std::unordered_map<crypto::key_image, std::vector<uint64_t>> ringdb::get_rings(
+        const crypto::chacha_key& chacha_key, const std::vector<crypto::key_image>& key_images) {
+    std::unordered_map<crypto::key_image, std::vector<uint64_t>> result;
+    std::vector<crypto::key_image> missing;
+    {
+        std::lock_guard lock{cache_mutex_};
+        use_cache_key(chacha_key);
+        for (const auto& key_image : key_images) {
+            if (auto it = cache_.find(key_image); it != cache_.end()) {
+                if (it->second)
+                    result.emplace(key_image, *it->second);
+            } else {
+                missing.push_back(key_image);
+            }
+        }
     }
-    if (try_v0) {
-        data_plaintext = decrypt(
-                std::string((const char*)data.mv_data, data.mv_size), key_image, chacha_key, 0);
-        outs = decompress_ring(data_plaintext, 0);
+    std::sort(missing.begin(), missing.end());
+    missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+    if (missing.empty())
+        return result;
+
+    std::vector<std::string> keys(missing.size());
+    for_each_ring(missing.size(), [&](size_t i) { keys[i] = encrypt(missing[i], chacha_key, 0); });
+
+    std::vector<std::optional<std::string>> ciphertexts(missing.size());
+    {
+        MDB_txn* txn;
+        int dbr;
+        bool tx_active = false;
+
+        dbr = resize_env(env, filename_, 0);
+        THROW_WALLET_EXCEPTION_IF(
+                dbr,
+                tools::error::wallet_internal_error,
+                "Failed to set env map size: " + std::string(mdb_strerror(dbr)));
+        dbr = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
+        THROW_WALLET_EXCEPTION_IF(
+                dbr,
+                tools::error::wallet_internal_error,
+                "Failed to create LMDB transaction: " + std::string(mdb_strerror(dbr)));
+        OXEN_DEFER {
+            if (tx_active)
+                mdb_txn_abort(txn);
+        };
+        tx_active = true;
+
+        for (size_t i = 0; i < missing.size(); ++i) {
+            MDB_val key, data;
+            key.mv_data = (void*)keys[i].data();
+            key.mv_size = keys[i].size();
+            dbr = mdb_get(txn, dbi_rings, &key, &data);
+            THROW_WALLET_EXCEPTION_IF(
+                    dbr && dbr != MDB_NOTFOUND,
+                    tools::error::wallet_internal_error,
+                    "Failed to look for key image in LMDB table: " +
+                            std::string(mdb_strerror(dbr)));
+            if (dbr == MDB_NOTFOUND)
+                continue;
+            THROW_WALLET_EXCEPTION_IF(
+                    data.mv_size <= 0,
+                    tools::error::wallet_internal_error,
+                    "Invalid ring data size");
+            ciphertexts[i].emplace((const char*)data.mv_data, data.mv_size);
+        }
+
+        dbr = mdb_txn_commit(txn);
+        THROW_WALLET_EXCEPTION_IF(
+                dbr,
+                tools::error::wallet_internal_error,
+                "Failed to commit txn getting ring from database: " +
+                        std::string(mdb_strerror(dbr)));
+        tx_active = false;
     }
-    log::debug(logcat, "Found ring for key image {}:", key_image);
-    log::debug(logcat, "Relative: {}", tools::join(" ", outs));
-    outs = cryptonote::relative_output_offsets_to_absolute(outs);
-    log::debug(logcat, "Absolute: {}", tools::join(" ", outs));
 
-    dbr = mdb_txn_commit(txn);
-    THROW_WALLET_EXCEPTION_IF(
-            dbr,
-            tools::error::wallet_internal_error,
-            "Failed to commit txn getting ring from database: " + std::string(mdb_strerror(dbr)));
-    tx_active = false;
-    return true;
+    std::vector<std::optional<std::vector<uint64_t>>> rings(missing.size());
+    for_each_ring(missing.size(), [&](size_t i) {
+        if (ciphertexts[i])
+            rings[i] = decrypt_ring(*ciphertexts[i], missing[i], chacha_key);
+    });
+
+    std::lock_guard lock{cache_mutex_};
+    use_cache_key(chacha_key);
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (rings[i]) {
+            log::debug(
+                    logcat,
+                    "Found ring for key image {}: {}",
+                    missing[i],
+                    tools::join(" ", *rings[i]));
+            result.emplace(missing[i], *rings[i]);
+        }
+        cache_[missing[i]] = std::move(rings[i]);
+    }
+    return result;
 }
 
 bool ringdb::set_ring(
@@ -488,11 +590,36 @@ bool ringdb::set_ring(
         const crypto::key_image& key_image,
         const std::vector<uint64_t>& outs,
         bool relative) {
+    return set_rings(chacha_key, {{key_image, outs}}, relative);
+}
+
+bool ringdb::set_rings(
+        const crypto::chacha_key& chacha_key,
+        const std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>>& rings,
+        bool relative) {
+    if (rings.empty())
+        return true;
+
+    // Encrypt everything up front so that the write txn is only held for the puts
+    std::vector<encrypted_ring> records(rings.size());
+    std::vector<std::vector<uint64_t>> absolute(rings.size());
+    for_each_ring(rings.size(), [&](size_t i) {
+        const auto& [key_image, outs] = rings[i];
+        if (relative) {
+            records[i] = encrypt_relative_ring(key_image, outs, chacha_key);
+            absolute[i] = cryptonote::relative_output_offsets_to_absolute(outs);
+        } else {
+            records[i] = encrypt_relative_ring(
+                    key_image, cryptonote::absolute_output_offsets_to_relative(outs), chacha_key);
+            absolute[i] = outs;
+        }
+    });
+
     MDB_txn* txn;
     int dbr;
     bool tx_active = false;
 
-    dbr = resize_env(env, filename_, outs.size() * 64);
+    dbr = resize_env(env, filename_, get_ring_data_size(rings.size()));
     THROW_WALLET_EXCEPTION_IF(
             dbr,
             tools::error::wallet_internal_error,
@@ -508,12 +635,8 @@ bool ringdb::set_ring(
     };
     tx_active = true;
 
-    store_relative_ring(
-            txn,
-            dbi_rings,
-            key_image,
-            relative ? outs : cryptonote::absolute_output_offsets_to_relative(outs),
-            chacha_key);
+    for (const auto& record : records)
+        store_ring(txn, dbi_rings, record);
 
     dbr = mdb_txn_commit(txn);
     THROW_WALLET_EXCEPTION_IF(
@@ -521,6 +644,11 @@ bool ringdb::set_ring(
             tools::error::wallet_internal_error,
             "Failed to commit txn setting ring to database: " + std::string(mdb_strerror(dbr)));
     tx_active = false;
+
+    std::lock_guard lock{cache_mutex_};
+    use_cache_key(chacha_key);
+    for (size_t i = 0; i < rings.size(); ++i)
+        cache_[rings[i].first] = std::move(absolute[i]);
     return true;
 }
 
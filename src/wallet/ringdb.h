@@ -30,7 +30,11 @@
 
 #include <lmdb.h>
 
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "common/fs.h"
@@ -62,6 +66,16 @@ class ringdb {
             const std::vector<uint64_t>& outs,
             bool relative);
 
+    // Batch versions of get_ring/set_ring: the whole set of key images is handled in a single
+    // LMDB transaction, with the encryption/decryption done in bulk outside of it.  get_rings
+    // returns the (absolute) rings of those key images that have one stored.
+    std::unordered_map<crypto::key_image, std::vector<uint64_t>> get_rings(
+            const crypto::chacha_key& chacha_key, const std::vector<crypto::key_image>& key_images);
+    bool set_rings(
+            const crypto::chacha_key& chacha_key,
+            const std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>>& rings,
+            bool relative);
+
     bool blackball(const std::pair<uint64_t, uint64_t>& output);
     bool blackball(const std::vector<std::pair<uint64_t, uint64_t>>& outputs);
     bool unblackball(const std::pair<uint64_t, uint64_t>& output);
@@ -71,10 +85,19 @@ class ringdb {
   private:
     bool blackball_worker(const std::vector<std::pair<uint64_t, uint64_t>>& outputs, int op);
 
+    // Must be called with cache_mutex_ held; drops the cache if it was built with another key.
+    void use_cache_key(const crypto::chacha_key& chacha_key);
+
   private:
     fs::path filename_;
     MDB_env* env = nullptr;
     MDB_dbi dbi_rings;
     MDB_dbi dbi_blackballs;
+
+    // Decrypted absolute rings we have looked up or stored this session, keyed by key image;
+    // nullopt records a key image known to have no ring.  Only valid for cache_key_.
+    std::mutex cache_mutex_;
+    std::optional<crypto::chacha_key> cache_key_;
+    std::unordered_map<crypto::key_image, std::optional<std::vector<uint64_t>>> cache_;
 };
 }  // namespace tools
@@ -36,12 +36,14 @@
 #include <oxenc/base64.h>
 #include <oxenc/endian.h>
 
+#include <exception>
 #include <iterator>
 #include <mutex>
 #include <numeric>
 #include <optional>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 
 #include "common/apply_permutation.h"
 #include "common/base58.h"
@@ -142,6 +144,10 @@ namespace {
 
     constexpr uint64_t FIRST_REFRESH_GRANULARITY = 1024;
 
+    // Number of recent block hashes the wallet keeps in full; older ones are reduced to sparse
+    // checkpoints (see hashchain::trim).
+    constexpr uint64_t HASHCHAIN_DENSE_BLOCKS = 7 * BLOCKS_PER_DAY;
+
     constexpr double GAMMA_SHAPE = 19.28;
     constexpr double GAMMA_SCALE = 1 / 1.61;
 
@@ -3325,6 +3331,7 @@ void wallet2::get_short_chain_history(std::list<crypto::hash>& ids, uint64_t gra
     }
     if (!base_included)
         ids.push_back(m_blockchain[m_blockchain.offset()]);
+    m_blockchain.append_checkpoints(ids);
     if (m_blockchain.offset())
         ids.push_back(m_blockchain.genesis());
 }
@@ -4315,6 +4322,10 @@ void wallet2::refresh(
 
             first = false;
 
+            // keep the hashchain from growing without bound during a long refresh
+            if (m_blockchain.size() - m_blockchain.offset() > 2 * HASHCHAIN_DENSE_BLOCKS)
+                m_blockchain.trim(m_blockchain.size() - HASHCHAIN_DENSE_BLOCKS);
+
             // handle error from async fetching thread
             if (error) {
                 throw std::runtime_error("proxy exception in refresh thread");
@@ -4532,6 +4543,9 @@ void wallet2::detach_blockchain(
             height,
             transfers_detached,
             blocks_detached);
+
+    if (m_callback)
+        m_callback->on_reorg(height, blocks_detached, transfers_detached);
 }
 //----------------------------------------------------------------------------------------------------
 bool wallet2::deinit() {
@@ -6726,6 +6740,12 @@ void wallet2::trim_hashchain() {
         if (td.m_block_height < height)
             height = td.m_block_height;
 
+    // Whatever the above allows, only the most recent hashes are worth keeping in full: a reorg
+    // deeper than that is not going to happen, and the checkpoints left behind by trimming still
+    // let the daemon find where we are.
+    if (m_blockchain.size() > HASHCHAIN_DENSE_BLOCKS)
+        height = std::max<uint64_t>(height, m_blockchain.size() - HASHCHAIN_DENSE_BLOCKS);
+
     if (!m_blockchain.empty() && m_blockchain.size() == m_blockchain.offset()) {
         log::info(logcat, "Fixing empty hashchain");
         nlohmann::json req_params{{"height", m_blockchain.size() - 1}};
@@ -9037,6 +9057,38 @@ bool wallet2::set_ring(
     }
 }
 
+bool wallet2::set_rings(
+        const std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>>& rings,
+        bool relative) {
+    if (!m_ringdb)
+        return false;
+
+    try {
+        return m_ringdb->set_rings(get_ringdb_key(), rings, relative);
+    } catch (const std::exception& e) {
+        return false;
+    }
+}
+
+std::unordered_map<crypto::key_image, std::vector<uint64_t>> wallet2::get_known_rings(
+        const std::vector<size_t>& selected_transfers) {
+    if (!m_ringdb)
+        return {};
+
+    std::vector<crypto::key_image> key_images;
+    key_images.reserve(selected_transfers.size());
+    for (size_t idx : selected_transfers) {
+        const transfer_details& td = m_transfers[idx];
+        if (td.m_key_image_known && !td.m_key_image_partial)
+            key_images.push_back(td.m_key_image);
+    }
+    try {
+        return m_ringdb->get_rings(get_ringdb_key(), key_images);
+    } catch (const std::exception& e) {
+        return {};
+    }
+}
+
 bool wallet2::unset_ring(const std::vector<crypto::key_image>& key_images) {
     if (!m_ringdb)
         return false;
@@ -10526,6 +10578,8 @@ void wallet2::get_outs(
         if (has_rct_distribution)
             gamma.reset(new gamma_picker(rct_offsets));
 
+        const auto known_rings = get_known_rings(selected_transfers);
+
         size_t num_selected_transfers = 0;
         for (size_t idx : selected_transfers) {
             ++num_selected_transfers;
@@ -10641,42 +10695,40 @@ void wallet2::get_outs(
             uint64_t num_found = 0;
 
             // if we have a known ring, use it
-            if (td.m_key_image_known && !td.m_key_image_partial) {
-                std::vector<uint64_t> ring;
-                if (get_ring(get_ringdb_key(), td.m_key_image, ring)) {
-                    log::info(
-                            logcat, "This output has a known ring, reusing (size {})", ring.size());
-                    THROW_WALLET_EXCEPTION_IF(
-                            ring.size() > fake_outputs_count + 1,
-                            error::wallet_internal_error,
-                            "An output in this transaction was previously spent on another chain "
-                            "with ring size " +
-                                    std::to_string(ring.size()) +
-                                    ", it cannot be spent now with ring size " +
-                                    std::to_string(fake_outputs_count + 1) +
-                                    " as it is smaller: use a higher ring size");
-                    bool own_found = false;
-                    for (const auto& out : ring) {
-                        log::info(logcat, "Ring has output {}", out);
-                        if (out < num_outs) {
-                            log::info(logcat, "Using it");
-                            get_outputs.push_back({amount, out});
-                            ++num_found;
-                            seen_indices.emplace(out);
-                            if (out == td.m_global_output_index) {
-                                log::info(logcat, "This is the real output");
-                                own_found = true;
-                            }
-                        } else {
-                            log::info(logcat, "Ignoring output {}, too recent", out);
+            if (auto known = known_rings.find(td.m_key_image);
+                td.m_key_image_known && !td.m_key_image_partial && known != known_rings.end()) {
+                const auto& ring = known->second;
+                log::info(logcat, "This output has a known ring, reusing (size {})", ring.size());
+                THROW_WALLET_EXCEPTION_IF(
+                        ring.size() > fake_outputs_count + 1,
+                        error::wallet_internal_error,
+                        "An output in this transaction was previously spent on another chain "
+                        "with ring size " +
+                                std::to_string(ring.size()) +
+                                ", it cannot be spent now with ring size " +
+                                std::to_string(fake_outputs_count + 1) +
+                                " as it is smaller: use a higher ring size");
+                bool own_found = false;
+                for (const auto& out : ring) {
+                    log::info(logcat, "Ring has output {}", out);
+                    if (out < num_outs) {
+                        log::info(logcat, "Using it");
+                        get_outputs.push_back({amount, out});
+                        ++num_found;
+                        seen_indices.emplace(out);
+                        if (out == td.m_global_output_index) {
+                            log::info(logcat, "This is the real output");
+                            own_found = true;
                         }
+                    } else {
+                        log::info(logcat, "Ignoring output {}, too recent", out);
                     }
-                    THROW_WALLET_EXCEPTION_IF(
-                            !own_found,
-                            error::wallet_internal_error,
-                            "Known ring does not include the spent output: " +
-                                    std::to_string(td.m_global_output_index));
                 }
+                THROW_WALLET_EXCEPTION_IF(
+                        !own_found,
+                        error::wallet_internal_error,
+                        "Known ring does not include the spent output: " +
+                                std::to_string(td.m_global_output_index));
             }
 
             if (num_outs <= requested_outputs_count) {
@@ -10953,42 +11005,41 @@ void wallet2::get_outs(
                     mask));
 
             // then pick outs from an existing ring, if any
-            if (td.m_key_image_known && !td.m_key_image_partial) {
-                std::vector<uint64_t> ring;
-                if (get_ring(get_ringdb_key(), td.m_key_image, ring)) {
-                    for (uint64_t out : ring) {
-                        if (out < num_outs) {
-                            if (out != td.m_global_output_index) {
-                                bool found = false;
-                                for (size_t o = 0; o < requested_outputs_count; ++o) {
-                                    size_t i = base + o;
-                                    if (get_outputs[i].index == out) {
-                                        log::debug(
-                                                logcat,
-                                                "Index {}/{}: idx {} (real {}), unlocked {}, key "
-                                                "{} (from existing ring)",
-                                                i,
-                                                requested_outputs_count,
-                                                get_outputs[i].index,
-                                                td.m_global_output_index,
-                                                got_outs[i].unlocked,
-                                                got_outs[i].key);
-                                        tx_add_fake_output(
-                                                outs,
-                                                get_outputs[i].index,
-                                                got_outs[i].key,
-                                                got_outs[i].mask,
-                                                td.m_global_output_index,
-                                                got_outs[i].unlocked);
-                                        found = true;
-                                        break;
-                                    }
+            if (auto known = known_rings.find(td.m_key_image);
+                td.m_key_image_known && !td.m_key_image_partial && known != known_rings.end()) {
+                const auto& ring = known->second;
+                for (uint64_t out : ring) {
+                    if (out < num_outs) {
+                        if (out != td.m_global_output_index) {
+                            bool found = false;
+                            for (size_t o = 0; o < requested_outputs_count; ++o) {
+                                size_t i = base + o;
+                                if (get_outputs[i].index == out) {
+                                    log::debug(
+                                            logcat,
+                                            "Index {}/{}: idx {} (real {}), unlocked {}, key "
+                                            "{} (from existing ring)",
+                                            i,
+                                            requested_outputs_count,
+                                            get_outputs[i].index,
+                                            td.m_global_output_index,
+                                            got_outs[i].unlocked,
+                                            got_outs[i].key);
+                                    tx_add_fake_output(
+                                            outs,
+                                            get_outputs[i].index,
+                                            got_outs[i].key,
+                                            got_outs[i].mask,
+                                            td.m_global_output_index,
+                                            got_outs[i].unlocked);
+                                    found = true;
+                                    break;
                                 }
-                                THROW_WALLET_EXCEPTION_IF(
-                                        !found,
-                                        error::wallet_internal_error,
-                                        "Falied to find existing ring output in daemon out data");
                             }
+                            THROW_WALLET_EXCEPTION_IF(
+                                    !found,
+                                    error::wallet_internal_error,
+                                    "Falied to find existing ring output in daemon out data");
                         }
                     }
                 }
@@ -11058,6 +11109,8 @@ void wallet2::get_outs(
     }
 
     // save those outs in the ringdb for reuse
+    std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>> rings;
+    rings.reserve(selected_transfers.size());
     for (size_t i = 0; i < selected_transfers.size(); ++i) {
         const size_t idx = selected_transfers[i];
         THROW_WALLET_EXCEPTION_IF(
@@ -11065,13 +11118,14 @@ void wallet2::get_outs(
                 error::wallet_internal_error,
                 "selected_transfers entry out of range");
         const transfer_details& td = m_transfers[idx];
-        std::vector<uint64_t> ring;
+        auto& [key_image, ring] = rings.emplace_back();
+        key_image = td.m_key_image;
         ring.reserve(outs[i].size());
         for (const auto& e : outs[i])
             ring.push_back(std::get<0>(e));
-        if (!set_ring(td.m_key_image, ring, false))
-            log::error(logcat, "Failed to set ring for {}", td.m_key_image);
     }
+    if (!set_rings(rings, false))
+        log::error(logcat, "Failed to set rings for {} inputs", rings.size());
 }
 
 void wallet2::transfer_selected_rct(
@@ -12366,6 +12420,10 @@ std::vector<wallet2::pending_tx> wallet2::create_transactions_2(
     std::unique_lock hwdev_lock{hwdev};
     hw::mode_resetter rst{hwdev};
 
+    const auto selection_start = std::chrono::steady_clock::now();
+    auto& timings = m_last_tx_construction_timings;
+    timings = {};
+
     bool const is_ons_tx = (tx_params.tx_type == txtype::oxen_name_system);
     auto original_dsts = dsts;
     if (is_ons_tx) {
@@ -12643,6 +12701,40 @@ std::vector<wallet2::pending_tx> wallet2::create_transactions_2(
     needed_fee = 0;
     std::vector<std::vector<tools::wallet2::get_outs_entry>> outs;
 
+    // Rings fetched so far, keyed by transfer index.  Every input we add to a tx invalidates
+    // `outs`, but the rings of the inputs already selected are still good, so we only go back to
+    // the daemon for the new ones rather than re-fetching the whole set on every attempt.  (The
+    // rings can't all be left for one fetch once the inputs are settled: each attempt builds a
+    // real tx to size the fee, and the ring members' offsets are part of that size.)
+    std::unordered_map<size_t, std::vector<get_outs_entry>> ring_cache;
+    auto fetch_rings = [&](const std::vector<size_t>& selected) {
+        std::vector<size_t> missing;
+        bool has_rct = false;
+        for (size_t idx : selected) {
+            if (!ring_cache.count(idx)) {
+                missing.push_back(idx);
+                has_rct |= m_transfers[idx].is_rct();
+            }
+        }
+        if (!missing.empty()) {
+            const auto fetch_start = std::chrono::steady_clock::now();
+            std::vector<std::vector<get_outs_entry>> fetched;
+            get_outs(fetched, missing, fake_outs_count, has_rct);  // may throw
+            THROW_WALLET_EXCEPTION_IF(
+                    fetched.size() != missing.size(),
+                    error::wallet_internal_error,
+                    "Unexpected number of rings returned");
+            for (size_t i = 0; i < missing.size(); ++i)
+                ring_cache[missing[i]] = std::move(fetched[i]);
+            timings.ring_fetch += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - fetch_start);
+        }
+        outs.clear();
+        outs.reserve(selected.size());
+        for (size_t idx : selected)
+            outs.push_back(ring_cache[idx]);
+    };
+
     // for rct, since we don't see the amounts, we will try to make all transactions
     // look the same, with 1 or 2 inputs, and 2 outputs. One input is preferable, as
     // this prevents linking to another by provenance analysis, but two is ok if we
@@ -12920,6 +13012,8 @@ std::vector<wallet2::pending_tx> wallet2::create_transactions_2(
                     "Trying to create a tx now, with {} outputs and {} inputs",
                     tx.dsts.size(),
                     tx.selected_transfers.size());
+            if (outs.empty())
+                fetch_rings(tx.selected_transfers);
             transfer_selected_rct(
                     tx.dsts,
                     tx.selected_transfers,
@@ -13076,13 +13170,21 @@ std::vector<wallet2::pending_tx> wallet2::create_transactions_2(
             print_money(accumulated_fee),
             print_money(accumulated_change));
 
+    const auto construction_start = std::chrono::steady_clock::now();
+    timings.selection = std::chrono::duration_cast<std::chrono::microseconds>(
+                                construction_start - selection_start) -
+                        timings.ring_fetch;
+    timings.transactions = txes.size();
+
     hwdev.set_mode(hw::device::mode::TRANSACTION_CREATE_REAL);
-    for (auto& tx : txes) {
+    // Builds the final version of `tx`, returning the amount it burns
+    auto construct_final_tx = [&](TX& tx) -> uint64_t {
         // Convert burn percent into a fixed burn amount because this is the last place we can back
         // out the base fee that would apply at 100% (the actual fee here is that times the
         // priority-based fee percent)
+        oxen_construct_tx_params params = tx_params;
         if (burning)
-            tx_params.burn_fixed =
+            params.burn_fixed =
                     burn_fixed + (tx.needed_fee - burn_fixed) * burn_percent / fee_percent;
 
         cryptonote::transaction test_tx;
@@ -13098,12 +13200,54 @@ std::vector<wallet2::pending_tx> wallet2::create_transactions_2(
                 test_tx,       /* OUT   cryptonote::transaction& tx, */
                 test_ptx,      /* OUT   cryptonote::transaction& tx, */
                 rct_config,
-                tx_params);
+                params);
         auto txBlob = t_serializable_object_to_blob(test_ptx.tx);
         tx.tx = test_tx;
         tx.ptx = test_ptx;
         tx.weight = get_transaction_weight(test_tx, txBlob.size());
-    }
+        return params.burn_fixed;
+    };
+
+    // Each final tx only depends on its own inputs, rings and destinations, so when the keys are
+    // held in software (a hardware device signs one tx at a time, and multisig needs the shared
+    // kLRki bookkeeping) we build and sign them concurrently.  Results land in each tx's own slot,
+    // so the returned order is the same as building them serially.
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    std::vector<uint64_t> burns(txes.size());
+    if (txes.size() > 1 && tpool.get_max_concurrency() > 1 &&
+        hwdev.get_type() == hw::device::type::SOFTWARE && !m_multisig) {
+        std::vector<std::exception_ptr> errors(txes.size());
+        tools::threadpool::waiter waiter;
+        for (size_t i = 0; i < txes.size(); ++i)
+            tpool.submit(&waiter, [&, i] {
+                try {
+                    burns[i] = construct_final_tx(txes[i]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        waiter.wait(&tpool);
+        for (auto& e : errors)
+            if (e)
+                std::rethrow_exception(e);
+        timings.threads = std::min<size_t>(txes.size(), tpool.get_max_concurrency());
+    } else {
+        for (size_t i = 0; i < txes.size(); ++i)
+            burns[i] = construct_final_tx(txes[i]);
+    }
+    // The caller's params end up with the burn of the last tx, as they always have
+    if (burning)
+        tx_params.burn_fixed = burns.back();
+    timings.construction = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - construction_start);
+    log::debug(
+            logcat,
+            "Built {} txes: selection {}us, ring fetch {}us, construction {}us on {} thread(s)",
+            timings.transactions,
+            timings.selection.count(),
+            timings.ring_fetch.count(),
+            timings.construction.count(),
+            timings.threads);
 
     std::vector<wallet2::pending_tx> ptx_vector;
     for (auto i = txes.begin(); i != txes.end(); ++i) {
@@ -32,6 +32,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <boost/serialization/deque.hpp>
@@ -183,6 +184,9 @@ class i_wallet2_callback {
     virtual void on_device_progress(const hw::device_progress& event){};
     // Common callbacks
     virtual void on_pool_tx_removed(const crypto::hash& txid) {}
+    // Called after blocks from `height` up were detached (reorg or rescan); transfers, payments and
+    // confirmed txes at those heights are gone from the wallet.
+    virtual void on_reorg(uint64_t height, uint64_t blocks_detached, size_t transfers_detached) {}
     virtual ~i_wallet2_callback() {}
 };
 
@@ -206,6 +210,10 @@ struct tx_money_got_in_out {
     uint64_t unlock_time;
 };
 
+// Block hashes known to the wallet.  Hashes from offset() up to the tip are kept in full (the
+// "dense" region); trimming moves older hashes out of it, keeping only a sparse set of them at
+// exponentially growing distances below the offset as checkpoints.  The checkpoints let a short
+// chain history still reach back past the offset without storing every hash.
 class hashchain {
   public:
     hashchain() : m_genesis(crypto::null<crypto::hash>), m_offset(0) {}
@@ -225,18 +233,46 @@ class hashchain {
     void clear() {
         m_offset = 0;
         m_blockchain.clear();
+        m_checkpoint_heights.clear();
+        m_checkpoint_hashes.clear();
     }
     bool empty() const { return m_blockchain.empty() && m_offset == 0; }
     void trim(size_t height) {
-        while (height > m_offset && m_blockchain.size() > 1) {
-            m_blockchain.pop_front();
-            ++m_offset;
+        if (height > m_offset && m_blockchain.size() > 1) {
+            const size_t new_offset = std::min(height, size() - 1);
+            // Of the hashes leaving the dense region, keep those 1, 2, 4, ... blocks below the new
+            // offset.  Null hashes and copies of the genesis hash are placeholders used when
+            // skipping ahead (see wallet2::fast_refresh), so they never become checkpoints.
+            std::vector<size_t> heights;
+            for (size_t d = 1; d <= new_offset - m_offset; d *= 2)
+                heights.push_back(new_offset - d);
+            for (auto it = heights.rbegin(); it != heights.rend(); ++it) {
+                const crypto::hash& h = (*this)[*it];
+                if (*it == 0 || !h || h == m_genesis)
+                    continue;
+                m_checkpoint_heights.push_back(*it);
+                m_checkpoint_hashes.push_back(h);
+            }
+            m_blockchain.erase(m_blockchain.begin(), m_blockchain.begin() + (new_offset - m_offset));
+            m_offset = new_offset;
+            thin_checkpoints();
         }
         m_blockchain.shrink_to_fit();
     }
     void refill(const crypto::hash& hash) {
         m_blockchain.push_back(hash);
         --m_offset;
+        while (!m_checkpoint_heights.empty() && m_checkpoint_heights.back() >= m_offset) {
+            m_checkpoint_heights.pop_back();
+            m_checkpoint_hashes.pop_back();
+        }
+    }
+
+    // Heights of the sparse checkpoints below offset(), in ascending order.
+    const std::vector<uint64_t>& checkpoint_heights() const { return m_checkpoint_heights; }
+    // Appends the sparse checkpoint hashes to `ids`, newest first.
+    void append_checkpoints(std::list<crypto::hash>& ids) const {
+        ids.insert(ids.end(), m_checkpoint_hashes.rbegin(), m_checkpoint_hashes.rend());
     }
 
     template <class t_archive>
@@ -244,12 +280,39 @@ class hashchain {
         a& m_offset;
         a& m_genesis;
         a& m_blockchain;
+        if (ver < 1)
+            return;
+        a& m_checkpoint_heights;
+        a& m_checkpoint_hashes;
     }
 
   private:
+    // Keeps at most one checkpoint per power-of-two distance below the offset, preferring the
+    // oldest, which bounds the number of checkpoints to O(log(offset)) while letting the oldest
+    // ones survive as the offset advances.
+    void thin_checkpoints() {
+        std::vector<uint64_t> heights;
+        std::vector<crypto::hash> hashes;
+        int last_bucket = -1;
+        for (size_t i = 0; i < m_checkpoint_heights.size(); ++i) {
+            int bucket = 0;
+            for (uint64_t d = m_offset - m_checkpoint_heights[i]; d > 1; d >>= 1)
+                ++bucket;
+            if (bucket == last_bucket)
+                continue;
+            heights.push_back(m_checkpoint_heights[i]);
+            hashes.push_back(m_checkpoint_hashes[i]);
+            last_bucket = bucket;
+        }
+        m_checkpoint_heights = std::move(heights);
+        m_checkpoint_hashes = std::move(hashes);
+    }
+
     size_t m_offset;
     crypto::hash m_genesis;
     std::deque<crypto::hash> m_blockchain;
+    std::vector<uint64_t> m_checkpoint_heights;
+    std::vector<crypto::hash> m_checkpoint_hashes;
 };
 
 // enum class stake_check_result { allowed, not_allowed, try_later };
@@ -958,6 +1021,18 @@ class wallet2 {
             std::set<uint32_t> subaddr_indices,
             cryptonote::oxen_construct_tx_params& tx_params);
 
+    // Wall-clock time spent in each stage of the most recent create_transactions_2 call.
+    struct tx_construction_timings {
+        std::chrono::microseconds selection{0};     // input selection and fee estimation
+        std::chrono::microseconds ring_fetch{0};    // fetching decoy rings from the daemon
+        std::chrono::microseconds construction{0};  // building and signing the final txes
+        size_t transactions = 0;
+        unsigned threads = 1;  // number of final txes built concurrently
+    };
+    const tx_construction_timings& last_tx_construction_timings() const {
+        return m_last_tx_construction_timings;
+    }
+
     std::vector<pending_tx> create_transactions_all(
             uint64_t below,
             const cryptonote::account_public_address& address,
@@ -1888,6 +1963,10 @@ class wallet2 {
             std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>>& outs);
     bool set_ring(
             const crypto::key_image& key_image, const std::vector<uint64_t>& outs, bool relative);
+    // Stores many rings at once, in a single ringdb transaction.
+    bool set_rings(
+            const std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>>& rings,
+            bool relative);
     bool unset_ring(const std::vector<crypto::key_image>& key_images);
     bool unset_ring(const crypto::hash& txid);
     bool find_and_save_rings(bool force = true);
@@ -2290,6 +2369,9 @@ class wallet2 {
             const crypto::chacha_key& key,
             const crypto::key_image& key_image,
             std::vector<uint64_t>& outs);
+    // Looks up, in one ringdb transaction, the rings previously used by the given transfers.
+    std::unordered_map<crypto::key_image, std::vector<uint64_t>> get_known_rings(
+            const std::vector<size_t>& selected_transfers);
     crypto::chacha_key get_ringdb_key();
     void setup_keys(const epee::wipeable_string& password);
     size_t get_transfer_details(const crypto::key_image& ki) const;
@@ -2416,6 +2498,7 @@ class wallet2 {
     uint64_t m_ignore_outputs_below;
     bool m_track_uses;
     std::chrono::seconds m_inactivity_lock_timeout;
+    tx_construction_timings m_last_tx_construction_timings;
     bool m_is_initialized;
     NodeRPCProxy m_node_rpc_proxy;
     std::unordered_set<crypto::hash> m_scanned_pool_txs[2];
@@ -2495,6 +2578,7 @@ bool parse_subaddress_indices(
 bool parse_priority(const std::string& arg, uint32_t& priority);
 
 }  // namespace tools
+BOOST_CLASS_VERSION(tools::hashchain, 1)
 BOOST_CLASS_VERSION(tools::wallet2, 30)
 BOOST_CLASS_VERSION(tools::wallet2::payment_details, 6)
 BOOST_CLASS_VERSION(tools::wallet2::pool_payment_details, 1)
@@ -1190,6 +1190,12 @@ TRANSFER_SPLIT::response wallet_rpc_server::invoke(TRANSFER_SPLIT::request&& req
                 res.tx_blob_list,
                 req.get_tx_metadata,
                 res.tx_metadata_list);
+
+        const auto& timings = m_wallet->last_tx_construction_timings();
+        res.timings.selection_us = timings.selection.count();
+        res.timings.ring_fetch_us = timings.ring_fetch.count();
+        res.timings.construction_us = timings.construction.count();
+        res.timings.threads = timings.threads;
     }
     return res;
 }
@@ -213,6 +213,13 @@ KV_SERIALIZE_MAP_CODE_BEGIN(TRANSFER_SPLIT::key_list)
 KV_SERIALIZE(keys)
 KV_SERIALIZE_MAP_CODE_END()
 
+KV_SERIALIZE_MAP_CODE_BEGIN(TRANSFER_SPLIT::construction_timings)
+KV_SERIALIZE(selection_us)
+KV_SERIALIZE(ring_fetch_us)
+KV_SERIALIZE(construction_us)
+KV_SERIALIZE(threads)
+KV_SERIALIZE_MAP_CODE_END()
+
 KV_SERIALIZE_MAP_CODE_BEGIN(TRANSFER_SPLIT::response)
 KV_SERIALIZE(tx_hash_list)
 KV_SERIALIZE(tx_key_list)
@@ -222,6 +229,7 @@ KV_SERIALIZE(tx_blob_list)
 KV_SERIALIZE(tx_metadata_list)
 KV_SERIALIZE(multisig_txset)
 KV_SERIALIZE(unsigned_txset)
+KV_SERIALIZE(timings)
 KV_SERIALIZE_MAP_CODE_END()
 
 KV_SERIALIZE_MAP_CODE_BEGIN(DESCRIBE_TRANSFER::recipient)
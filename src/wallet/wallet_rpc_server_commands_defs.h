@@ -454,6 +454,15 @@ struct TRANSFER_SPLIT : RESTRICTED {
         KV_MAP_SERIALIZABLE
     };
 
+    struct construction_timings {
+        uint64_t selection_us;     // Time spent selecting inputs and estimating fees.
+        uint64_t ring_fetch_us;    // Time spent fetching decoy rings from the daemon.
+        uint64_t construction_us;  // Time spent building and signing the final transactions.
+        uint32_t threads;          // Number of transactions built concurrently.
+
+        KV_MAP_SERIALIZABLE
+    };
+
     struct response {
         std::list<std::string> tx_hash_list;      // The tx hashes of every transaction.
         std::list<std::string> tx_key_list;       // The transaction keys for every transaction.
@@ -465,6 +474,7 @@ struct TRANSFER_SPLIT : RESTRICTED {
         std::string multisig_txset;  // The set of signing keys used in a multisig transaction
                                      // (empty for non-multisig).
         std::string unsigned_txset;  // Set of unsigned tx for cold-signing purposes.
+        construction_timings timings;  // Time spent in each stage of building the transactions.
 
         KV_MAP_SERIALIZABLE
     };
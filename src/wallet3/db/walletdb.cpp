@@ -5,7 +5,13 @@
 #include <cryptonote_basic/cryptonote_basic.h>
 #include <fmt/core.h>
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <iterator>
+#include <string_view>
+#include <tuple>
+#include <variant>
 
 #include "wallet3/block.hpp"
 
@@ -14,6 +20,135 @@ static auto logcat = oxen::log::Cat("wallet");
 
 WalletDB::~WalletDB() {}
 
+// Changes to the schema since it was first created, in order.  The `db_version` metadata is the
+// number of them that have been applied to a database; create_schema() applies the rest.
+static constexpr std::array<std::string_view, 2> schema_migrations{
+        // 1: unlock schedule.  Keeps the amount of unspent, not-being-spent outputs that unlocks at
+        // each height, and running available/unlocked balances, so that balance queries don't have
+        // to scan every output the wallet has ever received.
+        R"(
+          CREATE TABLE unlock_schedule (
+            height INTEGER PRIMARY KEY NOT NULL,
+            amount BIGINT NOT NULL
+          );
+
+          INSERT INTO unlock_schedule(height, amount)
+          SELECT block_height + unlock_time, sum(amount) FROM outputs
+          WHERE spent_height = 0 AND spending = FALSE
+          GROUP BY block_height + unlock_time;
+
+          -- unlocked_balance is the sum of the schedule up to and including unlocked_height, which
+          -- follows the last scanned block
+          INSERT INTO metadata(id, val_numeric)
+          VALUES
+            ('available_balance', (SELECT coalesce(sum(amount), 0) FROM unlock_schedule)),
+            ('unlocked_height', (SELECT val_numeric FROM metadata WHERE id = 'last_scan_height')),
+            ('unlocked_balance', (SELECT coalesce(sum(amount), 0) FROM unlock_schedule
+              WHERE height <= (SELECT val_numeric FROM metadata WHERE id = 'last_scan_height')));
+
+          CREATE INDEX output_unspent_amount ON outputs(amount)
+          WHERE spent_height = 0 AND spending = FALSE;
+          CREATE INDEX output_unspent_height ON outputs(block_height, amount)
+          WHERE spent_height = 0 AND spending = FALSE;
+
+          -- inserting (height, amount) here adds amount (which may be negative) to the schedule and
+          -- the balances
+          CREATE VIEW unlock_schedule_changes AS SELECT height, amount FROM unlock_schedule;
+
+          CREATE TRIGGER unlock_schedule_changed INSTEAD OF INSERT ON unlock_schedule_changes
+          FOR EACH ROW
+          BEGIN
+            INSERT INTO unlock_schedule(height, amount) VALUES(NEW.height, NEW.amount)
+              ON CONFLICT(height) DO UPDATE SET amount = amount + excluded.amount;
+            DELETE FROM unlock_schedule WHERE height = NEW.height AND amount = 0;
+            UPDATE metadata SET val_numeric = val_numeric + NEW.amount WHERE id = 'available_balance';
+            UPDATE metadata SET val_numeric = val_numeric + NEW.amount WHERE id = 'unlocked_balance'
+              AND NEW.height <= (SELECT val_numeric FROM metadata WHERE id = 'unlocked_height');
+          END;
+
+          -- inserting a height here moves unlocked_height to it, adding or removing whatever
+          -- unlocks in between from unlocked_balance
+          CREATE VIEW unlocked_height_changes AS SELECT val_numeric AS height FROM metadata
+          WHERE id = 'unlocked_height';
+
+          CREATE TRIGGER unlocked_height_changed INSTEAD OF INSERT ON unlocked_height_changes
+          FOR EACH ROW
+          BEGIN
+            UPDATE metadata SET val_numeric = val_numeric
+              + (SELECT coalesce(sum(amount), 0) FROM unlock_schedule
+                  WHERE height > (SELECT val_numeric FROM metadata WHERE id = 'unlocked_height')
+                    AND height <= NEW.height)
+              - (SELECT coalesce(sum(amount), 0) FROM unlock_schedule
+                  WHERE height > NEW.height
+                    AND height <= (SELECT val_numeric FROM metadata WHERE id = 'unlocked_height'))
+              WHERE id = 'unlocked_balance';
+            UPDATE metadata SET val_numeric = NEW.height WHERE id = 'unlocked_height';
+          END;
+
+          -- the original took the block's output count off last_scan_height instead of output_count
+          DROP TRIGGER block_removed;
+          CREATE TRIGGER block_removed AFTER DELETE ON blocks
+          FOR EACH ROW
+          BEGIN
+            UPDATE metadata SET val_numeric = OLD.height - 1 WHERE id = 'last_scan_height';
+            UPDATE metadata SET val_numeric = val_numeric - OLD.output_count WHERE id = 'output_count';
+          END;
+
+          CREATE TRIGGER block_added_unlock AFTER INSERT ON blocks
+          FOR EACH ROW
+          BEGIN
+            INSERT INTO unlocked_height_changes VALUES(NEW.height);
+          END;
+
+          CREATE TRIGGER block_removed_unlock AFTER DELETE ON blocks
+          FOR EACH ROW
+          BEGIN
+            INSERT INTO unlocked_height_changes VALUES(OLD.height - 1);
+          END;
+
+          CREATE TRIGGER output_available_added AFTER INSERT ON outputs
+          FOR EACH ROW WHEN NEW.spent_height = 0 AND NOT NEW.spending
+          BEGIN
+            INSERT INTO unlock_schedule_changes
+            VALUES(NEW.block_height + NEW.unlock_time, NEW.amount);
+          END;
+
+          CREATE TRIGGER output_available_removed AFTER DELETE ON outputs
+          FOR EACH ROW WHEN OLD.spent_height = 0 AND NOT OLD.spending
+          BEGIN
+            INSERT INTO unlock_schedule_changes
+            VALUES(OLD.block_height + OLD.unlock_time, -OLD.amount);
+          END;
+
+          -- spent (or being spent), or un-spent by a re-org
+          CREATE TRIGGER output_available_changed AFTER UPDATE OF spent_height, spending ON outputs
+          FOR EACH ROW
+          WHEN (OLD.spent_height = 0 AND NOT OLD.spending) != (NEW.spent_height = 0 AND NOT NEW.spending)
+          BEGIN
+            INSERT INTO unlock_schedule_changes VALUES(
+              NEW.block_height + NEW.unlock_time,
+              CASE WHEN NEW.spent_height = 0 AND NOT NEW.spending
+                THEN NEW.amount ELSE -NEW.amount END);
+          END;
+        )",
+
+        // 2: transfer history.  Payment IDs on transactions, and indexes for listing received
+        // outputs and transfers a page at a time by height, subaddress or payment ID.
+        R"(
+          -- hex of the decrypted payment ID, if the transaction had a (non-dummy) one
+          ALTER TABLE transactions ADD COLUMN payment_id TEXT;
+
+          CREATE INDEX transaction_block ON transactions(block);
+          CREATE INDEX transaction_payment_id ON transactions(payment_id)
+          WHERE payment_id IS NOT NULL;
+          CREATE INDEX output_height ON outputs(block_height);
+          CREATE INDEX output_subaddress
+          ON outputs(subaddress_major, subaddress_minor, block_height);
+          CREATE INDEX output_tx ON outputs(tx);
+          CREATE INDEX spend_tx ON spends(tx);
+        )",
+};
+
 void WalletDB::create_schema(cryptonote::network_type nettype) {
     if (db.tableExists("outputs")) {
         if (auto stored_nettype = this->network_type(); stored_nettype != nettype) {
@@ -24,6 +159,9 @@ void WalletDB::create_schema(cryptonote::network_type nettype) {
             // TODO: log error as well
             throw std::invalid_argument(err);
         }
+        SQLite::Transaction db_tx(db);
+        migrate_schema();
+        db_tx.commit();
         return;
     }
 
@@ -179,9 +317,23 @@ void WalletDB::create_schema(cryptonote::network_type nettype) {
 
     set_metadata_text("nettype", std::string(cryptonote::network_type_to_string(nettype)));
 
+    migrate_schema();
+
     db_tx.commit();
 }
 
+void WalletDB::migrate_schema() {
+    auto version = get_metadata_int("db_version");
+    if (version < 0 || version > static_cast<int64_t>(schema_migrations.size()))
+        throw std::runtime_error{"Wallet db has unknown schema version {}"_format(version)};
+
+    for (; version < static_cast<int64_t>(schema_migrations.size()); ++version) {
+        oxen::log::info(logcat, "Upgrading wallet db schema to version {}", version + 1);
+        db.exec(std::string{schema_migrations[version]});
+    }
+    set_metadata_int("db_version", version);
+}
+
 // Helpers to access the metadata table
 void WalletDB::set_metadata_int(const std::string& id, int64_t val) {
     prepared_exec(
@@ -293,7 +445,14 @@ void WalletDB::pop_block() {
 void WalletDB::store_transaction(
         const crypto::hash& tx_hash, const int64_t height, const std::vector<Output>& outputs) {
     auto hash_str = tools::type_to_hex(tx_hash);
-    prepared_exec("INSERT INTO transactions(block,hash) VALUES(?,?)", height, hash_str);
+    if (!outputs.empty() && outputs.front().payment_id)
+        prepared_exec(
+                "INSERT INTO transactions(block,hash,payment_id) VALUES(?,?,?)",
+                height,
+                hash_str,
+                tools::type_to_hex(*outputs.front().payment_id));
+    else
+        prepared_exec("INSERT INTO transactions(block,hash) VALUES(?,?)", height, hash_str);
 
     for (const auto& output : outputs) {
         prepared_exec(
@@ -379,46 +538,29 @@ int64_t WalletDB::overall_balance() {
 }
 
 int64_t WalletDB::unlocked_balance() {
-    return prepared_get<int64_t>(
-            "SELECT sum(o.amount) FROM outputs AS o WHERE o.spent_height = 0 AND o.spending = "
-            "false AND (o.block_height + o.unlock_time) <= (SELECT m.val_numeric FROM metadata as "
-            "m WHERE m.id = 'last_scan_height')");
+    return get_metadata_int("unlocked_balance");
 }
 
 int64_t WalletDB::available_balance(std::optional<int64_t> min_amount) {
-    std::string query =
-            "SELECT sum(amount) FROM outputs WHERE spent_height = 0 AND spending = FALSE";
-
-    if (min_amount) {
-        query += " AND amount > ?";
-        return prepared_get<int64_t>(query, *min_amount);
-    }
+    if (!min_amount)
+        return get_metadata_int("available_balance");
 
-    return prepared_get<int64_t>(query);
+    // Uses the output_unspent_amount index, so only looks at the unspent outputs above the minimum
+    return prepared_get<int64_t>(
+            "SELECT coalesce(sum(amount), 0) FROM outputs WHERE spent_height = 0 AND spending = "
+            "FALSE AND amount > ?",
+            *min_amount);
 }
 
-std::vector<Output> WalletDB::available_outputs(std::optional<int64_t> min_amount) {
-    std::vector<Output> outs;
+namespace {
+    // The columns read_output reads, from outputs joined with key_images
+    constexpr std::string_view output_columns =
+            "amount, output_index, global_index, unlock_time, block_height, output_key, "
+            "derivation, rct_mask, key_images.key_image, spent_height, spending, "
+            "subaddress_major, subaddress_minor";
 
-    std::string query =
-            "SELECT amount, output_index, global_index, "
-            "unlock_time, block_height, output_key, derivation, rct_mask, key_images.key_image, "
-            "spent_height, spending FROM outputs JOIN key_images ON outputs.key_image = "
-            "key_images.id WHERE spent_height = 0 AND spending = FALSE ";
-
-    if (min_amount) {
-        query += "AND amount > ? ";
-    }
-
-    query += "ORDER BY amount";
-
-    auto st = prepared_st(query);
-
-    if (min_amount)
-        st->bind(1, *min_amount);
-
-    while (st->executeStep()) {
-        auto& out = outs.emplace_back();
+    Output read_output(SQLite::Statement& st) {
+        Output out;
         auto from_db =
                 db::get<int64_t,
                         int64_t,
@@ -430,6 +572,8 @@ std::vector<Output> WalletDB::available_outputs(std::optional<int64_t> min_amoun
                         std::string,
                         std::string,
                         int64_t,
+                        int64_t,
+                        int64_t,
                         int64_t>(st);
         out.amount = std::get<0>(from_db);
         out.output_index = std::get<1>(from_db);
@@ -442,11 +586,307 @@ std::vector<Output> WalletDB::available_outputs(std::optional<int64_t> min_amoun
         tools::hex_to_type(std::get<8>(from_db), out.key_image);
         out.spent_height = std::get<9>(from_db);
         out.spending = std::get<10>(from_db);
+        out.subaddress_index = {
+                static_cast<uint32_t>(std::get<11>(from_db)),
+                static_cast<uint32_t>(std::get<12>(from_db))};
+        return out;
+    }
+
+    // Unspent, not being spent, and unlocked as of the last scanned block
+    constexpr std::string_view unlocked_output =
+            "spent_height = 0 AND spending = FALSE AND block_height + unlock_time <= "
+            "(SELECT val_numeric FROM metadata WHERE id = 'unlocked_height')";
+}  // namespace
+
+std::vector<Output> WalletDB::available_outputs(std::optional<int64_t> min_amount) {
+    std::vector<Output> outs;
+
+    std::string query = "SELECT {} FROM outputs JOIN key_images ON outputs.key_image = "
+                        "key_images.id WHERE spent_height = 0 AND spending = FALSE "_format(
+                                output_columns);
+
+    if (min_amount) {
+        query += "AND amount > ? ";
+    }
+
+    query += "ORDER BY block_height, amount";
+
+    auto st = prepared_st(query);
+
+    if (min_amount)
+        st->bind(1, *min_amount);
+
+    while (st->executeStep())
+        outs.push_back(read_output(st));
+
+    return outs;
+}
+
+std::vector<Output> WalletDB::unlocked_outputs(
+        std::optional<uint32_t> account,
+        const std::vector<uint32_t>& subaddresses,
+        std::optional<int64_t> below_amount) {
+    std::string query = "SELECT {} FROM outputs JOIN key_images ON outputs.key_image = "
+                        "key_images.id WHERE {}"_format(output_columns, unlocked_output);
+    std::vector<int64_t> params;
+    if (account) {
+        query += " AND subaddress_major = ?";
+        params.push_back(*account);
+        if (!subaddresses.empty()) {
+            query += db::multi_in_query(" AND subaddress_minor IN (", subaddresses.size(), ")");
+            params.insert(params.end(), subaddresses.begin(), subaddresses.end());
+        }
     }
+    if (below_amount) {
+        query += " AND amount < ?";
+        params.push_back(*below_amount);
+    }
+    query += " ORDER BY block_height, amount, outputs.id";
 
+    auto st = prepared_st(query);
+    int i = 1;
+    for (auto param : params)
+        st->bind(i++, param);
+
+    std::vector<Output> outs;
+    while (st->executeStep())
+        outs.push_back(read_output(st));
     return outs;
 }
 
+std::optional<Output> WalletDB::unlocked_output_by_key_image(const std::string& key_image) {
+    auto st = prepared_st(
+            "SELECT {} FROM outputs JOIN key_images ON outputs.key_image = key_images.id "
+            "WHERE key_images.key_image = ? AND {}"_format(output_columns, unlocked_output));
+    st->bind(1, key_image);
+    if (!st->executeStep())
+        return std::nullopt;
+    return read_output(st);
+}
+
+namespace {
+    // The WHERE conditions of a listing query, and the parameters they take, in order.
+    struct listing_conditions {
+        std::vector<std::string> conditions;
+        std::vector<std::variant<int64_t, std::string>> params;
+
+        void add(std::string condition) { conditions.push_back(std::move(condition)); }
+
+        template <typename... T>
+        void add(std::string condition, T&&... values) {
+            add(std::move(condition));
+            (params.emplace_back(std::forward<T>(values)), ...);
+        }
+
+        // The query's position, height range, subaddress and payment ID filters; `height`, `id`
+        // and `subaddress` are the columns to filter on.
+        listing_conditions(
+                const TransferQuery& query,
+                const std::string& height,
+                const std::string& id,
+                const std::string& subaddress) {
+            // The minimum height goes into the cursor rather than being a condition of its own:
+            // given two lower bounds sqlite seeks to only one of them, which may not be the cursor.
+            TransferCursor after = query.after;
+            if (after.block_height < query.min_height)
+                after = {query.min_height - 1, std::numeric_limits<int64_t>::max()};
+            add("({0}, {1}) > (?, ?)"_format(height, id), after.block_height, after.id);
+            if (query.max_height != std::numeric_limits<int64_t>::max())
+                add("{} <= ?"_format(height), query.max_height);
+            if (query.account) {
+                add("{}_major = ?"_format(subaddress), int64_t{*query.account});
+                if (!query.subaddresses.empty()) {
+                    add(db::multi_in_query(
+                            "{}_minor IN ("_format(subaddress), query.subaddresses.size(), ")"));
+                    for (auto minor : query.subaddresses)
+                        params.emplace_back(int64_t{minor});
+                }
+            }
+            if (!query.payment_ids.empty()) {
+                add(db::multi_in_query("t.payment_id IN (", query.payment_ids.size(), ")"));
+                for (const auto& payment_id : query.payment_ids)
+                    params.emplace_back(payment_id);
+            }
+        }
+
+        std::string where() const {
+            std::string sql = " WHERE ";
+            for (size_t i = 0; i < conditions.size(); i++) {
+                if (i > 0)
+                    sql += " AND ";
+                sql += conditions[i];
+            }
+            return sql;
+        }
+
+        // Binds the parameters, and then `extra`, to the statement
+        template <typename... T>
+        void bind(SQLite::Statement& st, const T&... extra) const {
+            int i = 1;
+            for (const auto& param : params)
+                std::visit([&](const auto& value) { st.bind(i++, value); }, param);
+            (st.bind(i++, extra), ...);
+        }
+    };
+
+    // Subaddresses are listed by their lowest one, packed into a single integer so that min() on
+    // it picks the major and the minor index together
+    constexpr std::string_view packed_subaddress =
+            "o.subaddress_major * 4294967296 + o.subaddress_minor";
+
+    cryptonote::subaddress_index unpack_subaddress(int64_t packed) {
+        return {static_cast<uint32_t>(packed >> 32), static_cast<uint32_t>(packed & 0xffffffff)};
+    }
+}  // namespace
+
+std::vector<ReceivedOutput> WalletDB::received_outputs(const TransferQuery& query) {
+    std::vector<ReceivedOutput> outs;
+    if (query.limit == 0)
+        return outs;
+
+    listing_conditions where{query, "o.block_height", "o.id", "o.subaddress"};
+    if (query.spent)
+        where.add(*query.spent ? "o.spent_height != 0" : "o.spent_height = 0");
+
+    // Walks the output_height index (or output_subaddress, for a single subaddress) from the
+    // cursor, so a page costs the same wherever it starts
+    auto st = prepared_st(
+            "SELECT o.id, o.amount, o.global_index, o.unlock_time, o.block_height, "
+            "o.spent_height, o.spending, o.subaddress_major, o.subaddress_minor, t.hash, "
+            "t.payment_id, k.key_image "
+            "FROM outputs o JOIN transactions t ON o.tx = t.id "
+            "JOIN key_images k ON o.key_image = k.id" +
+            where.where() + " ORDER BY o.block_height, o.id LIMIT ?");
+    where.bind(st, static_cast<int64_t>(query.limit));
+
+    while (st->executeStep()) {
+        auto [id, amount, global_index, unlock_time, block_height, spent_height, spending, major,
+              minor, tx_hash, payment_id, key_image] =
+                db::get<int64_t,
+                        int64_t,
+                        int64_t,
+                        int64_t,
+                        int64_t,
+                        int64_t,
+                        int64_t,
+                        int64_t,
+                        int64_t,
+                        std::string,
+                        std::string,
+                        std::string>(st);
+        outs.push_back(ReceivedOutput{
+                id,
+                amount,
+                global_index,
+                unlock_time,
+                block_height,
+                spent_height,
+                spending != 0,
+                {static_cast<uint32_t>(major), static_cast<uint32_t>(minor)},
+                std::move(tx_hash),
+                std::move(payment_id),
+                std::move(key_image)});
+    }
+    return outs;
+}
+
+std::vector<Transfer> WalletDB::transfers(const TransferQuery& query, bool in, bool out) {
+    std::vector<Transfer> incoming, outgoing;
+    if (query.limit == 0)
+        return incoming;
+
+    auto list = [this, &query](const std::string& select, listing_conditions& where) {
+        std::vector<Transfer> transfers;
+        auto st = prepared_st(
+                select + where.where() + " GROUP BY t.block, t.id ORDER BY t.block, t.id LIMIT ?");
+        where.bind(st, static_cast<int64_t>(query.limit));
+        while (st->executeStep()) {
+            auto [id, block_height, tx_hash, payment_id, outgoing, amount, unlock_time, sub] =
+                    db::get<int64_t,
+                            int64_t,
+                            std::string,
+                            std::string,
+                            int64_t,
+                            int64_t,
+                            int64_t,
+                            int64_t>(st);
+            transfers.push_back(Transfer{
+                    id,
+                    block_height,
+                    std::move(tx_hash),
+                    std::move(payment_id),
+                    outgoing != 0,
+                    amount,
+                    unlock_time,
+                    unpack_subaddress(sub)});
+        }
+        return transfers;
+    };
+
+    // Both walk the transaction_block index from the cursor, unless there's a more selective
+    // subaddress or payment ID filter
+    if (in) {
+        listing_conditions where{query, "t.block", "t.id", "o.subaddress"};
+        where.add("NOT EXISTS (SELECT 1 FROM spends s WHERE s.tx = t.id)");
+        incoming = list(
+                "SELECT t.id, t.block, t.hash, t.payment_id, 0, sum(o.amount), max(o.unlock_time), "
+                "min({}) FROM transactions t JOIN outputs o ON o.tx = t.id"_format(
+                        packed_subaddress),
+                where);
+    }
+    if (out) {
+        // The amount is worked out separately so that it doesn't depend on which subaddresses are
+        // asked for.  CROSS JOIN keeps sqlite on transaction_block, and the unary + keeps it from
+        // looking up the spent outputs by subaddress rather than key image: otherwise it may go
+        // through every output of ours to find the spent ones.
+        listing_conditions where{query, "t.block", "t.id", "+o.subaddress"};
+        outgoing = list(
+                "SELECT t.id, t.block, t.hash, t.payment_id, 1, "
+                "(SELECT sum(so.amount) FROM spends ss JOIN outputs so ON so.key_image = "
+                "ss.key_image WHERE ss.tx = t.id) - "
+                "coalesce((SELECT sum(c.amount) FROM outputs c WHERE c.tx = t.id), 0), 0, "
+                "min({}) FROM transactions t CROSS JOIN spends s ON s.tx = t.id "
+                "JOIN outputs o ON o.key_image = s.key_image"_format(packed_subaddress),
+                where);
+    }
+    if (incoming.empty())
+        return outgoing;
+    if (outgoing.empty())
+        return incoming;
+
+    // A transaction is only ever in one of them, so this is the first `limit` of both
+    std::vector<Transfer> merged;
+    merged.reserve(std::min(query.limit, incoming.size() + outgoing.size()));
+    std::merge(
+            std::make_move_iterator(incoming.begin()),
+            std::make_move_iterator(incoming.end()),
+            std::make_move_iterator(outgoing.begin()),
+            std::make_move_iterator(outgoing.end()),
+            std::back_inserter(merged),
+            [](const Transfer& a, const Transfer& b) {
+                return std::tie(a.block_height, a.id) < std::tie(b.block_height, b.id);
+            });
+    if (merged.size() > query.limit)
+        merged.resize(query.limit);
+    return merged;
+}
+
+std::vector<Transfer> WalletDB::transfers_by_hash(const std::string& tx_hash) {
+    auto id = prepared_maybe_get<int64_t, int64_t>(
+            "SELECT block, id FROM transactions WHERE hash = ?", tx_hash);
+    if (!id)
+        return {};
+
+    // The page that is just this transaction
+    TransferQuery query;
+    query.after = {std::get<0>(*id), std::get<1>(*id) - 1};
+    query.limit = 1;
+    auto found = transfers(query, true, true);
+    if (!found.empty() && found.front().id != std::get<1>(*id))
+        found.clear();
+    return found;
+}
+
 int64_t WalletDB::chain_output_count() {
     return get_metadata_int("output_count");
 }
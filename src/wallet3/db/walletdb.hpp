@@ -2,6 +2,7 @@
 
 #include <SQLiteCpp/SQLiteCpp.h>
 
+#include <limits>
 #include <optional>
 #include <sqlitedb/database.hpp>
 
@@ -17,6 +18,59 @@ namespace wallet {
 struct Output;
 struct Block;
 
+// Where a page of received outputs or transfers starts: listings are in (block height, id) order,
+// and a page holds the rows after this.  The default starts from the beginning.
+struct TransferCursor {
+    int64_t block_height = -1;
+    int64_t id = 0;
+};
+
+// Which received outputs or transfers to list, and how many of them at once.
+struct TransferQuery {
+    TransferCursor after{};
+    size_t limit = 1000;
+    int64_t min_height = 0;
+    int64_t max_height = std::numeric_limits<int64_t>::max();
+    // Only spent (true) or unspent (false) outputs.  Received outputs only.
+    std::optional<bool> spent;
+    // Only outputs to (or, for outgoing transfers, spent from) this account...
+    std::optional<uint32_t> account;
+    // ...and, if not empty, these of its subaddresses.
+    std::vector<uint32_t> subaddresses;
+    // If not empty, only transactions with one of these payment IDs (hex).
+    std::vector<std::string> payment_ids;
+};
+
+// An output we received, as listed by WalletDB::received_outputs.
+struct ReceivedOutput {
+    int64_t id;
+    int64_t amount;
+    int64_t global_index;
+    int64_t unlock_time;
+    int64_t block_height;
+    int64_t spent_height;
+    bool spending;
+    cryptonote::subaddress_index subaddress;
+    std::string tx_hash;
+    std::string payment_id;  // hex, or empty if none
+    std::string key_image;
+};
+
+// A transaction that paid us, or spent our outputs, as listed by WalletDB::transfers.
+struct Transfer {
+    int64_t id;
+    int64_t block_height;
+    std::string tx_hash;
+    std::string payment_id;  // hex, or empty if none
+    bool outgoing;
+    // Incoming: the total of our outputs.  Outgoing: the total of our outputs it spent less any
+    // change it paid back to us, i.e. what was sent including the fee.
+    int64_t amount;
+    int64_t unlock_time;  // Incoming: the latest unlock time of our outputs
+    // The subaddress paid to (or spent from), or the lowest one if there are several
+    cryptonote::subaddress_index subaddress;
+};
+
 class WalletDB : public db::Database {
   public:
     using db::Database::Database;
@@ -27,8 +81,8 @@ class WalletDB : public db::Database {
     // while it exists when it is destroyed unless commit() is called on it.
     SQLite::Transaction db_transaction() { return SQLite::Transaction{db}; }
 
-    // Create the database schema for the current version of the wallet db.
-    // Migration code will live elsewhere.
+    // Create the database schema for the current version of the wallet db, or bring an existing
+    // database's schema up to date.
     void create_schema(cryptonote::network_type nettype = cryptonote::network_type::TESTNET);
 
     // Helpers to access the metadata table
@@ -82,17 +136,42 @@ class WalletDB : public db::Database {
     // Get available balance across all subaddresses
     int64_t overall_balance();
 
-    // Get unlocked balance across all subaddresses
+    // Get unlocked balance across all subaddresses: the available outputs that unlock at or below
+    // the last scanned block.  Kept up to date by triggers, so this doesn't scan the outputs.
     int64_t unlocked_balance();
 
     // Get available balance with amount above an optional minimum amount.
     // TODO: subaddress specification
     int64_t available_balance(std::optional<int64_t> min_amount);
 
-    // Selects all outputs with amount above an optional minimum amount.
+    // Selects all outputs with amount above an optional minimum amount, oldest first.
     // TODO: subaddress specification
     std::vector<Output> available_outputs(std::optional<int64_t> min_amount);
 
+    // Selects the unspent outputs that are unlocked as of the last scanned block, oldest first:
+    // only those of `account`, if given, and of the given subaddresses of it, if any, and only
+    // those with amount below `below_amount`, if given.  These are what a sweep can spend.
+    std::vector<Output> unlocked_outputs(
+            std::optional<uint32_t> account = std::nullopt,
+            const std::vector<uint32_t>& subaddresses = {},
+            std::optional<int64_t> below_amount = std::nullopt);
+
+    // The unspent, unlocked output with the given key image (hex), if we have one.
+    std::optional<Output> unlocked_output_by_key_image(const std::string& key_image);
+
+    // Lists a page of the outputs we have received that match `query`, in (block height, id)
+    // order.  A page full of outputs may be followed by more, starting after the last one.
+    std::vector<ReceivedOutput> received_outputs(const TransferQuery& query);
+
+    // Lists a page of the transactions that paid us (`in`) and/or spent our outputs (`out`) that
+    // match `query`, in (block height, transaction id) order, one entry per transaction and
+    // direction.  Change paid back to us by our own transactions isn't listed as incoming.  A page
+    // full of transfers may be followed by more, starting after the last one.
+    std::vector<Transfer> transfers(const TransferQuery& query, bool in, bool out);
+
+    // The transfers made by the transaction with the given hash (hex), if any.
+    std::vector<Transfer> transfers_by_hash(const std::string& tx_hash);
+
     // Gets the total number of outputs on the chain.  Since all Oxen outputs are RingCT
     // and thus mixable, this can be used for decoy selection.
     int64_t chain_output_count();
@@ -102,5 +181,10 @@ class WalletDB : public db::Database {
 
     // Loads keys from an already created database
     std::optional<DBKeys> load_keys();
+
+  private:
+    // Applies the schema migrations newer than the db_version metadata.  Must be called inside a
+    // db transaction.
+    void migrate_schema();
 };
 }  // namespace wallet
@@ -74,6 +74,7 @@ std::optional<cryptonote::subaddress_index> Keyring::output_and_derivation_ours(
 
     // Searchs against our map for subaddress public view keys which also includes our
     // regular view key at index (0,0)
+    std::shared_lock lock{subaddresses_mutex};
     if (const auto subaddress_index = subaddresses.find(candidate_key);
         subaddress_index != subaddresses.end())
         return subaddress_index->second;
@@ -101,6 +102,15 @@ crypto::key_image Keyring::key_image(
     return ret;
 }
 
+// Payment IDs are encrypted by xor with a hash of a*R, so decrypting is the same as encrypting.
+std::optional<crypto::hash8> Keyring::decrypt_payment_id(
+        const crypto::hash8& encrypted, const crypto::public_key& tx_pubkey) {
+    crypto::hash8 payment_id = encrypted;
+    if (not key_device.decrypt_payment_id(payment_id, tx_pubkey, view_private_key))
+        return std::nullopt;
+    return payment_id;
+}
+
 // TODO: replace later when removing wallet2½ layer
 std::pair<uint64_t, rct::key> Keyring::output_amount_and_mask(
         const rct::rctSig& rv, const crypto::key_derivation& derivation, unsigned int i) {
@@ -444,6 +454,7 @@ void Keyring::expand_subaddresses(const cryptonote::subaddress_index& lookahead)
     for (uint32_t i = 0; i < lookahead.major; i++) {
         const std::vector<crypto::public_key> pkeys =
                 get_subaddress_spend_public_keys(i, 0, lookahead.minor);
+        std::unique_lock lock{subaddresses_mutex};
         for (uint32_t j = 0; j < lookahead.minor; j++) {
             subaddresses[pkeys[j]] = {i, j};
         }
@@ -8,6 +8,7 @@
 
 #include <device/device_default.hpp>
 #include <optional>
+#include <shared_mutex>
 
 #include "pending_transaction.hpp"
 #include "walletkeys.hpp"
@@ -77,6 +78,11 @@ class Keyring : public WalletKeys {
             uint64_t output_index,
             const cryptonote::subaddress_index& sub_index);
 
+    // Decrypts an encrypted (short) payment ID from the extra of a transaction with public key
+    // `tx_pubkey`.
+    virtual std::optional<crypto::hash8> decrypt_payment_id(
+            const crypto::hash8& encrypted, const crypto::public_key& tx_pubkey);
+
     virtual std::pair<uint64_t, rct::key> output_amount_and_mask(
             const rct::rctSig& rv, const crypto::key_derivation& derivation, unsigned int i);
 
@@ -133,6 +139,8 @@ class Keyring : public WalletKeys {
     hw::core::device_default key_device;
     // TODO persist the subaddresses list to the database
     std::unordered_map<crypto::public_key, cryptonote::subaddress_index> subaddresses;
+    // Outputs get scanned on several threads at once, possibly while the list is being expanded
+    mutable std::shared_mutex subaddresses_mutex;
 };
 
 }  // namespace wallet
@@ -5,6 +5,7 @@
 #include <ringct/rctTypes.h>
 
 #include <cstdint>
+#include <optional>
 #include <string>
 
 namespace wallet {
@@ -26,6 +27,8 @@ struct Output {
     rct::key rct_mask;
     crypto::key_image key_image;
     cryptonote::subaddress_index subaddress_index;
+    // The (decrypted) payment ID of the transaction, if it had a real one
+    std::optional<crypto::hash8> payment_id;
 
     Output(std::tuple<int64_t, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t> row) :
             amount(std::get<0>(row)),
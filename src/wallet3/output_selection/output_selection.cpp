@@ -1,6 +1,97 @@
 #include "output_selection.hpp"
 
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
 namespace wallet {
+
+namespace {
+    // The outputs in block height order.  When they are already in that order this is just a view
+    // onto them; otherwise the order is worked out once, as positions into the outputs.
+    class height_index {
+      public:
+        explicit height_index(const std::vector<Output>& outputs) : outputs{outputs} {
+            auto by_height = [](const Output& a, const Output& b) {
+                return a.block_height < b.block_height;
+            };
+            if (std::is_sorted(outputs.begin(), outputs.end(), by_height))
+                return;
+            order.resize(outputs.size());
+            std::iota(order.begin(), order.end(), size_t{0});
+            std::stable_sort(order.begin(), order.end(), [&outputs](size_t a, size_t b) {
+                return outputs[a].block_height < outputs[b].block_height;
+            });
+        }
+
+        size_t size() const { return outputs.size(); }
+
+        // Position of the `i`th lowest output in the outputs
+        size_t at(size_t i) const { return order.empty() ? i : order[i]; }
+
+        int64_t height(size_t i) const { return outputs[at(i)].block_height; }
+
+        // The first i with height(i) >= h
+        size_t lower_bound(int64_t h) const {
+            size_t lo = 0, hi = size();
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (height(mid) < h)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+      private:
+        const std::vector<Output>& outputs;
+        std::vector<size_t> order;
+    };
+
+    // The positions of the (up to) `count` outputs that come first according to `cmp`, in that
+    // order, without sorting the rest of them.
+    template <typename Compare>
+    std::vector<size_t> first_outputs(
+            const std::vector<Output>& outputs, size_t count, Compare cmp) {
+        std::vector<size_t> heap;
+        if (count == 0)
+            return heap;
+        heap.reserve(count);
+        auto by_output = [&](size_t a, size_t b) { return cmp(outputs[a], outputs[b]); };
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            if (heap.size() < count) {
+                heap.push_back(i);
+                std::push_heap(heap.begin(), heap.end(), by_output);
+            } else if (by_output(i, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), by_output);
+                heap.back() = i;
+                std::push_heap(heap.begin(), heap.end(), by_output);
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), by_output);
+        return heap;
+    }
+
+    bool smaller(const Output& a, const Output& b) {
+        return a.amount < b.amount;
+    }
+    bool larger(const Output& a, const Output& b) {
+        return a.amount > b.amount;
+    }
+}  // namespace
+
+int64_t OutputSelector::fee_for(size_t input_count) const {
+    auto pos = fee_map.find(static_cast<int64_t>(input_count));
+    if (pos == fee_map.end())
+        throw std::runtime_error("Missing fee amount");
+    return pos->second;
+}
+
+size_t OutputSelector::max_inputs() const {
+    return fee_map.empty() ? 0 : std::max<int64_t>(fee_map.rbegin()->first, 0);
+}
+
 std::vector<Output> OutputSelector::operator()(
         const std::vector<Output>& available_outputs, int64_t amount) const {
     // Check that we actually have enough in the outputs to build this transaction. Fail early
@@ -9,84 +100,163 @@ std::vector<Output> OutputSelector::operator()(
             available_outputs.end(),
             int64_t{0},
             [](const int64_t& accumulator, const auto& x) { return accumulator + x.amount; });
-    int64_t fee = 0;
-    auto pos = fee_map.find(1);
-    if (pos == fee_map.end()) {
-        throw std::runtime_error("Missing fee amount");
-    } else {
-        fee = pos->second;
-    }
+    int64_t fee = fee_for(1);
     if (wallet_balance < amount + fee) {
         throw std::runtime_error("Insufficient Wallet Balance");
     }
 
-    // Prefer a single output if suitable
-    std::vector<Output> outputs_bigger_than_amount{};
-    std::copy_if(
-            available_outputs.begin(),
-            available_outputs.end(),
-            std::back_inserter(outputs_bigger_than_amount),
-            [amount, fee](const auto& x) { return static_cast<int64_t>(x.amount) > amount + fee; });
-
-    if (outputs_bigger_than_amount.size() > 0) {
-        std::random_device rd;
-        std::default_random_engine rng(rd());
-        auto start = outputs_bigger_than_amount.begin();
-        std::uniform_int_distribution<> dis(
-                0, std::distance(start, outputs_bigger_than_amount.end()) - 1);
-        std::advance(start, dis(rng));
-        std::vector<Output> single_output(start, start + 1);
-        return single_output;
+    std::random_device rd;
+    std::mt19937_64 rng(rd());
+
+    std::vector<size_t> chosen;
+    if (mode == SelectionMode::consolidate) {
+        chosen = select_consolidation(available_outputs, amount);
+    } else if (auto single = select_single(available_outputs, amount, rng)) {
+        // Prefer a single output if suitable
+        chosen.push_back(*single);
+    } else {
+        chosen = select_sampled(available_outputs, amount, rng);
     }
+    if (chosen.empty())
+        chosen = select_fewest(available_outputs, amount);
 
-    // Else select some random outputs according to gamma distribution
-    std::vector<double> scores;
-    scores.reserve(available_outputs.size());
-    std::random_device rd;
-    std::default_random_engine rng(rd());
-    auto output_cmp = [](const Output& lhs, const Output& rhs) {
-        return lhs.block_height < rhs.block_height;
+    std::vector<Output> selected;
+    selected.reserve(chosen.size());
+    for (size_t i : chosen)
+        selected.push_back(available_outputs[i]);
+    return selected;
+}
+
+// Picks uniformly among the outputs that can cover the amount and the fee on their own, if there
+// are any.
+std::optional<size_t> OutputSelector::select_single(
+        const std::vector<Output>& outputs, int64_t amount, std::mt19937_64& rng) const {
+    const int64_t needed = amount + fee_for(1);
+    auto big_enough = [needed](const Output& x) { return x.amount > needed; };
+
+    size_t count = std::count_if(outputs.begin(), outputs.end(), big_enough);
+    if (count == 0)
+        return std::nullopt;
+
+    size_t pick = std::uniform_int_distribution<size_t>{0, count - 1}(rng);
+    for (size_t i = 0; i < outputs.size(); ++i)
+        if (big_enough(outputs[i]) && pick-- == 0)
+            return i;
+    return std::nullopt;
+}
+
+// Draws target heights from a gamma distribution of ages back from the newest output, and takes
+// the unspent output nearest to each until the amount and the fee for that many inputs are
+// covered.  Recent outputs are favoured, but older ones still get spent.  Returns nothing if
+// MAX_SAMPLED_INPUTS draws aren't enough.
+std::vector<size_t> OutputSelector::select_sampled(
+        const std::vector<Output>& outputs, int64_t amount, std::mt19937_64& rng) const {
+    std::vector<size_t> chosen;
+    const height_index index{outputs};
+    const size_t limit = std::min({index.size(), MAX_SAMPLED_INPUTS, max_inputs()});
+    if (limit == 0)
+        return chosen;
+
+    const int64_t oldest = index.height(0);
+    const int64_t newest = index.height(index.size() - 1);
+    // Mean age is a quarter of the span of the wallet's outputs
+    std::gamma_distribution<double> age{2.0, std::max(1.0, (newest - oldest) / 8.0)};
+
+    // Positions in the index already taken; never more than MAX_SAMPLED_INPUTS of them
+    std::vector<size_t> taken;
+    auto is_taken = [&taken](size_t i) {
+        return std::find(taken.begin(), taken.end(), i) != taken.end();
     };
 
-    int64_t min_output_height =
-            std::min_element(available_outputs.begin(), available_outputs.end(), output_cmp)
-                    ->block_height;
-    int64_t max_output_height =
-            std::max_element(available_outputs.begin(), available_outputs.end(), output_cmp)
-                    ->block_height;
-    std::gamma_distribution<double> distribution(min_output_height, max_output_height);
-
-    // Build a distribution and apply a score to each element of available outputs depending
-    // on distance from the number chosen. Lower score is better.
-    const int nrolls = 1000;  // number of experiments
-    for (size_t i = 0; i < nrolls; ++i) {
-        double number = distribution(rng);
-        for (size_t j = 0; j < available_outputs.size(); ++j) {
-            scores[j] += std::abs(number - available_outputs[j].block_height);
-        }
+    int64_t sum = 0;
+    while (chosen.size() < limit) {
+        const int64_t target = std::max(oldest, newest - static_cast<int64_t>(age(rng)));
+
+        size_t up = index.lower_bound(target), down = up;
+        while (up < index.size() && is_taken(up))
+            ++up;
+        while (down > 0 && is_taken(down - 1))
+            --down;
+        size_t i;
+        if (up == index.size())
+            i = down - 1;
+        else if (down == 0)
+            i = up;
+        else
+            i = index.height(up) - target <= target - index.height(down - 1) ? up : down - 1;
+
+        taken.push_back(i);
+        chosen.push_back(index.at(i));
+        sum += outputs[chosen.back()].amount;
+        if (sum >= amount + fee_for(chosen.size()))
+            return chosen;
+    }
+    chosen.clear();
+    return chosen;
+}
+
+// The fee-aware fallback: the fewest inputs that cover the amount plus the fee for that many
+// inputs.  The largest outputs give the smallest count; the last of them is then swapped for the
+// smallest output that still covers what's left, so a big output isn't spent on a small remainder.
+std::vector<size_t> OutputSelector::select_fewest(
+        const std::vector<Output>& outputs, int64_t amount) const {
+    const size_t limit = std::min(outputs.size(), max_inputs());
+    auto chosen = first_outputs(outputs, limit, larger);
+
+    int64_t sum = 0;
+    size_t count = 0;
+    while (count < chosen.size()) {
+        sum += outputs[chosen[count++]].amount;
+        if (sum >= amount + fee_for(count))
+            break;
+    }
+    if (count == 0 || sum < amount + fee_for(count))
+        throw std::runtime_error(
+                limit == outputs.size() ? "Insufficient Wallet Balance" : "Missing fee amount");
+    chosen.resize(count);
+
+    // Anything smaller than the last pick isn't among the others, which are all at least as big
+    const int64_t remainder = amount + fee_for(count) - (sum - outputs[chosen.back()].amount);
+    for (size_t i = 0; i < outputs.size(); ++i)
+        if (outputs[i].amount >= remainder && outputs[i].amount < outputs[chosen.back()].amount)
+            chosen.back() = i;
+    return chosen;
+}
+
+// Spends the smallest outputs, as many as there are fees for, skipping any that aren't worth more
+// than the fee of an extra input.  While they don't cover the amount the smallest of them is
+// swapped for the largest output not yet chosen.  Returns nothing if that runs out.
+std::vector<size_t> OutputSelector::select_consolidation(
+        const std::vector<Output>& outputs, int64_t amount) const {
+    const size_t limit = std::min(outputs.size(), max_inputs());
+
+    const int64_t input_fee = limit > 1 ? fee_for(2) - fee_for(1) : 0;
+
+    std::vector<size_t> chosen;
+    chosen.reserve(limit);
+    int64_t sum = 0;
+    for (size_t i : first_outputs(outputs, limit, smaller)) {
+        if (outputs[i].amount <= input_fee)
+            continue;
+        chosen.push_back(i);
+        sum += outputs[i].amount;
     }
 
-    // Build a list of indexes based on score
-    std::vector<int> indices(available_outputs.size());
-    std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(), [&](int A, int B) -> bool {
-        return scores[A] < scores[B];
-    });
-
-    // Iterate through the list until we have sufficient return value
-    std::vector<Output> multiple_outputs{};
-    int i = 0;
-    while (amount + fee > 0) {
-        auto pos = fee_map.find(i + 1);
-        if (pos == fee_map.end()) {
-            throw std::runtime_error("Missing fee amount");
-        } else {
-            fee = pos->second;
+    auto largest = first_outputs(outputs, limit, larger);
+    auto next = largest.begin();
+    while (chosen.empty() || sum < amount + fee_for(chosen.size())) {
+        while (next != largest.end() &&
+               std::find(chosen.begin(), chosen.end(), *next) != chosen.end())
+            ++next;
+        if (next == largest.end())
+            return {};
+        if (chosen.size() == limit) {
+            sum -= outputs[chosen.front()].amount;
+            chosen.erase(chosen.begin());
         }
-        multiple_outputs.push_back(available_outputs[indices[i]]);
-        amount = amount - available_outputs[indices[i]].amount;
-        i++;
+        chosen.push_back(*next);
+        sum += outputs[*next].amount;
     }
-    return multiple_outputs;
+    return chosen;
 }
 }  // namespace wallet
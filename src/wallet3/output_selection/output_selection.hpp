@@ -1,13 +1,29 @@
 #pragma once
 
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <random>
 #include <vector>
 
 #include "../output.hpp"
 
 namespace wallet {
+
+enum class SelectionMode {
+    // Prefer a single output big enough to cover the amount, otherwise sample outputs by age
+    spend,
+    // Spend as many of the smallest outputs as the fees allow, to merge them into the change
+    consolidate,
+};
+
 // OutputSelector will choose some a subset of outputs from the provided list of outputs according
 // to the output selection algorithm. The sum of the amounts in the returned outputs will be
 // greater than the amount passed as the second parameter.
+//
+// The outputs are looked at through an index ordered by block height, which is free when they are
+// already in that order (as WalletDB::available_outputs returns them), so that the sampled
+// selection only costs a binary search per chosen output.  Only the chosen outputs are copied.
 
 class OutputSelector {
   public:
@@ -18,10 +34,29 @@ class OutputSelector {
 
     void clear_fees() { fee_map.clear(); };
 
+    void set_mode(SelectionMode m) { mode = m; };
+
+    // The most inputs the sampled selection picks before giving up on it and falling back to the
+    // fewest inputs that can cover the amount.
+    static constexpr size_t MAX_SAMPLED_INPUTS = 16;
+
   private:
+    int64_t fee_for(size_t input_count) const;
+    size_t max_inputs() const;
+
+    std::optional<size_t> select_single(
+            const std::vector<Output>& outputs, int64_t amount, std::mt19937_64& rng) const;
+    std::vector<size_t> select_sampled(
+            const std::vector<Output>& outputs, int64_t amount, std::mt19937_64& rng) const;
+    std::vector<size_t> select_fewest(const std::vector<Output>& outputs, int64_t amount) const;
+    std::vector<size_t> select_consolidation(
+            const std::vector<Output>& outputs, int64_t amount) const;
+
     // Keeps track of the fees that need to be paid on top of the amount passed in
     // key represents the number of outputs and value represents the fee that needs
     // to be included if that many outputs are chosen
     std::map<int64_t, int64_t> fee_map;
+
+    SelectionMode mode = SelectionMode::spend;
 };
 }  // namespace wallet
@@ -121,21 +121,119 @@ void parse_request(SIGN_TRANSFER& req, rpc_input in) {}
 
 void parse_request(SUBMIT_TRANSFER& req, rpc_input in) {}
 
-void parse_request(SWEEP_DUST& req, rpc_input in) {}
+void parse_request(SWEEP_DUST& req, rpc_input in) {
+    get_values(
+            in,
+            "do_not_relay",
+            req.request.do_not_relay,
+            "get_tx_hex",
+            req.request.get_tx_hex,
+            "get_tx_keys",
+            req.request.get_tx_keys,
+            "get_tx_metadata",
+            req.request.get_tx_metadata);
+}
 
-void parse_request(SWEEP_ALL& req, rpc_input in) {}
+void parse_request(SWEEP_ALL& req, rpc_input in) {
+    auto& r = req.request;
+    get_values(
+            in,
+            "account_index",
+            r.account_index,
+            "address",
+            required{r.address},
+            "below_amount",
+            r.below_amount,
+            "do_not_relay",
+            r.do_not_relay,
+            "get_tx_hex",
+            r.get_tx_hex,
+            "get_tx_keys",
+            r.get_tx_keys,
+            "get_tx_metadata",
+            r.get_tx_metadata,
+            "outputs",
+            r.outputs,
+            "payment_id",
+            r.payment_id,
+            "priority",
+            r.priority,
+            "subaddr_indices",
+            r.subaddr_indices,
+            "subaddr_indices_all",
+            r.subaddr_indices_all,
+            "unlock_time",
+            r.unlock_time);
+}
 
-void parse_request(SWEEP_SINGLE& req, rpc_input in) {}
+void parse_request(SWEEP_SINGLE& req, rpc_input in) {
+    auto& r = req.request;
+    get_values(
+            in,
+            "address",
+            required{r.address},
+            "do_not_relay",
+            r.do_not_relay,
+            "get_tx_hex",
+            r.get_tx_hex,
+            "get_tx_key",
+            r.get_tx_key,
+            "get_tx_metadata",
+            r.get_tx_metadata,
+            "key_image",
+            required{r.key_image},
+            "outputs",
+            r.outputs,
+            "payment_id",
+            r.payment_id,
+            "priority",
+            r.priority,
+            "unlock_time",
+            r.unlock_time);
+}
 
 void parse_request(RELAY_TX& req, rpc_input in) {}
 
 void parse_request(STORE& req, rpc_input in) {}
 
-void parse_request(GET_PAYMENTS& req, rpc_input in) {}
+void parse_request(GET_PAYMENTS& req, rpc_input in) {
+    get_values(
+            in,
+            "after",
+            req.request.after,
+            "limit",
+            req.request.limit,
+            "payment_id",
+            required{req.request.payment_id});
+}
 
-void parse_request(GET_BULK_PAYMENTS& req, rpc_input in) {}
+void parse_request(GET_BULK_PAYMENTS& req, rpc_input in) {
+    get_values(
+            in,
+            "after",
+            req.request.after,
+            "limit",
+            req.request.limit,
+            "min_block_height",
+            req.request.min_block_height,
+            "payment_ids",
+            required{req.request.payment_ids});
+}
 
-void parse_request(INCOMING_TRANSFERS& req, rpc_input in) {}
+void parse_request(INCOMING_TRANSFERS& req, rpc_input in) {
+    get_values(
+            in,
+            "account_index",
+            req.request.account_index,
+            "after",
+            req.request.after,
+            "limit",
+            req.request.limit,
+            "subaddr_indices",
+            req.request.subaddr_indices,
+            "transfer_type",
+            required{req.request.transfer_type});
+}
 
 void parse_request(EXPORT_VIEW_KEY& req, rpc_input in) {}
 
@@ -177,11 +275,52 @@ void parse_request(GET_RESERVE_PROOF& req, rpc_input in) {}
 
 void parse_request(CHECK_RESERVE_PROOF& req, rpc_input in) {}
 
-void parse_request(GET_TRANSFERS& req, rpc_input in) {}
+void parse_request(GET_TRANSFERS& req, rpc_input in) {
+    auto& r = req.request;
+    get_values(
+            in,
+            "account_index",
+            r.account_index,
+            "after",
+            r.after,
+            "all_accounts",
+            r.all_accounts,
+            "coinbase",
+            r.coinbase,
+            "failed",
+            r.failed,
+            "filter_by_height",
+            r.filter_by_height,
+            "in",
+            r.in,
+            "limit",
+            r.limit,
+            "max_height",
+            r.max_height,
+            "min_height",
+            r.min_height,
+            "out",
+            r.out,
+            "pending",
+            r.pending,
+            "pool",
+            r.pool,
+            "stake",
+            r.stake,
+            "subaddr_indices",
+            r.subaddr_indices);
+}
 
 void parse_request(GET_TRANSFERS_CSV& req, rpc_input in) {}
 
-void parse_request(GET_TRANSFER_BY_TXID& req, rpc_input in) {}
+void parse_request(GET_TRANSFER_BY_TXID& req, rpc_input in) {
+    get_values(
+            in,
+            "account_index",
+            req.request.account_index,
+            "txid",
+            required{req.request.txid});
+}
 
 void parse_request(SIGN& req, rpc_input in) {}
 
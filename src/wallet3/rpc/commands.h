@@ -691,7 +691,7 @@ struct SWEEP_ALL : RESTRICTED {
     struct REQUEST {
         std::string address;     // Destination public address.
         uint32_t account_index;  // Sweep transactions from this account.
-        std::set<uint32_t>
+        std::vector<uint32_t>
                 subaddr_indices;   // (Optional) Sweep from this set of subaddresses in the account.
         bool subaddr_indices_all;  //
         uint32_t priority;         // Set a priority for the transaction. Accepted values are: 1 for
@@ -831,16 +831,23 @@ struct payment_details {
 /// Inputs:
 ///
 /// - \p payment_id -- Payment ID used to find the payments (16 characters hex).
+/// - \p limit -- (Optional) The most payments to return at once. (defaults to 1000, at most 10000)
+/// - \p after -- (Optional) Return the payments after this, the `next` of the previous page.
 ///
 /// Outputs:
 ///
 /// - \p payments -- List of payment details:
 ///   - \ref payment_details
+/// - \p next -- Where the next page starts, if this one is full: pass it as `after` to get more.
 struct GET_PAYMENTS : RPC_COMMAND {
     static constexpr auto names() { return NAMES("get_payments"); }
 
     struct REQUEST {
         std::string payment_id;  // Payment ID used to find the payments (16 characters hex).
+        uint32_t limit;          // (Optional) The most payments to return at once. (defaults to
+                                 // 1000, at most 10000)
+        std::string after;       // (Optional) Return the payments after this, the `next` of the
+                                 // previous page.
     } request;
 };
 
@@ -855,11 +862,14 @@ struct GET_PAYMENTS : RPC_COMMAND {
 ///
 /// - \p payment_ids -- Payment IDs used to find the payments (16 characters hex).
 /// - \p min_block_height -- The block height at which to start looking for payments.
+/// - \p limit -- (Optional) The most payments to return at once. (defaults to 1000, at most 10000)
+/// - \p after -- (Optional) Return the payments after this, the `next` of the previous page.
 ///
 /// Outputs:
 ///
 /// - \p payments -- List of payment details:
 ///   - \ref payment_details
+/// - \p next -- Where the next page starts, if this one is full: pass it as `after` to get more.
 struct GET_BULK_PAYMENTS : RPC_COMMAND {
     static constexpr auto names() { return NAMES("get_bulk_payments"); }
 
@@ -867,6 +877,10 @@ struct GET_BULK_PAYMENTS : RPC_COMMAND {
         std::vector<std::string>
                 payment_ids;        // Payment IDs used to find the payments (16 characters hex).
         uint64_t min_block_height;  // The block height at which to start looking for payments.
+        uint32_t limit;             // (Optional) The most payments to return at once. (defaults to
+                                    // 1000, at most 10000)
+        std::string after;          // (Optional) Return the payments after this, the `next` of
+                                    // the previous page.
     } request;
 };
 
@@ -908,11 +922,14 @@ struct transfer_details {
 /// spent, OR "unavailable": only transfers which are already spent.
 /// - \p account_index -- (Optional) Return transfers for this account. (defaults to 0)
 /// - \p subaddr_indices -- (Optional) Return transfers sent to these subaddresses.
+/// - \p limit -- (Optional) The most transfers to return at once. (defaults to 1000, at most 10000)
+/// - \p after -- (Optional) Return the transfers after this, the `next` of the previous page.
 ///
 /// Outputs:
 ///
 /// - \p transfers -- List of information of the transfers details.
 ///   - \ref transfer_details
+/// - \p next -- Where the next page starts, if this one is full: pass it as `after` to get more.
 struct INCOMING_TRANSFERS : RPC_COMMAND {
     static constexpr auto names() { return NAMES("incoming_transfers"); }
 
@@ -921,8 +938,12 @@ struct INCOMING_TRANSFERS : RPC_COMMAND {
                                     // are not yet spent, OR "unavailable": only transfers which are
                                     // already spent.
         uint32_t account_index;     // (Optional) Return transfers for this account. (defaults to 0)
-        std::set<uint32_t>
+        std::vector<uint32_t>
                 subaddr_indices;  // (Optional) Return transfers sent to these subaddresses.
+        uint32_t limit;     // (Optional) The most transfers to return at once. (defaults to
+                            // 1000, at most 10000)
+        std::string after;  // (Optional) Return the transfers after this, the `next` of the
+                            // previous page.
     } request;
 };
 
@@ -1323,6 +1344,9 @@ struct CHECK_RESERVE_PROOF : RPC_COMMAND {
 /// to 0)
 /// - \p all_accounts -- If true, return transfers for all accounts, subaddr_indices and
 /// account_index are ignored
+/// - \p limit -- (Optional) The most transfers, in and out together, to return at once. (defaults
+/// to 1000, at most 10000)
+/// - \p after -- (Optional) Return the transfers after this, the `next` of the previous page.
 ///
 /// Outputs:
 ///
@@ -1336,6 +1360,7 @@ struct CHECK_RESERVE_PROOF : RPC_COMMAND {
 ///   - \ref transfer_view
 /// - \p pool --
 ///   - \ref transfer_view
+/// - \p next -- Where the next page starts, if this one is full: pass it as `after` to get more.
 struct GET_TRANSFERS : RESTRICTED {
     static constexpr auto names() { return NAMES("get_transfers"); }
 
@@ -1355,10 +1380,14 @@ struct GET_TRANSFERS : RESTRICTED {
                               // by height is enabled (defaults to max block height).
         uint32_t account_index;  // (Optional) Index of the account to query for transfers.
                                  // (defaults to 0)
-        std::set<uint32_t> subaddr_indices;  // (Optional) List of subaddress indices to query for
-                                             // transfers. (defaults to 0)
+        std::vector<uint32_t> subaddr_indices;  // (Optional) List of subaddress indices to query
+                                                // for transfers. (defaults to 0)
         bool all_accounts;  // If true, return transfers for all accounts, subaddr_indices and
                             // account_index are ignored
+        uint32_t limit;     // (Optional) The most transfers, in and out together, to return at
+                            // once. (defaults to 1000, at most 10000)
+        std::string after;  // (Optional) Return the transfers after this, the `next` of the
+                            // previous page.
     } request;
 };
 
@@ -1411,8 +1440,9 @@ struct GET_TRANSFER_BY_TXID : RESTRICTED {
     static constexpr auto names() { return NAMES("get_transfer_by_txid"); }
 
     struct REQUEST {
-        std::string txid;        // Transaction ID used to find the transfer.
-        uint32_t account_index;  // (Optional) Index of the account to query for the transfer.
+        std::string txid;  // Transaction ID used to find the transfer.
+        std::optional<uint32_t>
+                account_index;  // (Optional) Index of the account to query for the transfer.
     } request;
 };
 
@@ -3,11 +3,15 @@
 #include <common/hex.h>
 #include <cryptonote_core/cryptonote_tx_utils.h>
 #include <oxenc/base64.h>
+#include <oxenc/hex.h>
 #include <version.h>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <wallet3/db/walletdb.hpp>
+#include <wallet3/transaction_constructor.hpp>
 #include <wallet3/wallet.hpp>
 
 #include "command_parser.h"
@@ -50,6 +54,108 @@ namespace {
         return regs;
     }
 
+    constexpr uint32_t DEFAULT_PAGE_SIZE = 1000;
+    constexpr uint32_t MAX_PAGE_SIZE = 10000;
+
+    // A query for a page of received outputs or transfers.  Pages are keyed by the (block height,
+    // id) of the last entry, so each one costs the same however far into the history it is; the
+    // `next` of a full page, which the caller passes back as `after`, is that key.
+    TransferQuery page_query(uint32_t limit, const std::string& after) {
+        TransferQuery query;
+        query.limit = limit == 0 ? DEFAULT_PAGE_SIZE : std::min(limit, MAX_PAGE_SIZE);
+        if (!after.empty()) {
+            auto colon = after.find(':');
+            if (colon == std::string::npos ||
+                !tools::parse_int(
+                        std::string_view{after}.substr(0, colon), query.after.block_height) ||
+                !tools::parse_int(std::string_view{after}.substr(colon + 1), query.after.id))
+                throw rpc_error(500, "Invalid 'after': " + after);
+        }
+        return query;
+    }
+
+    template <typename Entry>
+    void set_next_page(
+            nlohmann::json& response, const TransferQuery& query, const std::vector<Entry>& page) {
+        if (page.size() == query.limit)
+            response["next"] = "{}:{}"_format(page.back().block_height, page.back().id);
+    }
+
+    nlohmann::json subaddress_json(const cryptonote::subaddress_index& index) {
+        return {{"major", index.major}, {"minor", index.minor}};
+    }
+
+    // Payments to us, as listed by get_payments and get_bulk_payments
+    nlohmann::json payments_json(WalletDB& db, const std::vector<Transfer>& transfers) {
+        const auto height = db.last_scan_height();
+        std::unordered_map<cryptonote::subaddress_index, std::string> addresses;
+        auto payments = nlohmann::json::array();
+        for (const auto& t : transfers) {
+            auto& address = addresses[t.subaddress];
+            if (address.empty())
+                address = db.get_address(t.subaddress.major, t.subaddress.minor);
+            payments.push_back(
+                    {{"payment_id", t.payment_id},
+                     {"tx_hash", t.tx_hash},
+                     {"amount", t.amount},
+                     {"block_height", t.block_height},
+                     {"unlock_time", t.unlock_time},
+                     {"locked", t.block_height + t.unlock_time > height},
+                     {"subaddr_index", subaddress_json(t.subaddress)},
+                     {"address", address}});
+        }
+        return payments;
+    }
+
+    nlohmann::json transfer_json(const Transfer& t, int64_t height) {
+        return {{"txid", t.tx_hash},
+                {"payment_id", t.payment_id},
+                {"height", t.block_height},
+                {"amount", t.amount},
+                {"type", t.outgoing ? "out" : "in"},
+                {"unlock_time", t.unlock_time},
+                {"locked", t.block_height + t.unlock_time > height},
+                {"subaddr_index", subaddress_json(t.subaddress)},
+                {"confirmations", std::max<int64_t>(0, height - t.block_height + 1)}};
+    }
+
+    // Checks and normalizes a (short, 16 hex digit) payment ID
+    std::string payment_id_hex(const std::string& payment_id) {
+        crypto::hash8 id;
+        if (!tools::hex_to_type(payment_id, id))
+            throw rpc_error(500, "Invalid payment ID: " + payment_id);
+        return tools::type_to_hex(id);
+    }
+
+    // A destination (with no amount yet) for an address given in a request
+    cryptonote::tx_destination_entry destination(
+            cryptonote::network_type nettype, const std::string& address) {
+        cryptonote::address_parse_info addr_info;
+        if (not cryptonote::get_account_address_from_str(addr_info, nettype, address))
+            throw rpc_error(500, "Invalid destination: " + address);
+        cryptonote::tx_destination_entry entry;
+        entry.original = address;
+        entry.amount = 0;
+        entry.addr = addr_info.address;
+        entry.is_subaddress = addr_info.is_subaddress;
+        entry.is_integrated = addr_info.has_payment_id;
+        return entry;
+    }
+
+    // The sweeps always build a single-output blink transaction with no lock or payment ID, so
+    // refuse requests asking for anything else rather than quietly ignoring it.
+    template <typename Request>
+    void check_sweep_options(const Request& req) {
+        if (req.priority == 1)
+            throw rpc_error(500, "Unimportant priority is not supported for sweeps yet");
+        if (req.outputs > 1)
+            throw rpc_error(500, "Sweeping to more than one output is not supported yet");
+        if (req.unlock_time != 0)
+            throw rpc_error(500, "Unlock time is not supported for sweeps yet");
+        if (!req.payment_id.empty())
+            throw rpc_error(500, "Payment IDs are not supported for sweeps yet");
+    }
+
 }  // anonymous namespace
 
 void RequestHandler::set_wallet(std::weak_ptr<wallet::Wallet> ptr) {
@@ -71,6 +177,49 @@ std::string RequestHandler::submit_transaction(wallet::PendingTransaction& ptx)
     return response;
 }
 
+void RequestHandler::submit_sweep(
+        std::vector<wallet::PendingTransaction>& ptxs,
+        bool relay,
+        bool get_tx_hex,
+        nlohmann::json& response) {
+    auto w = wallet.lock();
+    if (!w)
+        return;
+
+    TransactionConstructor::sign_transactions(ptxs, *w->keys);
+
+    std::vector<std::future<std::string>> submitted;
+    if (relay)
+        for (const auto& ptx : ptxs)
+            submitted.push_back(w->daemon_comms->submit_transaction(ptx.tx, false));
+
+    auto& hashes = response["tx_hash_list"] = nlohmann::json::array();
+    auto& amounts = response["amount_list"] = nlohmann::json::array();
+    auto& fees = response["fee_list"] = nlohmann::json::array();
+    for (const auto& ptx : ptxs) {
+        hashes.push_back(tools::type_to_hex(cryptonote::get_transaction_hash(ptx.tx)));
+        amounts.push_back(ptx.recipients.front().amount);
+        fees.push_back(ptx.fee);
+    }
+    if (get_tx_hex) {
+        auto& blobs = response["tx_blob_list"] = nlohmann::json::array();
+        for (const auto& ptx : ptxs)
+            blobs.push_back(oxenc::to_hex(cryptonote::tx_to_blob(ptx.tx)));
+    }
+
+    for (size_t i = 0; i < submitted.size(); ++i) {
+        if (submitted[i].wait_for(5s) != std::future_status::ready)
+            throw rpc_error(500, "request to daemon timed out");
+        try {
+            submitted[i].get();
+        } catch (const std::exception& e) {
+            throw rpc_error(
+                    500,
+                    "Sweep transaction {} of {} failed: {}"_format(i + 1, ptxs.size(), e.what()));
+        }
+    }
+}
+
 const std::unordered_map<std::string, std::shared_ptr<const rpc_command>> rpc_commands =
         register_rpc_commands(wallet_rpc_types{});
 
@@ -190,21 +339,134 @@ void RequestHandler::invoke(SIGN_TRANSFER& command, rpc_context context) {}
 
 void RequestHandler::invoke(SUBMIT_TRANSFER& command, rpc_context context) {}
 
-void RequestHandler::invoke(SWEEP_DUST& command, rpc_context context) {}
+// TODO: the sweeps don't return tx keys or metadata yet, and reject a non-default priority, unlock
+// time, payment ID or number of outputs (see check_sweep_options)
+void RequestHandler::invoke(SWEEP_DUST& command, rpc_context context) {
+    oxen::log::info(logcat, "RPC Handler received SWEEP_DUST command");
+    if (auto w = wallet.lock()) {
+        auto outputs = w->db->unlocked_outputs(
+                std::nullopt, {}, w->tx_constructor->dust_threshold());
+        if (outputs.empty())
+            throw rpc_error(500, "No unlocked dust outputs to sweep");
+
+        auto main_address = destination(w->nettype, w->db->get_address(0, 0));
+        auto ptxs = w->tx_constructor->create_sweep_transactions(
+                outputs, main_address, main_address);
+        submit_sweep(
+                ptxs, !command.request.do_not_relay, command.request.get_tx_hex, command.response);
+    }
+}
 
-void RequestHandler::invoke(SWEEP_ALL& command, rpc_context context) {}
+void RequestHandler::invoke(SWEEP_ALL& command, rpc_context context) {
+    oxen::log::info(logcat, "RPC Handler received SWEEP_ALL command");
+    const auto& req = command.request;
+    check_sweep_options(req);
+    if (auto w = wallet.lock()) {
+        std::optional<int64_t> below_amount;
+        if (req.below_amount > 0)
+            below_amount = req.below_amount;
+        // No subaddresses given means all of them
+        auto outputs = w->db->unlocked_outputs(
+                req.account_index,
+                req.subaddr_indices_all ? std::vector<uint32_t>{} : req.subaddr_indices,
+                below_amount);
+        if (outputs.empty())
+            throw rpc_error(500, "No unlocked outputs to sweep");
+
+        auto ptxs = w->tx_constructor->create_sweep_transactions(
+                outputs,
+                destination(w->nettype, req.address),
+                destination(w->nettype, w->db->get_address(req.account_index, 0)));
+        submit_sweep(ptxs, !req.do_not_relay, req.get_tx_hex, command.response);
+    }
+}
 
-void RequestHandler::invoke(SWEEP_SINGLE& command, rpc_context context) {}
+void RequestHandler::invoke(SWEEP_SINGLE& command, rpc_context context) {
+    oxen::log::info(logcat, "RPC Handler received SWEEP_SINGLE command");
+    const auto& req = command.request;
+    check_sweep_options(req);
+    if (auto w = wallet.lock()) {
+        crypto::key_image key_image;
+        if (!tools::hex_to_type(req.key_image, key_image))
+            throw rpc_error(500, "Invalid key image: " + req.key_image);
+        auto output = w->db->unlocked_output_by_key_image(tools::type_to_hex(key_image));
+        if (!output)
+            throw rpc_error(500, "No unlocked output with key image " + req.key_image);
+
+        auto ptxs = w->tx_constructor->create_sweep_transactions(
+                {*output},
+                destination(w->nettype, req.address),
+                destination(
+                        w->nettype,
+                        w->db->get_address(
+                                output->subaddress_index.major, output->subaddress_index.minor)),
+                1);
+        nlohmann::json sweep;
+        submit_sweep(ptxs, !req.do_not_relay, req.get_tx_hex, sweep);
+        command.response["tx_hash"] = sweep["tx_hash_list"][0];
+        command.response["amount"] = sweep["amount_list"][0];
+        command.response["fee"] = sweep["fee_list"][0];
+        if (req.get_tx_hex)
+            command.response["tx_blob"] = sweep["tx_blob_list"][0];
+    }
+}
 
 void RequestHandler::invoke(RELAY_TX& command, rpc_context context) {}
 
 void RequestHandler::invoke(STORE& command, rpc_context context) {}
 
-void RequestHandler::invoke(GET_PAYMENTS& command, rpc_context context) {}
+void RequestHandler::invoke(GET_PAYMENTS& command, rpc_context context) {
+    if (auto w = wallet.lock()) {
+        auto query = page_query(command.request.limit, command.request.after);
+        query.payment_ids.push_back(payment_id_hex(command.request.payment_id));
+        auto page = w->db->transfers(query, true, false);
+        command.response["payments"] = payments_json(*w->db, page);
+        set_next_page(command.response, query, page);
+    }
+}
 
-void RequestHandler::invoke(GET_BULK_PAYMENTS& command, rpc_context context) {}
+void RequestHandler::invoke(GET_BULK_PAYMENTS& command, rpc_context context) {
+    if (auto w = wallet.lock()) {
+        auto query = page_query(command.request.limit, command.request.after);
+        query.min_height = command.request.min_block_height;
+        for (const auto& payment_id : command.request.payment_ids)
+            query.payment_ids.push_back(payment_id_hex(payment_id));
+        auto page = w->db->transfers(query, true, false);
+        command.response["payments"] = payments_json(*w->db, page);
+        set_next_page(command.response, query, page);
+    }
+}
 
-void RequestHandler::invoke(INCOMING_TRANSFERS& command, rpc_context context) {}
+void RequestHandler::invoke(INCOMING_TRANSFERS& command, rpc_context context) {
+    if (auto w = wallet.lock()) {
+        auto& req = command.request;
+        auto query = page_query(req.limit, req.after);
+        if (req.transfer_type == "available")
+            query.spent = false;
+        else if (req.transfer_type == "unavailable")
+            query.spent = true;
+        else if (req.transfer_type != "all")
+            throw rpc_error(500, "Invalid transfer_type: " + req.transfer_type);
+        query.account = req.account_index;
+        query.subaddresses = req.subaddr_indices;
+
+        const auto height = w->db->last_scan_height();
+        auto page = w->db->received_outputs(query);
+        auto& transfers = (command.response["transfers"] = nlohmann::json::array());
+        for (const auto& o : page)
+            transfers.push_back(
+                    {{"amount", o.amount},
+                     {"spent", o.spent_height != 0},
+                     {"global_index", o.global_index},
+                     {"tx_hash", o.tx_hash},
+                     {"subaddr_index", subaddress_json(o.subaddress)},
+                     {"key_image", o.key_image},
+                     {"block_height", o.block_height},
+                     {"frozen", false},
+                     {"unlocked", o.block_height + o.unlock_time <= height}});
+        set_next_page(command.response, query, page);
+    }
+}
 
 void RequestHandler::invoke(EXPORT_VIEW_KEY& command, rpc_context context) {
     if (auto w = wallet.lock()) {
@@ -263,11 +525,56 @@ void RequestHandler::invoke(GET_RESERVE_PROOF& command, rpc_context context) {}
 
 void RequestHandler::invoke(CHECK_RESERVE_PROOF& command, rpc_context context) {}
 
-void RequestHandler::invoke(GET_TRANSFERS& command, rpc_context context) {}
+void RequestHandler::invoke(GET_TRANSFERS& command, rpc_context context) {
+    if (auto w = wallet.lock()) {
+        auto& req = command.request;
+        auto query = page_query(req.limit, req.after);
+        if (req.filter_by_height) {
+            query.min_height = req.min_height;
+            if (req.max_height > 0 &&
+                req.max_height < static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+                query.max_height = req.max_height;
+        }
+        if (!req.all_accounts) {
+            query.account = req.account_index;
+            query.subaddresses = req.subaddr_indices;
+        }
+
+        // Only confirmed transfers are stored; pending, failed and pool transfers aren't tracked
+        const bool all = !(req.in || req.out || req.stake || req.pending || req.failed ||
+                           req.pool || req.coinbase);
+        const bool in = all || req.in || req.coinbase;
+        const bool out = all || req.out || req.stake;
+
+        const auto height = w->db->last_scan_height();
+        auto page = w->db->transfers(query, in, out);
+        auto& in_json = (command.response["in"] = nlohmann::json::array());
+        auto& out_json = (command.response["out"] = nlohmann::json::array());
+        for (const auto& t : page)
+            (t.outgoing ? out_json : in_json).push_back(transfer_json(t, height));
+        set_next_page(command.response, query, page);
+    }
+}
 
 void RequestHandler::invoke(GET_TRANSFERS_CSV& command, rpc_context context) {}
 
-void RequestHandler::invoke(GET_TRANSFER_BY_TXID& command, rpc_context context) {}
+void RequestHandler::invoke(GET_TRANSFER_BY_TXID& command, rpc_context context) {
+    if (auto w = wallet.lock()) {
+        crypto::hash txid;
+        if (!tools::hex_to_type(command.request.txid, txid))
+            throw rpc_error(500, "Invalid txid: " + command.request.txid);
+
+        const auto height = w->db->last_scan_height();
+        auto& transfers = (command.response["transfers"] = nlohmann::json::array());
+        for (const auto& t : w->db->transfers_by_hash(tools::type_to_hex(txid)))
+            if (!command.request.account_index ||
+                t.subaddress.major == *command.request.account_index)
+                transfers.push_back(transfer_json(t, height));
+        if (transfers.empty())
+            throw rpc_error(500, "Transaction not found: " + command.request.txid);
+        command.response["transfer"] = transfers.front();
+    }
+}
 
 void RequestHandler::invoke(SIGN& command, rpc_context context) {}
 
@@ -43,6 +43,14 @@ class RequestHandler {
 
     std::string submit_transaction(wallet::PendingTransaction& ptx);
 
+    // Signs the transactions of a sweep and, if `relay`, submits them all to the daemon, adding
+    // their hashes, amounts and fees (and blobs, if `get_tx_hex`) to `response`.
+    void submit_sweep(
+            std::vector<wallet::PendingTransaction>& ptxs,
+            bool relay,
+            bool get_tx_hex,
+            nlohmann::json& response);
+
     void invoke(GET_BALANCE& command, rpc_context context);
     void invoke(GET_ADDRESS& command, rpc_context context);
     void invoke(GET_ADDRESS_INDEX& command, rpc_context context);
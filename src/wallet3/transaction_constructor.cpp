@@ -1,8 +1,11 @@
 #include "transaction_constructor.hpp"
 
+#include <common/threadpool.h>
 #include <cryptonote_basic/hardfork.h>
 #include <oxenc/base64.h>
 
+#include <exception>
+
 #include "db/walletdb.hpp"
 #include "decoy.hpp"
 #include "decoy_selection/decoy_selection.hpp"
@@ -29,6 +32,91 @@ PendingTransaction TransactionConstructor::create_transaction(
     return new_tx;
 }
 
+std::vector<PendingTransaction> TransactionConstructor::create_sweep_transactions(
+        const std::vector<Output>& outputs,
+        const cryptonote::tx_destination_entry& recipient,
+        const cryptonote::tx_destination_entry& change_recipient,
+        size_t max_inputs) {
+    PendingTransaction sweep_tx(std::vector<cryptonote::tx_destination_entry>{recipient});
+    auto [hf, hf_uint8] =
+            cryptonote::get_ideal_block_version(db->network_type(), db->scan_target_height());
+    sweep_tx.tx.version = cryptonote::transaction::get_max_version_for_hf(hf);
+    sweep_tx.tx.type = cryptonote::txtype::standard;
+    sweep_tx.fee_per_byte = fee_per_byte;
+    sweep_tx.fee_per_output = fee_per_output;
+    sweep_tx.change = change_recipient;
+    sweep_tx.change.amount = 0;
+
+    const int64_t input_fee = sweep_tx.get_fee(2) - sweep_tx.get_fee(1);
+    std::vector<Output> inputs;
+    inputs.reserve(outputs.size());
+    for (const auto& output : outputs)
+        if (output.amount > input_fee)
+            inputs.push_back(output);
+    if (inputs.empty())
+        throw std::runtime_error("No outputs worth sweeping");
+
+    size_t tx_inputs = 1;
+    while ((max_inputs == 0 || tx_inputs < max_inputs) &&
+           sweep_tx.get_tx_weight(tx_inputs + 1) <= SWEEP_TX_WEIGHT_LIMIT)
+        ++tx_inputs;
+
+    // Spread the inputs evenly, so that the last transaction isn't left with a handful of them
+    const size_t tx_count = (inputs.size() + tx_inputs - 1) / tx_inputs;
+    std::vector<PendingTransaction> ptxs(tx_count, sweep_tx);
+    auto next = inputs.begin();
+    for (size_t i = 0; i < tx_count; ++i) {
+        auto& ptx = ptxs[i];
+        const size_t count = inputs.size() / tx_count + (i < inputs.size() % tx_count ? 1 : 0);
+        ptx.chosen_outputs.assign(next, next + count);
+        next += count;
+
+        ptx.fee = ptx.get_fee();
+        const int64_t amount = ptx.sum_inputs() - ptx.fee;
+        if (amount <= 0)
+            throw std::runtime_error("Outputs to sweep do not cover the transaction fee");
+        ptx.recipients.front().amount = amount;
+        if (!ptx.finalise())
+            throw std::runtime_error("Sweep transaction amounts do not balance");
+    }
+
+    select_and_fetch_decoys(ptxs);
+    return ptxs;
+}
+
+int64_t TransactionConstructor::dust_threshold() const {
+    PendingTransaction single_input(std::vector<cryptonote::tx_destination_entry>(1));
+    single_input.fee_per_byte = fee_per_byte;
+    single_input.fee_per_output = fee_per_output;
+    return single_input.get_fee(1);
+}
+
+void TransactionConstructor::sign_transactions(
+        std::vector<PendingTransaction>& ptxs, Keyring& keys) {
+    if (ptxs.size() == 1) {
+        keys.sign_transaction(ptxs.front());
+        return;
+    }
+
+    auto& tpool = tools::threadpool::getInstance();
+    tools::threadpool::waiter waiter;
+    std::vector<std::exception_ptr> errors(ptxs.size());
+    // Not leaf tasks: the ringct signing and verification use the threadpool too
+    for (size_t i = 0; i < ptxs.size(); ++i)
+        tpool.submit(&waiter, [&ptxs, &keys, &errors, i] {
+            try {
+                keys.sign_transaction(ptxs[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    waiter.wait(&tpool);
+
+    for (auto& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+
 PendingTransaction TransactionConstructor::create_ons_buy_transaction(
         std::string_view name,
         std::string_view type_str,
@@ -256,6 +344,51 @@ void TransactionConstructor::select_and_fetch_decoys(PendingTransaction& ptx) {
     }
 }
 
+// Like the above for several transactions, but with one request to the daemon per transaction, all
+// of them sent before waiting on any.  The decoys are chosen in order, so the same decoy selector
+// picks the same decoys however the daemon's replies come back.
+void TransactionConstructor::select_and_fetch_decoys(std::vector<PendingTransaction>& ptxs) {
+    DecoySelector& decoy_selection = *decoy_selector;
+    std::vector<std::vector<size_t>> ring_sizes(ptxs.size());
+    std::vector<std::future<std::vector<Decoy>>> requests;
+    requests.reserve(ptxs.size());
+    for (size_t i = 0; i < ptxs.size(); ++i) {
+        std::vector<int64_t> indexes;
+        for (const auto& output : ptxs[i].chosen_outputs) {
+            auto ring = decoy_selection(output);
+            ring_sizes[i].push_back(ring.size());
+            indexes.insert(indexes.end(), ring.begin(), ring.end());
+        }
+        requests.push_back(daemon->fetch_decoys(indexes));
+    }
+
+    for (size_t i = 0; i < ptxs.size(); ++i) {
+        auto& ptx = ptxs[i];
+        if (requests[i].wait_for(5s) != std::future_status::ready)
+            throw std::runtime_error("request to daemon for decoys timed out");
+        auto decoys = requests[i].get();
+        size_t expected = 0;
+        for (auto size : ring_sizes[i])
+            expected += size;
+        if (decoys.size() != expected)
+            throw std::runtime_error{"Daemon returned the wrong number of decoys"};
+
+        ptx.decoys.clear();
+        auto next = decoys.begin();
+        for (size_t j = 0; j < ptx.chosen_outputs.size(); ++j) {
+            auto& ring = ptx.decoys.emplace_back(next, next + ring_sizes[i][j]);
+            next += ring_sizes[i][j];
+
+            bool good = false;
+            for (const auto& decoy : ring)
+                good |= (ptx.chosen_outputs[j].key == decoy.key);
+            if (!good)
+                throw std::runtime_error{
+                        "Key from daemon for real output does not match our stored key."};
+        }
+    }
+}
+
 void TransactionConstructor::select_inputs_and_finalise(PendingTransaction& ptx) {
     while (true) {
         if (ptx.finalise())
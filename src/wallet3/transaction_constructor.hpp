@@ -59,6 +59,31 @@ class TransactionConstructor {
             const cryptonote::tx_destination_entry& change_recipient,
             std::shared_ptr<Keyring> keyring);
 
+    // Builds the transactions that sweep `outputs` to `recipient`.  The outputs are split, in the
+    // order given, into as few transactions as the weight limit allows (or of no more than
+    // `max_inputs` inputs each, if that is lower), of about the same size, each of which sends all
+    // but its fee to the recipient.  Outputs that aren't worth the fee for an extra input are
+    // left out.  The decoys of all the transactions are requested before waiting on any of them.
+    std::vector<PendingTransaction> create_sweep_transactions(
+            const std::vector<Output>& outputs,
+            const cryptonote::tx_destination_entry& recipient,
+            const cryptonote::tx_destination_entry& change_recipient,
+            size_t max_inputs = 0);
+
+    // Signs the transactions with `keys`, several at once on the threadpool.  Each is signed on its
+    // own just as by Keyring::sign_transaction, so the result doesn't depend on the order they get
+    // signed in; if any fail, the error of the first of them is thrown once all are done.
+    static void sign_transactions(std::vector<PendingTransaction>& ptxs, Keyring& keys);
+
+    // Outputs below this amount are dust: they aren't worth the fee of a transaction spending just
+    // them, only of being swept together with others.
+    int64_t dust_threshold() const;
+
+    // The largest transaction weight a sweep builds
+    static constexpr size_t SWEEP_TX_WEIGHT_LIMIT =
+            cryptonote::BLOCK_GRANTED_FULL_REWARD_ZONE_V5 / 2 -
+            cryptonote::COINBASE_BLOB_RESERVED_SIZE;
+
     uint64_t fee_per_byte = cryptonote::FEE_PER_BYTE_V13;
     uint64_t fee_per_output = cryptonote::FEE_PER_OUTPUT_V18;
 
@@ -71,6 +96,8 @@ class TransactionConstructor {
 
     void select_and_fetch_decoys(PendingTransaction& ptx);
 
+    void select_and_fetch_decoys(std::vector<PendingTransaction>& ptxs);
+
     void select_inputs_and_finalise(PendingTransaction& ptx);
 
     int64_t estimate_fee() const;
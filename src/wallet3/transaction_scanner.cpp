@@ -1,6 +1,7 @@
 #include "transaction_scanner.hpp"
 
 #include <common/string_util.h>
+#include <cryptonote_basic/cryptonote_format_utils.h>
 
 #include <sqlitedb/database.hpp>
 #include <vector>
@@ -99,6 +100,24 @@ std::vector<Output> TransactionScanner::scan_received(
         }
     }
 
+    if (not received_outputs.empty()) {
+        // Only encrypted (short) payment IDs are still allowed; an all-zero one is the dummy that
+        // wallets add to transactions that don't have one so that they look the same.
+        std::vector<cryptonote::tx_extra_field> extra_fields;
+        cryptonote::parse_tx_extra(tx.tx.extra, extra_fields);  // ok if partially parsed
+        cryptonote::tx_extra_nonce extra_nonce;
+        crypto::hash8 encrypted_payment_id;
+        if (cryptonote::find_tx_extra_field_by_type(extra_fields, extra_nonce) &&
+            cryptonote::get_encrypted_payment_id_from_tx_extra_nonce(
+                    extra_nonce.nonce, encrypted_payment_id)) {
+            if (auto payment_id =
+                        wallet_keys->decrypt_payment_id(encrypted_payment_id, tx_public_keys[0]);
+                payment_id && *payment_id)
+                for (auto& o : received_outputs)
+                    o.payment_id = *payment_id;
+        }
+    }
+
     return received_outputs;
 }
 
@@ -56,6 +56,10 @@ int main(int argc, char *argv[]) {
     data.clear(data.rdstate());
     uint64_t timestamp, difficulty, cumulative_difficulty = 0;
     size_t n = 0;
+    // Fed the same blocks incrementally; heights are offset by one as the window never includes
+    // the genesis block.
+    cryptonote::difficulty_window window;
+    size_t window_end = 0;
     while (data >> timestamp >> difficulty) {
         size_t begin, end;
         if (n < (cryptonote::old::DIFFICULTY_WINDOW + 1) + DIFFICULTY_LAG) {
@@ -76,6 +80,18 @@ int main(int argc, char *argv[]) {
                 << "\nFound: " << res << "\n";
             return 1;
         }
+        for (; window_end < end; ++window_end)
+            window.push(window_end + 1, timestamps[window_end], cumulative_difficulties[window_end]);
+        uint64_t window_res = window.next_difficulty(
+            end - begin,
+            tools::to_seconds(cryptonote::TARGET_BLOCK_TIME),
+            cryptonote::difficulty_calc_mode::normal);
+        if (window_res != res) {
+            std::cerr << "difficulty_window mismatch for block " << n
+                << "\nExpected: " << res
+                << "\nFound: " << window_res << "\n";
+            return 1;
+        }
         timestamps.push_back(timestamp);
         cumulative_difficulties.push_back(cumulative_difficulty += difficulty);
         ++n;
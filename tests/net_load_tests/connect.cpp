@@ -0,0 +1,275 @@
+// Copyright (c) 2023, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "gtest/gtest.h"
+
+#include "common/util.h"
+#include "cryptonote_protocol/cryptonote_protocol_handler.h"
+#include "cryptonote_protocol/cryptonote_protocol_handler.inl"
+#include "logging/oxen_logger.h"
+#include "p2p/connect_scheduler.h"
+#include "p2p/net_node.h"
+#include "p2p/net_node.inl"
+
+#include "../unit_tests/random_path.h"
+#include "../unit_tests/test_core.h"
+
+using namespace std::literals;
+using nodetool::connect_scheduler;
+
+typedef nodetool::node_server<cryptonote::t_cryptonote_protocol_handler<test_core>> Server;
+
+namespace
+{
+  // connections_maker only makes a pass once a second
+  const size_t DEFAULT_OPERATION_TIMEOUT = 30000;
+  const std::string client_port("36232");
+  const std::string peers_port("36233");
+
+  template<typename t_predicate>
+  bool busy_wait_for(size_t timeout_ms, const t_predicate& predicate, size_t sleep_ms = 10)
+  {
+    for (size_t i = 0; i < timeout_ms / sleep_ms; ++i)
+    {
+      if (predicate())
+        return true;
+      std::this_thread::sleep_for(1ms * sleep_ms);
+    }
+    return false;
+  }
+
+  // A node server over a core that does nothing, running on its own thread once started
+  struct test_node
+  {
+    test_core core;
+    cryptonote::t_cryptonote_protocol_handler<test_core> protocol{core};
+    Server server{protocol};
+    std::thread thread;
+    bool initialized = false;
+
+    test_node()
+    {
+      protocol.set_p2p_endpoint(&server);
+    }
+
+    bool init(const fs::path& data_dir, std::vector<std::string> args)
+    {
+      boost::program_options::options_description desc_options("Command line options");
+      boost::program_options::options_description hidden("Hidden options");
+      cryptonote::core::init_options(desc_options);
+      Server::init_options(desc_options, hidden);
+      desc_options.add(hidden);
+
+      args.push_back("--data-dir=" + data_dir.string());
+      std::vector<const char*> argv{"net_load_tests_connect"};
+      for (const auto& a : args)
+        argv.push_back(a.c_str());
+      boost::program_options::variables_map vm;
+      boost::program_options::store(boost::program_options::parse_command_line(argv.size(), argv.data(), desc_options), vm);
+      boost::program_options::notify(vm);
+
+      initialized = server.init(vm);
+      return initialized;
+    }
+
+    void run()
+    {
+      thread = std::thread{[this] { server.run(); }};
+    }
+
+    void stop()
+    {
+      if (thread.joinable())
+      {
+        server.send_stop_signal();
+        thread.join();
+      }
+      if (initialized)
+        server.deinit();
+      initialized = false;
+    }
+
+    // The hosts this node has completed a handshake with
+    std::set<std::string> handshaked_hosts()
+    {
+      std::set<std::string> hosts;
+      static_cast<nodetool::i_p2p_endpoint<cryptonote::cryptonote_connection_context>&>(server).for_each_connection(
+        [&](cryptonote::cryptonote_connection_context& context, nodetool::peerid_type peer_id) {
+          if (peer_id)
+            hosts.insert(context.m_remote_address.host_str());
+          return true;
+        });
+      return hosts;
+    }
+  };
+
+  struct candidate
+  {
+    std::string host;
+    bool live;
+  };
+
+  // Live peers are node servers listening on their own loopback address; dead ones are loopback
+  // addresses with nothing listening, so connecting to them gets refused.  The client node gets
+  // them all in its white peer list, and makes its connections the way it does on the network.
+  class connect_test : public ::testing::Test
+  {
+  protected:
+    virtual void SetUp()
+    {
+      m_data_dir = random_tmp_file();
+      std::vector<std::string> client_args{
+        "--p2p-bind-ip=127.0.0.1", "--p2p-bind-port=" + client_port, "--allow-local-ip", "--hide-my-port"};
+
+      for (int i = 0; i < 12; ++i)
+      {
+        const bool live = i % 3 == 2;
+        m_candidates.push_back({"127.0.0." + std::to_string(10 + i), live});
+        client_args.push_back("--add-peer=" + m_candidates.back().host + ":" + peers_port);
+        if (!live)
+          continue;
+        // Peers only take connections: with no room for out peers and an exclusive node list
+        // they never go looking for seed nodes
+        auto& peer = m_peers.emplace_back(std::make_unique<test_node>());
+        ASSERT_TRUE(peer->init(m_data_dir / m_candidates.back().host, {
+          "--p2p-bind-ip=" + m_candidates.back().host, "--p2p-bind-port=" + peers_port, "--allow-local-ip",
+          "--out-peers=0", "--add-exclusive-node=127.0.0.1:" + client_port}));
+        peer->run();
+      }
+
+      // Room for exactly the live peers, so that the client is done (and doesn't go on to the
+      // seed nodes) once it has them all
+      client_args.push_back("--out-peers=" + std::to_string(m_peers.size()));
+      ASSERT_TRUE(m_client.init(m_data_dir / "client", client_args));
+    }
+
+    virtual void TearDown()
+    {
+      m_client.stop();
+      for (auto& peer : m_peers)
+        peer->stop();
+      std::error_code ec;
+      fs::remove_all(m_data_dir, ec);
+    }
+
+    fs::path m_data_dir;
+    std::vector<candidate> m_candidates;
+    std::vector<std::unique_ptr<test_node>> m_peers;
+    test_node m_client;
+  };
+}
+
+TEST_F(connect_test, connects_to_live_peers_past_dead_ones)
+{
+  std::set<std::string> live;
+  for (const auto& c : m_candidates)
+    if (c.live)
+      live.insert(c.host);
+
+  // Two out of three candidates are dead; connecting to them fails and they back off, while the
+  // live ones get connected and handshaked through the other connect slots
+  m_client.run();
+  EXPECT_TRUE(busy_wait_for(DEFAULT_OPERATION_TIMEOUT, [&] { return m_client.handshaked_hosts() == live; }));
+  ASSERT_EQ(live, m_client.handshaked_hosts());
+  ASSERT_EQ(m_peers.size(), m_client.server.get_public_outgoing_connections_count());
+  for (auto& peer : m_peers)
+    ASSERT_EQ(1, peer->server.get_public_connections_count());
+
+  // A couple more connections_maker passes don't add anything: the dead peers are backing off and
+  // the out peer slots are all taken
+  std::this_thread::sleep_for(2s);
+  ASSERT_EQ(live, m_client.handshaked_hosts());
+  ASSERT_EQ(m_peers.size(), m_client.server.get_public_connections_count());
+}
+
+TEST(connect_scheduler, slots)
+{
+  connect_scheduler s{2, 1min, 1h};
+  ASSERT_TRUE(s.try_begin("a"));
+  ASSERT_FALSE(s.try_begin("a"));
+  ASSERT_TRUE(s.try_begin("b"));
+  ASSERT_EQ(2, s.in_flight());
+  ASSERT_EQ(0, s.free_slots());
+  ASSERT_FALSE(s.try_begin("c"));
+  s.finish("a", true);
+  ASSERT_EQ(1, s.free_slots());
+  ASSERT_TRUE(s.try_begin("c"));
+  ASSERT_FALSE(s.backing_off("a"));
+}
+
+TEST(connect_scheduler, backoff)
+{
+  connect_scheduler s{4, 1min, 10min};
+  auto t = connect_scheduler::clock::now();
+
+  // 1min, 2min, 4min, 8min, then capped at 10min
+  for (auto wait : {1min, 2min, 4min, 8min, 10min, 10min})
+  {
+    ASSERT_TRUE(s.try_begin("a", t));
+    s.finish("a", false, t);
+    ASSERT_FALSE(s.try_begin("a", t + wait - 1s));
+    ASSERT_TRUE(s.backing_off("a", t + wait - 1s));
+    ASSERT_FALSE(s.backing_off("a", t + wait));
+    t += wait;
+  }
+
+  // A success clears the failure history
+  ASSERT_TRUE(s.try_begin("a", t));
+  s.finish("a", true, t);
+  s.record_failure("a", t);
+  ASSERT_FALSE(s.backing_off("a", t + 1min));
+
+  // ...and so does a long enough quiet period
+  s.record_failure("a", t + 1min);
+  s.record_failure("a", t + 3min);
+  ASSERT_TRUE(s.backing_off("a", t + 6min));
+  s.record_failure("a", t + 20min);
+  ASSERT_FALSE(s.backing_off("a", t + 21min));
+}
+
+int main(int argc, char** argv)
+{
+  TRY_ENTRY();
+  tools::on_startup();
+  epee::debug::get_set_enable_assert(true, false);
+  //set up logging options
+  oxen::logging::init("net_load_tests_connect.log", oxen::log::Level::debug);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+  CATCH_ENTRY_L0("main", 1);
+}
@@ -0,0 +1,210 @@
+// Copyright (c) 2023, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "common/util.h"
+#include "epee/net/buffer.h"
+#include "logging/oxen_logger.h"
+
+#include "net_load_tests.h"
+
+using namespace net_load_tests;
+
+namespace
+{
+  const size_t DEFAULT_OPERATION_TIMEOUT = 60000;
+  const std::string throughput_srv_port("36234");
+  const std::string throughput_clt_port("36235");
+  const int cmd_payload_id = 73600;
+
+  // Block-sized payloads, as served to a syncing peer
+  const size_t PAYLOAD_SIZE = 4 * 1024 * 1024;
+  const size_t PAYLOAD_COUNT = 64;
+  // Payloads sent but not yet received; keeps the send queue under its chunk limit
+  const size_t MAX_IN_FLIGHT = 6;
+
+  template<typename t_predicate>
+  bool busy_wait_for(size_t timeout_ms, const t_predicate& predicate, size_t sleep_ms = 1)
+  {
+    for (size_t i = 0; i < timeout_ms / sleep_ms; ++i)
+    {
+      if (predicate())
+        return true;
+      std::this_thread::sleep_for(1ms * sleep_ms);
+    }
+    return false;
+  }
+
+  double mb_per_s(size_t bytes, std::chrono::steady_clock::duration elapsed)
+  {
+    return bytes / 1e6 / std::chrono::duration<double>(elapsed).count();
+  }
+
+  struct counting_commands_handler : public test_levin_commands_handler
+  {
+    virtual int notify(int command, const epee::span<const uint8_t> in_buff, test_connection_context& context)
+    {
+      if (command == cmd_payload_id && !in_buff.empty() && in_buff[0] == 'x' && in_buff[in_buff.size() - 1] == 'y')
+        m_good_bytes += in_buff.size();
+      ++m_received;
+      return LEVIN_OK;
+    }
+
+    std::atomic<size_t> m_received{0};
+    std::atomic<size_t> m_good_bytes{0};
+  };
+
+  class throughput_test : public ::testing::Test
+  {
+  public:
+    throughput_test()
+      : m_server(epee::net_utils::e_connection_type_P2P)
+      , m_client(epee::net_utils::e_connection_type_P2P)
+    {
+    }
+
+  protected:
+    virtual void SetUp()
+    {
+      m_server.get_config_object().set_handler(&m_server_handler);
+      ASSERT_TRUE(m_server.init_server(throughput_srv_port, "127.0.0.1"));
+      ASSERT_TRUE(m_server.run_server(min_thread_count, false));
+      m_client.get_config_object().set_handler(&m_client_handler);
+      ASSERT_TRUE(m_client.init_server(throughput_clt_port, "127.0.0.1"));
+      ASSERT_TRUE(m_client.run_server(min_thread_count, false));
+
+      test_connection_context context;
+      ASSERT_TRUE(m_client.connect("127.0.0.1", throughput_srv_port, 5000, context));
+      m_connection_id = context.m_connection_id;
+
+      m_payload = std::string(PAYLOAD_SIZE, '.');
+      m_payload.front() = 'x';
+      m_payload.back() = 'y';
+    }
+
+    virtual void TearDown()
+    {
+      m_client.send_stop_signal();
+      ASSERT_TRUE(m_client.server_stop());
+      m_server.send_stop_signal();
+      ASSERT_TRUE(m_server.server_stop());
+    }
+
+    // Sends PAYLOAD_COUNT payloads with `send(i)`, and returns how long until they all arrived
+    template<typename t_send>
+    std::chrono::steady_clock::duration send_all(const t_send& send)
+    {
+      const size_t received_before = m_server_handler.m_received;
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < PAYLOAD_COUNT; ++i)
+      {
+        EXPECT_TRUE(busy_wait_for(DEFAULT_OPERATION_TIMEOUT, [&] {
+          return m_server_handler.m_received - received_before + MAX_IN_FLIGHT > i;
+        }));
+        EXPECT_EQ(1, send(i));
+      }
+      EXPECT_TRUE(busy_wait_for(DEFAULT_OPERATION_TIMEOUT, [&] {
+        return m_server_handler.m_received - received_before == PAYLOAD_COUNT;
+      }));
+      return std::chrono::steady_clock::now() - start;
+    }
+
+    counting_commands_handler m_server_handler;
+    test_levin_commands_handler m_client_handler;
+    test_tcp_server m_server;
+    test_tcp_server m_client;
+    boost::uuids::uuid m_connection_id;
+    std::string m_payload;
+  };
+}
+
+TEST_F(throughput_test, shared_payload)
+{
+  // The same payload queued to the connection again and again, never copied
+  epee::shared_sv payload{std::string{m_payload}};
+  auto elapsed = send_all([&](size_t) {
+    return m_client.get_config_object().notify(cmd_payload_id, payload, m_connection_id);
+  });
+  ASSERT_EQ(PAYLOAD_COUNT * PAYLOAD_SIZE, m_server_handler.m_good_bytes);
+  std::cout << "shared payload: " << mb_per_s(PAYLOAD_COUNT * PAYLOAD_SIZE, elapsed) << " MB/s" << std::endl;
+}
+
+TEST_F(throughput_test, copied_payload)
+{
+  // The span overload copies the payload once per send
+  auto elapsed = send_all([&](size_t) {
+    return m_client.get_config_object().notify(cmd_payload_id, epee::strspan<uint8_t>(m_payload), m_connection_id);
+  });
+  ASSERT_EQ(PAYLOAD_COUNT * PAYLOAD_SIZE, m_server_handler.m_good_bytes);
+  std::cout << "copied payload: " << mb_per_s(PAYLOAD_COUNT * PAYLOAD_SIZE, elapsed) << " MB/s" << std::endl;
+}
+
+TEST(net_buffer_throughput, frames)
+{
+  // Levin frames read off the socket 8 KiB at a time, with the start of the next frame behind
+  // each one, with and without making room for the frame up front like the levin handler does
+  const std::string read(8192, '.');
+  const size_t frame_size = PAYLOAD_SIZE + 1000;
+  for (bool reserve : {false, true})
+  {
+    epee::net_utils::buffer buf{4 * 1024};
+    size_t frames = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 16; ++i)
+    {
+      if (reserve)
+        buf.reserve(frame_size);
+      while (buf.size() < frame_size)
+        buf.append(read.data(), read.size());
+      ASSERT_EQ(frame_size, buf.carve(frame_size).size());
+      ++frames;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << (reserve ? "reserved" : "grown") << " receive buffer: "
+      << mb_per_s(frames * frame_size, elapsed) << " MB/s" << std::endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  TRY_ENTRY();
+  tools::on_startup();
+  epee::debug::get_set_enable_assert(true, false);
+  //set up logging options
+  oxen::logging::init("net_load_tests_throughput.log", oxen::log::Level::warn);
+
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+  CATCH_ENTRY_L0("main", 1);
+}
@@ -84,3 +84,72 @@ private:
   std::vector<cryptonote::tx_destination_entry> m_destinations;
   cryptonote::transaction m_tx;
 };
+
+// Builds a tx spending `a_in_count` distinct inputs (each with a ring of `a_ring_size`), as a sweep or
+// consolidation would; this is dominated by per-input key image derivation and CLSAG signing.
+template<size_t a_in_count, size_t a_ring_size = 10, size_t a_out_count = 2>
+class test_construct_tx_wide_inputs : private multi_tx_test_base<a_ring_size>
+{
+  static_assert(0 < a_in_count, "in_count must be greater than 0");
+  static_assert(0 < a_out_count, "out_count must be greater than 0");
+
+public:
+  static const size_t loop_count = a_in_count < 10 ? 10 : a_in_count < 100 ? 5 : 2;
+  static const size_t in_count = a_in_count;
+  static const size_t out_count = a_out_count;
+
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  bool init()
+  {
+    using namespace cryptonote;
+
+    if (!base_class::init())
+      return false;
+
+    // Give the real signer a distinct output (and thus key image) for every input, keeping the
+    // base class's decoys around it.
+    const auto& signer = this->m_miners[this->real_source_idx];
+    const tx_source_entry base_source = this->m_sources.front();
+    this->m_sources.clear();
+    for (size_t i = 0; i < in_count; ++i)
+    {
+      transaction miner_tx;
+      bool r;
+      uint64_t reward;
+      std::tie(r, reward) = construct_miner_tx(0, 0, 0, 2, 0, miner_tx, cryptonote::oxen_miner_tx_context::miner_block(network_type::FAKECHAIN, signer.get_keys().m_account_address), {}, {}, hf::none);
+      if (!r || miner_tx.vout[0].amount != this->m_source_amount)
+        return false;
+
+      tx_source_entry src = base_source;
+      const auto& out_key = var::get<txout_to_key>(miner_tx.vout[0].target).key;
+      src.outputs[src.real_output].second = rct::ctkey({rct::pk2rct(out_key), rct::zeroCommit(this->m_source_amount)});
+      src.real_out_tx_key = get_tx_pub_key_from_extra(miner_tx);
+      this->m_sources.push_back(std::move(src));
+    }
+
+    m_alice.generate();
+    for (size_t i = 0; i < out_count; ++i)
+      m_destinations.push_back(tx_destination_entry(in_count * this->m_source_amount / out_count, m_alice.get_keys().m_account_address, false));
+
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::secret_key tx_key;
+    std::vector<crypto::secret_key> additional_tx_keys;
+    std::unordered_map<crypto::public_key, cryptonote::subaddress_index> subaddresses;
+    subaddresses[this->m_miners[this->real_source_idx].get_keys().m_account_address.m_spend_public_key] = {0,0};
+    rct::RCTConfig rct_config{rct::RangeProofType::PaddedBulletproof, 2};
+    cryptonote::oxen_construct_tx_params tx_params;
+    tx_params.hf_version = cryptonote::hf_max;
+    auto sources = this->m_sources;
+    return cryptonote::construct_tx_and_get_tx_key(this->m_miners[this->real_source_idx].get_keys(), subaddresses, sources, m_destinations, cryptonote::tx_destination_entry{}, std::vector<uint8_t>(), m_tx, 0, tx_key, additional_tx_keys, rct_config, nullptr, tx_params);
+  }
+
+private:
+  cryptonote::account_base m_alice;
+  std::vector<cryptonote::tx_destination_entry> m_destinations;
+  cryptonote::transaction m_tx;
+};
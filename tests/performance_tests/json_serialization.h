@@ -0,0 +1,117 @@
+// Copyright (c) 2014-2018, The Monero Project
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+// Parts of this file are originally copyright (c) 2012-2013 The Cryptonote developers
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <oxenc/hex.h>
+
+#include "common/json_chunks.h"
+#include "crypto/crypto.h"
+#include "rpc/common/command_decorators.h"
+
+// Data for a response shaped like a large get_transactions/get_block result: `txs` entries, each
+// with a couple of hashes, a hex blob and a nested array of outputs.
+struct large_rpc_response_data
+{
+  std::vector<crypto::hash> hashes;
+  std::string blob;
+
+  explicit large_rpc_response_data(size_t txs) : hashes(txs), blob(1500, '\0')
+  {
+    crypto::rand(hashes.size() * sizeof(crypto::hash), reinterpret_cast<uint8_t*>(hashes.data()));
+    crypto::rand(blob.size(), reinterpret_cast<uint8_t*>(blob.data()));
+  }
+
+  void fill_tx(size_t i, tools::json_binary_proxy tx) const
+  {
+    tx["tx_hash"] = hashes[i];
+    tx["as_hex"] = blob;
+    auto& e = *tx;
+    e["block_height"] = 1'000'000 + i;
+    e["block_timestamp"] = 1'650'000'000 + i;
+    e["in_pool"] = false;
+    auto& outs = e["output_indices"] = nlohmann::json::array();
+    for (uint64_t o = 0; o < 4; ++o)
+      outs.push_back(i * 4 + o);
+  }
+};
+
+// Producing a large rpc json response body.  With `streamed` false this is what a command used to
+// do: build the whole response DOM and then dump() it.  With `streamed` true it goes the way the
+// HTTP RPC server now does it: the large list is produced with RPC_COMMAND::stream_array and
+// written (an element at a time) into a json_chunks whose full chunks get handed off and dropped,
+// so that only one element and one chunk are ever held at once.
+template<size_t txs, bool streamed>
+class test_json_serialization
+{
+public:
+  static const size_t loop_count = txs < 100 ? 1000 : txs < 1000 ? 100 : 10;
+
+  bool init()
+  {
+    m_data.emplace(txs);
+    return true;
+  }
+
+  bool test()
+  {
+    const auto& data = *m_data;
+    cryptonote::rpc::RPC_COMMAND rpc;
+    rpc.response["status"] = "OK";
+    rpc.response["untrusted"] = false;
+    if constexpr (streamed)
+    {
+      rpc.stream_array("txs", txs, [&data](size_t i, tools::json_binary_proxy tx) {
+        data.fill_tx(i, tx);
+      });
+      size_t sent = 0;
+      tools::json_chunks out{[&sent](std::string chunk) { sent += chunk.size(); }};
+      rpc.write_response(out);
+      out.flush();
+      return sent == out.size() && sent > 0;
+    }
+    else
+    {
+      auto& list = rpc.response["txs"] = nlohmann::json::array();
+      for (size_t i = 0; i < txs; ++i)
+        data.fill_tx(i, rpc.response_hex["txs"].emplace_back(nlohmann::json::object()));
+      std::string out = rpc.response.dump();
+      return !out.empty() && list.size() == txs;
+    }
+  }
+
+private:
+  std::optional<large_rpc_response_data> m_data;
+};
@@ -0,0 +1,78 @@
+// Copyright (c) 2023, The Oxen Project
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+#include <spdlog/logger.h>
+#include <spdlog/sinks/basic_file_sink.h>
+
+#include "logging/async_sink.h"
+
+// Time spent by the logging thread on one trace message going to a log file, which is what a hot
+// path pays for every log statement once its category is turned up to trace.  `async` puts the
+// file behind an async_sink; `drop` lets it drop messages rather than wait when the writer thread
+// falls behind, as the daemon's file sink does.
+template<bool async, bool drop>
+class test_logging
+{
+public:
+  static const size_t loop_count = 100000;
+
+  bool init()
+  {
+    m_path = std::filesystem::temp_directory_path() / "performance_tests_logging.log";
+    spdlog::sink_ptr sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(m_path.string(), true);
+    if (async)
+      sink = std::make_shared<oxen::logging::async_sink>(std::move(sink),
+          drop ? oxen::logging::overflow_policy::drop : oxen::logging::overflow_policy::block);
+    m_logger = std::make_unique<spdlog::logger>("perf", std::move(sink));
+    m_logger->set_level(spdlog::level::trace);
+    return true;
+  }
+
+  ~test_logging()
+  {
+    m_logger.reset();
+    std::error_code ec;
+    std::filesystem::remove(m_path, ec);
+  }
+
+  bool test()
+  {
+    m_logger->trace("Received block {} with {} txes from peer {}", ++m_height, 17, "203.0.113.7:22022");
+    return true;
+  }
+
+private:
+  std::filesystem::path m_path;
+  std::unique_ptr<spdlog::logger> m_logger;
+  uint64_t m_height = 0;
+};
@@ -52,12 +52,16 @@
 #include "subaddress_expand.h"
 #include "sc_reduce32.h"
 #include "sc_check.h"
+#include "secret_key.h"
 #include "cn_fast_hash.h"
 #include "equality.h"
 #include "bulletproof.h"
 #include "crypto_ops.h"
 #include "multiexp.h"
 #include "sig_clsag.h"
+#include "json_serialization.h"
+#include "logging.h"
+#include "network_throttle.h"
 
 namespace po = boost::program_options;
 
@@ -148,6 +152,11 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE5(filter, p, test_construct_tx, 100, 2, true, rct::RangeProofType::PaddedBulletproof, 2);
   TEST_PERFORMANCE5(filter, p, test_construct_tx, 100, 10, true, rct::RangeProofType::PaddedBulletproof, 2);
 
+  TEST_PERFORMANCE1(filter, p, test_construct_tx_wide_inputs, 16);
+  TEST_PERFORMANCE1(filter, p, test_construct_tx_wide_inputs, 64);
+  TEST_PERFORMANCE1(filter, p, test_construct_tx_wide_inputs, 150);
+  TEST_PERFORMANCE2(filter, p, test_construct_tx_wide_inputs, 150, 16);
+
   TEST_PERFORMANCE3(filter, p, test_check_tx_signature, 1, 2, false);
   TEST_PERFORMANCE3(filter, p, test_check_tx_signature, 2, 2, false);
   TEST_PERFORMANCE3(filter, p, test_check_tx_signature, 10, 2, false);
@@ -188,6 +197,9 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(filter, p, test_ge_frombytes_vartime);
   TEST_PERFORMANCE0(filter, p, test_ge_tobytes);
   TEST_PERFORMANCE0(filter, p, test_generate_keypair);
+  TEST_PERFORMANCE1(filter, p, test_secret_key_temporaries, 1);
+  TEST_PERFORMANCE1(filter, p, test_secret_key_temporaries, 8);
+  TEST_PERFORMANCE1(filter, p, test_secret_key_temporaries, 64);
   TEST_PERFORMANCE0(filter, p, test_sc_reduce32);
   TEST_PERFORMANCE0(filter, p, test_sc_check);
   TEST_PERFORMANCE1(filter, p, test_signature, false);
@@ -207,6 +219,29 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE3(filter, p, test_sig_clsag, 128, 2, 2);
   TEST_PERFORMANCE3(filter, p, test_sig_clsag, 256, 2, 2);
 
+  TEST_PERFORMANCE2(filter, p, test_sig_clsag_ring_cache, 16, 0); // CLSAG verification, no ring cache
+  TEST_PERFORMANCE2(filter, p, test_sig_clsag_ring_cache, 16, 4096);
+  TEST_PERFORMANCE2(filter, p, test_sig_clsag_ring_cache, 64, 0);
+  TEST_PERFORMANCE2(filter, p, test_sig_clsag_ring_cache, 64, 4096);
+  TEST_PERFORMANCE1(filter, p, test_sig_clsag_sign, 16); // CLSAG signing
+  TEST_PERFORMANCE1(filter, p, test_sig_clsag_sign, 64);
+
+  TEST_PERFORMANCE2(filter, p, test_json_serialization, 100, false); // DOM + json::dump()
+  TEST_PERFORMANCE2(filter, p, test_json_serialization, 100, true); // stream_array + json_chunks
+  TEST_PERFORMANCE2(filter, p, test_json_serialization, 5000, false);
+  TEST_PERFORMANCE2(filter, p, test_json_serialization, 5000, true);
+
+  TEST_PERFORMANCE2(filter, p, test_logging, false, false); // synchronous file sink
+  TEST_PERFORMANCE2(filter, p, test_logging, true, false); // async_sink, blocking when full
+  TEST_PERFORMANCE2(filter, p, test_logging, true, true); // async_sink, dropping when full
+
+  TEST_PERFORMANCE2(filter, p, test_network_throttle, 1, false); // global throttle accounting, mutex
+  TEST_PERFORMANCE2(filter, p, test_network_throttle, 1, true); // global throttle accounting, lock-free
+  TEST_PERFORMANCE2(filter, p, test_network_throttle, 8, false);
+  TEST_PERFORMANCE2(filter, p, test_network_throttle, 8, true);
+  TEST_PERFORMANCE2(filter, p, test_network_throttle, 64, false);
+  TEST_PERFORMANCE2(filter, p, test_network_throttle, 64, true);
+
   TEST_PERFORMANCE2(filter, p, test_equality, memcmp32, true);
   TEST_PERFORMANCE2(filter, p, test_equality, memcmp32, false);
   TEST_PERFORMANCE2(filter, p, test_equality, verify32, false);
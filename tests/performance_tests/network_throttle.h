@@ -0,0 +1,89 @@
+// Copyright (c) 2023, The Oxen Project
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "epee/net/network_throttle-detail.hpp"
+#include "performance_utils.h"
+
+// Per-packet cost of the global throttle accounting done on every send and receive: each of
+// `threads` I/O threads counts its packets and asks for a sleep time the way connection::handle_read
+// does.  Each call pushes threads * packets_per_thread packets through.  With `shared` false this
+// is how the global throttles used to work: a network_throttle behind a mutex.
+template<size_t threads, bool shared>
+class test_network_throttle
+{
+public:
+  static const size_t loop_count = 20;
+  static const size_t packets_per_thread = 5000;
+
+  bool init()
+  {
+    m_shared.set_target_speed(1024 * 1024 * 1024);
+    m_locked.set_target_speed(1024 * 1024 * 1024);
+    return true;
+  }
+
+  bool test()
+  {
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i)
+      workers.emplace_back([this] {
+        clear_thread_affinity();
+        for (size_t j = 0; j < packets_per_thread; ++j)
+          packet(1500);
+      });
+    for (auto& w : workers)
+      w.join();
+    return true;
+  }
+
+private:
+  void packet(size_t size)
+  {
+    if constexpr (shared)
+    {
+      m_shared.handle_trafic_exact(size);
+      m_shared.get_sleep_time_after_tick(size);
+    }
+    else
+    {
+      std::lock_guard lock{m_mutex};
+      m_locked.handle_trafic_exact(size);
+      m_locked.get_sleep_time_after_tick(size);
+    }
+  }
+
+  epee::net_utils::shared_network_throttle m_shared{"bench", "bench"};
+  epee::net_utils::network_throttle m_locked{"bench", "bench"};
+  std::mutex m_mutex;
+};
@@ -60,6 +60,19 @@ void set_process_affinity(int core)
 #endif
 }
 
+// Undoes set_process_affinity() for a thread started by a multithreaded test, which would
+// otherwise inherit the single core pinning from the main thread.
+void clear_thread_affinity()
+{
+#if defined(BOOST_HAS_PTHREADS) && !(defined (__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__DragonFly__) || defined(__NetBSD__) || defined(__sun))
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int i = 0; i < CPU_SETSIZE; ++i)
+    CPU_SET(i, &cpuset);
+  ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuset), &cpuset);
+#endif
+}
+
 void set_thread_high_priority()
 {
 #if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__DragonFly__) || defined(_NetBSD_) || defined(__sun)
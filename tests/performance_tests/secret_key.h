@@ -0,0 +1,68 @@
+// Copyright (c) 2023, The Oxen Project
+// 
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+// 
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+// 
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "performance_utils.h"
+
+// Cost of creating and destroying a temporary crypto::secret_key (mlock bookkeeping and
+// scrubbing) on each of `threads` threads at once, as wallet scanning and multi-threaded
+// verification do.  Each call makes threads * keys_per_thread keys.
+template<size_t threads>
+class test_secret_key_temporaries
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t keys_per_thread = 10000;
+
+  bool init()
+  {
+    return true;
+  }
+
+  bool test()
+  {
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i)
+      workers.emplace_back([] {
+        clear_thread_affinity();
+        for (size_t j = 0; j < keys_per_thread; ++j)
+        {
+          crypto::secret_key k;
+          k.data[0] = j;
+        }
+      });
+    for (auto& w : workers)
+      w.join();
+    return true;
+  }
+};
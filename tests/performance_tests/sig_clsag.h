@@ -47,6 +47,8 @@ class test_sig_clsag
 
         bool init()
         {
+            rct::set_clsag_ring_cache_size(default_ring_cache_size);
+
             pubs.reserve(N);
             pubs.resize(N);
 
@@ -157,7 +159,9 @@ class test_sig_clsag
             return true;
         }
 
-    private:
+        static constexpr size_t default_ring_cache_size = 4096;
+
+    protected:
         ctkeyV pubs;
         keyV Q;
         keyV r;
@@ -170,3 +174,52 @@ class test_sig_clsag
         keyV messages;
         std::vector<clsag> sigs;
 };
+
+// CLSAG verification using a caller-owned scratch arena and a ring member cache of the given size
+// (0 disables the cache, so every ring member gets decompressed and hashed to a point each time).
+template<size_t a_N, size_t a_cache_size>
+class test_sig_clsag_ring_cache : public test_sig_clsag<a_N, 2, 2>
+{
+    public:
+        using base = test_sig_clsag<a_N, 2, 2>;
+
+        bool init()
+        {
+            if (!base::init())
+                return false;
+            rct::set_clsag_ring_cache_size(a_cache_size);
+            return true;
+        }
+
+        bool test()
+        {
+            for (size_t u = 0; u < base::w; u++)
+                if (!verRctCLSAGSimple(base::messages[u], base::sigs[u], base::pubs, base::C_offsets[u], scratch))
+                    return false;
+            return true;
+        }
+
+    private:
+        clsag_scratch scratch;
+};
+
+// CLSAG signing using a caller-owned scratch arena.  The decoys of the ring are hit in the ring
+// member cache after the first iteration, as they would be for popular decoys.
+template<size_t a_N>
+class test_sig_clsag_sign : public test_sig_clsag<a_N, 2, 1>
+{
+    public:
+        using base = test_sig_clsag<a_N, 2, 1>;
+
+        bool test()
+        {
+            ctkey sk;
+            sk.dest = base::r[0];
+            sk.mask = base::s[0];
+            clsag sig = proveRctCLSAGSimple(base::messages[0], base::pubs, sk, base::s1[0], base::C_offsets[0], NULL, NULL, NULL, 0, hw::get_device("default"), scratch);
+            return sig.s.size() == a_N;
+        }
+
+    private:
+        clsag_scratch scratch;
+};
@@ -334,6 +334,27 @@ TYPED_TEST(BlockchainDBTest, RetrieveBlockData)
 
   ASSERT_HASH_EQ(get_block_hash(this->m_blocks[0].first), hashes[0]);
   ASSERT_HASH_EQ(get_block_hash(this->m_blocks[1].first), hashes[1]);
+
+  std::vector<block_info_t> infos;
+  ASSERT_NO_THROW(infos = this->m_db->get_block_info_range(0, 1));
+  ASSERT_EQ(2, infos.size());
+  for (uint64_t h = 0; h < 2; ++h)
+  {
+    ASSERT_EQ(h, infos[h].height);
+    ASSERT_HASH_EQ(get_block_hash(this->m_blocks[h].first), infos[h].hash);
+    ASSERT_EQ(this->m_blocks[h].first.timestamp, infos[h].timestamp);
+    ASSERT_EQ(t_sizes[h], infos[h].weight);
+    ASSERT_EQ(t_sizes[h], infos[h].long_term_weight);
+    ASSERT_EQ(t_coins[h], infos[h].already_generated_coins);
+    ASSERT_EQ(t_diffs[h], infos[h].cumulative_difficulty);
+    ASSERT_EQ(this->m_db->get_block_difficulty(h), infos[h].difficulty);
+  }
+
+  ASSERT_NO_THROW(infos = this->m_db->get_block_info_range(1, 1));
+  ASSERT_EQ(1, infos.size());
+  ASSERT_EQ(t_diffs[1] - t_diffs[0], infos[0].difficulty);
+
+  ASSERT_THROW(this->m_db->get_block_info_range(1, 2), BLOCK_DNE);
 }
 
 }  // anonymous namespace
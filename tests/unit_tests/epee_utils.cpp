@@ -758,6 +758,29 @@ TEST(net_buffer, move)
   ASSERT_TRUE(!memcmp(span.data() + 1, std::string(4000, '0').c_str(), 4000));
 }
 
+TEST(net_buffer, reserve)
+{
+  epee::net_utils::buffer buf;
+
+  buf.append(std::string(400, ' ').c_str(), 400);
+  buf.erase(300);
+  buf.reserve(100000);
+  const uint8_t* data = buf.span(100).data();
+  for (int i = 0; i < 99; ++i)
+    buf.append(std::string(1000, '0').c_str(), 1000);
+  ASSERT_EQ(buf.size(), 99100);
+  // Nothing moved once the room was made
+  epee::span<const uint8_t> span = buf.span(99100);
+  ASSERT_EQ(span.data(), data);
+  ASSERT_TRUE(!memcmp(span.data(), std::string(100, ' ').c_str(), 100));
+  ASSERT_TRUE(!memcmp(span.data() + 100, std::string(99000, '0').c_str(), 99000));
+
+  // Reserving no more than there is already room for does nothing
+  buf.erase(99000);
+  buf.reserve(50);
+  ASSERT_EQ(buf.span(100).data(), data + 99000);
+}
+
 TEST(parsing, isspace)
 {
   ASSERT_FALSE(epee::misc_utils::parse::isspace(0));
@@ -0,0 +1,420 @@
+// Copyright (c) 2023, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/program_options.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "gtest/gtest.h"
+
+#include "blockchain_db/testdb.h"
+#include "blockchain_utilities/blockchain_objects.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_core/blockchain.h"
+#include "cryptonote_core/cryptonote_core.h"
+#include "cryptonote_protocol/cryptonote_protocol_handler.h"
+#include "p2p/net_node_common.h"
+#include "test_core.h"
+
+using namespace std::literals;
+
+namespace
+{
+
+// A chain of blocks with a few (made up) transactions each, all in memory.  Reads can be made to
+// take a while, as they do when the db pages aren't cached.
+class TestDB: public cryptonote::BaseTestDB
+{
+public:
+  TestDB(size_t height, size_t txs_per_block)
+  {
+    m_open = true;
+    crypto::hash prev{};
+    for (size_t h = 0; h < height; ++h)
+    {
+      cryptonote::block b{};
+      b.prev_id = prev;
+      b.timestamp = 1000 + h;
+      b.miner_tx.vin.push_back(cryptonote::txin_gen{h});
+      for (size_t i = 0; i < txs_per_block; ++i)
+      {
+        std::string tx = "tx " + std::to_string(h) + "/" + std::to_string(i);
+        tx.resize(1500, 'x');
+        const crypto::hash tx_hash = crypto::cn_fast_hash(tx.data(), tx.size());
+        b.tx_hashes.push_back(tx_hash);
+        txs.emplace(tx_hash, std::move(tx));
+      }
+      prev = cryptonote::get_block_hash(b);
+      heights.emplace(prev, h);
+      hashes.push_back(prev);
+      blobs.push_back(cryptonote::block_to_blob(b));
+    }
+  }
+
+  virtual uint64_t height() const override { return blobs.size(); }
+  virtual bool block_exists(const crypto::hash& h, uint64_t* height) const override
+  {
+    auto it = heights.find(h);
+    if (it == heights.end())
+      return false;
+    if (height)
+      *height = it->second;
+    return true;
+  }
+  virtual std::string get_block_blob_from_height(uint64_t height) const override
+  {
+    { std::lock_guard lock{gate}; }
+    std::this_thread::sleep_for(read_delay);
+    return blobs.at(height);
+  }
+  virtual bool get_tx_blob(const crypto::hash& h, std::string& tx) const override
+  {
+    auto it = txs.find(h);
+    if (it == txs.end())
+      return false;
+    tx = it->second;
+    return true;
+  }
+
+  std::vector<crypto::hash> hashes;
+  std::vector<std::string> blobs;
+  std::unordered_map<crypto::hash, uint64_t> heights;
+  std::unordered_map<crypto::hash, std::string> txs;
+  std::chrono::microseconds read_delay{0};
+  mutable std::mutex gate; // holding it holds up every block read
+};
+
+class get_blocks : public ::testing::Test
+{
+protected:
+  static constexpr size_t HEIGHT = 1000;
+  static constexpr size_t TXS_PER_BLOCK = 5;
+
+  virtual void SetUp()
+  {
+    m_db = new TestDB(HEIGHT, TXS_PER_BLOCK);
+    ASSERT_TRUE(m_bc.m_blockchain.init(m_db, nullptr /*ons_db*/, nullptr /*sqlite_db*/, cryptonote::network_type::FAKECHAIN, true, &m_test_options, 0, NULL));
+  }
+
+  // What serving used to be: every block read in turn, on the one thread
+  void serve_sequentially(const cryptonote::NOTIFY_REQUEST_GET_BLOCKS::request& req, cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request& rsp)
+  {
+    for (const auto& id : req.blocks)
+    {
+      uint64_t height;
+      if (!m_db->block_exists(id, &height))
+        continue;
+      cryptonote::block_complete_entry entry;
+      entry.block = m_db->get_block_blob_from_height(height);
+      cryptonote::block b;
+      ASSERT_TRUE(cryptonote::parse_and_validate_block_from_blob(entry.block, b));
+      for (const auto& h : b.tx_hashes)
+        ASSERT_TRUE(m_db->get_tx_blob(h, entry.txs.emplace_back()));
+      rsp.blocks.push_back(std::move(entry));
+    }
+  }
+
+  const std::vector<cryptonote::hard_fork> m_hard_forks{{cryptonote::hf::hf7,0,0,0}};
+  const cryptonote::test_options m_test_options{m_hard_forks};
+  blockchain_objects_t m_bc;
+  TestDB* m_db = nullptr;  // owned by the blockchain
+};
+
+// Stands in for the node server: keeps what the protocol handler sends, and which connections it
+// drops
+class recording_p2p : public nodetool::p2p_endpoint_stub<cryptonote::cryptonote_connection_context>
+{
+public:
+  virtual bool invoke_notify_to_peer(int command, epee::shared_sv req_buff, const epee::net_utils::connection_context_base& context) override
+  {
+    EXPECT_EQ(cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::ID, command);
+    cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request rsp;
+    EXPECT_TRUE(epee::serialization::load_t_from_binary(rsp, req_buff.view));
+    std::lock_guard lock{mutex};
+    responses[context.m_connection_id].push_back(std::move(rsp));
+    ++response_count;
+    cv.notify_all();
+    return true;
+  }
+  virtual bool drop_connection(const epee::net_utils::connection_context_base& context) override
+  {
+    std::lock_guard lock{mutex};
+    dropped.push_back(context.m_connection_id);
+    return true;
+  }
+  virtual bool for_connection(const boost::uuids::uuid& id, std::function<bool(cryptonote::cryptonote_connection_context&, nodetool::peerid_type)> f) override
+  {
+    auto it = connections.find(id);
+    return it != connections.end() && f(*it->second, 0);
+  }
+
+  // Waits (for a while) until `count` responses in all have been sent
+  bool wait_for(size_t count)
+  {
+    std::unique_lock lock{mutex};
+    return cv.wait_for(lock, 10s, [&] { return response_count >= count; });
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::map<boost::uuids::uuid, std::vector<cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request>> responses;
+  size_t response_count = 0;
+  std::vector<boost::uuids::uuid> dropped;
+  std::map<boost::uuids::uuid, cryptonote::cryptonote_connection_context*> connections;
+};
+
+// The protocol handler serving a couple of connections out of the blockchain above, on its pool
+class get_blocks_handler : public get_blocks
+{
+protected:
+  static constexpr size_t SPAN = 100;
+
+  virtual void SetUp() override
+  {
+    get_blocks::SetUp();
+    m_core.blockchain = &m_bc.m_blockchain;
+    m_handler.set_p2p_endpoint(&m_p2p);
+
+    boost::program_options::options_description desc;
+    command_line::add_arg(desc, cryptonote::arg_block_download_max_size);
+    const char* argv[] = {"unit_tests", nullptr};
+    boost::program_options::variables_map vm;
+    boost::program_options::store(boost::program_options::parse_command_line(1, argv, desc), vm);
+    boost::program_options::notify(vm);
+    ASSERT_TRUE(m_handler.init(vm));
+
+    for (auto& c : m_connections)
+    {
+      static_cast<epee::net_utils::connection_context_base&>(c) = epee::net_utils::connection_context_base{
+          boost::uuids::random_generator()(), epee::net_utils::ipv4_network_address{0x0100007f, 18080}, true};
+      m_p2p.connections.emplace(c.m_connection_id, &c);
+    }
+  }
+
+  virtual void TearDown() override
+  {
+    m_handler.deinit();
+  }
+
+  // Sends connection `conn` a request for the span of blocks starting at `start`, the way it comes
+  // in off the wire
+  void request(size_t conn, size_t start)
+  {
+    cryptonote::NOTIFY_REQUEST_GET_BLOCKS::request req;
+    for (size_t h = start; h < start + SPAN; ++h)
+      req.blocks.push_back(m_db->hashes[h]);
+    std::string blob, out;
+    ASSERT_TRUE(epee::serialization::store_t_to_binary(req, blob));
+    bool handled = false;
+    m_handler.handle_invoke_map(true, cryptonote::NOTIFY_REQUEST_GET_BLOCKS::ID, epee::strspan<uint8_t>(blob), out, m_connections[conn], handled);
+    ASSERT_TRUE(handled);
+  }
+
+  // The start of each span sent on connection `conn`, in the order they were sent
+  std::vector<size_t> served(size_t conn)
+  {
+    std::lock_guard lock{m_p2p.mutex};
+    std::vector<size_t> starts;
+    for (const auto& rsp : m_p2p.responses[m_connections[conn].m_connection_id])
+    {
+      EXPECT_EQ(SPAN, rsp.blocks.size());
+      if (!rsp.blocks.empty())
+        starts.push_back(std::find(m_db->blobs.begin(), m_db->blobs.end(), rsp.blocks.front().block) - m_db->blobs.begin());
+    }
+    return starts;
+  }
+
+  test_core m_core;
+  recording_p2p m_p2p;
+  cryptonote::t_cryptonote_protocol_handler<test_core> m_handler{m_core};
+  cryptonote::cryptonote_connection_context m_connections[2];
+};
+
+}
+
+// Instantiated with the node server tests
+extern template class cryptonote::t_cryptonote_protocol_handler<test_core>;
+
+TEST_F(get_blocks, order_and_missed)
+{
+  cryptonote::NOTIFY_REQUEST_GET_BLOCKS::request req;
+  std::vector<crypto::hash> unknown;
+  for (size_t i = 0; i < 60; ++i)
+  {
+    req.blocks.push_back(m_db->hashes[(i * 37) % HEIGHT]);
+    if (i % 20 == 7)
+    {
+      unknown.push_back(crypto::cn_fast_hash(&i, sizeof(i)));
+      req.blocks.push_back(unknown.back());
+    }
+  }
+
+  cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request rsp;
+  ASSERT_TRUE(m_bc.m_blockchain.handle_get_blocks(req, rsp));
+  ASSERT_EQ(HEIGHT, rsp.current_blockchain_height);
+  ASSERT_EQ(unknown, rsp.missed_ids);
+  ASSERT_EQ(60, rsp.blocks.size());
+  for (size_t i = 0; i < 60; ++i)
+  {
+    const uint64_t height = (i * 37) % HEIGHT;
+    ASSERT_EQ(m_db->blobs[height], rsp.blocks[i].block);
+    cryptonote::block b;
+    ASSERT_TRUE(cryptonote::parse_and_validate_block_from_blob(rsp.blocks[i].block, b));
+    ASSERT_EQ(TXS_PER_BLOCK, rsp.blocks[i].txs.size());
+    for (size_t t = 0; t < TXS_PER_BLOCK; ++t)
+      ASSERT_EQ(m_db->txs.at(b.tx_hashes[t]), rsp.blocks[i].txs[t]);
+  }
+}
+
+TEST_F(get_blocks, missed_tx)
+{
+  cryptonote::block b;
+  ASSERT_TRUE(cryptonote::parse_and_validate_block_from_blob(m_db->blobs[123], b));
+  const crypto::hash gone = b.tx_hashes[2];
+  m_db->txs.erase(gone);
+
+  cryptonote::NOTIFY_REQUEST_GET_BLOCKS::request req;
+  for (size_t h = 100; h < 200; ++h)
+    req.blocks.push_back(m_db->hashes[h]);
+  cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request rsp;
+  ASSERT_FALSE(m_bc.m_blockchain.handle_get_blocks(req, rsp));
+  ASSERT_NE(rsp.missed_ids.end(), std::find(rsp.missed_ids.begin(), rsp.missed_ids.end(), gone));
+}
+
+TEST_F(get_blocks, serving_peers)
+{
+  // Several peers syncing from us at once, each asking for one span after another, with reads
+  // that have to go to disk.  This checks that concurrent serving gives every peer complete
+  // responses; the timings are only printed for reference, since wall clock numbers depend on the
+  // machine and its load.
+  constexpr size_t PEERS = 8, SPANS = 5, SPAN = 100;
+  m_db->read_delay = 200us;
+
+  auto span_request = [&](size_t peer, size_t span) {
+    cryptonote::NOTIFY_REQUEST_GET_BLOCKS::request req;
+    const size_t start = ((peer * SPANS + span) * SPAN) % (HEIGHT - SPAN);
+    for (size_t h = start; h < start + SPAN; ++h)
+      req.blocks.push_back(m_db->hashes[h]);
+    return req;
+  };
+
+  auto serve_all = [&](auto serve) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> peers;
+    for (size_t peer = 0; peer < PEERS; ++peer)
+      peers.emplace_back([&, peer] {
+        for (size_t span = 0; span < SPANS; ++span)
+        {
+          cryptonote::NOTIFY_RESPONSE_GET_BLOCKS::request rsp;
+          serve(span_request(peer, span), rsp);
+          EXPECT_EQ(SPAN, rsp.blocks.size());
+        }
+      });
+    for (auto& t : peers)
+      t.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // One peer at a time, behind a lock standing in for the blockchain lock serving used to hold
+  std::mutex blockchain_lock;
+  const double before = serve_all([&](auto req, auto& rsp) {
+    std::lock_guard lock{blockchain_lock};
+    serve_sequentially(req, rsp);
+  });
+  const double after = serve_all([&](auto req, auto& rsp) {
+    EXPECT_TRUE(m_bc.m_blockchain.handle_get_blocks(req, rsp));
+  });
+
+  std::cout << PEERS << " peers, " << PEERS * SPANS * SPAN << " blocks: " << before << "s one at a time, "
+    << after << "s in parallel (" << before / after << "x)" << std::endl;
+}
+
+TEST_F(get_blocks_handler, serves_in_order)
+{
+  // Both connections get their requests in before any of them can be served, so that there is a
+  // queue for each, served alongside each other
+  {
+    std::lock_guard hold{m_db->gate};
+    for (size_t i = 0; i < 4; ++i)
+    {
+      request(0, (3 - i) * SPAN);
+      request(1, 500 + i * SPAN);
+    }
+  }
+  ASSERT_TRUE(m_p2p.wait_for(8));
+  EXPECT_EQ((std::vector<size_t>{300, 200, 100, 0}), served(0));
+  EXPECT_EQ((std::vector<size_t>{500, 600, 700, 800}), served(1));
+  EXPECT_TRUE(m_p2p.dropped.empty());
+}
+
+TEST_F(get_blocks_handler, drops_flooding_peer)
+{
+  {
+    std::lock_guard hold{m_db->gate};
+    for (size_t i = 0; i < 4; ++i)
+      request(0, i * SPAN);
+    EXPECT_TRUE(m_p2p.dropped.empty());
+    request(0, 4 * SPAN);
+    EXPECT_EQ(std::vector{m_connections[0].m_connection_id}, m_p2p.dropped);
+  }
+  // What was queued before the one too many still gets served, and the one too many doesn't
+  ASSERT_TRUE(m_p2p.wait_for(4));
+  m_handler.deinit();
+  EXPECT_EQ((std::vector<size_t>{0, 100, 200, 300}), served(0));
+}
+
+TEST_F(get_blocks_handler, close_clears_queue)
+{
+  {
+    std::lock_guard hold{m_db->gate};
+    for (size_t i = 0; i < 3; ++i)
+      request(0, i * SPAN);
+    request(1, 500);
+    m_handler.on_connection_close(m_connections[0]);
+  }
+  // Only the request at the front of the closed connection's queue is finished off
+  ASSERT_TRUE(m_p2p.wait_for(2));
+  EXPECT_EQ(std::vector<size_t>{500}, served(1));
+  EXPECT_EQ(std::vector<size_t>{0}, served(0));
+
+  // and once it is, the queue is gone: a new connection with the same id starts over
+  request(0, 700);
+  ASSERT_TRUE(m_p2p.wait_for(3));
+  m_handler.deinit();
+  EXPECT_EQ((std::vector<size_t>{0, 700}), served(0));
+  EXPECT_TRUE(m_p2p.dropped.empty());
+}
@@ -39,6 +39,14 @@ static crypto::hash make_hash(uint64_t n)
   return hash;
 }
 
+static int log2_floor(uint64_t n)
+{
+  int r = 0;
+  while (n >>= 1)
+    ++r;
+  return r;
+}
+
 TEST(hashchain, empty)
 {
   tools::hashchain hashchain;
@@ -122,3 +130,68 @@ TEST(hashchain, trim)
   ASSERT_FALSE(hashchain.empty());
   ASSERT_EQ(hashchain.genesis(), make_hash(1));
 }
+
+TEST(hashchain, trim_checkpoints)
+{
+  tools::hashchain hashchain;
+  for (uint64_t n = 0; n < 1000; ++n)
+    hashchain.push_back(make_hash(n + 1));
+  hashchain.trim(900);
+  ASSERT_EQ(hashchain.offset(), 900);
+  ASSERT_EQ(hashchain.size(), 1000);
+  ASSERT_EQ(hashchain.checkpoint_heights(),
+      (std::vector<uint64_t>{388, 644, 772, 836, 868, 884, 892, 896, 898, 899}));
+  std::list<crypto::hash> ids;
+  hashchain.append_checkpoints(ids);
+  ASSERT_EQ(ids.size(), 10);
+  ASSERT_EQ(ids.front(), make_hash(900));
+  ASSERT_EQ(ids.back(), make_hash(389));
+  ASSERT_EQ(hashchain.genesis(), make_hash(1));
+}
+
+TEST(hashchain, trim_checkpoints_bounded)
+{
+  tools::hashchain hashchain;
+  for (uint64_t n = 0; n < 100000; ++n)
+  {
+    hashchain.push_back(make_hash(n + 1));
+    if (hashchain.size() - hashchain.offset() > 200)
+      hashchain.trim(hashchain.size() - 100);
+  }
+  const auto& heights = hashchain.checkpoint_heights();
+  ASSERT_FALSE(heights.empty());
+  ASSERT_LE(heights.size(), 17); // at most one per power-of-two distance below the offset
+  ASSERT_LT(heights.front(), 100); // the oldest checkpoints survive
+  ASSERT_EQ(heights.back(), hashchain.offset() - 1);
+  for (size_t i = 1; i < heights.size(); ++i)
+  {
+    ASSERT_LT(heights[i - 1], heights[i]);
+    ASSERT_GT(log2_floor(hashchain.offset() - heights[i - 1]), log2_floor(hashchain.offset() - heights[i]));
+  }
+}
+
+TEST(hashchain, trim_skips_placeholders)
+{
+  tools::hashchain hashchain;
+  hashchain.push_back(make_hash(1));
+  for (uint64_t n = 1; n < 64; ++n)
+    hashchain.push_back(crypto::null<crypto::hash>);
+  hashchain.push_back(make_hash(65));
+  hashchain.trim(64);
+  ASSERT_EQ(hashchain.offset(), 64);
+  ASSERT_TRUE(hashchain.checkpoint_heights().empty());
+}
+
+TEST(hashchain, refill_drops_checkpoints)
+{
+  tools::hashchain hashchain;
+  for (uint64_t n = 0; n < 10; ++n)
+    hashchain.push_back(make_hash(n + 1));
+  hashchain.trim(9);
+  ASSERT_EQ(hashchain.checkpoint_heights().back(), 8);
+  hashchain.refill(make_hash(11));
+  ASSERT_EQ(hashchain.offset(), 8);
+  ASSERT_EQ(hashchain.checkpoint_heights().back(), 7);
+  hashchain.clear();
+  ASSERT_TRUE(hashchain.checkpoint_heights().empty());
+}
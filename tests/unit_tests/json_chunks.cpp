@@ -0,0 +1,114 @@
+// Copyright (c) 2023, The Oxen Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "common/json_chunks.h"
+#include "rpc/common/command_decorators.h"
+
+namespace {
+
+nlohmann::json make_response(size_t count)
+{
+  nlohmann::json res{{"status", "OK"}, {"height", 1234}, {"untrusted", false}};
+  auto& list = res["values"] = nlohmann::json::array();
+  for (size_t i = 0; i < count; ++i)
+    list.push_back({
+        {"id", i},
+        {"neg", -static_cast<int64_t>(i)},
+        {"hex", std::string(3000, 'a' + i % 6)},
+        {"escaped", "q\"uote\\d\né"},
+        {"ratio", 0.5 * i},
+        {"empty", nlohmann::json::object()},
+        {"list", {1, nullptr, true, "x"}}});
+  return res;
+}
+
+}  // anonymous namespace
+
+TEST(json_chunks, matches_dump)
+{
+  for (size_t count : {0, 1, 100})
+  {
+    auto res = make_response(count);
+    tools::json_chunks out;
+    out.append(res);
+    ASSERT_EQ(out.str(), res.dump());
+    ASSERT_EQ(out.size(), res.dump().size());
+    for (size_t i = 0; i + 1 < out.chunks().size(); ++i)
+      ASSERT_EQ(out.chunks()[i].size(), tools::json_chunks::CHUNK_SIZE);
+  }
+}
+
+TEST(json_chunks, sink)
+{
+  auto res = make_response(100);
+  std::string sent;
+  size_t partial = 0;
+  tools::json_chunks out{[&](std::string chunk) {
+    if (chunk.size() != tools::json_chunks::CHUNK_SIZE)
+      ++partial;
+    sent += chunk;
+  }};
+  out.append(res);
+  ASSERT_GT(out.sent(), 0);
+  ASSERT_LE(out.chunks().size(), 1);
+  ASSERT_EQ(partial, 0);
+  out.flush();
+  ASSERT_EQ(partial, 1);
+  ASSERT_EQ(sent, res.dump());
+}
+
+TEST(json_chunks, stream_array)
+{
+  auto expected = make_response(100);
+  auto& values = expected["values"];
+  auto fill = [&values](size_t i, tools::json_binary_proxy elem) { *elem = values[i]; };
+
+  // Streamed into json: the streamed array goes after the other keys, which here is also where
+  // dump() puts it.
+  cryptonote::rpc::RPC_COMMAND streamed;
+  for (auto& key : {"status", "height", "untrusted"})
+    streamed.response[key] = expected[key];
+  streamed.stream_array("values", values.size(), fill);
+  std::string sent;
+  tools::json_chunks out{[&](std::string chunk) { sent += chunk; }};
+  streamed.write_response(out);
+  out.flush();
+  ASSERT_EQ(sent, expected.dump());
+
+  // Filled into the response value for callers that want the whole thing
+  cryptonote::rpc::RPC_COMMAND filled;
+  filled.response["status"] = "OK";
+  filled.stream_array("values", values.size(), fill);
+  filled.fill_streamed();
+  ASSERT_EQ(filled.response["values"], values);
+}
@@ -31,9 +31,14 @@
 #include "gtest/gtest.h"
 #include "common/file.h"
 #include "epee/misc_log_ex.h"
+#include "logging/async_sink.h"
 #include "logging/oxen_logger.h"
 #include <oxen/log.hpp>
 #include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/ostream_sink.h>
+#include <atomic>
+#include <sstream>
+#include <thread>
 
 #include "random_path.h"
 
@@ -158,3 +163,95 @@ TEST(logging, last_precedence)
   cleanup();
 }
 
+
+namespace {
+  // Holds up the async_sink writer thread on the first message until released
+  class gated_sink : public spdlog::sinks::base_sink<std::mutex>
+  {
+  public:
+    std::promise<void> gate;
+    std::vector<std::string> messages;
+
+  protected:
+    void sink_it_(const spdlog::details::log_msg& msg) override
+    {
+      if (!waited)
+      {
+        waited = true;
+        gate.get_future().wait();
+      }
+      messages.emplace_back(msg.payload.data(), msg.payload.size());
+    }
+    void flush_() override {}
+
+  private:
+    bool waited = false;
+  };
+}
+
+TEST(logging, async_sink_order)
+{
+  std::ostringstream out;
+  auto sink = std::make_shared<oxen::logging::async_sink>(std::make_shared<spdlog::sinks::ostream_sink_mt>(out), oxen::logging::overflow_policy::block, 16);
+  sink->set_pattern("%v");
+  spdlog::logger logger{"test", sink};
+  logger.set_level(spdlog::level::trace);
+
+  const int threads = 4, per_thread = 500;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++)
+    workers.emplace_back([&, t] {
+      for (int i = 0; i < per_thread; i++)
+        logger.trace("{} {}", t, i);
+    });
+  for (auto& w : workers)
+    w.join();
+  logger.flush();
+
+  // Everything arrives, and each thread's messages in the order it logged them
+  std::vector<int> next(threads, 0);
+  std::istringstream lines{out.str()};
+  int t, i, count = 0;
+  while (lines >> t >> i)
+  {
+    ASSERT_EQ(next[t]++, i);
+    count++;
+  }
+  ASSERT_EQ(threads * per_thread, count);
+  ASSERT_EQ(0, sink->dropped());
+}
+
+TEST(logging, async_sink_drop)
+{
+  auto gated = std::make_shared<gated_sink>();
+  auto sink = std::make_shared<oxen::logging::async_sink>(gated, oxen::logging::overflow_policy::drop, 8);
+  spdlog::logger logger{"test", sink};
+  logger.set_level(spdlog::level::trace);
+
+  // The writer gets stuck on the first message, and doesn't hand back the slots of what it took
+  // until it's done, so only 8 messages get through until the gate opens
+  logger.debug("first");
+  while (sink->dropped() == 0)
+    logger.debug("filler");
+  const auto dropped = sink->dropped();
+
+  // Warnings wait for room rather than being dropped: the ring stays full until the gate opens,
+  // so the warning can't get in before then
+  std::atomic<bool> released{false};
+  std::thread release{[&] {
+    std::this_thread::sleep_for(50ms);
+    released = true;
+    gated->gate.set_value();
+  }};
+  logger.warn("warning");
+  ASSERT_TRUE(released);
+  release.join();
+  logger.flush();
+
+  ASSERT_EQ(dropped, sink->dropped());
+  ASSERT_EQ("first", gated->messages.front());
+  ASSERT_EQ("warning", gated->messages.back());
+  const auto notice = std::to_string(dropped) + " log messages dropped because the log buffer was full";
+  ASSERT_EQ(1, std::count(gated->messages.begin(), gated->messages.end(), notice));
+  ASSERT_EQ(8 + 1 + 1, gated->messages.size());
+}
@@ -31,6 +31,11 @@
 #include "epee/misc_log_ex.h"
 #include "epee/mlocker.h"
 
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #if defined __GNUC__ && !defined _WIN32
 #define HAVE_MLOCK 1
 #endif
@@ -192,4 +197,79 @@ TEST(mlocker, mlocked)
   ASSERT_EQ(epee::mlocker::get_num_locked_objects(), base_objects + 0);
 }
 
+TEST(mlocker, stack_temporaries)
+{
+  const size_t base_pages = epee::mlocker::get_num_locked_pages();
+  const size_t base_objects = epee::mlocker::get_num_locked_objects();
+  for (int i = 0; i < 1000; ++i)
+  {
+    epee::mlocked<std::array<uint64_t, 4>> a, b;
+    ASSERT_GE(epee::mlocker::get_num_locked_pages(), base_pages + 1);
+    ASSERT_EQ(epee::mlocker::get_num_locked_objects(), base_objects + 2);
+  }
+  ASSERT_EQ(epee::mlocker::get_num_locked_pages(), base_pages + 0);
+  ASSERT_EQ(epee::mlocker::get_num_locked_objects(), base_objects + 0);
+}
+
+TEST(mlocker, threads)
+{
+  const size_t base_pages = epee::mlocker::get_num_locked_pages();
+  const size_t base_objects = epee::mlocker::get_num_locked_objects();
+  const size_t page_size = epee::mlocker::get_page_size();
+  std::unique_ptr<char[]> data{new char[8 * page_size]};
+
+  // Stack temporaries on every thread, plus objects shared between threads on the same heap
+  // pages, created on one thread and destroyed on another
+  std::vector<std::unique_ptr<epee::mlocker>> shared(8);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; ++t)
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 1000; ++i)
+        epee::mlocked<std::array<uint64_t, 4>> k;
+      shared[t].reset(new epee::mlocker(BASE(data) + (t % 2) * page_size + t * 64, 32));
+    });
+  for (auto &t : threads)
+    t.join();
+  ASSERT_EQ(epee::mlocker::get_num_locked_pages(), base_pages + 2);
+  ASSERT_EQ(epee::mlocker::get_num_locked_objects(), base_objects + 8);
+
+  threads.clear();
+  for (size_t t = 0; t < 8; ++t)
+    threads.emplace_back([&, t] { shared[7 - t].reset(); });
+  for (auto &t : threads)
+    t.join();
+  ASSERT_EQ(epee::mlocker::get_num_locked_pages(), base_pages + 0);
+  ASSERT_EQ(epee::mlocker::get_num_locked_objects(), base_objects + 0);
+}
+
+TEST(mlocker, cached_pages_capped)
+{
+  const size_t base_pages = epee::mlocker::get_num_locked_pages();
+  const size_t base_cached = epee::mlocker::get_num_cached_pages();
+
+  // Every thread locks several stack pages and then lets go of them, and stays alive so that its
+  // stack cache could keep them; no more than MAX_CACHED_PAGES may stay locked in total
+  std::atomic<int> done{0};
+  std::atomic<bool> finish{false};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; ++t)
+    threads.emplace_back([&] {
+      {
+        epee::mlocked<std::array<char, 16384>> big;
+      }
+      ++done;
+      while (!finish)
+        std::this_thread::yield();
+    });
+  while (done < 8)
+    std::this_thread::yield();
+  EXPECT_EQ(epee::mlocker::get_num_locked_pages(), base_pages + 0);
+  EXPECT_LE(epee::mlocker::get_num_cached_pages(), epee::mlocker::MAX_CACHED_PAGES);
+
+  finish = true;
+  for (auto &t : threads)
+    t.join();
+  ASSERT_EQ(epee::mlocker::get_num_cached_pages(), base_cached);
+}
+
 #endif
@@ -204,6 +204,58 @@ TEST(ringct, CLSAG)
   ASSERT_TRUE(rct::verRctCLSAGSimple(message,clsag,pubs,Cout));
 }
 
+TEST(ringct, CLSAG_ring_cache)
+{
+  const size_t N = 11;
+  const size_t idx = 3;
+  ctkeyV pubs;
+  key p, t, t2, u;
+  const key message = identity();
+
+  for (size_t i = 0; i < N; ++i)
+  {
+    key sk;
+    ctkey tmp;
+    skpkGen(sk, tmp.dest);
+    skpkGen(sk, tmp.mask);
+    pubs.push_back(tmp);
+  }
+  skpkGen(p, pubs[idx].dest);
+  t = skGen();
+  u = skGen();
+  addKeys2(pubs[idx].mask,t,u,H);
+  key Cout;
+  t2 = skGen();
+  addKeys2(Cout,t2,u,H);
+  ctkey insk;
+  insk.dest = p;
+  insk.mask = t;
+
+  rct::set_clsag_ring_cache_size(4096);
+  clsag_scratch scratch;
+  clsag sig = rct::proveRctCLSAGSimple(message,pubs,insk,t2,Cout,NULL,NULL,NULL,idx,hw::get_device("default"),scratch);
+
+  // Verification with a cold cache, a warm cache, and with the cache disabled must all agree
+  auto before = rct::get_clsag_ring_cache_stats();
+  ASSERT_TRUE(rct::verRctCLSAGSimple(message,sig,pubs,Cout,scratch));
+  ASSERT_TRUE(rct::verRctCLSAGSimple(message,sig,pubs,Cout));
+  auto after = rct::get_clsag_ring_cache_stats();
+  ASSERT_GE(after.hits - before.hits, N);
+  ASSERT_FALSE(rct::verRctCLSAGSimple(zero(),sig,pubs,Cout,scratch));
+
+  // A ring that is a different size than the last one used with the scratch space
+  ctkeyV short_pubs(pubs.begin(), pubs.begin() + idx + 1);
+  clsag short_sig = rct::proveRctCLSAGSimple(message,short_pubs,insk,t2,Cout,NULL,NULL,NULL,idx,hw::get_device("default"),scratch);
+  ASSERT_TRUE(rct::verRctCLSAGSimple(message,short_sig,short_pubs,Cout,scratch));
+  ASSERT_TRUE(rct::verRctCLSAGSimple(message,sig,pubs,Cout,scratch));
+
+  rct::set_clsag_ring_cache_size(0);
+  ASSERT_EQ(rct::get_clsag_ring_cache_stats().size, 0);
+  ASSERT_TRUE(rct::verRctCLSAGSimple(message,sig,pubs,Cout,scratch));
+  ASSERT_FALSE(rct::verRctCLSAGSimple(zero(),sig,pubs,Cout,scratch));
+  rct::set_clsag_ring_cache_size(4096);
+}
+
 TEST(ringct, range_proofs)
 {
   //Ring CT Stuff
@@ -131,6 +131,35 @@ TEST(ringdb, different_genesis)
   ASSERT_FALSE(ringdb.get_ring(get_context().KEY_2, get_context().KEY_IMAGE_1, outs2));
 }
 
+TEST(ringdb, batch)
+{
+  RingDB ringdb;
+  std::vector<std::pair<crypto::key_image, std::vector<uint64_t>>> rings;
+  std::vector<crypto::key_image> key_images;
+  for (uint64_t i = 0; i < 100; ++i)
+  {
+    rings.emplace_back(generate_key_image(), std::vector<uint64_t>{i + 1, 5, 17});
+    key_images.push_back(rings.back().first);
+  }
+  ASSERT_TRUE(ringdb.set_rings(get_context().KEY_1, rings, true));
+  ASSERT_TRUE(ringdb.remove_rings(get_context().KEY_1, {key_images[7]}));
+  key_images.push_back(get_context().KEY_IMAGE_1);
+
+  auto check = [&](tools::ringdb &db) {
+    auto found = db.get_rings(get_context().KEY_1, key_images);
+    ASSERT_EQ(found.size(), 99);
+    ASSERT_EQ(found.count(key_images[7]), 0);
+    ASSERT_EQ(found.count(get_context().KEY_IMAGE_1), 0);
+    ASSERT_EQ(found[key_images[42]], (std::vector<uint64_t>{43, 48, 65}));
+    ASSERT_TRUE(db.get_rings(get_context().KEY_2, key_images).empty());
+  };
+  // once from the session cache, then again from a fresh handle to see what actually got stored
+  check(ringdb);
+  ringdb.close();
+  tools::ringdb ringdb2(ringdb.filename(), "");
+  check(ringdb2);
+}
+
 TEST(spent_outputs, not_found)
 {
   RingDB ringdb;
@@ -219,6 +219,99 @@ TEST(service_nodes, vote_validation)
   }
 }
 
+TEST(service_nodes, vote_pool_stress)
+{
+  using service_nodes::quorum_type;
+  constexpr uint64_t base_height = 1000, num_heights = 60;
+  constexpr uint32_t num_workers = 10;
+  const uint64_t top_height = base_height + num_heights - 1;
+
+  auto obligation_vote = [](uint64_t height, uint32_t worker, uint16_t voter) {
+    service_nodes::quorum_vote_t vote{};
+    vote.type = quorum_type::obligations;
+    vote.block_height = height;
+    vote.group = service_nodes::quorum_group::validator;
+    vote.index_in_group = voter;
+    vote.state_change.worker_index = worker;
+    vote.state_change.state = service_nodes::new_state::decommission;
+    return vote;
+  };
+  auto checkpoint_vote = [](uint64_t height, uint16_t voter) {
+    service_nodes::quorum_vote_t vote{};
+    vote.type = quorum_type::checkpointing;
+    vote.block_height = height;
+    vote.group = service_nodes::quorum_group::validator;
+    vote.index_in_group = voter;
+    vote.checkpoint.block_hash = crypto::cn_fast_hash(&height, sizeof(height));
+    return vote;
+  };
+
+  service_nodes::voting_pool pool;
+  size_t total_obligations = 0, total_checkpoints = 0;
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (uint64_t height = base_height; height <= top_height; height++)
+    {
+      for (uint32_t worker = 0; worker < num_workers; worker++)
+        for (uint16_t voter = 0; voter < service_nodes::STATE_CHANGE_QUORUM_SIZE; voter++)
+        {
+          cryptonote::vote_verification_context vvc{};
+          auto votes = pool.add_pool_vote_if_unique(obligation_vote(height, worker, voter), vvc);
+          ASSERT_EQ(vvc.m_added_to_pool, pass == 0); // second pass is all duplicates
+          ASSERT_EQ(votes.size(), pass == 0 ? voter + 1 : service_nodes::STATE_CHANGE_QUORUM_SIZE);
+          ASSERT_EQ(votes.back().vote.index_in_group, pass == 0 ? voter : service_nodes::STATE_CHANGE_QUORUM_SIZE - 1);
+          total_obligations += vvc.m_added_to_pool;
+        }
+
+      for (uint16_t voter = 0; voter < service_nodes::CHECKPOINT_QUORUM_SIZE; voter += 2)
+      {
+        cryptonote::vote_verification_context vvc{};
+        pool.add_pool_vote_if_unique(checkpoint_vote(height, voter), vvc);
+        ASSERT_EQ(vvc.m_added_to_pool, pass == 0);
+        total_checkpoints += vvc.m_added_to_pool;
+      }
+    }
+  }
+  ASSERT_EQ(total_obligations, num_heights * num_workers * service_nodes::STATE_CHANGE_QUORUM_SIZE);
+  ASSERT_EQ(total_checkpoints, num_heights * service_nodes::CHECKPOINT_QUORUM_SIZE / 2);
+
+  ASSERT_TRUE(pool.received_checkpoint_vote(base_height, 0));
+  ASSERT_FALSE(pool.received_checkpoint_vote(base_height, 1));
+  ASSERT_FALSE(pool.received_checkpoint_vote(top_height + 1, 0));
+
+  // Obligation votes relay over quorumnet, checkpoints over p2p
+  auto obligations = pool.get_relayable_votes(top_height, cryptonote::hf_max, true /*quorum_relay*/);
+  auto checkpoints = pool.get_relayable_votes(top_height, cryptonote::hf_max, false /*quorum_relay*/);
+  ASSERT_EQ(obligations.size(), total_obligations);
+  ASSERT_EQ(checkpoints.size(), total_checkpoints);
+  for (auto& vote : obligations) ASSERT_EQ(vote.type, quorum_type::obligations);
+  for (auto& vote : checkpoints) ASSERT_EQ(vote.type, quorum_type::checkpointing);
+
+  // Relaying half the obligation votes takes them out of the relayable set until they are due again
+  std::vector<service_nodes::quorum_vote_t> relayed(obligations.begin(), obligations.begin() + obligations.size() / 2);
+  pool.set_relayed(relayed);
+  ASSERT_EQ(pool.get_relayable_votes(top_height, cryptonote::hf_max, true).size(), total_obligations - relayed.size());
+  pool.set_relayed(obligations);
+  ASSERT_TRUE(pool.get_relayable_votes(top_height, cryptonote::hf_max, true).empty());
+  ASSERT_EQ(pool.get_relayable_votes(top_height, cryptonote::hf_max, false).size(), total_checkpoints);
+
+  // Expire everything below the vote lifetime window
+  const uint64_t new_height = top_height + 30;
+  const uint64_t min_height = new_height - service_nodes::VOTE_LIFETIME;
+  pool.remove_expired_votes(new_height);
+  const uint64_t remaining_heights = top_height >= min_height ? top_height - min_height + 1 : 0;
+  ASSERT_EQ(pool.get_relayable_votes(new_height, cryptonote::hf_max, false).size(), remaining_heights * service_nodes::CHECKPOINT_QUORUM_SIZE / 2);
+  ASSERT_FALSE(pool.received_checkpoint_vote(base_height, 0));
+  ASSERT_EQ(pool.received_checkpoint_vote(top_height, 0), remaining_heights > 0);
+
+  // Expired groups start over; unexpired ones still dedup
+  {
+    cryptonote::vote_verification_context vvc{};
+    auto votes = pool.add_pool_vote_if_unique(obligation_vote(top_height, 0, 0), vvc);
+    ASSERT_EQ(vvc.m_added_to_pool, remaining_heights == 0);
+  }
+}
+
 TEST(service_nodes, tx_extra_state_change_validation)
 {
   // Generate a quorum and the voter
@@ -31,7 +31,9 @@
 #include "gtest/gtest.h"
 #include "cryptonote_core/service_node_swarm.h"
 #include "cryptonote_basic/cryptonote_basic.h"
+#include "common/random.h"
 
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <random>
@@ -626,3 +628,200 @@ TEST(swarm_to_snodes, deterministic_swarm_ids)
   EXPECT_EQ(ids[5046], 18442592317803069438ULL);
   EXPECT_EQ(ids[5047], 18445442251942264830ULL);
 }
+
+namespace
+{
+  /// calc_swarm_changes as it was before it learned to skip the steps with nothing to do and to
+  /// pick from the excess swarms without building the pool: the reference for the differential
+  /// test below.
+  namespace reference
+  {
+    void create_new_swarm_from_excess(swarm_snode_map_t& swarm_to_snodes, std::mt19937_64& mt)
+    {
+      const bool has_starving_swarms = std::any_of(swarm_to_snodes.begin(), swarm_to_snodes.end(),
+          [](const swarm_snode_map_t::value_type& pair) { return pair.second.size() < MIN_SWARM_SIZE; });
+      if (has_starving_swarms)
+        return;
+
+      std::vector<excess_pool_snode> pool_snodes;
+      while (calc_excess(swarm_to_snodes) >= calc_threshold(swarm_to_snodes))
+      {
+        std::vector<crypto::public_key> new_swarm_snodes;
+        while (new_swarm_snodes.size() < NEW_SWARM_SIZE)
+        {
+          size_t excess;
+          get_excess_pool(EXCESS_BASE, swarm_to_snodes, pool_snodes, excess);
+          if (pool_snodes.size() == 0)
+            return;
+          const auto& random_excess_snode = pick_from_excess_pool(pool_snodes, mt);
+          new_swarm_snodes.push_back(random_excess_snode.public_key);
+          remove_excess_snode_from_swarm(random_excess_snode, swarm_to_snodes);
+        }
+        const auto new_swarm_id = get_new_swarm_id(swarm_to_snodes);
+        swarm_to_snodes.emplace(new_swarm_id, std::move(new_swarm_snodes));
+      }
+    }
+
+    void assign_snodes(const std::vector<crypto::public_key>& snode_pubkeys, swarm_snode_map_t& swarm_to_snodes, std::mt19937_64& mt, size_t percentile)
+    {
+      std::vector<swarm_size> sorted_swarm_sizes;
+      for (const auto& sn_pk : snode_pubkeys)
+      {
+        calc_swarm_sizes(swarm_to_snodes, sorted_swarm_sizes);
+        const size_t percentile_index = percentile * (sorted_swarm_sizes.size() - 1) / 100;
+        const size_t percentile_value = sorted_swarm_sizes.at(percentile_index).size;
+        size_t upper_index = sorted_swarm_sizes.size() - 1;
+        for (size_t i = percentile_index; i < sorted_swarm_sizes.size(); ++i)
+        {
+          if (sorted_swarm_sizes[i].size > percentile_value)
+          {
+            upper_index = i - 1;
+            break;
+          }
+        }
+        const size_t random_idx = tools::uniform_distribution_portable(mt, upper_index + 1);
+        swarm_to_snodes.at(sorted_swarm_sizes[random_idx].swarm_id).push_back(sn_pk);
+        create_new_swarm_from_excess(swarm_to_snodes, mt);
+      }
+    }
+
+    void calc_swarm_changes(swarm_snode_map_t& swarm_to_snodes, uint64_t seed)
+    {
+      if (swarm_to_snodes.size() == 0)
+        return;
+
+      std::mt19937_64 mersenne_twister(seed);
+
+      std::vector<crypto::public_key> unassigned_snodes;
+      const auto it = swarm_to_snodes.find(UNASSIGNED_SWARM_ID);
+      if (it != swarm_to_snodes.end())
+      {
+        unassigned_snodes = it->second;
+        swarm_to_snodes.erase(it);
+      }
+
+      if (swarm_to_snodes.size() == 0)
+        swarm_to_snodes.insert({get_new_swarm_id({}), {}});
+
+      assign_snodes(unassigned_snodes, swarm_to_snodes, mersenne_twister, FILL_SWARM_LOWER_PERCENTILE);
+
+      {
+        std::vector<swarm_size> sorted_swarm_sizes;
+        calc_swarm_sizes(swarm_to_snodes, sorted_swarm_sizes);
+        bool insufficient_excess = false;
+        for (const auto& swarm : sorted_swarm_sizes)
+        {
+          if (swarm.size >= MIN_SWARM_SIZE)
+            break;
+
+          auto& poor_swarm_snodes = swarm_to_snodes.at(swarm.swarm_id);
+          do
+          {
+            const size_t percentile_index = STEALING_SWARM_UPPER_PERCENTILE * (sorted_swarm_sizes.size() - 1) / 100;
+            size_t percentile_value = sorted_swarm_sizes.at(percentile_index).size - 1;
+            percentile_value = std::max(MIN_SWARM_SIZE, percentile_value);
+            size_t excess;
+            std::vector<excess_pool_snode> excess_pool;
+            get_excess_pool(percentile_value, swarm_to_snodes, excess_pool, excess);
+            const size_t deficit = MIN_SWARM_SIZE - poor_swarm_snodes.size();
+            insufficient_excess = (excess < deficit);
+            if (insufficient_excess)
+              break;
+            const auto& excess_snode = pick_from_excess_pool(excess_pool, mersenne_twister);
+            remove_excess_snode_from_swarm(excess_snode, swarm_to_snodes);
+            poor_swarm_snodes.push_back(excess_snode.public_key);
+          } while (poor_swarm_snodes.size() < MIN_SWARM_SIZE);
+
+          if (insufficient_excess)
+            break;
+        }
+      }
+
+      create_new_swarm_from_excess(swarm_to_snodes, mersenne_twister);
+
+      if (swarm_to_snodes.size() > 1)
+      {
+        while (true)
+        {
+          auto it = std::find_if(swarm_to_snodes.begin(), swarm_to_snodes.end(),
+              [](const swarm_snode_map_t::value_type& pair) { return pair.second.size() < MIN_SWARM_SIZE; });
+          if (it == swarm_to_snodes.end())
+            break;
+          std::vector<crypto::public_key> decommissioned_snodes;
+          std::swap(decommissioned_snodes, it->second);
+          swarm_to_snodes.erase(it);
+          assign_snodes(decommissioned_snodes, swarm_to_snodes, mersenne_twister, DECOMMISSIONED_REDISTRIBUTION_LOWER_PERCENTILE);
+        }
+      }
+    }
+  }
+
+  crypto::public_key randomPubKey(std::mt19937_64& rng)
+  {
+    crypto::public_key pk;
+    for (size_t i = 0; i < sizeof(pk); i += sizeof(uint64_t))
+    {
+      const uint64_t r = rng();
+      std::memcpy(pk.data() + i, &r, std::min(sizeof(r), sizeof(pk) - i));
+    }
+    return pk;
+  }
+}
+
+TEST(swarm_to_snodes, matches_reference)
+{
+  // Runs the network through registrations, deregistrations, decommissions and recommissions,
+  // block by block, and checks that every block's swarms are exactly what the reference gives.
+  for (uint64_t run = 0; run < 20; ++run)
+  {
+    std::mt19937_64 rng{run};
+    swarm_snode_map_t swarms;
+    std::vector<crypto::public_key> decommissioned;
+    size_t skipped = 0;
+
+    for (uint64_t block = 0; block < 300; ++block)
+    {
+      // Gather the changes in this block the way service_node_list does: active nodes in their
+      // swarms, newcomers (and, after HF13, recommissioned nodes) unassigned
+      std::vector<crypto::public_key> unassigned;
+      const size_t registrations = rng() % (block < 20 ? 40 : 4);
+      for (size_t i = 0; i < registrations; ++i)
+        unassigned.push_back(randomPubKey(rng));
+      if (!decommissioned.empty() && rng() % 3 == 0)
+      {
+        unassigned.push_back(decommissioned.back());
+        decommissioned.pop_back();
+      }
+
+      const size_t departures = rng() % 3;
+      for (size_t i = 0; i < departures && !swarms.empty(); ++i)
+      {
+        auto swarm = swarms.begin();
+        std::advance(swarm, rng() % swarms.size());
+        if (swarm->second.empty())
+          continue;
+        auto victim = swarm->second.begin() + rng() % swarm->second.size();
+        if (rng() % 2)
+          decommissioned.push_back(*victim);
+        swarm->second.erase(victim);
+      }
+      for (auto it = swarms.begin(); it != swarms.end();)
+        it = it->second.empty() ? swarms.erase(it) : std::next(it);
+      if (!unassigned.empty())
+        swarms[UNASSIGNED_SWARM_ID] = std::move(unassigned);
+
+      swarm_snode_map_t expected = swarms;
+      reference::calc_swarm_changes(expected, block);
+      // Like the swarm ids on the service node infos, which are only touched when something changed
+      if (!calc_swarm_changes(swarms, block))
+        ++skipped;
+      for (auto it = swarms.begin(); it != swarms.end();)
+        it = it->second.empty() ? swarms.erase(it) : std::next(it);
+      for (auto it = expected.begin(); it != expected.end();)
+        it = it->second.empty() ? expected.erase(it) : std::next(it);
+      ASSERT_EQ(expected, swarms) << "run " << run << ", block " << block;
+    }
+    // Most blocks only lose a node or two, which the swarms can absorb
+    EXPECT_GT(skipped, 0) << "run " << run;
+  }
+}
@@ -147,3 +147,34 @@ TEST(threadpool, leaf_reentrancy)
   waiter.wait(tpool.get());
   ASSERT_EQ(counter, 500000);
 }
+
+TEST(threadpool, dedicated_nested)
+{
+  // Tasks on a dedicated pool fan out onto another pool rather than running inline
+  auto outer = tools::threadpool::getNewDedicated(2);
+  std::shared_ptr<tools::threadpool> inner(tools::threadpool::getNewForUnitTests(4));
+  tools::threadpool::waiter waiter;
+
+  std::atomic<int> counter(0);
+  std::atomic<int> inner_tasks_elsewhere(0);
+  for (int i = 0; i < 4; ++i)
+  {
+    outer->submit(&waiter, [&](){
+      tools::threadpool::waiter inner_waiter;
+      const auto id = std::this_thread::get_id();
+      for (int j = 0; j < 100; ++j)
+      {
+        inner->submit(&inner_waiter, [&, id](){
+          std::this_thread::sleep_for(1ms);
+          ++counter;
+          if (std::this_thread::get_id() != id)
+            ++inner_tasks_elsewhere;
+        });
+      }
+      inner_waiter.wait(inner.get());
+    });
+  }
+  waiter.wait(outer.get());
+  ASSERT_EQ(counter, 400);
+  ASSERT_GT(inner_tasks_elsewhere, 0);
+}
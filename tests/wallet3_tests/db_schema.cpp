@@ -71,6 +71,8 @@ TEST_CASE("DB Triggers", "[wallet,db]")
   {
     REQUIRE(db.prepared_get<int64_t>("SELECT amount FROM outputs WHERE id = 0") == 42);
     REQUIRE(db.overall_balance() == 42);
+    REQUIRE(db.available_balance(std::nullopt) == 42);
+    REQUIRE(db.unlocked_balance() == 42);
   }
 
   REQUIRE_NOTHROW(db.prepared_exec("INSERT INTO blocks VALUES(?,?,?,?);", 1, 0, "bar", 0));
@@ -80,6 +82,8 @@ TEST_CASE("DB Triggers", "[wallet,db]")
   SECTION("Confirm spend insert triggers")
   {
     REQUIRE(db.overall_balance() == 0);
+    REQUIRE(db.available_balance(std::nullopt) == 0);
+    REQUIRE(db.unlocked_balance() == 0);
     REQUIRE(db.prepared_get<int64_t>("SELECT spent_height FROM outputs WHERE key_image = 0") == 1);
   }
 
@@ -97,6 +101,8 @@ TEST_CASE("DB Triggers", "[wallet,db]")
     // existing output's spend height should be back to 0.
     REQUIRE(db.prepared_get<int>("SELECT COUNT(*) FROM spends;") == 0);
     REQUIRE(db.overall_balance() == 42);
+    REQUIRE(db.unlocked_balance() == 42);
+    REQUIRE(db.last_scan_height() == 0);
     REQUIRE(db.prepared_get<int64_t>("SELECT spent_height FROM outputs WHERE key_image = 0") == 0);
   }
 
@@ -110,10 +116,402 @@ TEST_CASE("DB Triggers", "[wallet,db]")
     // key image should be removed as nothing references it.
     REQUIRE(db.prepared_get<int>("SELECT COUNT(*) FROM outputs;") == 0);
     REQUIRE(db.overall_balance() == 0);
+    REQUIRE(db.unlocked_balance() == 0);
     REQUIRE(db.prepared_get<int64_t>("SELECT COUNT(*) FROM key_images;") == 0);
+    REQUIRE(db.prepared_get<int64_t>("SELECT COUNT(*) FROM unlock_schedule;") == 0);
   }
 }
 
+namespace
+{
+  // Adds a block at `height` with one transaction holding an output of `amount` for each of
+  // `unlock_times`
+  void
+  add_block(wallet::WalletDB& db, int64_t height, int64_t amount, const std::vector<int64_t>& unlock_times)
+  {
+    static int64_t next_key_image = 0;
+    const auto tx_hash = "tx" + std::to_string(height);
+    db.prepared_exec("INSERT INTO blocks VALUES(?,?,?,?);", height, static_cast<int64_t>(unlock_times.size()), "block" + std::to_string(height), 0);
+    db.prepared_exec("INSERT INTO transactions(block, hash) VALUES(?,?);", height, tx_hash);
+    for (auto unlock_time : unlock_times)
+    {
+      const int64_t key_image = ++next_key_image;
+      db.prepared_exec("INSERT INTO key_images VALUES(?,?);", key_image, "key_image" + std::to_string(key_image));
+      db.prepared_exec(
+          R"(INSERT INTO outputs(amount, output_index, global_index, unlock_time, block_height, tx,
+                output_key, derivation, rct_mask, key_image, subaddress_major, subaddress_minor)
+             VALUES(?,0,0,?,?,(SELECT id FROM transactions WHERE hash = ?),'','','',?,0,0))",
+          amount, unlock_time, height, tx_hash, key_image);
+    }
+  }
+
+  // What unlocked_balance() used to work out on every call
+  int64_t
+  scan_unlocked_balance(wallet::WalletDB& db)
+  {
+    return db.prepared_get<int64_t>(
+        "SELECT coalesce(sum(amount), 0) FROM outputs WHERE spent_height = 0 AND spending = FALSE "
+        "AND block_height + unlock_time <= (SELECT val_numeric FROM metadata WHERE id = 'last_scan_height')");
+  }
+}
+
+TEST_CASE("Unlock schedule", "[wallet,db]")
+{
+  wallet::WalletDB db{fs::path(":memory:"), ""};
+  REQUIRE_NOTHROW(db.create_schema());
+  REQUIRE(db.get_metadata_int("db_version") == 2);
+
+  // Outputs at height 1 unlocking at 1, 3 and 11
+  add_block(db, 1, 10, {0, 2, 10});
+  REQUIRE(db.unlocked_balance() == 10);
+  REQUIRE(db.available_balance(std::nullopt) == 30);
+
+  add_block(db, 2, 100, {0});
+  add_block(db, 3, 1000, {5});
+  REQUIRE(db.unlocked_balance() == 120);
+  REQUIRE(db.unlocked_balance() == scan_unlocked_balance(db));
+
+  SECTION("Spends and outputs being spent come off the unlocked balance")
+  {
+    REQUIRE_NOTHROW(db.prepared_exec("UPDATE outputs SET spending = TRUE WHERE amount = 100"));
+    REQUIRE(db.unlocked_balance() == 20);
+    REQUIRE(db.available_balance(std::nullopt) == 1030);
+
+    add_block(db, 4, 0, {});
+    REQUIRE_NOTHROW(db.prepared_exec(
+        "INSERT INTO spends(key_image, height) SELECT key_image, 4 FROM outputs WHERE amount = 10 AND unlock_time = 0"));
+    REQUIRE(db.unlocked_balance() == 10);
+    REQUIRE(db.unlocked_balance() == scan_unlocked_balance(db));
+
+    // Re-org the spend away
+    REQUIRE_NOTHROW(db.pop_block());
+    REQUIRE(db.unlocked_balance() == 20);
+    REQUIRE(db.unlocked_balance() == scan_unlocked_balance(db));
+  }
+
+  SECTION("Unlocks as blocks are added and re-locks as they are popped")
+  {
+    for (int64_t h = 4; h <= 11; ++h)
+      add_block(db, h, 1, {100});
+    REQUIRE(db.unlocked_balance() == 10 + 10 + 100 + 1000 + 10);
+    REQUIRE(db.unlocked_balance() == scan_unlocked_balance(db));
+
+    for (int i = 0; i < 4; ++i)
+      REQUIRE_NOTHROW(db.pop_block());
+    REQUIRE(db.last_scan_height() == 7);
+    REQUIRE(db.unlocked_balance() == 10 + 10 + 100);
+    REQUIRE(db.unlocked_balance() == scan_unlocked_balance(db));
+    REQUIRE(db.available_balance(std::nullopt) == 1130 + 4);
+    REQUIRE(db.available_balance(50) == 1100);
+  }
+
+  SECTION("Opening the db again leaves the schema as it is")
+  {
+    REQUIRE_NOTHROW(db.create_schema());
+    REQUIRE(db.get_metadata_int("db_version") == 2);
+    REQUIRE(db.unlocked_balance() == 120);
+  }
+}
+
+TEST_CASE("Unlock schedule benchmarks", "[.][benchmark][wallet,db]")
+{
+  wallet::WalletDB db{fs::path(":memory:"), ""};
+  db.create_schema();
+
+  // A wallet with 200k outputs over 20k blocks
+  {
+    auto tx = db.db_transaction();
+    for (int64_t h = 1; h <= 20'000; ++h)
+      add_block(db, h, h % 1000 + 1, std::vector<int64_t>(10, h % 3 ? 0 : 20));
+    tx.commit();
+  }
+  REQUIRE(db.unlocked_balance() == scan_unlocked_balance(db));
+
+  BENCHMARK("unlocked balance")
+  {
+    return db.unlocked_balance();
+  };
+  BENCHMARK("unlocked balance, scanning the outputs")
+  {
+    return scan_unlocked_balance(db);
+  };
+  BENCHMARK("available balance above a minimum")
+  {
+    return db.available_balance(990);
+  };
+  BENCHMARK("add and pop a block")
+  {
+    add_block(db, 20'001, 5, {0, 0});
+    db.pop_block();
+  };
+}
+
+
+namespace
+{
+  const std::string payment_id = "0123456789abcdef";
+
+  // Adds a block at `height` with a transaction paying `amount` to each of the given minor
+  // subaddresses of account 0, and with `payment_id` if `paid` is set
+  void
+  add_payment(wallet::WalletDB& db, int64_t height, int64_t amount, const std::vector<int64_t>& minors, bool paid)
+  {
+    const auto tx_hash = "in" + std::to_string(height);
+    db.prepared_exec("INSERT INTO blocks VALUES(?,?,?,?);", height, static_cast<int64_t>(minors.size()), "block" + std::to_string(height), 0);
+    if (paid)
+      db.prepared_exec("INSERT INTO transactions(block, hash, payment_id) VALUES(?,?,?);", height, tx_hash, payment_id);
+    else
+      db.prepared_exec("INSERT INTO transactions(block, hash) VALUES(?,?);", height, tx_hash);
+    for (size_t i = 0; i < minors.size(); ++i)
+    {
+      const auto key_image = tx_hash + "/" + std::to_string(i);
+      db.prepared_exec("INSERT INTO key_images(key_image) VALUES(?);", key_image);
+      db.prepared_exec(
+          R"(INSERT INTO outputs(amount, output_index, global_index, unlock_time, block_height, tx,
+                output_key, derivation, rct_mask, key_image, subaddress_major, subaddress_minor)
+             VALUES(?,?,0,0,?,(SELECT id FROM transactions WHERE hash = ?),'','','',
+               (SELECT id FROM key_images WHERE key_image = ?),0,?))",
+          amount, static_cast<int64_t>(i), height, tx_hash, key_image, minors[i]);
+    }
+  }
+
+  // Adds a block at `height` with a transaction spending the outputs received at `spent_heights`
+  // and paying `change` back to us
+  void
+  add_spend(wallet::WalletDB& db, int64_t height, const std::vector<int64_t>& spent_heights, int64_t change)
+  {
+    const auto tx_hash = "out" + std::to_string(height);
+    db.prepared_exec("INSERT INTO blocks VALUES(?,?,?,?);", height, 1, "block" + std::to_string(height), 0);
+    db.prepared_exec("INSERT INTO transactions(block, hash) VALUES(?,?);", height, tx_hash);
+    for (auto spent : spent_heights)
+      db.prepared_exec(
+          R"(INSERT INTO spends(key_image, height, tx)
+             SELECT key_image, ?, (SELECT id FROM transactions WHERE hash = ?) FROM outputs
+             WHERE block_height = ?)",
+          height, tx_hash, spent);
+    db.prepared_exec("INSERT INTO key_images(key_image) VALUES(?);", "change" + std::to_string(height));
+    db.prepared_exec(
+        R"(INSERT INTO outputs(amount, output_index, global_index, unlock_time, block_height, tx,
+              output_key, derivation, rct_mask, key_image, subaddress_major, subaddress_minor)
+           VALUES(?,0,0,0,?,(SELECT id FROM transactions WHERE hash = ?),'','','',
+             (SELECT id FROM key_images WHERE key_image = ?),0,0))",
+        change, height, tx_hash, "change" + std::to_string(height));
+  }
+
+  // Everything matching `query`, a page of `page_size` at a time
+  template <typename List>
+  auto
+  all_pages(wallet::TransferQuery query, size_t page_size, List list)
+  {
+    query.limit = page_size;
+    decltype(list(query)) all;
+    while (true)
+    {
+      auto page = list(query);
+      all.insert(all.end(), page.begin(), page.end());
+      if (page.size() < page_size)
+        return all;
+      query.after = {page.back().block_height, page.back().id};
+    }
+  }
+}
+
+TEST_CASE("Transfer history", "[wallet,db]")
+{
+  wallet::WalletDB db{fs::path(":memory:"), ""};
+  REQUIRE_NOTHROW(db.create_schema());
+
+  // Payments of h at heights 1-9 to subaddress h % 3, with a payment ID at even heights
+  for (int64_t h = 1; h < 10; ++h)
+    add_payment(db, h, h, {h % 3}, h % 2 == 0);
+  // Sends 2 + 3 - 1 (including the fee), paying 1 back as change
+  add_spend(db, 10, {2, 3}, 1);
+  // Two outputs in one transaction
+  add_payment(db, 11, 50, {1, 2}, false);
+
+  auto received = [&db](const wallet::TransferQuery& query) { return db.received_outputs(query); };
+  auto heights = [](const auto& entries) {
+    std::vector<int64_t> heights;
+    for (const auto& e : entries)
+      heights.push_back(e.block_height);
+    return heights;
+  };
+
+  SECTION("Received outputs in height order, a page at a time")
+  {
+    wallet::TransferQuery query;
+    auto all = db.received_outputs(query);
+    REQUIRE(heights(all) == std::vector<int64_t>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 11});
+    for (size_t page_size : {1, 2, 5, 12, 100})
+    {
+      auto paged = all_pages(query, page_size, received);
+      REQUIRE(paged.size() == all.size());
+      for (size_t i = 0; i < all.size(); ++i)
+        REQUIRE(paged[i].id == all[i].id);
+    }
+
+    REQUIRE(all[1].spent_height == 10);
+    REQUIRE(all[1].tx_hash == "in2");
+    REQUIRE(all[1].payment_id == payment_id);
+    REQUIRE(all[2].payment_id.empty());
+    REQUIRE(all[11].subaddress == cryptonote::subaddress_index{0, 2});
+  }
+
+  SECTION("Received outputs by subaddress, height and whether they're spent")
+  {
+    wallet::TransferQuery query;
+    query.account = 0;
+    query.subaddresses = {1};
+    REQUIRE(heights(all_pages(query, 2, received)) == std::vector<int64_t>{1, 4, 7, 11});
+
+    query.subaddresses = {0, 2};
+    query.min_height = 3;
+    query.max_height = 9;
+    REQUIRE(heights(all_pages(query, 2, received)) == std::vector<int64_t>{3, 5, 6, 8, 9});
+
+    query = {};
+    query.spent = true;
+    REQUIRE(heights(db.received_outputs(query)) == std::vector<int64_t>{2, 3});
+    query.spent = false;
+    REQUIRE(db.received_outputs(query).size() == 10);
+
+    query = {};
+    query.account = 1;
+    REQUIRE(db.received_outputs(query).empty());
+  }
+
+  SECTION("Transfers in and out")
+  {
+    wallet::TransferQuery query;
+    auto all = db.transfers(query, true, true);
+    REQUIRE(heights(all) == std::vector<int64_t>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11});
+
+    const auto& out = all[9];
+    REQUIRE(out.outgoing);
+    REQUIRE(out.tx_hash == "out10");
+    REQUIRE(out.amount == 4);
+
+    const auto& both = all[10];
+    REQUIRE_FALSE(both.outgoing);
+    REQUIRE(both.amount == 100);
+    REQUIRE(both.subaddress == cryptonote::subaddress_index{0, 1});
+
+    auto in_only = db.transfers(query, true, false);
+    REQUIRE(in_only.size() == 10);
+    REQUIRE(db.transfers(query, false, true).size() == 1);
+
+    for (size_t page_size : {1, 3, 11})
+    {
+      auto paged = all_pages(query, page_size, [&db](const auto& q) { return db.transfers(q, true, true); });
+      REQUIRE(heights(paged) == heights(all));
+    }
+
+    // Spent from subaddresses 2 and 0
+    query.account = 0;
+    query.subaddresses = {2};
+    auto from_2 = db.transfers(query, false, true);
+    REQUIRE(from_2.size() == 1);
+    REQUIRE(from_2[0].subaddress == cryptonote::subaddress_index{0, 2});
+    REQUIRE(from_2[0].amount == 4);
+    query.subaddresses = {1};
+    REQUIRE(db.transfers(query, false, true).empty());
+  }
+
+  SECTION("Payments by payment ID")
+  {
+    wallet::TransferQuery query;
+    query.payment_ids = {payment_id};
+    auto paged = all_pages(query, 3, [&db](const auto& q) { return db.transfers(q, true, false); });
+    REQUIRE(heights(paged) == std::vector<int64_t>{2, 4, 6, 8});
+    for (const auto& t : paged)
+      REQUIRE(t.payment_id == payment_id);
+
+    query.payment_ids = {"0000000000000000"};
+    REQUIRE(db.transfers(query, true, true).empty());
+  }
+
+  SECTION("Transfers by hash")
+  {
+    auto found = db.transfers_by_hash("out10");
+    REQUIRE(found.size() == 1);
+    REQUIRE(found[0].outgoing);
+    REQUIRE(found[0].amount == 4);
+
+    found = db.transfers_by_hash("in5");
+    REQUIRE(found.size() == 1);
+    REQUIRE(found[0].amount == 5);
+
+    REQUIRE(db.transfers_by_hash("nope").empty());
+  }
+
+  SECTION("Re-orgs take transfers with them")
+  {
+    REQUIRE_NOTHROW(db.pop_block());
+    REQUIRE_NOTHROW(db.pop_block());
+    REQUIRE(heights(db.transfers({}, true, true)) == std::vector<int64_t>{1, 2, 3, 4, 5, 6, 7, 8, 9});
+    REQUIRE(db.received_outputs({}).size() == 9);
+  }
+}
+
+TEST_CASE("Transfer history benchmarks", "[.][benchmark][wallet,db]")
+{
+  wallet::WalletDB db{fs::path(":memory:"), ""};
+  db.create_schema();
+
+  // A wallet with 1M outputs over 100k blocks: 11 per block to subaddresses 0-10, with a payment
+  // ID every 100 blocks, and every 10th block spending the previous one's outputs
+  constexpr int64_t blocks = 100'000;
+  {
+    auto tx = db.db_transaction();
+    const std::vector<int64_t> minors{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    for (int64_t h = 1; h <= blocks; ++h)
+    {
+      if (h % 10 == 0)
+        add_spend(db, h, {h - 1}, 0);
+      else
+        add_payment(db, h, h, minors, h % 100 == 1);
+    }
+    tx.commit();
+  }
+
+  wallet::TransferQuery first, deep;
+  deep.after = {blocks / 2, 0};
+
+  BENCHMARK("received outputs, first page")
+  {
+    return db.received_outputs(first);
+  };
+  BENCHMARK("received outputs, page halfway")
+  {
+    return db.received_outputs(deep);
+  };
+  BENCHMARK("received outputs, page halfway for a subaddress")
+  {
+    auto query = deep;
+    query.account = 0;
+    query.subaddresses = {3};
+    return db.received_outputs(query);
+  };
+  BENCHMARK("transfers, first page")
+  {
+    return db.transfers(first, true, true);
+  };
+  BENCHMARK("transfers, page halfway")
+  {
+    return db.transfers(deep, true, true);
+  };
+  BENCHMARK("payments by payment ID")
+  {
+    auto query = first;
+    query.payment_ids = {payment_id};
+    return db.transfers(query, true, false);
+  };
+  BENCHMARK("transfer by hash")
+  {
+    return db.transfers_by_hash("in" + std::to_string(blocks / 2 + 1));
+  };
+}
+
 
 /*
     // SQLiteCpp could throw on a bad query, so make sure the exception caught
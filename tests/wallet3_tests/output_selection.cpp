@@ -0,0 +1,191 @@
+#include <catch2/catch.hpp>
+
+#include <wallet3/output_selection/output_selection.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+
+namespace
+{
+  wallet::Output
+  make_output(int64_t amount, int64_t height)
+  {
+    wallet::Output o{};
+    o.amount = amount;
+    o.block_height = height;
+    o.global_index = height;
+    return o;
+  }
+
+  // Outputs with random amounts spread over `count` blocks, in height order as the db returns them
+  std::vector<wallet::Output>
+  make_outputs(size_t count, int64_t max_amount, uint64_t seed = 42)
+  {
+    std::mt19937_64 rng{seed};
+    std::uniform_int_distribution<int64_t> amount{1, max_amount};
+    std::vector<wallet::Output> outputs;
+    outputs.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+      outputs.push_back(make_output(amount(rng), 1000 + static_cast<int64_t>(i)));
+    return outputs;
+  }
+
+  // Fees for up to 299 inputs, like TransactionConstructor::select_inputs sets up
+  wallet::OutputSelector
+  make_selector(int64_t base_fee, int64_t per_input)
+  {
+    wallet::OutputSelector select;
+    for (int64_t n = 1; n < 300; ++n)
+      select.push_fee(n, base_fee + per_input * (n - 1));
+    return select;
+  }
+
+  int64_t
+  sum(const std::vector<wallet::Output>& outputs)
+  {
+    return std::accumulate(outputs.begin(), outputs.end(), int64_t{0},
+        [](int64_t acc, const auto& o) { return acc + o.amount; });
+  }
+}
+
+TEST_CASE("Output Selection", "[wallet,output_selection]")
+{
+  auto select = make_selector(10, 2);
+
+  SECTION("Requires fees and a sufficient balance")
+  {
+    wallet::OutputSelector no_fees;
+    REQUIRE_THROWS_WITH(no_fees({make_output(100, 1)}, 5), "Missing fee amount");
+    REQUIRE_THROWS_WITH(select({make_output(14, 1)}, 5), "Insufficient Wallet Balance");
+    REQUIRE_THROWS_WITH(select({}, 5), "Insufficient Wallet Balance");
+  }
+
+  SECTION("Prefers a single output")
+  {
+    std::vector<wallet::Output> outputs{
+        make_output(5, 1), make_output(30, 2), make_output(6, 3), make_output(31, 4)};
+    for (int i = 0; i < 20; ++i)
+    {
+      auto chosen = select(outputs, 19);
+      REQUIRE(chosen.size() == 1);
+      REQUIRE(chosen[0].amount >= 30);
+    }
+  }
+
+  SECTION("Covers the amount and the fee for the inputs chosen")
+  {
+    for (uint64_t seed = 0; seed < 50; ++seed)
+    {
+      auto outputs = make_outputs(200, 100, seed);
+      const int64_t amount = 150 + static_cast<int64_t>(seed) * 20;
+      auto chosen = select(outputs, amount);
+      REQUIRE(chosen.size() > 1);
+      REQUIRE(sum(chosen) >= amount + 10 + 2 * static_cast<int64_t>(chosen.size() - 1));
+
+      std::vector<int64_t> heights;
+      for (const auto& o : chosen)
+        heights.push_back(o.block_height);
+      std::sort(heights.begin(), heights.end());
+      REQUIRE(std::adjacent_find(heights.begin(), heights.end()) == heights.end());
+    }
+  }
+
+  SECTION("Favours recent outputs")
+  {
+    auto outputs = make_outputs(10000, 100);
+    double total_height = 0;
+    size_t count = 0;
+    for (int i = 0; i < 200; ++i)
+      for (const auto& o : select(outputs, 150))
+      {
+        total_height += o.block_height;
+        ++count;
+      }
+    REQUIRE(total_height / count > 1000 + 10000 / 2);
+  }
+
+  SECTION("Does not depend on the outputs being in height order")
+  {
+    auto outputs = make_outputs(500, 100);
+    std::shuffle(outputs.begin(), outputs.end(), std::mt19937_64{7});
+    auto chosen = select(outputs, 400);
+    REQUIRE(sum(chosen) >= 400 + 10 + 2 * static_cast<int64_t>(chosen.size() - 1));
+  }
+
+  SECTION("Falls back to the fewest inputs when sampling isn't enough")
+  {
+    // Sampling almost always lands on dust, so it runs out of draws
+    std::vector<wallet::Output> outputs;
+    for (int i = 0; i < 1000; ++i)
+      outputs.push_back(make_output(3, i));
+    outputs.push_back(make_output(500, 1000));
+    outputs.push_back(make_output(400, 1001));
+    outputs.push_back(make_output(300, 1002));
+    outputs.push_back(make_output(200, 1003));
+
+    auto chosen = select(outputs, 600);
+    REQUIRE(chosen.size() == 2);
+    REQUIRE(sum(chosen) >= 612);
+    // The 500 plus the smallest output that covers the rest
+    REQUIRE(sum(chosen) == 700);
+  }
+
+  SECTION("Consolidates the smallest outputs")
+  {
+    select.set_mode(wallet::SelectionMode::consolidate);
+    std::vector<wallet::Output> outputs{
+        make_output(1000, 1), make_output(3, 2), make_output(1, 3), make_output(4, 4),
+        make_output(50, 5), make_output(2, 6)};
+
+    // Everything but the 1 and 2, which aren't worth the extra input fee of 2
+    auto chosen = select(outputs, 5);
+    std::vector<int64_t> amounts;
+    for (const auto& o : chosen)
+      amounts.push_back(o.amount);
+    std::sort(amounts.begin(), amounts.end());
+    REQUIRE(amounts == std::vector<int64_t>{3, 4, 50, 1000});
+
+    // Only as many inputs as there are fees for, swapping in big outputs to cover the amount
+    wallet::OutputSelector three;
+    for (int64_t n = 1; n <= 3; ++n)
+      three.push_fee(n, 10 + 2 * (n - 1));
+    three.set_mode(wallet::SelectionMode::consolidate);
+    std::vector<wallet::Output> small{
+        make_output(5, 1), make_output(6, 2), make_output(7, 3), make_output(8, 4),
+        make_output(60, 5), make_output(90, 6)};
+    chosen = three(small, 100);
+    amounts.clear();
+    for (const auto& o : chosen)
+      amounts.push_back(o.amount);
+    std::sort(amounts.begin(), amounts.end());
+    REQUIRE(amounts == std::vector<int64_t>{7, 60, 90});
+  }
+}
+
+TEST_CASE("Output Selection benchmarks", "[.][benchmark][output_selection]")
+{
+  auto select = make_selector(10, 2);
+  auto consolidate = make_selector(10, 2);
+  consolidate.set_mode(wallet::SelectionMode::consolidate);
+
+  for (size_t count : {1'000, 100'000, 1'000'000})
+  {
+    auto outputs = make_outputs(count, 1000);
+    const auto n = std::to_string(count);
+
+    BENCHMARK("single output, " + n + " outputs")
+    {
+      return select(outputs, 500);
+    };
+    BENCHMARK("sampled, " + n + " outputs")
+    {
+      return select(outputs, 2500);
+    };
+    BENCHMARK("consolidate, " + n + " outputs")
+    {
+      return consolidate(outputs, 2500);
+    };
+  }
+}
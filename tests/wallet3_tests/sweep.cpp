@@ -0,0 +1,258 @@
+#include <catch2/catch.hpp>
+
+#include <wallet3/transaction_constructor.hpp>
+#include <wallet3/db/walletdb.hpp>
+
+#include <common/hex.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "mock_wallet.hpp"
+#include "mock_daemon_comms.hpp"
+#include "mock_decoy_selector.hpp"
+
+namespace
+{
+  // Counts the decoy requests made, and how many decoys each asked for
+  class CountingDaemonComms : public wallet::MockDaemonComms
+  {
+    public:
+      std::vector<size_t> requests;
+
+      std::future<std::vector<wallet::Decoy>>
+      fetch_decoys(const std::vector<int64_t>& indexes, bool with_txid = false) override
+      {
+        requests.push_back(indexes.size());
+        return MockDaemonComms::fetch_decoys(indexes, with_txid);
+      }
+  };
+
+  // "Signs" by listing the key images of the inputs in the transaction, after a pause that varies
+  // so that the transactions get done out of order.  Fails on any transaction spending
+  // `fail_amount`.
+  class MockSweepKeyring : public wallet::Keyring
+  {
+    public:
+      std::atomic<int> signed_count{0};
+      int64_t fail_amount = -1;
+
+      void
+      sign_transaction(wallet::PendingTransaction& ptx) override
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds{(ptx.chosen_outputs.size() * 7) % 5});
+        for (const auto& o : ptx.chosen_outputs)
+        {
+          if (o.amount == fail_amount)
+            throw std::runtime_error{"cannot sign output " + std::to_string(o.global_index)};
+          cryptonote::txin_to_key in{};
+          in.k_image = o.key_image;
+          ptx.tx.vin.push_back(in);
+        }
+        ++signed_count;
+      }
+  };
+
+  std::vector<wallet::Output>
+  make_outputs(size_t count, int64_t amount)
+  {
+    std::vector<wallet::Output> outputs;
+    for (size_t i = 0; i < count; ++i)
+    {
+      wallet::Output o{};
+      o.amount = amount;
+      o.block_height = 100 + static_cast<int64_t>(i);
+      o.global_index = static_cast<int64_t>(i);
+      o.key_image = wallet::debug_random_filled<crypto::key_image>(i);
+      outputs.push_back(o);
+    }
+    return outputs;
+  }
+}
+
+TEST_CASE("Sweep transactions", "[wallet,tx,sweep]")
+{
+  wallet::MockWallet wallet{};
+  auto comms = std::make_shared<CountingDaemonComms>();
+  wallet::TransactionConstructor ctor{wallet.get_db(), comms};
+  ctor.fee_per_byte = 1;
+  ctor.fee_per_output = 0;
+  cryptonote::tx_destination_entry recipient{};
+  cryptonote::tx_destination_entry change{};
+
+  SECTION("Splits the outputs into evenly sized transactions, in order")
+  {
+    auto outputs = make_outputs(25, 100000);
+    auto ptxs = ctor.create_sweep_transactions(outputs, recipient, change, 10);
+
+    REQUIRE(ptxs.size() == 3);
+    REQUIRE(ptxs[0].chosen_outputs.size() == 9);
+    REQUIRE(ptxs[1].chosen_outputs.size() == 8);
+    REQUIRE(ptxs[2].chosen_outputs.size() == 8);
+
+    int64_t next_index = 0;
+    for (const auto& ptx : ptxs)
+    {
+      for (const auto& o : ptx.chosen_outputs)
+        REQUIRE(o.global_index == next_index++);
+      REQUIRE(ptx.recipients.size() == 1);
+      REQUIRE(ptx.change.amount == 0);
+      REQUIRE(ptx.fee == ptx.get_fee());
+      REQUIRE(ptx.recipients[0].amount == ptx.sum_inputs() - ptx.fee);
+      REQUIRE(ptx.tx.output_unlock_times.size() == 2);
+
+      REQUIRE(ptx.decoys.size() == ptx.chosen_outputs.size());
+      for (size_t i = 0; i < ptx.decoys.size(); ++i)
+      {
+        const auto& ring = ptx.decoys[i];
+        REQUIRE(std::any_of(ring.begin(), ring.end(), [&](const auto& d) {
+          return d.global_index == ptx.chosen_outputs[i].global_index;
+        }));
+      }
+    }
+    REQUIRE(next_index == 25);
+
+    // One decoy request per transaction
+    REQUIRE(comms->requests.size() == 3);
+    REQUIRE(comms->requests[0] == 9 * ptxs[0].decoys[0].size());
+  }
+
+  SECTION("Uses as few transactions as the weight limit allows")
+  {
+    auto ptxs = ctor.create_sweep_transactions(make_outputs(1000, 100000), recipient, change);
+
+    wallet::PendingTransaction one_recipient{std::vector<cryptonote::tx_destination_entry>{recipient}};
+    size_t max_inputs = 1;
+    while (one_recipient.get_tx_weight(max_inputs + 1) <= wallet::TransactionConstructor::SWEEP_TX_WEIGHT_LIMIT)
+      ++max_inputs;
+
+    REQUIRE(ptxs.size() == (1000 + max_inputs - 1) / max_inputs);
+    size_t inputs = 0;
+    for (const auto& ptx : ptxs)
+    {
+      REQUIRE(ptx.get_tx_weight(ptx.chosen_outputs.size()) <= wallet::TransactionConstructor::SWEEP_TX_WEIGHT_LIMIT);
+      REQUIRE(ptx.chosen_outputs.size() + 1 >= ptxs[0].chosen_outputs.size());
+      inputs += ptx.chosen_outputs.size();
+    }
+    REQUIRE(inputs == 1000);
+  }
+
+  SECTION("Leaves out outputs that aren't worth an extra input")
+  {
+    auto outputs = make_outputs(6, 100000);
+    outputs[1].amount = 1;
+    outputs[4].amount = 2;
+    auto ptxs = ctor.create_sweep_transactions(outputs, recipient, change);
+    REQUIRE(ptxs.size() == 1);
+    REQUIRE(ptxs[0].chosen_outputs.size() == 4);
+    for (const auto& o : ptxs[0].chosen_outputs)
+      REQUIRE(o.amount == 100000);
+
+    REQUIRE_THROWS_WITH(
+        ctor.create_sweep_transactions(make_outputs(3, 1), recipient, change),
+        "No outputs worth sweeping");
+  }
+
+  SECTION("Fails if a transaction can't cover its fee")
+  {
+    // Worth an extra input, but not a transaction of its own
+    REQUIRE_THROWS_WITH(
+        ctor.create_sweep_transactions(make_outputs(1, ctor.dust_threshold() - 1), recipient, change),
+        "Outputs to sweep do not cover the transaction fee");
+  }
+
+  SECTION("Chooses the decoys in the order of the transactions")
+  {
+    auto selector = std::make_unique<wallet::MockDecoySelector>();
+    std::vector<int64_t> indexes;
+    for (int64_t i = 0; i < 30; ++i)
+      indexes.push_back(1000 + i);
+    selector->add_index(indexes);
+    ctor.decoy_selector = std::move(selector);
+
+    // The mock decoys have no key, so neither do these outputs, and they match any of them
+    auto ptxs = ctor.create_sweep_transactions(make_outputs(7, 100000), recipient, change, 3);
+    REQUIRE(ptxs.size() == 3);
+    size_t ring = 0;
+    for (const auto& ptx : ptxs)
+      for (const auto& decoys : ptx.decoys)
+      {
+        REQUIRE(decoys.size() == 10);
+        for (size_t i = 0; i < decoys.size(); ++i)
+          REQUIRE(decoys[i].global_index == 1000 + static_cast<int64_t>((ring * 10 + i) % 30));
+        ++ring;
+      }
+    REQUIRE(ring == 7);
+  }
+}
+
+TEST_CASE("Sweep signing", "[wallet,tx,sweep]")
+{
+  wallet::MockWallet wallet{};
+  auto comms = std::make_shared<wallet::MockDaemonComms>();
+  wallet::TransactionConstructor ctor{wallet.get_db(), comms};
+  ctor.fee_per_byte = 1;
+  ctor.fee_per_output = 0;
+  cryptonote::tx_destination_entry recipient{};
+
+  auto outputs = make_outputs(100, 100000);
+  auto ptxs = ctor.create_sweep_transactions(outputs, recipient, recipient, 4);
+  REQUIRE(ptxs.size() == 25);
+
+  MockSweepKeyring keys;
+
+  SECTION("Signs every transaction, each with its own inputs")
+  {
+    wallet::TransactionConstructor::sign_transactions(ptxs, keys);
+    REQUIRE(keys.signed_count == 25);
+    size_t next = 0;
+    for (const auto& ptx : ptxs)
+    {
+      REQUIRE(ptx.tx.vin.size() == 4);
+      for (const auto& in : ptx.tx.vin)
+        REQUIRE(std::get<cryptonote::txin_to_key>(in).k_image == outputs[next++].key_image);
+    }
+  }
+
+  SECTION("Throws the error of the first transaction that fails")
+  {
+    // Outputs 9 and 21 are in the third and sixth transactions
+    ptxs[2].chosen_outputs[1].amount = 1;
+    ptxs[5].chosen_outputs[1].amount = 1;
+    keys.fail_amount = 1;
+    REQUIRE_THROWS_WITH(
+        wallet::TransactionConstructor::sign_transactions(ptxs, keys), "cannot sign output 9");
+    // The others still got signed
+    REQUIRE(keys.signed_count == 23);
+  }
+}
+
+TEST_CASE("Sweepable outputs", "[wallet,db,sweep]")
+{
+  wallet::MockWallet wallet{};
+  auto db = wallet.get_db();
+  for (int64_t amount : {5, 500, 50, 5000})
+    wallet.store_test_transaction(amount);
+
+  auto all = db->unlocked_outputs();
+  REQUIRE(all.size() == 4);
+  for (size_t i = 0; i < all.size(); ++i)
+    REQUIRE(all[i].block_height == static_cast<int64_t>(i + 1));
+
+  REQUIRE(db->unlocked_outputs(0, {0}).size() == 4);
+  REQUIRE(db->unlocked_outputs(1).empty());
+  REQUIRE(db->unlocked_outputs(0, {1}).empty());
+
+  auto small = db->unlocked_outputs(std::nullopt, {}, 500);
+  REQUIRE(small.size() == 2);
+  REQUIRE(small[0].amount == 5);
+  REQUIRE(small[1].amount == 50);
+
+  // Heights 1 to 4, so the third is the 50
+  auto key_image = tools::type_to_hex(wallet::debug_random_filled<crypto::key_image>(3));
+  auto output = db->unlocked_output_by_key_image(key_image);
+  REQUIRE(output);
+  REQUIRE(output->amount == 50);
+  REQUIRE_FALSE(db->unlocked_output_by_key_image(std::string(64, '0')));
+}